@@ -0,0 +1,220 @@
+/* ============================================================================
+ * API Kit - Benchmark Support Implementation
+ * ============================================================================ */
+
+#include "bench_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifndef BENCH_BUILD_ID
+#define BENCH_BUILD_ID "unknown"
+#endif
+
+/* ============================================================================
+ * ALLOCATION COUNTING
+ *
+ * On toolchains with GNU ld the bench targets link with
+ * --wrap=malloc/calloc/realloc, which routes every allocation made by apikit
+ * code through these counters. Allocations inside shared libraries such as
+ * libcurl are not visible this way.
+ * ============================================================================ */
+
+static uint64_t alloc_count = 0;
+static uint64_t alloc_bytes = 0;
+
+#ifdef BENCH_WRAP_ALLOCATIONS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, nmemb * size, __ATOMIC_RELAXED);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+int bench_alloc_supported(void) {
+#ifdef BENCH_WRAP_ALLOCATIONS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void bench_alloc_reset(void) {
+    __atomic_store_n(&alloc_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&alloc_bytes, 0, __ATOMIC_RELAXED);
+}
+
+bench_alloc_stats_t bench_alloc_read(void) {
+    bench_alloc_stats_t stats = {
+        .allocations = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED),
+        .bytes = __atomic_load_n(&alloc_bytes, __ATOMIC_RELAXED)
+    };
+    return stats;
+}
+
+/* ============================================================================
+ * OPTIONS AND TIMING
+ * ============================================================================ */
+
+void bench_parse_args(int argc, char **argv, bench_options_t *options) {
+    memset(options, 0, sizeof(*options));
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options->json_path = argv[++i];
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            options->iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            options->quick = 1;
+        } else {
+            printf("Usage: %s [--json FILE] [--iterations N] [--quick]\n", argv[0]);
+            exit(strcmp(argv[i], "--help") == 0 ? 0 : 1);
+        }
+    }
+}
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * SAMPLES
+ * ============================================================================ */
+
+void bench_samples_init(bench_samples_t *samples, size_t expected) {
+    samples->count = 0;
+    samples->capacity = expected > 0 ? expected : 1024;
+    samples->samples_ns = malloc(samples->capacity * sizeof(uint64_t));
+    if (!samples->samples_ns) {
+        samples->capacity = 0;
+    }
+}
+
+void bench_samples_add(bench_samples_t *samples, uint64_t ns) {
+    if (samples->count == samples->capacity) {
+        size_t capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        uint64_t *grown = realloc(samples->samples_ns, capacity * sizeof(uint64_t));
+        if (!grown) return;
+        samples->samples_ns = grown;
+        samples->capacity = capacity;
+    }
+    samples->samples_ns[samples->count++] = ns;
+}
+
+void bench_samples_free(bench_samples_t *samples) {
+    free(samples->samples_ns);
+    samples->samples_ns = NULL;
+    samples->count = samples->capacity = 0;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+uint64_t bench_samples_percentile(bench_samples_t *samples, double percentile) {
+    if (samples->count == 0) return 0;
+
+    qsort(samples->samples_ns, samples->count, sizeof(uint64_t), compare_u64);
+
+    // Nearest-rank percentile
+    size_t rank = (size_t)(percentile / 100.0 * (double)samples->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > samples->count) rank = samples->count;
+    return samples->samples_ns[rank - 1];
+}
+
+/* ============================================================================
+ * REPORTING
+ * ============================================================================ */
+
+void bench_report(const bench_options_t *options, const bench_result_t *result, bench_samples_t *samples) {
+    double seconds = (double)result->elapsed_ns / 1e9;
+    double ops_per_sec = seconds > 0 ? (double)result->operations / seconds : 0;
+    double mb_per_sec = seconds > 0 ? (double)result->bytes / seconds / (1024.0 * 1024.0) : 0;
+    double ops = result->operations ? (double)result->operations : 1;
+
+    uint64_t p50 = bench_samples_percentile(samples, 50);
+    uint64_t p90 = bench_samples_percentile(samples, 90);
+    uint64_t p99 = bench_samples_percentile(samples, 99);
+    uint64_t min = samples->count ? samples->samples_ns[0] : 0;
+    uint64_t max = samples->count ? samples->samples_ns[samples->count - 1] : 0;
+
+    printf("%-16s %-28s %10.0f op/s %9.2f MB/s  p50 %9.1f us  p99 %9.1f us  %8.1f allocs/op\n",
+           result->suite, result->name, ops_per_sec, mb_per_sec,
+           (double)p50 / 1000.0, (double)p99 / 1000.0,
+           (double)result->allocs.allocations / ops);
+
+    if (!options->json_path) return;
+
+    FILE *file = fopen(options->json_path, "a");
+    if (!file) {
+        printf("Failed to open %s\n", options->json_path);
+        return;
+    }
+
+    fprintf(file,
+            "{\"suite\":\"%s\",\"case\":\"%s\",\"build\":\"%s\",\"timestamp\":%ld,"
+            "\"operations\":%llu,\"bytes\":%llu,\"elapsed_ns\":%llu,"
+            "\"ops_per_sec\":%.2f,\"mb_per_sec\":%.3f,"
+            "\"latency_ns\":{\"min\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%llu},"
+            "\"allocs_supported\":%s,\"allocs_per_op\":%.2f,\"alloc_bytes_per_op\":%.1f}\n",
+            result->suite, result->name, BENCH_BUILD_ID, (long)time(NULL),
+            (unsigned long long)result->operations, (unsigned long long)result->bytes,
+            (unsigned long long)result->elapsed_ns, ops_per_sec, mb_per_sec,
+            (unsigned long long)min, (unsigned long long)p50, (unsigned long long)p90,
+            (unsigned long long)p99, (unsigned long long)max,
+            bench_alloc_supported() ? "true" : "false",
+            (double)result->allocs.allocations / ops, (double)result->allocs.bytes / ops);
+    fclose(file);
+}
+
+/* ============================================================================
+ * SCRATCH DIRECTORIES
+ * ============================================================================ */
+
+int bench_make_temp_dir(char *path, size_t path_size, const char *prefix) {
+    const char *tmp = getenv("TMPDIR");
+    if (!tmp || tmp[0] == '\0') tmp = "/tmp";
+
+    snprintf(path, path_size, "%s/%s-XXXXXX", tmp, prefix);
+    return mkdtemp(path) ? 0 : -1;
+}
+
+void bench_remove_temp_dir(const char *path) {
+    DIR *dir = opendir(path);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            char file_path[1024];
+            snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+            unlink(file_path);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
@@ -0,0 +1,82 @@
+/* ============================================================================
+ * API Kit - Benchmark Support
+ *
+ * Shared helpers for the bench_* targets: monotonic timing, latency
+ * samples with percentiles, allocation counting and result reporting. Every
+ * result is printed as a table row and, with --json FILE, appended to FILE
+ * as one JSON object per line so runs of different builds can be compared.
+ * ============================================================================ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+// Command line options shared by all benchmark targets
+typedef struct {
+    const char *json_path;   // Append JSON lines here (NULL = stdout table only)
+    int iterations;          // Measured iterations per case (0 = case default)
+    int quick;               // Smaller workloads for smoke runs
+} bench_options_t;
+
+// Latency samples for one case
+typedef struct {
+    uint64_t *samples_ns;
+    size_t count;
+    size_t capacity;
+} bench_samples_t;
+
+// Allocation counters (only populated when built with allocation wrapping)
+typedef struct {
+    uint64_t allocations;
+    uint64_t bytes;
+} bench_alloc_stats_t;
+
+// Summary of one measured case
+typedef struct {
+    const char *suite;
+    const char *name;
+    uint64_t operations;     // Operations timed
+    uint64_t bytes;          // Payload bytes processed (0 if not meaningful)
+    uint64_t elapsed_ns;     // Wall time of the measured loop
+    bench_alloc_stats_t allocs;
+} bench_result_t;
+
+/* ============================================================================
+ * BENCHMARK API
+ * ============================================================================ */
+
+// Parse --json FILE, --iterations N and --quick; exits on --help
+void bench_parse_args(int argc, char **argv, bench_options_t *options);
+
+// Monotonic clock in nanoseconds
+uint64_t bench_now_ns(void);
+
+// Sample storage
+void bench_samples_init(bench_samples_t *samples, size_t expected);
+void bench_samples_add(bench_samples_t *samples, uint64_t ns);
+void bench_samples_free(bench_samples_t *samples);
+
+// Percentile (0-100) of the recorded samples; sorts the samples in place
+uint64_t bench_samples_percentile(bench_samples_t *samples, double percentile);
+
+// Allocation counters since the last reset (zero when wrapping is unavailable)
+void bench_alloc_reset(void);
+bench_alloc_stats_t bench_alloc_read(void);
+int bench_alloc_supported(void);
+
+// Print a result row and append it to the JSON file if requested
+void bench_report(const bench_options_t *options, const bench_result_t *result, bench_samples_t *samples);
+
+// Create a scratch directory under the system temp dir; returns 0 on success
+int bench_make_temp_dir(char *path, size_t path_size, const char *prefix);
+
+// Remove a scratch directory and the regular files inside it
+void bench_remove_temp_dir(const char *path);
+
+#endif // BENCH_COMMON_H
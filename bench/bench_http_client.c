@@ -0,0 +1,117 @@
+/* ============================================================================
+ * API Kit - HTTP Client Benchmark
+ *
+ * Runs request loops against an in-process mock_server on an ephemeral
+ * loopback port, so results measure the client and libcurl rather than the
+ * network or the stand-in server.
+ * ============================================================================ */
+
+#include "bench_common.h"
+#include "mock_server.h"
+#include "http_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SUITE "http_client"
+
+/* ============================================================================
+ * CASES
+ * ============================================================================ */
+
+static void run_case(const bench_options_t *options, const char *name, http_client_t *client,
+                     http_method_t method, const char *url, const http_request_options_t *request_options,
+                     int iterations) {
+    bench_samples_t samples;
+    bench_samples_init(&samples, (size_t)iterations);
+    uint64_t bytes = 0;
+    int failures = 0;
+
+    // One untimed request establishes the keep-alive connection
+    http_response_t *warmup = http_request(client, method, url, request_options);
+    if (warmup) http_response_free(warmup);
+
+    bench_alloc_reset();
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        uint64_t t0 = bench_now_ns();
+        http_response_t *response = http_request(client, method, url, request_options);
+        bench_samples_add(&samples, bench_now_ns() - t0);
+
+        if (!response || response->error_message || response->status_code != 200) {
+            failures++;
+        } else {
+            bytes += response->body_size;
+        }
+        if (response) http_response_free(response);
+    }
+    bench_result_t result = {
+        .suite = SUITE, .name = name,
+        .operations = (uint64_t)iterations,
+        .bytes = bytes,
+        .elapsed_ns = bench_now_ns() - start,
+        .allocs = bench_alloc_read()
+    };
+
+    if (failures > 0) {
+        printf("%s: %d of %d requests failed\n", name, failures, iterations);
+    }
+    bench_report(options, &result, &samples);
+    bench_samples_free(&samples);
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv) {
+    bench_options_t options;
+    bench_parse_args(argc, argv, &options);
+
+    mock_server_config_t server_config = {.threads = 1};
+    mock_server_t *server = mock_server_start(&server_config);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+    int port = mock_server_port(server);
+
+    http_client_t *client = http_client_create();
+    if (!client) {
+        mock_server_stop(server);
+        return 1;
+    }
+
+    int iterations = options.iterations ? options.iterations : (options.quick ? 50 : 5000);
+    char url[128];
+
+    const char *headers[] = {"Accept: */*", "X-Bench: 1", NULL};
+    http_request_options_t get_options = {.headers = headers, .timeout_ms = 10000};
+
+    char *payload = malloc(1024 + 1);
+    memset(payload, 'p', 1024);
+    payload[1024] = '\0';
+    http_request_options_t post_options = {
+        .headers = headers,
+        .body = payload,
+        .content_type = "application/octet-stream",
+        .timeout_ms = 10000
+    };
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/bytes/64", port);
+    run_case(&options, "get_64b", client, HTTP_METHOD_GET, url, &get_options, iterations);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/bytes/65536", port);
+    run_case(&options, "get_64kb", client, HTTP_METHOD_GET, url, &get_options, iterations);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/bytes/1048576", port);
+    run_case(&options, "get_1mb", client, HTTP_METHOD_GET, url, &get_options, iterations / 10 + 1);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/bytes/64", port);
+    run_case(&options, "post_1kb", client, HTTP_METHOD_POST, url, &post_options, iterations);
+
+    free(payload);
+    http_client_destroy(client);
+    mock_server_stop(server);
+    return 0;
+}
@@ -0,0 +1,192 @@
+/* ============================================================================
+ * API Kit - HTTP Parser Benchmark
+ *
+ * Generates large .http collections and measures parsing, saving and
+ * per-request formatting throughput.
+ * ============================================================================ */
+
+#include "bench_common.h"
+#include "http_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SUITE "http_parser"
+
+// Capacity of http_collection_t
+#define COLLECTION_CAPACITY ((int)(sizeof(((http_collection_t *)0)->requests) / sizeof(http_request_t)))
+
+/* ============================================================================
+ * WORKLOAD GENERATION
+ * ============================================================================ */
+
+// Fill a request so every field is close to its capacity
+static void make_request(http_request_t *request, int index) {
+    static const char *methods[] = {"GET", "POST", "PUT", "DELETE", "PATCH"};
+
+    memset(request, 0, sizeof(*request));
+    snprintf(request->name, sizeof(request->name), "Synthetic request %d", index);
+    snprintf(request->method, sizeof(request->method), "%s", methods[index % 5]);
+    snprintf(request->url, sizeof(request->url),
+             "https://api.example.com/v1/tenants/%d/resources/%d?page=%d&limit=100&sort=created_at",
+             index % 7, index, index % 13);
+
+    size_t used = 0;
+    for (int h = 0; used + 64 < sizeof(request->headers); h++) {
+        used += (size_t)snprintf(request->headers + used, sizeof(request->headers) - used,
+                                 "%sX-Bench-Header-%02d: value-%d-%d",
+                                 h ? "\n" : "", h, index, h);
+    }
+
+    used = 0;
+    used += (size_t)snprintf(request->body, sizeof(request->body), "{\n  \"items\": [\n");
+    for (int i = 0; used + 96 < sizeof(request->body); i++) {
+        used += (size_t)snprintf(request->body + used, sizeof(request->body) - used,
+                                 "    {\"id\": %d, \"name\": \"item-%d\", \"active\": true},\n", i, i);
+    }
+    snprintf(request->body + used, sizeof(request->body) - used, "    {}\n  ]\n}");
+}
+
+static size_t file_size(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size > 0 ? (size_t)size : 0;
+}
+
+/* ============================================================================
+ * CASES
+ * ============================================================================ */
+
+static void bench_parse_file(const bench_options_t *options, const char *path, int iterations) {
+    http_collection_t *collection = malloc(sizeof(http_collection_t));
+    size_t size = file_size(path);
+    bench_samples_t samples;
+    bench_samples_init(&samples, (size_t)iterations);
+
+    // Warm the page cache
+    http_parse_file(path, collection);
+
+    bench_alloc_reset();
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        uint64_t t0 = bench_now_ns();
+        http_parse_file(path, collection);
+        bench_samples_add(&samples, bench_now_ns() - t0);
+    }
+    bench_result_t result = {
+        .suite = SUITE, .name = "parse_file",
+        .operations = (uint64_t)iterations,
+        .bytes = (uint64_t)size * (uint64_t)iterations,
+        .elapsed_ns = bench_now_ns() - start,
+        .allocs = bench_alloc_read()
+    };
+
+    bench_report(options, &result, &samples);
+    bench_samples_free(&samples);
+    free(collection);
+}
+
+static void bench_save_file(const bench_options_t *options, const char *path,
+                            const http_collection_t *collection, int iterations) {
+    bench_samples_t samples;
+    bench_samples_init(&samples, (size_t)iterations);
+    uint64_t bytes = 0;
+
+    bench_alloc_reset();
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        uint64_t t0 = bench_now_ns();
+        http_save_file(path, collection);
+        bench_samples_add(&samples, bench_now_ns() - t0);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_alloc_stats_t allocs = bench_alloc_read();
+    bytes = (uint64_t)file_size(path) * (uint64_t)iterations;
+
+    bench_result_t result = {
+        .suite = SUITE, .name = "save_file",
+        .operations = (uint64_t)iterations,
+        .bytes = bytes,
+        .elapsed_ns = elapsed,
+        .allocs = allocs
+    };
+
+    bench_report(options, &result, &samples);
+    bench_samples_free(&samples);
+}
+
+static void bench_format_request(const bench_options_t *options,
+                                 const http_collection_t *collection, int iterations) {
+    char *buffer = malloc(8192);
+    bench_samples_t samples;
+    bench_samples_init(&samples, (size_t)iterations);
+    uint64_t bytes = 0;
+
+    bench_alloc_reset();
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        const http_request_t *request = &collection->requests[i % collection->count];
+        uint64_t t0 = bench_now_ns();
+        http_format_request(request, buffer, 8192);
+        bench_samples_add(&samples, bench_now_ns() - t0);
+        bytes += strlen(buffer);
+    }
+    bench_result_t result = {
+        .suite = SUITE, .name = "format_request",
+        .operations = (uint64_t)iterations,
+        .bytes = bytes,
+        .elapsed_ns = bench_now_ns() - start,
+        .allocs = bench_alloc_read()
+    };
+
+    bench_report(options, &result, &samples);
+    bench_samples_free(&samples);
+    free(buffer);
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv) {
+    bench_options_t options;
+    bench_parse_args(argc, argv, &options);
+
+    char dir[512];
+    if (bench_make_temp_dir(dir, sizeof(dir), "apikit-bench-parser") != 0) {
+        printf("Failed to create scratch directory\n");
+        return 1;
+    }
+
+    // A full collection with every field near capacity; the parser holds a
+    // fixed number of requests per file, so file size grows via field size
+    http_collection_t *collection = malloc(sizeof(http_collection_t));
+    http_collection_clear(collection);
+    for (int i = 0; i < COLLECTION_CAPACITY; i++) {
+        http_request_t request;
+        make_request(&request, i);
+        http_collection_add(collection, &request);
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/synthetic.http", dir);
+    if (http_save_file(path, collection) != 0) {
+        printf("Failed to write %s\n", path);
+        bench_remove_temp_dir(dir);
+        return 1;
+    }
+
+    int file_iterations = options.iterations ? options.iterations : (options.quick ? 20 : 500);
+    int format_iterations = options.iterations ? options.iterations : (options.quick ? 1000 : 100000);
+
+    bench_parse_file(&options, path, file_iterations);
+    bench_save_file(&options, path, collection, file_iterations);
+    bench_format_request(&options, collection, format_iterations);
+
+    free(collection);
+    bench_remove_temp_dir(dir);
+    return 0;
+}
@@ -0,0 +1,142 @@
+/* ============================================================================
+ * API Kit - Store Persistence Benchmark
+ *
+ * Fills the store with a full history and full workspaces, then measures
+ * saving, loading and the save-per-entry cost of appending to history.
+ * ============================================================================ */
+
+#include "bench_common.h"
+#include "store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SUITE "store_persist"
+
+/* ============================================================================
+ * WORKLOAD GENERATION
+ * ============================================================================ */
+
+static void fill_history(app_state_t *state) {
+    static const char *methods[] = {"GET", "POST", "PUT", "DELETE", "PATCH"};
+
+    state->history_count = 0;
+    for (int i = 0; i < MAX_HISTORY_ITEMS; i++) {
+        history_item_t *item = &state->history[state->history_count++];
+        snprintf(item->method, sizeof(item->method), "%s", methods[i % 5]);
+        snprintf(item->url, sizeof(item->url),
+                 "https://api.example.com/v1/orders/%d?expand=customer,items&trace=%08x", i, i * 2654435761u);
+        snprintf(item->timestamp, sizeof(item->timestamp), "%02d:%02d:%02d", i / 3600, (i / 60) % 60, i % 60);
+        item->status_code = (i % 17 == 0) ? 500 : 200;
+    }
+}
+
+static void fill_workspaces(app_state_t *state, const char *dir) {
+    state->workspace_count = MAX_WORKSPACES;
+    state->active_workspace = 0;
+
+    for (int w = 0; w < MAX_WORKSPACES; w++) {
+        workspace_t *workspace = &state->workspaces[w];
+        snprintf(workspace->name, sizeof(workspace->name), "Workspace %d", w);
+        snprintf(workspace->filename, sizeof(workspace->filename), "%s/workspace_%d.http", dir, w);
+        workspace->collection_count = MAX_COLLECTIONS_PER_WORKSPACE;
+
+        for (int c = 0; c < MAX_COLLECTIONS_PER_WORKSPACE; c++) {
+            collection_t *collection = &workspace->collections[c];
+            snprintf(collection->name, sizeof(collection->name), "Collection %d", c);
+            collection->request_count = MAX_REQUESTS_PER_COLLECTION;
+
+            for (int r = 0; r < MAX_REQUESTS_PER_COLLECTION; r++) {
+                request_item_t *item = &collection->requests[r];
+                snprintf(item->name, sizeof(item->name), "Request %d", r);
+                snprintf(item->method, sizeof(item->method), "%s", r % 2 ? "POST" : "GET");
+                snprintf(item->url, sizeof(item->url), "https://api.example.com/v1/w%d/c%d/r%d", w, c, r);
+                snprintf(item->headers, sizeof(item->headers),
+                         "Content-Type: application/json\nAccept: application/json\nX-Request-Id: %d-%d-%d", w, c, r);
+                snprintf(item->body, sizeof(item->body),
+                         "{\"workspace\": %d, \"collection\": %d, \"request\": %d, \"payload\": \"%0200d\"}", w, c, r, 0);
+            }
+        }
+    }
+}
+
+/* ============================================================================
+ * CASES
+ * ============================================================================ */
+
+typedef void (*store_case_fn)(app_state_t *state, int iteration);
+
+static void run_case(const bench_options_t *options, const char *name, store_case_fn fn,
+                     app_state_t *state, int iterations) {
+    bench_samples_t samples;
+    bench_samples_init(&samples, (size_t)iterations);
+
+    bench_alloc_reset();
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        uint64_t t0 = bench_now_ns();
+        fn(state, i);
+        bench_samples_add(&samples, bench_now_ns() - t0);
+    }
+    bench_result_t result = {
+        .suite = SUITE, .name = name,
+        .operations = (uint64_t)iterations,
+        .elapsed_ns = bench_now_ns() - start,
+        .allocs = bench_alloc_read()
+    };
+
+    bench_report(options, &result, &samples);
+    bench_samples_free(&samples);
+}
+
+static void case_save(app_state_t *state, int iteration) {
+    (void)state;
+    (void)iteration;
+    store_save_data();
+}
+
+static void case_load(app_state_t *state, int iteration) {
+    (void)state;
+    (void)iteration;
+    store_load_data();
+}
+
+// Every history append rewrites history.http, the latency trends and all workspace files
+static void case_history_append(app_state_t *state, int iteration) {
+    if (state->history_count >= MAX_HISTORY_ITEMS) {
+        state->history_count = MAX_HISTORY_ITEMS / 2;
+    }
+    store_add_to_history("GET", "https://api.example.com/v1/health", 200 + iteration % 5, 1000 + (uint64_t)iteration % 97);
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv) {
+    bench_options_t options;
+    bench_parse_args(argc, argv, &options);
+
+    char dir[512];
+    if (bench_make_temp_dir(dir, sizeof(dir), "apikit-bench-store") != 0) {
+        printf("Failed to create scratch directory\n");
+        return 1;
+    }
+
+    app_state_t *state = store_get_state();
+    snprintf(state->settings.data_folder_path, sizeof(state->settings.data_folder_path), "%s", dir);
+    fill_history(state);
+    fill_workspaces(state, dir);
+
+    int iterations = options.iterations ? options.iterations : (options.quick ? 5 : 100);
+
+    run_case(&options, "save_data", case_save, state, iterations);
+    run_case(&options, "load_data", case_load, state, iterations);
+
+    // Loading replaces the workspaces with what the parser read back
+    fill_workspaces(state, dir);
+    run_case(&options, "history_append", case_history_append, state, iterations);
+
+    bench_remove_temp_dir(dir);
+    return 0;
+}
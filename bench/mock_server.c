@@ -0,0 +1,719 @@
+/* ============================================================================
+ * API Kit - Mock HTTP Server Implementation
+ *
+ * Each worker thread owns an SO_REUSEPORT listening socket, an epoll
+ * instance and the connections it accepted, so workers share nothing but
+ * the read-only response body. Connections are non-blocking and
+ * level-triggered; pipelined requests are answered in order, with small
+ * responses batched into one output buffer and large bodies sent straight
+ * from the shared body with writev. Delayed responses park the connection
+ * on a per-worker min-heap of deadlines that drives the epoll timeout.
+ * ============================================================================ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // memmem, accept4
+#endif
+
+#include "mock_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define MAX_EVENTS 256
+#define MAX_HEADER_SIZE (64 * 1024)
+#define MAX_REQUEST_SIZE (64 * 1024 * 1024)
+#define INLINE_BODY_MAX (16 * 1024)     // Larger bodies are sent by reference
+#define OUT_FLUSH_THRESHOLD (64 * 1024) // Flush batched responses at this size
+#define DEFAULT_MAX_RESPONSE (64 * 1024 * 1024)
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct mock_worker mock_worker_t;
+
+typedef struct mock_conn {
+    int fd;
+    mock_worker_t *worker;
+
+    char *in;
+    size_t in_off, in_len, in_cap;
+
+    char *out;
+    size_t out_off, out_len, out_cap;
+    const char *body;        // Large body being sent by reference
+    size_t body_left;
+
+    // Response held back by injected latency
+    int has_pending;
+    int pending_status;
+    size_t pending_size;
+    int pending_head;
+    uint64_t ready_at_ns;    // 0 = not waiting
+    long heap_index;         // Position in the worker's timer heap, -1 if absent
+
+    int close_after;         // Close once the current output is flushed
+    int want_write;          // EPOLLOUT registered
+
+    struct mock_conn *prev, *next;
+} mock_conn_t;
+
+struct mock_worker {
+    mock_server_t *server;
+    pthread_t thread;
+    int listen_fd;
+    int epoll_fd;
+    uint64_t rng;
+
+    mock_conn_t *conns;
+    mock_conn_t **timers;
+    size_t timer_count, timer_cap;
+
+    uint64_t connections, requests, errors, drops, bytes_sent;
+};
+
+struct mock_server {
+    mock_server_config_t config;
+    int port;
+    int stop_fd;
+    char *body;              // max_response_size bytes of filler
+    int worker_count;
+    mock_worker_t *workers;
+};
+
+static void conn_close(mock_conn_t *conn);
+static void conn_progress(mock_conn_t *conn);
+
+/* ============================================================================
+ * UTILITIES
+ * ============================================================================ */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64* in [0, 1)
+static double rng_next(mock_worker_t *worker) {
+    worker->rng ^= worker->rng >> 12;
+    worker->rng ^= worker->rng << 25;
+    worker->rng ^= worker->rng >> 27;
+    uint64_t x = worker->rng * 2685821657736338717ull;
+    return (double)(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t sample_latency_us(mock_worker_t *worker, const mock_latency_t *latency) {
+    switch (latency->kind) {
+        case MOCK_LATENCY_FIXED:
+            return latency->base_us;
+        case MOCK_LATENCY_UNIFORM:
+            return latency->base_us + (uint64_t)(rng_next(worker) * ((double)latency->spread_us + 1.0));
+        case MOCK_LATENCY_EXPONENTIAL:
+            return (uint64_t)(-log(1.0 - rng_next(worker)) * (double)latency->base_us);
+        case MOCK_LATENCY_NONE:
+        default:
+            return 0;
+    }
+}
+
+static const char *status_reason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default:  return "Status";
+    }
+}
+
+static void stat_add(uint64_t *counter, uint64_t value) {
+    __atomic_add_fetch(counter, value, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ * TIMER HEAP
+ * ============================================================================ */
+
+static void heap_swap(mock_worker_t *worker, size_t a, size_t b) {
+    mock_conn_t *tmp = worker->timers[a];
+    worker->timers[a] = worker->timers[b];
+    worker->timers[b] = tmp;
+    worker->timers[a]->heap_index = (long)a;
+    worker->timers[b]->heap_index = (long)b;
+}
+
+static void heap_sift_up(mock_worker_t *worker, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (worker->timers[parent]->ready_at_ns <= worker->timers[i]->ready_at_ns) break;
+        heap_swap(worker, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_sift_down(mock_worker_t *worker, size_t i) {
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < worker->timer_count &&
+            worker->timers[left]->ready_at_ns < worker->timers[smallest]->ready_at_ns) smallest = left;
+        if (right < worker->timer_count &&
+            worker->timers[right]->ready_at_ns < worker->timers[smallest]->ready_at_ns) smallest = right;
+        if (smallest == i) break;
+        heap_swap(worker, i, smallest);
+        i = smallest;
+    }
+}
+
+static int heap_push(mock_worker_t *worker, mock_conn_t *conn) {
+    if (worker->timer_count == worker->timer_cap) {
+        size_t capacity = worker->timer_cap ? worker->timer_cap * 2 : 64;
+        mock_conn_t **grown = realloc(worker->timers, capacity * sizeof(mock_conn_t *));
+        if (!grown) return -1;
+        worker->timers = grown;
+        worker->timer_cap = capacity;
+    }
+    conn->heap_index = (long)worker->timer_count;
+    worker->timers[worker->timer_count++] = conn;
+    heap_sift_up(worker, (size_t)conn->heap_index);
+    return 0;
+}
+
+static void heap_remove(mock_worker_t *worker, mock_conn_t *conn) {
+    size_t i = (size_t)conn->heap_index;
+    size_t last = --worker->timer_count;
+    if (i != last) {
+        heap_swap(worker, i, last);
+        heap_sift_down(worker, i);
+        heap_sift_up(worker, i);
+    }
+    conn->heap_index = -1;
+}
+
+/* ============================================================================
+ * CONNECTION I/O
+ * ============================================================================ */
+
+static void conn_set_write_interest(mock_conn_t *conn, int want_write) {
+    if (conn->want_write == want_write) return;
+
+    struct epoll_event event = {
+        .events = EPOLLIN | (want_write ? EPOLLOUT : 0),
+        .data.ptr = conn
+    };
+    epoll_ctl(conn->worker->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    conn->want_write = want_write;
+}
+
+static int out_reserve(mock_conn_t *conn, size_t extra) {
+    if (conn->out_off > 0 && conn->out_off == conn->out_len) {
+        conn->out_off = conn->out_len = 0;
+    }
+    if (conn->out_len + extra <= conn->out_cap) return 0;
+
+    size_t capacity = conn->out_cap ? conn->out_cap : 4096;
+    while (capacity < conn->out_len + extra) capacity *= 2;
+    char *grown = realloc(conn->out, capacity);
+    if (!grown) return -1;
+    conn->out = grown;
+    conn->out_cap = capacity;
+    return 0;
+}
+
+// Write pending output; returns 1 when drained, 0 on EAGAIN, -1 on error
+static int conn_flush(mock_conn_t *conn) {
+    while (conn->out_len > conn->out_off || conn->body_left > 0) {
+        struct iovec iov[2];
+        int count = 0;
+        if (conn->out_len > conn->out_off) {
+            iov[count].iov_base = conn->out + conn->out_off;
+            iov[count].iov_len = conn->out_len - conn->out_off;
+            count++;
+        }
+        if (conn->body_left > 0) {
+            iov[count].iov_base = (void *)conn->body;
+            iov[count].iov_len = conn->body_left;
+            count++;
+        }
+
+        ssize_t n = writev(conn->fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        stat_add(&conn->worker->bytes_sent, (uint64_t)n);
+
+        size_t written = (size_t)n;
+        size_t head = conn->out_len - conn->out_off;
+        if (written >= head) {
+            conn->out_off = conn->out_len = 0;
+            written -= head;
+            conn->body += written;
+            conn->body_left -= written;
+        } else {
+            conn->out_off += written;
+        }
+    }
+    return 1;
+}
+
+static void conn_emit(mock_conn_t *conn, int status, size_t size, int head) {
+    mock_server_t *server = conn->worker->server;
+    int has_body = status != 204 && status != 304;
+    if (!has_body) size = 0;
+    if (size > server->config.max_response_size) size = server->config.max_response_size;
+
+    if (out_reserve(conn, 256 + (size <= INLINE_BODY_MAX ? size : 0)) != 0) {
+        conn->close_after = 1;
+        return;
+    }
+
+    conn->out_len += (size_t)snprintf(conn->out + conn->out_len, 256,
+                                      "HTTP/1.1 %d %s\r\n"
+                                      "Content-Type: text/plain\r\n"
+                                      "Content-Length: %zu\r\n"
+                                      "%s"
+                                      "\r\n",
+                                      status, status_reason(status), size,
+                                      conn->close_after ? "Connection: close\r\n" : "");
+
+    if (head || size == 0) return;
+    if (size <= INLINE_BODY_MAX) {
+        memcpy(conn->out + conn->out_len, server->body, size);
+        conn->out_len += size;
+    } else {
+        conn->body = server->body;
+        conn->body_left = size;
+    }
+}
+
+/* ============================================================================
+ * REQUEST HANDLING
+ * ============================================================================ */
+
+static uint64_t path_number(const char *path, size_t path_len, const char *prefix, int *found) {
+    size_t prefix_len = strlen(prefix);
+    if (path_len <= prefix_len || strncmp(path, prefix, prefix_len) != 0) return 0;
+    *found = 1;
+    return strtoull(path + prefix_len, NULL, 10);
+}
+
+// Parse one buffered request; returns 1 when handled, 0 if incomplete, -1 to close
+static int conn_handle_request(mock_conn_t *conn) {
+    mock_worker_t *worker = conn->worker;
+    const mock_server_config_t *config = &worker->server->config;
+    char *start = conn->in + conn->in_off;
+    size_t available = conn->in_len - conn->in_off;
+
+    char *end = memmem(start, available, "\r\n\r\n", 4);
+    if (!end) return available > MAX_HEADER_SIZE ? -1 : 0;
+    size_t header_len = (size_t)(end - start) + 4;
+
+    // Request line
+    char *line_end = memchr(start, '\r', header_len);
+    char *method_end = memchr(start, ' ', (size_t)(line_end - start));
+    if (!method_end) return -1;
+    char *path = method_end + 1;
+    char *path_end = memchr(path, ' ', (size_t)(line_end - path));
+    if (!path_end) return -1;
+    int head = (method_end - start == 4 && strncmp(start, "HEAD", 4) == 0);
+    int keep_alive = !(line_end - path_end >= 9 && strncmp(path_end + 1, "HTTP/1.0", 8) == 0);
+
+    // Headers
+    size_t content_length = 0;
+    int chunked = 0;
+    char *line = line_end + 2;
+    while (line < end) {
+        char *next = memchr(line, '\r', (size_t)(end - line) + 1);
+        size_t len = (size_t)(next - line);
+        if (len > 15 && strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = (size_t)strtoull(line + 15, NULL, 10);
+        } else if (len > 11 && strncasecmp(line, "Connection:", 11) == 0) {
+            const char *value = line + 11;
+            while (*value == ' ') value++;
+            if (strncasecmp(value, "close", 5) == 0) keep_alive = 0;
+            else if (strncasecmp(value, "keep-alive", 10) == 0) keep_alive = 1;
+        } else if (len > 18 && strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = 1;
+        }
+        line = next + 2;
+    }
+
+    if (content_length > MAX_REQUEST_SIZE) return -1;
+    if (available < header_len + content_length) return 0;
+    conn->in_off += header_len + content_length;
+
+    // Per-path overrides, then configured defaults and injected faults
+    size_t path_len = (size_t)(path_end - path);
+    int status = 200;
+    size_t size = config->response_size;
+    uint64_t delay_us = sample_latency_us(worker, &config->latency);
+    int found = 0;
+
+    uint64_t value = path_number(path, path_len, "/bytes/", &found);
+    if (found) size = (size_t)value;
+    found = 0;
+    value = path_number(path, path_len, "/status/", &found);
+    if (found) status = (int)value;
+    found = 0;
+    value = path_number(path, path_len, "/delay/", &found);
+    if (found) delay_us = value;
+
+    stat_add(&worker->requests, 1);
+
+    if (config->drop_rate > 0 && rng_next(worker) < config->drop_rate) {
+        stat_add(&worker->drops, 1);
+        return -1;
+    }
+    if (config->error_rate > 0 && rng_next(worker) < config->error_rate) {
+        stat_add(&worker->errors, 1);
+        status = config->error_status;
+        size = 0;
+    }
+    if (chunked) {
+        // Chunked request bodies are not supported; answer and close
+        status = 501;
+        size = 0;
+        keep_alive = 0;
+    }
+
+    conn->close_after = !keep_alive;
+    conn->has_pending = 1;
+    conn->pending_status = status;
+    conn->pending_size = size;
+    conn->pending_head = head;
+
+    if (delay_us > 0) {
+        conn->ready_at_ns = now_ns() + delay_us * 1000ull;
+        if (heap_push(worker, conn) != 0) conn->ready_at_ns = 0;
+    }
+    return 1;
+}
+
+// Answer as many buffered requests as possible without blocking
+static void conn_progress(mock_conn_t *conn) {
+    for (;;) {
+        if (conn->ready_at_ns) {
+            // Waiting for injected latency; drain earlier responses meanwhile
+            int flushed = conn_flush(conn);
+            if (flushed < 0) { conn_close(conn); return; }
+            conn_set_write_interest(conn, !flushed);
+            return;
+        }
+
+        if (conn->has_pending) {
+            conn->has_pending = 0;
+            conn_emit(conn, conn->pending_status, conn->pending_size, conn->pending_head);
+        }
+
+        if (conn->body_left > 0 || conn->out_len - conn->out_off >= OUT_FLUSH_THRESHOLD || conn->close_after) {
+            int flushed = conn_flush(conn);
+            if (flushed < 0) { conn_close(conn); return; }
+            if (!flushed) { conn_set_write_interest(conn, 1); return; }
+            if (conn->close_after) { conn_close(conn); return; }
+        }
+
+        int handled = conn_handle_request(conn);
+        if (handled < 0) { conn_close(conn); return; }
+        if (handled == 0) {
+            int flushed = conn_flush(conn);
+            if (flushed < 0) { conn_close(conn); return; }
+            conn_set_write_interest(conn, !flushed);
+            return;
+        }
+    }
+}
+
+// Read everything available; returns -1 when the peer closed or failed
+static int conn_read(mock_conn_t *conn) {
+    for (;;) {
+        if (conn->in_off == conn->in_len) {
+            conn->in_off = conn->in_len = 0;
+        } else if (conn->in_off > 0 && conn->in_len == conn->in_cap) {
+            memmove(conn->in, conn->in + conn->in_off, conn->in_len - conn->in_off);
+            conn->in_len -= conn->in_off;
+            conn->in_off = 0;
+        }
+        if (conn->in_len == conn->in_cap) {
+            if (conn->in_cap >= MAX_REQUEST_SIZE + MAX_HEADER_SIZE) return -1;
+            char *grown = realloc(conn->in, conn->in_cap * 2);
+            if (!grown) return -1;
+            conn->in = grown;
+            conn->in_cap *= 2;
+        }
+
+        ssize_t n = recv(conn->fd, conn->in + conn->in_len, conn->in_cap - conn->in_len, 0);
+        if (n > 0) {
+            conn->in_len += (size_t)n;
+            if (conn->in_len < conn->in_cap) return 0;
+            continue;
+        }
+        if (n == 0) return -1;
+        if (errno == EINTR) continue;
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+}
+
+static void conn_close(mock_conn_t *conn) {
+    mock_worker_t *worker = conn->worker;
+
+    if (conn->heap_index >= 0) heap_remove(worker, conn);
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+
+    if (conn->prev) conn->prev->next = conn->next;
+    else worker->conns = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+
+    free(conn->in);
+    free(conn->out);
+    free(conn);
+}
+
+static void worker_accept(mock_worker_t *worker) {
+    for (;;) {
+        int fd = accept4(worker->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        mock_conn_t *conn = calloc(1, sizeof(mock_conn_t));
+        if (conn) conn->in = malloc(16 * 1024);
+        if (!conn || !conn->in) {
+            if (conn) free(conn);
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->worker = worker;
+        conn->in_cap = 16 * 1024;
+        conn->heap_index = -1;
+
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = conn};
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            free(conn->in);
+            free(conn);
+            close(fd);
+            continue;
+        }
+
+        conn->next = worker->conns;
+        if (worker->conns) worker->conns->prev = conn;
+        worker->conns = conn;
+        stat_add(&worker->connections, 1);
+    }
+}
+
+/* ============================================================================
+ * WORKER THREAD
+ * ============================================================================ */
+
+static void *worker_main(void *arg) {
+    mock_worker_t *worker = arg;
+    mock_server_t *server = worker->server;
+    struct epoll_event events[MAX_EVENTS];
+
+    for (;;) {
+        int timeout_ms = -1;
+        if (worker->timer_count > 0) {
+            uint64_t now = now_ns();
+            uint64_t deadline = worker->timers[0]->ready_at_ns;
+            timeout_ms = deadline <= now ? 0 : (int)((deadline - now + 999999) / 1000000);
+        }
+
+        int count = epoll_wait(worker->epoll_fd, events, MAX_EVENTS, timeout_ms);
+        if (count < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < count; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &server->stop_fd) {
+                return NULL;
+            }
+            if (ptr == &worker->listen_fd) {
+                worker_accept(worker);
+                continue;
+            }
+
+            mock_conn_t *conn = ptr;
+            if (events[i].events & EPOLLIN) {
+                if (conn_read(conn) != 0) {
+                    conn_close(conn);
+                    continue;
+                }
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                conn_close(conn);
+                continue;
+            }
+            conn_progress(conn);
+        }
+
+        // Release responses whose injected latency has elapsed
+        uint64_t now = now_ns();
+        while (worker->timer_count > 0 && worker->timers[0]->ready_at_ns <= now) {
+            mock_conn_t *conn = worker->timers[0];
+            heap_remove(worker, conn);
+            conn->ready_at_ns = 0;
+            conn_progress(conn);
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * SERVER LIFECYCLE
+ * ============================================================================ */
+
+static int open_listener(const char *address, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1 ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, 1024) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void worker_cleanup(mock_worker_t *worker) {
+    while (worker->conns) conn_close(worker->conns);
+    free(worker->timers);
+    if (worker->epoll_fd >= 0) close(worker->epoll_fd);
+    if (worker->listen_fd >= 0) close(worker->listen_fd);
+}
+
+mock_server_t *mock_server_start(const mock_server_config_t *config) {
+    mock_server_t *server = calloc(1, sizeof(mock_server_t));
+    if (!server) return NULL;
+
+    if (config) server->config = *config;
+    if (!server->config.bind_address) server->config.bind_address = "127.0.0.1";
+    if (server->config.threads <= 0) server->config.threads = 1;
+    if (server->config.error_status <= 0) server->config.error_status = 500;
+    if (server->config.max_response_size == 0) server->config.max_response_size = DEFAULT_MAX_RESPONSE;
+    if (server->config.response_size > server->config.max_response_size) {
+        server->config.max_response_size = server->config.response_size;
+    }
+
+    server->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    server->body = malloc(server->config.max_response_size);
+    server->workers = calloc((size_t)server->config.threads, sizeof(mock_worker_t));
+    if (server->stop_fd < 0 || !server->body || !server->workers) {
+        if (server->stop_fd >= 0) close(server->stop_fd);
+        free(server->body);
+        free(server->workers);
+        free(server);
+        return NULL;
+    }
+    memset(server->body, 'x', server->config.max_response_size);
+
+    // The first listener picks the port; the others share it via SO_REUSEPORT
+    server->port = server->config.port;
+    for (int i = 0; i < server->config.threads; i++) {
+        mock_worker_t *worker = &server->workers[i];
+        worker->server = server;
+        worker->rng = 0x9E3779B97F4A7C15ull * (uint64_t)(i + 1) ^ now_ns();
+        worker->listen_fd = open_listener(server->config.bind_address, server->port);
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+        int ok = worker->listen_fd >= 0 && worker->epoll_fd >= 0;
+        if (ok && server->port == 0) {
+            struct sockaddr_in addr;
+            socklen_t addr_len = sizeof(addr);
+            ok = getsockname(worker->listen_fd, (struct sockaddr *)&addr, &addr_len) == 0;
+            server->port = ntohs(addr.sin_port);
+        }
+        if (ok) {
+            struct epoll_event listen_event = {.events = EPOLLIN, .data.ptr = &worker->listen_fd};
+            struct epoll_event stop_event = {.events = EPOLLIN, .data.ptr = &server->stop_fd};
+            ok = epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->listen_fd, &listen_event) == 0 &&
+                 epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, server->stop_fd, &stop_event) == 0;
+        }
+        if (ok) {
+            ok = pthread_create(&worker->thread, NULL, worker_main, worker) == 0;
+        }
+        if (!ok) {
+            worker_cleanup(worker);
+            server->worker_count = i;
+            mock_server_stop(server);
+            return NULL;
+        }
+        server->worker_count = i + 1;
+    }
+
+    return server;
+}
+
+int mock_server_port(const mock_server_t *server) {
+    return server->port;
+}
+
+mock_server_stats_t mock_server_stats(const mock_server_t *server) {
+    mock_server_stats_t stats = {0};
+    for (int i = 0; i < server->worker_count; i++) {
+        const mock_worker_t *worker = &server->workers[i];
+        stats.connections += __atomic_load_n(&worker->connections, __ATOMIC_RELAXED);
+        stats.requests += __atomic_load_n(&worker->requests, __ATOMIC_RELAXED);
+        stats.errors_injected += __atomic_load_n(&worker->errors, __ATOMIC_RELAXED);
+        stats.drops_injected += __atomic_load_n(&worker->drops, __ATOMIC_RELAXED);
+        stats.bytes_sent += __atomic_load_n(&worker->bytes_sent, __ATOMIC_RELAXED);
+    }
+    return stats;
+}
+
+void mock_server_stop(mock_server_t *server) {
+    if (!server) return;
+
+    // The eventfd stays readable, so every worker sees the stop request
+    uint64_t one = 1;
+    if (write(server->stop_fd, &one, sizeof(one)) < 0) {
+        perror("mock_server_stop");
+    }
+    for (int i = 0; i < server->worker_count; i++) {
+        pthread_join(server->workers[i].thread, NULL);
+        worker_cleanup(&server->workers[i]);
+    }
+
+    close(server->stop_fd);
+    free(server->body);
+    free(server->workers);
+    free(server);
+}
@@ -0,0 +1,94 @@
+/* ============================================================================
+ * API Kit - Mock HTTP Server
+ *
+ * Multi-threaded epoll HTTP/1.1 server used by benchmarks and load runs.
+ * Supports keep-alive and pipelining, binds an ephemeral loopback port by
+ * default, and can shape responses with a configurable body size, latency
+ * distribution and error injection. Linux only.
+ *
+ * Request paths can override the configuration per request:
+ *   /bytes/N     respond with an N byte body
+ *   /status/N    respond with status N
+ *   /delay/US    hold the response for US microseconds
+ * Any other path gets the configured defaults.
+ * ============================================================================ */
+
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+// Shape of the injected response latency
+typedef enum {
+    MOCK_LATENCY_NONE,
+    MOCK_LATENCY_FIXED,        // Always base_us
+    MOCK_LATENCY_UNIFORM,      // Uniform in [base_us, base_us + spread_us]
+    MOCK_LATENCY_EXPONENTIAL   // Exponential with mean base_us
+} mock_latency_kind_t;
+
+typedef struct {
+    mock_latency_kind_t kind;
+    uint32_t base_us;
+    uint32_t spread_us;
+} mock_latency_t;
+
+typedef struct {
+    const char *bind_address;  // NULL = 127.0.0.1
+    int port;                  // 0 = ephemeral
+    int threads;               // Event loop threads (0 = 1)
+    size_t response_size;      // Default body size in bytes
+    size_t max_response_size;  // Largest body /bytes/N may request (0 = 64MB)
+    mock_latency_t latency;
+    double error_rate;         // Fraction of requests answered with error_status
+    int error_status;          // Status for injected errors (0 = 500)
+    double drop_rate;          // Fraction of requests answered by closing the connection
+} mock_server_config_t;
+
+// Counters summed over all worker threads
+typedef struct {
+    uint64_t connections;
+    uint64_t requests;
+    uint64_t errors_injected;
+    uint64_t drops_injected;
+    uint64_t bytes_sent;
+} mock_server_stats_t;
+
+typedef struct mock_server mock_server_t;
+
+/* ============================================================================
+ * MOCK SERVER API
+ * ============================================================================ */
+
+/**
+ * @brief Start the server and its worker threads
+ * @param config Server configuration (NULL for defaults)
+ * @return Server handle, or NULL if the socket or threads could not be created
+ */
+mock_server_t *mock_server_start(const mock_server_config_t *config);
+
+/**
+ * @brief Port the server is listening on
+ * @param server Server handle
+ * @return Port number
+ */
+int mock_server_port(const mock_server_t *server);
+
+/**
+ * @brief Snapshot of the server counters
+ * @param server Server handle
+ * @return Counters since start
+ */
+mock_server_stats_t mock_server_stats(const mock_server_t *server);
+
+/**
+ * @brief Stop the workers, close every connection and free the server
+ * @param server Server handle (may be NULL)
+ */
+void mock_server_stop(mock_server_t *server);
+
+#endif // MOCK_SERVER_H
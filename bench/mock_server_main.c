@@ -0,0 +1,120 @@
+/* ============================================================================
+ * API Kit - Mock HTTP Server CLI
+ *
+ * Standalone wrapper around mock_server for load runs against a local
+ * stand-in. Prints the listening port, serves until SIGINT/SIGTERM and then
+ * prints the request counters.
+ * ============================================================================ */
+
+#include "mock_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+
+static void usage(const char *program) {
+    printf("Usage: %s [options]\n"
+           "  --bind ADDRESS          Listen address (default 127.0.0.1)\n"
+           "  --port N                Port (default: ephemeral)\n"
+           "  --threads N             Event loop threads (default 1)\n"
+           "  --size BYTES            Default response body size (default 0)\n"
+           "  --max-size BYTES        Largest body /bytes/N may request\n"
+           "  --latency SPEC          fixed:US | uniform:MIN_US:MAX_US | exp:MEAN_US\n"
+           "  --error-rate FRACTION   Answer this fraction with --error-status\n"
+           "  --error-status N        Status for injected errors (default 500)\n"
+           "  --drop-rate FRACTION    Close the connection for this fraction\n",
+           program);
+}
+
+static int parse_latency(const char *spec, mock_latency_t *latency) {
+    unsigned a = 0, b = 0;
+    if (sscanf(spec, "fixed:%u", &a) == 1) {
+        latency->kind = MOCK_LATENCY_FIXED;
+        latency->base_us = a;
+    } else if (sscanf(spec, "uniform:%u:%u", &a, &b) == 2 && b >= a) {
+        latency->kind = MOCK_LATENCY_UNIFORM;
+        latency->base_us = a;
+        latency->spread_us = b - a;
+    } else if (sscanf(spec, "exp:%u", &a) == 1) {
+        latency->kind = MOCK_LATENCY_EXPONENTIAL;
+        latency->base_us = a;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    mock_server_config_t config = {0};
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+
+        if (strcmp(arg, "--bind") == 0) {
+            config.bind_address = value;
+        } else if (strcmp(arg, "--port") == 0) {
+            config.port = atoi(value);
+        } else if (strcmp(arg, "--threads") == 0) {
+            config.threads = atoi(value);
+        } else if (strcmp(arg, "--size") == 0) {
+            config.response_size = (size_t)strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--max-size") == 0) {
+            config.max_response_size = (size_t)strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--latency") == 0) {
+            if (parse_latency(value, &config.latency) != 0) {
+                printf("Invalid latency: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(arg, "--error-rate") == 0) {
+            config.error_rate = atof(value);
+        } else if (strcmp(arg, "--error-status") == 0) {
+            config.error_status = atoi(value);
+        } else if (strcmp(arg, "--drop-rate") == 0) {
+            config.drop_rate = atof(value);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Block the stop signals before the workers start so only sigwait sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    mock_server_t *server = mock_server_start(&config);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+
+    printf("Mock server listening on http://%s:%d\n",
+           config.bind_address ? config.bind_address : "127.0.0.1", mock_server_port(server));
+    fflush(stdout);
+
+    int signal_number;
+    sigwait(&signals, &signal_number);
+
+    mock_server_stats_t stats = mock_server_stats(server);
+    mock_server_stop(server);
+
+    printf("connections %llu, requests %llu, injected errors %llu, injected drops %llu, bytes sent %llu\n",
+           (unsigned long long)stats.connections, (unsigned long long)stats.requests,
+           (unsigned long long)stats.errors_injected, (unsigned long long)stats.drops_injected,
+           (unsigned long long)stats.bytes_sent);
+    return 0;
+}
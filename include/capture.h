@@ -0,0 +1,80 @@
+/* ============================================================================
+ * API Kit - Response Captures
+ *
+ * "# @capture" directives in a request's header block copy values from its
+ * response into template variables, so later requests can use them:
+ *
+ *   POST {{host}}/login
+ *   # @capture token = body $.access_token
+ *   # @capture session = header Set-Cookie
+ *   # @capture login_status = status
+ *
+ * Directive lines are comments, so they are never sent as headers.
+ * ============================================================================ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "http_client.h"
+#include "json_path.h"
+#include "template.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define MAX_CAPTURES 16
+#define CAPTURE_DIRECTIVE "# @capture"
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef enum {
+    CAPTURE_STATUS,     // Status code of the response
+    CAPTURE_HEADER,     // Value of a response header (the last one if repeated)
+    CAPTURE_BODY        // JSON path into the body; "$" is the whole body
+} capture_source_t;
+
+typedef struct {
+    char variable[64];
+    capture_source_t source;
+    char header[128];   // CAPTURE_HEADER only
+    json_path_t path;   // CAPTURE_BODY only
+} capture_t;
+
+typedef struct {
+    int count;
+    capture_t items[MAX_CAPTURES];
+} capture_list_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Collect the capture directives in a header block
+ *
+ * Lines are "# @capture NAME = status", "# @capture NAME = header HEADER" or
+ * "# @capture NAME = body [PATH]". Malformed directives are skipped.
+ *
+ * @param headers Header text (may be NULL)
+ * @param list List to fill (cleared first)
+ * @return Number of captures
+ */
+int capture_parse(const char *headers, capture_list_t *list);
+
+/**
+ * @brief Copy captured values from a response into variables
+ *
+ * Captures whose value is missing (no such header, path not in the body)
+ * leave the variable unchanged.
+ *
+ * @param list Captures
+ * @param response Response to read
+ * @param vars Variables to set
+ * @return Number of variables set
+ */
+int capture_apply(const capture_list_t *list, const http_response_t *response, template_vars_t *vars);
+
+#endif // CAPTURE_H
@@ -0,0 +1,168 @@
+/* ============================================================================
+ * API Kit - Collection Runner
+ *
+ * Runs a list of requests as a dependency graph on the async engine.
+ * A request depends on an earlier one when it uses a {{variable}} that the
+ * earlier one captures ("# @capture"), and on any request it names in a
+ * "# @depends-on NAME" directive. Requests whose dependencies are done run
+ * in parallel, so a run takes about as long as its critical path.
+ * Later captures of a variable also wait for earlier readers of it, so
+ * every request sees the same values it would in a sequential run.
+ * ============================================================================ */
+
+#ifndef COLLECTION_RUNNER_H
+#define COLLECTION_RUNNER_H
+
+#include <stdint.h>
+#include "http_parser.h"
+#include "template.h"
+#include "http_engine.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define RUN_DEPENDS_DIRECTIVE "# @depends-on"
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef enum {
+    RUN_PENDING,        // Waiting for dependencies
+    RUN_RUNNING,
+    RUN_PASSED,         // Response with status < 400
+    RUN_FAILED,         // Transport error or status >= 400
+    RUN_SKIPPED         // A dependency failed or is part of a cycle
+} run_state_t;
+
+typedef struct {
+    run_state_t state;
+    long status_code;
+    char error[128];
+    uint64_t body_size;         // Decoded body bytes
+    uint64_t wire_size;         // Body bytes as transferred (compressed)
+    int attempts;               // Transfers made, including retries and hedges
+    uint64_t start_ns;          // Offsets from the start of the run
+    uint64_t end_ns;
+    int dependency_count;
+    const int *dependencies;    // Indices of the requests this one waited for
+} run_result_t;
+
+typedef struct collection_run collection_run_t;
+
+// Called after each request finishes (passed, failed or skipped)
+typedef void (*run_progress_fn)(void *user_data, int index, const run_result_t *result);
+
+typedef struct {
+    int concurrency;            // Requests in flight at once (0 = no limit)
+    long timeout_ms;            // Per-request timeout (0 = none)
+    const http_retry_policy_t *retry;   // Retries and hedging (NULL = single attempt)
+    double rate;                // Requests started per second, all hosts (0 = no limit)
+    double host_rate;           // Requests started per second to each host (0 = no limit)
+    int host_connections;       // Requests in flight to each host (0 = no limit)
+    int warmup;                 // Connections per origin opened before the clock starts (0 = none)
+    const char *routes;         // "# @unix-socket"/"# @resolve"/"# @http-version" lines for every request (may be NULL)
+    int max_streams;            // Streams per HTTP/2 connection (see http_engine_set_multiplexing)
+    run_progress_fn on_result;  // Optional
+    void *user_data;
+} run_options_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Plan a run: compile every request and build the dependency graph
+ *
+ * @param requests Requests in file order (must outlive the run)
+ * @param count Number of requests
+ * @param vars Variables (environment values); captures are written here
+ * @return Run, or NULL on allocation failure
+ */
+collection_run_t *collection_run_create(const http_request_t *requests, int count, template_vars_t *vars);
+
+/**
+ * @brief Execute the run to completion
+ * @param run Planned run
+ * @param options Options (NULL for defaults)
+ * @return Number of requests that did not pass, or -1 if the engine failed
+ */
+int collection_run_execute(collection_run_t *run, const run_options_t *options);
+
+/**
+ * @brief Engine set up from run options
+ *
+ * Concurrency, retries, rate and host limits and multiplexing as
+ * collection_run_execute applies them, for runs started on a shared engine.
+ *
+ * @param options Options (NULL for defaults)
+ * @return Engine (free with http_engine_destroy), or NULL on failure
+ */
+http_engine_t *collection_run_engine_create(const run_options_t *options);
+
+/**
+ * @brief Start the run on an engine the caller drives
+ *
+ * Lets many runs share one engine and its connections, such as one run per
+ * data row. The caller turns the engine with http_engine_run and calls
+ * collection_run_pump on each started run after every turn. There is no
+ * warm-up, and connection statistics stay with the engine.
+ *
+ * @param run Planned run, not currently started
+ * @param engine Engine (must outlive the run's completion)
+ * @param options Options (NULL for defaults); engine settings in it are ignored
+ * @return 0 on success, -1 on invalid parameters
+ */
+int collection_run_start(collection_run_t *run, http_engine_t *engine, const run_options_t *options);
+
+/**
+ * @brief Check on a started run
+ *
+ * Requests are sent from the engine's completion callbacks as soon as
+ * their dependencies finish; this sends any left over and notices when
+ * the run is complete.
+ *
+ * @param run Run
+ * @return Requests in flight or ready to send; 0 once the run is complete
+ *         (results are final and the run can be started again)
+ */
+int collection_run_pump(collection_run_t *run);
+
+/**
+ * @brief Result of one request
+ */
+const run_result_t *collection_run_result(const collection_run_t *run, int index);
+
+/**
+ * @brief Wall time of the last execution
+ */
+uint64_t collection_run_elapsed_ns(const collection_run_t *run);
+
+/**
+ * @brief Connections opened by the warm-up of the last execution
+ */
+int collection_run_warm_connections(const collection_run_t *run);
+
+/**
+ * @brief Connections the last execution sent requests on, in order of first use
+ * @param run Run
+ * @param count Set to the number of connections
+ * @return Connection statistics (owned by the run), or NULL if there are none
+ */
+const http_connection_stats_t *collection_run_connections(const collection_run_t *run, int *count);
+
+/**
+ * @brief Longest chain of measured request durations along dependencies
+ *
+ * The lower bound for the run's wall time at unlimited concurrency.
+ */
+uint64_t collection_run_critical_path_ns(const collection_run_t *run);
+
+/**
+ * @brief Free a run
+ * @param run Run to free (may be NULL)
+ */
+void collection_run_destroy(collection_run_t *run);
+
+#endif // COLLECTION_RUNNER_H
@@ -0,0 +1,103 @@
+/* ============================================================================
+ * API Kit - Compiled Requests
+ *
+ * A request parsed once into the form libcurl consumes: method, URL, body
+ * and a ready-made header list. A compiled request is immutable after
+ * creation and can be sent any number of times (see http_request_compiled),
+ * so the per-send cost is only setting options on the handle.
+ *
+ * Directives in the header text route the request: "# @unix-socket PATH"
+ * connects through a Unix domain socket, and "# @resolve HOST:PORT:ADDRESS"
+ * connects to ADDRESS whenever the URL names HOST:PORT. Either way the URL,
+ * Host header and TLS server name stay those of the original host.
+ * "# @http-version 1.1|2|2-prior-knowledge" picks the protocol: HTTP/1.1
+ * only, HTTP/2 where TLS negotiates it (ALPN), or HTTP/2 without
+ * negotiation, also over plain TCP.
+ * ============================================================================ */
+
+#ifndef COMPILED_REQUEST_H
+#define COMPILED_REQUEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "http_client.h"
+
+#define ROUTE_UNIX_SOCKET_DIRECTIVE "# @unix-socket"
+#define ROUTE_RESOLVE_DIRECTIVE "# @resolve"
+#define ROUTE_HTTP_VERSION_DIRECTIVE "# @http-version"
+
+typedef struct compiled_request {
+    http_method_t method;
+    const char *method_name;      // "GET", "POST", ...
+    char *url;
+    char *body;                   // NULL when the request has no body
+    size_t body_size;
+    struct curl_slist *headers;   // Passed to CURLOPT_HTTPHEADER as is
+    int header_count;
+    long timeout_ms;              // 0 = no timeout
+    char *unix_socket;            // Unix domain socket to connect through, NULL = TCP
+    struct curl_slist *connect_to;  // Passed to CURLOPT_CONNECT_TO ("# @resolve" entries)
+    long http_version;            // CURL_HTTP_VERSION_*, NONE = libcurl's default
+    uint64_t source_hash;         // compiled_request_hash() of the source text
+} compiled_request_t;
+
+/**
+ * @brief Compile a request from editor/collection text
+ *
+ * Headers are newline-separated "Name: Value" lines. Surrounding whitespace
+ * and trailing '\r' are trimmed; blank lines, '#' comment lines and lines
+ * without ':' are skipped. There is no limit on the number of headers.
+ * Routing directives are read from the comment lines: the first
+ * "# @unix-socket" and "# @http-version" apply, and "# @resolve" entries
+ * are tried in order.
+ * When a body is given and no Content-Type header is present,
+ * "Content-Type: application/json" is added.
+ *
+ * @param method HTTP method
+ * @param url Request URL
+ * @param headers Header text (may be NULL)
+ * @param body Request body (NULL or empty for none)
+ * @param timeout_ms Transfer timeout in milliseconds (0 = none)
+ * @return Compiled request, or NULL on allocation failure
+ */
+compiled_request_t *compiled_request_create(http_method_t method, const char *url,
+                                            const char *headers, const char *body,
+                                            long timeout_ms);
+
+/**
+ * @brief Add default routing from a workspace or the command line
+ *
+ * Reads the routing directives of text (other lines are ignored). Its
+ * socket and HTTP version apply only if the request names none, and its resolve entries
+ * go after the request's own, so the request's directives take precedence.
+ *
+ * @param request Compiled request
+ * @param directives "# @unix-socket", "# @resolve" and "# @http-version" lines (may be NULL)
+ * @return 0 on success, -1 on allocation failure
+ */
+int compiled_request_add_routes(compiled_request_t *request, const char *directives);
+
+/**
+ * @brief Add another request's routing, as compiled_request_add_routes would
+ * @param request Compiled request
+ * @param source Request whose socket, HTTP version and resolve entries to add
+ * @return 0 on success, -1 on allocation failure
+ */
+int compiled_request_copy_routes(compiled_request_t *request, const compiled_request_t *source);
+
+/**
+ * @brief Free a compiled request
+ * @param request Request to free (may be NULL)
+ */
+void compiled_request_destroy(compiled_request_t *request);
+
+/**
+ * @brief Hash of the source text a request is compiled from
+ *
+ * Used to decide whether a cached compiled request is still current without
+ * recompiling it. NULL strings hash like empty strings.
+ */
+uint64_t compiled_request_hash(http_method_t method, const char *url,
+                               const char *headers, const char *body);
+
+#endif // COMPILED_REQUEST_H
@@ -0,0 +1,138 @@
+/* ============================================================================
+ * API Kit - Data Files
+ *
+ * Rows of parameters for data-driven runs, read from a CSV file (a header
+ * line of column names, then one row per line) or a JSONL file (one flat
+ * JSON object per line, member names as column names).
+ *
+ * The file is memory-mapped and never copied or indexed: it is split into
+ * fixed-size byte chunks, and a chunk yields the rows whose first byte lies
+ * in it, so workers can take chunks in any order and every row is read
+ * exactly once. Field values point into the mapping; only values that need
+ * unescaping (doubled CSV quotes, JSON escapes) are written to the row's
+ * own buffer. Rows are lines, so a CSV field cannot contain a line break.
+ * ============================================================================ */
+
+#ifndef DATA_FILE_H
+#define DATA_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define DATA_MAX_COLUMNS 64
+#define DATA_CHUNK_SIZE (4u << 20)      // Bytes of rows per chunk of work
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef enum {
+    DATA_FORMAT_CSV,
+    DATA_FORMAT_JSONL
+} data_format_t;
+
+typedef struct {
+    const char *name;           // Column name (not NUL-terminated)
+    size_t name_length;
+    const char *value;          // Not NUL-terminated; NULL for a JSON null
+    size_t value_length;
+} data_field_t;
+
+// One row; reuse it for the next one so its buffer is allocated once
+typedef struct {
+    uint64_t offset;            // Of the row's first byte in the file
+    int field_count;
+    data_field_t fields[DATA_MAX_COLUMNS];
+    char *buffer;               // Unescaped names and values
+    size_t capacity;
+} data_row_t;
+
+// Position in a chunk
+typedef struct {
+    const char *begin;          // First row of the chunk
+    const char *next;           // Next row to read
+    const char *end;            // Rows starting here or later belong to the next chunk
+} data_cursor_t;
+
+typedef struct data_file data_file_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Map a data file
+ *
+ * The format comes from the extension (.csv, .jsonl, .ndjson), or else
+ * from the first character: '{' for JSONL, anything else CSV. A CSV header
+ * is read here.
+ *
+ * @param path File to map
+ * @return File, or NULL if it cannot be read or a CSV header is missing
+ *         or has more than DATA_MAX_COLUMNS columns
+ */
+data_file_t *data_file_open(const char *path);
+
+/**
+ * @brief Unmap a data file
+ * @param file File (may be NULL)
+ */
+void data_file_close(data_file_t *file);
+
+/**
+ * @brief Format of a file
+ */
+data_format_t data_file_format(const data_file_t *file);
+
+/**
+ * @brief Size of the file in bytes
+ */
+uint64_t data_file_size(const data_file_t *file);
+
+/**
+ * @brief Number of chunks of chunk_size bytes the rows are split into
+ */
+uint64_t data_file_chunk_count(const data_file_t *file, uint64_t chunk_size);
+
+/**
+ * @brief Position a cursor on the rows of a chunk
+ * @param file File
+ * @param chunk_size Same as for data_file_chunk_count
+ * @param index Chunk, below data_file_chunk_count
+ * @param cursor Cursor to set
+ */
+void data_file_chunk(const data_file_t *file, uint64_t chunk_size, uint64_t index, data_cursor_t *cursor);
+
+/**
+ * @brief Read the next row of a chunk
+ *
+ * Blank lines are skipped. A malformed row (unterminated quote, wrong
+ * number of CSV fields, not a JSON object) is passed over, with its
+ * offset in row.
+ *
+ * @param file File
+ * @param cursor Chunk position, advanced past the row
+ * @param row Receives the row; values stay valid until row is read into again
+ * @return 1 for a row, 0 at the end of the chunk, -1 for a malformed row
+ */
+int data_file_next(const data_file_t *file, data_cursor_t *cursor, data_row_t *row);
+
+/**
+ * @brief Let the kernel drop a finished chunk's pages
+ *
+ * Keeps resident memory flat on files larger than RAM. The mapping stays
+ * valid; pages read again are faulted back in.
+ */
+void data_file_release(const data_file_t *file, const data_cursor_t *cursor);
+
+/**
+ * @brief Free a row's buffer
+ * @param row Row (may be NULL)
+ */
+void data_row_free(data_row_t *row);
+
+#endif // DATA_FILE_H
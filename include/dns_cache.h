@@ -0,0 +1,77 @@
+/* ============================================================================
+ * API Kit - DNS Cache
+ *
+ * Remembers the address each host:port was last reached at, with an
+ * expiry, and saves the list to a file so the next launch can hand it to
+ * libcurl (CURLOPT_RESOLVE) instead of resolving every host again.
+ * libcurl does not report DNS TTLs, so entries live a fixed time.
+ * ============================================================================ */
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <curl/curl.h>
+#include <time.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define DNS_CACHE_TTL_SECONDS 600   // Lifetime of an entry from when it was recorded
+#define DNS_CACHE_MAX_ENTRIES 256   // Oldest entries are dropped beyond this
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct dns_cache dns_cache_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Load a cache file, dropping expired entries
+ * @param path File to read; a missing or unreadable file gives an empty cache
+ * @return Cache, or NULL on allocation failure
+ */
+dns_cache_t *dns_cache_load(const char *path);
+
+/**
+ * @brief Write the unexpired entries to a file
+ * @return 0 on success, -1 on failure
+ */
+int dns_cache_save(const dns_cache_t *cache, const char *path);
+
+/**
+ * @brief Record the address a host was reached at
+ * @param cache Cache
+ * @param host Host name (IP literals are ignored)
+ * @param port Port
+ * @param address Numeric address from CURLINFO_PRIMARY_IP
+ * @param now Current time
+ */
+void dns_cache_record(dns_cache_t *cache, const char *host, long port, const char *address, time_t now);
+
+/**
+ * @brief Unexpired entries as a CURLOPT_RESOLVE list
+ *
+ * Entries use the "+host:port:address" form, so libcurl expires them from
+ * its own DNS cache like resolved names instead of pinning them.
+ *
+ * @return List (free with curl_slist_free_all), or NULL if empty
+ */
+struct curl_slist *dns_cache_resolve_list(const dns_cache_t *cache, time_t now);
+
+/**
+ * @brief Number of entries (expired ones included until the next save)
+ */
+int dns_cache_count(const dns_cache_t *cache);
+
+/**
+ * @brief Free a cache
+ * @param cache Cache to free (may be NULL)
+ */
+void dns_cache_destroy(dns_cache_t *cache);
+
+#endif // DNS_CACHE_H
@@ -0,0 +1,85 @@
+/* ============================================================================
+ * API Kit - Environments
+ *
+ * Named sets of template variables loaded from environments.toml in the
+ * data folder. Each table is an environment; [shared] holds defaults that
+ * every environment inherits and may override:
+ *
+ *   [shared]
+ *   api_version = "v1"
+ *
+ *   [dev]
+ *   host = "http://localhost:8080"
+ *   token = "dev-token"
+ * ============================================================================ */
+
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include "template.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define MAX_ENVIRONMENTS 10
+#define MAX_ENVIRONMENT_VARIABLES 32
+#define ENVIRONMENT_SHARED_NAME "shared"
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    char name[64];
+    char value[512];
+} environment_variable_t;
+
+typedef struct {
+    char name[64];
+    int variable_count;
+    environment_variable_t variables[MAX_ENVIRONMENT_VARIABLES];
+} environment_t;
+
+typedef struct {
+    environment_t shared;
+    int count;
+    environment_t items[MAX_ENVIRONMENTS];
+} environment_list_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Load environments from a TOML file
+ *
+ * String values are taken as is; numbers and booleans as their TOML text.
+ * Environments and variables beyond the limits are ignored.
+ *
+ * @param path Path to environments.toml
+ * @param list List to fill (cleared first)
+ * @return 0 on success or when the file does not exist, -1 on parse error
+ */
+int environment_load(const char *path, environment_list_t *list);
+
+/**
+ * @brief Find an environment by name
+ * @return Index into list->items, or -1
+ */
+int environment_find(const environment_list_t *list, const char *name);
+
+/**
+ * @brief Make an environment's values the current template variables
+ *
+ * Clears vars, then sets the shared variables and the environment's own.
+ * Slots and compiled templates stay valid, so only rendering is redone.
+ *
+ * @param list Environments
+ * @param index Environment index, or -1 for shared variables only
+ * @param vars Variable table to fill
+ * @return 0 on success, -1 on allocation failure
+ */
+int environment_apply(const environment_list_t *list, int index, template_vars_t *vars);
+
+#endif // ENVIRONMENT_H
@@ -0,0 +1,155 @@
+/* ============================================================================
+ * API Kit - HDR Histogram
+ *
+ * A high dynamic range histogram of unsigned values (latencies in
+ * microseconds, sizes). Values below 2^(precision_bits + 1) have a bucket
+ * each; above that every power of two is split into 2^precision_bits
+ * buckets, so a value is known to within 2^-precision_bits of itself at any
+ * magnitude. Recording is a shift, a count-leading-zeros and an increment.
+ *
+ * A histogram has one writer. Its counts are updated with relaxed atomic
+ * stores, so other threads can merge or query it while it records without
+ * locks; give each thread its own histogram and merge them for totals.
+ * The counts can live in memory the caller provides, such as a region
+ * shared with forked processes.
+ *
+ * hdr_histogram_encode packs the non-zero buckets as varint gaps and
+ * counts, typically a few dozen bytes, for storing results alongside
+ * history.
+ * ============================================================================ */
+
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HDR_PRECISION_MIN 1
+#define HDR_PRECISION_MAX 14
+#define HDR_RANGE_MAX 64
+
+// Buckets of a histogram; range_bits must be above precision_bits
+#define HDR_BUCKET_COUNT(precision_bits, range_bits) \
+    ((((range_bits) - (precision_bits)) + 1) << (precision_bits))
+
+// Longest encoding of a histogram with this many buckets
+#define HDR_ENCODED_MAX(buckets) (4 + (size_t)(buckets) * 13)
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    int precision_bits;         // 2^precision_bits buckets per power of two
+    int range_bits;             // Values up to 2^range_bits - 1; larger ones count as that
+    int bucket_count;
+    uint64_t *counts;           // Written by one thread at a time (see hdr_histogram_record)
+    int owns_counts;
+} hdr_histogram_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Set up a histogram
+ * @param histogram Histogram to initialize
+ * @param precision_bits HDR_PRECISION_MIN to HDR_PRECISION_MAX (5 = about 3%)
+ * @param range_bits Above precision_bits, at most HDR_RANGE_MAX
+ * @param counts HDR_BUCKET_COUNT(precision_bits, range_bits) counts to use
+ *        as they are (not cleared, not freed), or NULL to allocate zeroed ones
+ * @return 0 on success, -1 on invalid parameters or allocation failure
+ */
+int hdr_histogram_init(hdr_histogram_t *histogram, int precision_bits, int range_bits, uint64_t *counts);
+
+/**
+ * @brief Free the counts if the histogram allocated them
+ * @param histogram Histogram (may be NULL)
+ */
+void hdr_histogram_free(hdr_histogram_t *histogram);
+
+/**
+ * @brief Count a value
+ *
+ * Only one thread may record into a histogram at a time; any thread may
+ * read it meanwhile.
+ */
+void hdr_histogram_record(hdr_histogram_t *histogram, uint64_t value);
+
+/**
+ * @brief Count a value n times
+ */
+void hdr_histogram_record_n(hdr_histogram_t *histogram, uint64_t value, uint64_t n);
+
+/**
+ * @brief Clear all counts
+ */
+void hdr_histogram_reset(hdr_histogram_t *histogram);
+
+/**
+ * @brief Add another histogram's counts
+ *
+ * source may be recording meanwhile. With a different layout every source
+ * bucket is counted at its middle value, so precision is the coarser one.
+ *
+ * @param target Histogram to add to (recorded by the calling thread)
+ * @param source Histogram to add
+ */
+void hdr_histogram_merge(hdr_histogram_t *target, const hdr_histogram_t *source);
+
+/**
+ * @brief Number of values recorded
+ */
+uint64_t hdr_histogram_count(const hdr_histogram_t *histogram);
+
+/**
+ * @brief Value at a percentile
+ * @param histogram Histogram
+ * @param percentile 0 to 100
+ * @return Middle of the bucket holding that value, 0 if nothing was recorded
+ */
+uint64_t hdr_histogram_percentile(const hdr_histogram_t *histogram, double percentile);
+
+/**
+ * @brief Lowest and highest values that may have been recorded
+ *
+ * The bounds of the lowest and highest non-empty buckets; 0 if nothing
+ * was recorded.
+ */
+uint64_t hdr_histogram_min(const hdr_histogram_t *histogram);
+uint64_t hdr_histogram_max(const hdr_histogram_t *histogram);
+
+/**
+ * @brief Mean of the recorded values, each taken as its bucket's middle
+ */
+double hdr_histogram_mean(const hdr_histogram_t *histogram);
+
+/**
+ * @brief Serialize the counts
+ *
+ * Four header bytes (format, version, precision and range bits), then for
+ * each non-empty bucket the number of empty buckets before it and its
+ * count, both as LEB128 varints.
+ *
+ * @param histogram Histogram
+ * @param out Buffer (may be NULL to only measure)
+ * @param capacity Size of out
+ * @return Bytes of the encoding; it is complete in out only if that is
+ *         at most capacity
+ */
+size_t hdr_histogram_encode(const hdr_histogram_t *histogram, uint8_t *out, size_t capacity);
+
+/**
+ * @brief Read an encoded histogram
+ * @param histogram Initialized here, with allocated counts (free with hdr_histogram_free)
+ * @param data Output of hdr_histogram_encode
+ * @param size Length of data
+ * @return 0 on success, -1 if data is malformed or on allocation failure
+ */
+int hdr_histogram_decode(hdr_histogram_t *histogram, const uint8_t *data, size_t size);
+
+#endif // HDR_HISTOGRAM_H
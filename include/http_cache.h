@@ -0,0 +1,88 @@
+/* ============================================================================
+ * API Kit - HTTP Cache
+ *
+ * A private HTTP cache (RFC 9111) for GET responses, attached to a client
+ * with http_client_set_cache. Entries live in an in-memory LRU and, when a
+ * directory is given, in one file per URL so they survive restarts.
+ *
+ * Fresh entries (Cache-Control max-age, Expires, or the Last-Modified
+ * heuristic) are answered without a request. Stale entries with an ETag or
+ * Last-Modified are revalidated with If-None-Match / If-Modified-Since, and
+ * a 304 reuses the stored body. Responses are stored per Vary variant in
+ * memory; the disk keeps the latest variant of each URL.
+ * ============================================================================ */
+
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "compiled_request.h"
+#include "http_client.h"
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct http_cache http_cache_t;
+
+typedef struct {
+    uint64_t hits;              // Answered from the cache without a request
+    uint64_t revalidated;       // 304 Not Modified: stored body reused
+    uint64_t misses;            // Full response downloaded
+    uint64_t stores;            // Responses written to the cache
+    uint64_t evictions;         // Dropped from memory by the LRU (kept on disk)
+} http_cache_stats_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Create a cache
+ * @param max_memory Bytes of headers and bodies kept in memory
+ * @param directory Directory for the disk store (created if missing), or NULL for memory only
+ * @return Cache, or NULL on allocation failure
+ */
+http_cache_t *http_cache_create(size_t max_memory, const char *directory);
+
+/**
+ * @brief Free a cache (the disk store is kept)
+ * @param cache Cache to free (may be NULL)
+ */
+void http_cache_destroy(http_cache_t *cache);
+
+/**
+ * @brief Look up a request before sending it
+ *
+ * @param cache Cache
+ * @param request Request about to be sent
+ * @param conditional Receives a header list with the request's headers plus
+ *        the validators of a stale entry (free with curl_slist_free_all),
+ *        or NULL when the request should be sent as is
+ * @return Copy of a fresh stored response (cache_result HTTP_CACHE_HIT), or NULL
+ */
+http_response_t *http_cache_lookup(http_cache_t *cache, const compiled_request_t *request,
+                                   struct curl_slist **conditional);
+
+/**
+ * @brief Update the cache with a response received from the network
+ *
+ * Stores cacheable GET responses, turns a 304 into a copy of the stored
+ * response, and drops entries for a URL after a successful unsafe request
+ * (POST, PUT, PATCH, DELETE) to it.
+ *
+ * @param cache Cache
+ * @param request Request the response answers
+ * @param response Network response (ownership passes to the cache)
+ * @return Response to hand to the caller
+ */
+http_response_t *http_cache_store(http_cache_t *cache, const compiled_request_t *request,
+                                  http_response_t *response);
+
+/**
+ * @brief Counters since the cache was created
+ */
+http_cache_stats_t http_cache_stats(http_cache_t *cache);
+
+#endif // HTTP_CACHE_H
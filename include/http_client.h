@@ -2,12 +2,31 @@
 #define HTTP_CLIENT_H
 
 #include <curl/curl.h>
+#include <stdint.h>
+#include "http_headers.h"
+
+struct http_cache;
+struct dns_cache;
+struct http_share_locks;
 
 typedef struct {
   CURL *curl;
+  CURLSH *share;             // DNS cache and TLS sessions shared with warm-up handles
+  struct http_share_locks *share_locks;
   struct curl_slist *headers;
+  struct http_cache *cache;  // Optional, see http_cache.h (not owned)
+  struct dns_cache *dns;     // Addresses reached, saved on destroy (NULL without state_dir)
+  struct curl_slist *resolve;  // Addresses from the last run, loaded by the first transfer
+  char *state_dir;
 } http_client_t;
 
+typedef struct {
+  // Directory where the client keeps DNS results (dns.txt), Alt-Svc
+  // (alt-svc.txt) and HSTS (hsts.txt) between runs; it must exist.
+  // NULL keeps nothing.
+  const char *state_dir;
+} http_client_options_t;
+
 typedef struct {
   const char **headers;  // Array of "Key: Value" strings, NULL-terminated
   const char *body;
@@ -15,15 +34,54 @@ typedef struct {
   long timeout_ms;       // Request timeout in milliseconds
 } http_request_options_t;
 
+typedef enum {
+  HTTP_CACHE_NONE,         // Downloaded
+  HTTP_CACHE_HIT,          // Served from the cache without a request
+  HTTP_CACHE_REVALIDATED   // Server answered 304; body is the stored one
+} http_cache_result_t;
+
+typedef enum {
+  HTTP_ATTEMPT_RUNNING,
+  HTTP_ATTEMPT_WON,        // Its response was delivered
+  HTTP_ATTEMPT_FAILED,     // Retryable failure; another attempt followed or was in flight
+  HTTP_ATTEMPT_CANCELLED   // A sibling (hedge) finished first
+} http_attempt_outcome_t;
+
+// One transfer made for a request by the async engine (see http_engine.h)
 typedef struct {
-  char *body;
+  uint64_t start_ns;       // Offsets from when the request was submitted
+  uint64_t end_ns;
+  long status_code;
+  int curl_result;         // CURLcode
+  int hedge;               // Started as a duplicate of a slow attempt
+  http_attempt_outcome_t outcome;
+} http_attempt_t;
+
+typedef struct {
+  char *body;            // Decoded (Content-Encoding is undone as it streams in)
   size_t body_size;
+  uint64_t wire_size;    // Body bytes as transferred, before decoding (0 from the cache)
   long status_code;
-  char *headers;
+  int http_version;       // Of the final response: 10, 11, 20 or 30 (0 = none)
+  char *headers;          // Raw header text of every hop, as received
   size_t headers_size;
+  http_headers_t header_fields;  // Index over headers, filled as they arrive
   char *error_message;
+  http_cache_result_t cache_result;
+  http_attempt_t *attempts;  // Engine transfers for this response, in start order (NULL otherwise)
+  int attempt_count;
 } http_response_t;
 
+// Live progress of a transfer, shared with other threads (see http_request_tracked).
+// The transfer writes the counters and reads cancel with __atomic builtins.
+typedef struct {
+  int cancel;              // Set to 1 to abort the transfer (error "Cancelled")
+  uint64_t downloaded;     // Body bytes received so far, as transferred
+  uint64_t download_total; // Expected body bytes (Content-Length), 0 if unknown
+  uint64_t uploaded;
+  uint64_t upload_total;
+} http_progress_t;
+
 typedef enum {
   HTTP_METHOD_GET,
   HTTP_METHOD_POST,
@@ -32,6 +90,8 @@ typedef enum {
   HTTP_METHOD_PATCH
 } http_method_t;
 
+struct compiled_request;
+
 /**
  * @brief Create HTTP client (call once at startup)
  *
@@ -39,6 +99,19 @@ typedef enum {
  */
 http_client_t *http_client_create(void);
 
+/**
+ * @brief Create an HTTP client with options
+ *
+ * With a state directory, the client starts with the DNS results, Alt-Svc
+ * and HSTS entries saved by the previous run and writes them back on
+ * http_client_destroy, so the first request to a known host skips name
+ * resolution.
+ *
+ * @param options Options (NULL for defaults, like http_client_create)
+ * @return Client, or NULL on failure
+ */
+http_client_t *http_client_create_ex(const http_client_options_t *options);
+
 /**
  * @brief Destroy HTTP client (call once at shutdown)
  *
@@ -46,6 +119,14 @@ http_client_t *http_client_create(void);
  */
 void http_client_destroy(http_client_t *client);
 
+/**
+ * @brief Attach a cache to the client's compiled requests
+ *
+ * @param client HTTP client
+ * @param cache Cache, or NULL to detach; must outlive the client
+ */
+void http_client_set_cache(http_client_t *client, struct http_cache *cache);
+
 /**
  * @brief Perform HTTP request
  *
@@ -60,6 +141,80 @@ http_response_t *http_request(
     const char *url, 
     const http_request_options_t *options);
 
+/**
+ * @brief Send a compiled request (see compiled_request.h)
+ *
+ * Only sets options on the client's handle; the header list and body are
+ * used as compiled, so the same request can be sent repeatedly.
+ *
+ * @param client HTTP client
+ * @param request Compiled request
+ * @return Pointer to response data, NULL on allocation failure
+ */
+http_response_t *http_request_compiled(
+    http_client_t *client,
+    const struct compiled_request *request);
+
+/**
+ * @brief Send a compiled request, reporting progress and honouring cancel
+ *
+ * Like http_request_compiled, but the transfer updates progress as data
+ * moves and stops soon after progress->cancel is set. Meant for a worker
+ * thread, with another thread watching progress (see http_task.h).
+ *
+ * @param client HTTP client
+ * @param request Compiled request
+ * @param progress Progress to update (may be NULL)
+ * @return Pointer to response data, NULL on allocation failure
+ */
+http_response_t *http_request_tracked(
+    http_client_t *client,
+    const struct compiled_request *request,
+    http_progress_t *progress);
+
+/**
+ * @brief Configure an easy handle for a compiled request
+ *
+ * The building block of http_request_compiled for callers that run their
+ * own handles (see http_engine.h). The request must stay alive until the
+ * transfer has finished.
+ *
+ * @param curl Easy handle
+ * @param request Compiled request
+ * @return Empty response the transfer will fill, NULL on allocation failure
+ */
+http_response_t *http_transfer_prepare(CURL *curl, const struct compiled_request *request);
+
+/**
+ * @brief Report a prepared transfer's progress and let it be cancelled
+ *
+ * @param curl Easy handle configured by http_transfer_prepare
+ * @param progress Progress to update, or NULL for none (the default after prepare)
+ */
+void http_transfer_set_progress(CURL *curl, http_progress_t *progress);
+
+/**
+ * @brief Record the outcome of a finished transfer in its response
+ *
+ * Sets the status code and error message, and records the trace spans.
+ *
+ * @param curl Easy handle the transfer ran on
+ * @param response Response returned by http_transfer_prepare
+ * @param result Transfer result
+ * @param trace_start_ns trace_begin() taken when the transfer started
+ */
+void http_transfer_finish(CURL *curl, http_response_t *response, CURLcode result, uint64_t trace_start_ns);
+
+/**
+ * @brief Method name ("GET", "POST", ...)
+ */
+const char *http_method_name(http_method_t method);
+
+/**
+ * @brief Parse a method name; unknown names map to GET
+ */
+http_method_t http_method_from_name(const char *name);
+
 /**
  * @brief Free response memory
  *
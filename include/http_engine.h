@@ -0,0 +1,271 @@
+/* ============================================================================
+ * API Kit - Async HTTP Engine
+ *
+ * Runs many compiled requests concurrently on one thread with a libcurl
+ * multi handle. Transfers beyond the concurrency limit wait in FIFO
+ * queues, one per host; easy handles are pooled, and connections and DNS results are
+ * shared through the multi handle. Completion callbacks run inside
+ * http_engine_run and may submit further requests.
+ *
+ * A retry policy makes one submitted request into up to max_attempts
+ * transfers: retryable failures are sent again after an exponential
+ * backoff with full jitter (or the server's Retry-After), and a slow
+ * attempt can be hedged with a duplicate, whichever finishes first wins
+ * and the other is cancelled. A budget caps retries and hedges to a
+ * fraction of the traffic so an outage is not multiplied. Every attempt's
+ * timing is recorded in response->attempts.
+ *
+ * Token buckets limit how fast attempts start: one for the whole engine,
+ * one per host and optionally one per request (a bucket shared by every
+ * submission of that request). Each host can also be capped to a number
+ * of transfers in flight. Jobs held back by a limit wait in per-host
+ * queues without blocking other hosts, and http_engine_run sleeps until
+ * the next token is due instead of polling.
+ *
+ * HTTP/2 requests to one origin share connections as concurrent streams.
+ * The engine counts the streams sent on every connection it uses, so
+ * HTTP/1.1 connection fan-out can be compared with HTTP/2 multiplexing.
+ * ============================================================================ */
+
+#ifndef HTTP_ENGINE_H
+#define HTTP_ENGINE_H
+
+#include "http_client.h"
+#include "compiled_request.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HTTP_MAX_ATTEMPTS 8
+
+// Failure classes a policy retries (retry_on)
+#define HTTP_RETRY_CONNECT  0x01u   // DNS or connect failed: nothing was sent, safe for any method
+#define HTTP_RETRY_NETWORK  0x02u   // Connection reset or empty reply
+#define HTTP_RETRY_TIMEOUT  0x04u   // Transfer timed out
+#define HTTP_RETRY_429      0x08u   // 429 Too Many Requests
+#define HTTP_RETRY_5XX      0x10u   // 502, 503, 504
+
+// hedge_after_ms value: hedge after the p95 latency of recent attempts
+#define HTTP_HEDGE_P95 (-1L)
+
+// http_engine_set_multiplexing value: one request per connection at a time
+#define HTTP_MULTIPLEX_OFF (-1)
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct http_engine http_engine_t;
+
+/**
+ * Only idempotent methods (GET, PUT, DELETE) are retried after the request
+ * may have reached the server, or hedged; POST and PATCH are retried only
+ * for HTTP_RETRY_CONNECT failures.
+ */
+typedef struct {
+    int max_attempts;           // Transfers per request, including hedges (1 = none)
+    unsigned retry_on;          // HTTP_RETRY_* classes
+    long backoff_base_ms;       // Upper bound of the first retry delay; doubles per retry
+    long backoff_max_ms;        // Cap on the delay bound and on Retry-After
+    double budget_ratio;        // Retries + hedges allowed per submitted request...
+    int budget_min;             // ...plus this many regardless of traffic
+    long hedge_after_ms;        // Duplicate an attempt slower than this (0 = off, HTTP_HEDGE_P95)
+} http_retry_policy_t;
+
+typedef struct {
+    uint64_t requests;          // Submitted
+    uint64_t attempts;          // Transfers started
+    uint64_t retries;
+    uint64_t hedges;
+    uint64_t hedge_wins;        // Hedges that finished before the original
+    uint64_t budget_denied;     // Retries or hedges refused by the budget
+    uint64_t throttled;         // Requests that waited for a rate limit or host cap
+} http_engine_stats_t;
+
+/**
+ * Token bucket: refills at rate tokens per second up to burst, and each
+ * attempt takes one token. The burst should cover a few milliseconds of
+ * traffic at high rates, since the engine wakes at millisecond granularity.
+ */
+typedef struct {
+    double rate;                // Tokens per second (0 = unlimited)
+    double burst;               // Bucket size
+    double tokens;
+    uint64_t updated_ns;        // Last refill (monotonic)
+} http_token_bucket_t;
+
+/**
+ * One connection the engine sent requests on. Connections are told apart
+ * by their local address; all Unix socket connections count as one.
+ */
+typedef struct {
+    char local[64];             // Local address:port ("unix" for Unix sockets)
+    char remote[64];            // Server address:port
+    int http_version;           // 11, 20, ... of the last response on it (0 = none yet)
+    uint64_t streams;           // Requests sent on it
+} http_connection_stats_t;
+
+/**
+ * Called once per submitted request. The callback owns the response (free
+ * it with http_response_free); it is NULL if the transfer could not be
+ * started. Transport errors are reported through response->error_message.
+ */
+typedef void (*http_engine_done_fn)(void *user_data, http_response_t *response);
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Create an engine
+ * @param max_concurrent Transfers in flight at once (0 = no limit)
+ * @return Engine, or NULL on failure
+ */
+http_engine_t *http_engine_create(int max_concurrent);
+
+/**
+ * @brief Destroy an engine, abandoning unfinished transfers without callbacks
+ * @param engine Engine to destroy (may be NULL)
+ */
+void http_engine_destroy(http_engine_t *engine);
+
+/**
+ * @brief Production-like policy: 3 attempts on connect, network, 429 and
+ *        5xx failures, 100 ms base / 2 s max backoff, 10% budget, no hedging
+ */
+http_retry_policy_t http_retry_policy_default(void);
+
+/**
+ * @brief Set the policy for requests submitted afterwards
+ *
+ * The engine starts with no retries and no hedging (max_attempts 1).
+ */
+void http_engine_set_policy(http_engine_t *engine, const http_retry_policy_t *policy);
+
+/**
+ * @brief Initialize a token bucket, full
+ * @param bucket Bucket
+ * @param rate Tokens per second (0 = unlimited)
+ * @param burst Bucket size (0 = rate / 100, at least 1)
+ */
+void http_token_bucket_init(http_token_bucket_t *bucket, double rate, double burst);
+
+/**
+ * @brief Limit attempts started per second across all hosts
+ * @param engine Engine
+ * @param rate Attempts per second (0 = unlimited)
+ * @param burst Bucket size (0 = default, see http_token_bucket_init)
+ */
+void http_engine_set_rate(http_engine_t *engine, double rate, double burst);
+
+/**
+ * @brief Limit attempts per second and transfers in flight for a host
+ *
+ * Hosts are matched by name, case-insensitively, regardless of scheme and
+ * port. A host without its own limits uses the defaults (host NULL).
+ *
+ * @param engine Engine
+ * @param host Host name, or NULL to set the defaults
+ * @param rate Attempts per second (0 = unlimited)
+ * @param burst Bucket size (0 = default, see http_token_bucket_init)
+ * @param max_connections Transfers in flight to the host (0 = no limit)
+ * @return 0 on success, -1 on allocation failure
+ */
+int http_engine_set_host_limits(http_engine_t *engine, const char *host, double rate, double burst,
+                                int max_connections);
+
+/**
+ * @brief Control how many requests share an HTTP/2 connection
+ *
+ * With max_streams > 0, requests wait for a stream on an existing
+ * connection to their origin instead of opening another, and a connection
+ * carries at most max_streams of them at once. Each host then gets at most
+ * max_concurrent / max_streams connections (rounded up), which also caps
+ * HTTP/1.1 hosts, so set this only for HTTP/2 targets. The default
+ * (0) is libcurl's: multiplex where possible, but open a new connection
+ * rather than wait for the first one's protocol to be known.
+ * HTTP_MULTIPLEX_OFF sends one request per connection at a time, even over
+ * HTTP/2. HTTP/1.1 connections always carry one request at a time.
+ *
+ * @param engine Engine
+ * @param max_streams Streams per connection, 0 or HTTP_MULTIPLEX_OFF
+ */
+void http_engine_set_multiplexing(http_engine_t *engine, int max_streams);
+
+/**
+ * @brief Counters since the engine was created
+ */
+http_engine_stats_t http_engine_stats(const http_engine_t *engine);
+
+/**
+ * @brief Connections used since the engine was created, in order of first use
+ * @param engine Engine
+ * @param connections Filled with up to max entries (may be NULL)
+ * @param max Size of connections
+ * @return Number of connections used (may exceed max)
+ */
+int http_engine_connections(const http_engine_t *engine, http_connection_stats_t *connections, int max);
+
+/**
+ * @brief Queue a request
+ *
+ * @param engine Engine
+ * @param request Compiled request; must stay alive until its callback ran
+ * @param done Completion callback
+ * @param user_data Passed to done
+ * @return 0 on success, -1 on allocation failure (done is not called)
+ */
+int http_engine_submit(http_engine_t *engine, const compiled_request_t *request,
+                       http_engine_done_fn done, void *user_data);
+
+/**
+ * @brief Queue a request under an extra rate limit of its own
+ *
+ * Every attempt of the request takes a token from limit as well as from
+ * the engine and host buckets. Share one bucket between submissions to
+ * limit a request that is sent repeatedly.
+ *
+ * @param limit Bucket (must outlive the request), or NULL for none
+ * @return 0 on success, -1 on allocation failure (done is not called)
+ */
+int http_engine_submit_limited(http_engine_t *engine, const compiled_request_t *request,
+                               http_token_bucket_t *limit, http_engine_done_fn done, void *user_data);
+
+/**
+ * @brief Open connections to the origins of upcoming requests
+ *
+ * Sends "OPTIONS *" to each distinct origin, connections times at once and
+ * routed like the requests to it, so the first requests find resolved,
+ * connected and TLS-handshaked connections in the pool (see http_warmup.h).
+ * Obeys the concurrency, host and rate limits. Call before submitting
+ * requests.
+ *
+ * @param engine Engine with no pending requests
+ * @param requests Requests about to be submitted
+ * @param count Number of requests
+ * @param connections Connections per origin and routing
+ * @return Connections opened, or -1 on failure
+ */
+int http_engine_warm_up(http_engine_t *engine, const compiled_request_t *const *requests, int count,
+                        int connections);
+
+/**
+ * @brief Make progress on all transfers
+ *
+ * Starts queued transfers, moves data, delivers completions and then
+ * waits up to timeout_ms for network activity. Call in a loop until it
+ * returns 0.
+ *
+ * @param engine Engine
+ * @param timeout_ms Longest wait for activity
+ * @return Requests still queued, waiting to retry or in flight
+ */
+int http_engine_run(http_engine_t *engine, int timeout_ms);
+
+/**
+ * @brief Requests queued, waiting to retry or in flight
+ */
+int http_engine_pending(const http_engine_t *engine);
+
+#endif // HTTP_ENGINE_H
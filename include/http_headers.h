@@ -0,0 +1,119 @@
+/* ============================================================================
+ * API Kit - Response Header Index
+ *
+ * Response headers parsed line by line as they arrive. Every header is a
+ * (name, value) span into the raw header text, grouped into one block per
+ * response (redirect hops and 1xx responses each get their own block).
+ * Lookups in the final block go through a small hash table on the
+ * case-folded name; repeated headers (Set-Cookie, Vary) are all kept, in
+ * arrival order.
+ * ============================================================================ */
+
+#ifndef HTTP_HEADERS_H
+#define HTTP_HEADERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HTTP_HEADER_BUCKETS 64      // Hash buckets for the final block (power of 2)
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    uint32_t name_offset;       // Spans into http_headers_t.text
+    uint32_t name_length;
+    uint32_t value_offset;      // Without surrounding whitespace
+    uint32_t value_length;
+    uint32_t hash;              // FNV-1a of the lower-cased name
+    int next;                   // Next header in the same bucket, -1 = none
+} http_header_t;
+
+typedef struct {
+    uint32_t line_offset;       // Status line ("HTTP/1.1 200 OK"), without CRLF
+    uint32_t line_length;
+    long status_code;           // 0 when the block has no status line
+    int first;                  // Index of the block's first header
+    int count;                  // Number of headers in the block
+} http_header_block_t;
+
+typedef struct {
+    const char *text;           // Raw header text the spans point into
+    http_header_t *items;
+    int count;
+    int capacity;
+    http_header_block_t *blocks;
+    int block_count;
+    int block_capacity;
+    int bucket_head[HTTP_HEADER_BUCKETS];   // Final block only; -1 = empty
+    int bucket_tail[HTTP_HEADER_BUCKETS];
+} http_headers_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Initialize an empty index
+ */
+void http_headers_init(http_headers_t *headers);
+
+/**
+ * @brief Free an index's memory (the raw text is not owned)
+ * @param headers Index to reset (may be NULL)
+ */
+void http_headers_free(http_headers_t *headers);
+
+/**
+ * @brief Index one raw header line
+ *
+ * A line starting with "HTTP/" opens a new block; blank lines end one.
+ * Lines without a colon and obsolete folded continuation lines are ignored.
+ *
+ * @param headers Index
+ * @param text Raw header text (may have moved since the last call)
+ * @param offset Offset of the line in text
+ * @param length Length of the line, including its line ending
+ * @return 0 on success, -1 on allocation failure
+ */
+int http_headers_add_line(http_headers_t *headers, const char *text, size_t offset, size_t length);
+
+/**
+ * @brief Index a complete raw header text (e.g. loaded from disk)
+ * @return 0 on success, -1 on allocation failure
+ */
+int http_headers_parse(http_headers_t *headers, const char *text, size_t length);
+
+/**
+ * @brief Block of the final response, or NULL when no headers were seen
+ */
+const http_header_block_t *http_headers_final(const http_headers_t *headers);
+
+/**
+ * @brief First header with a name (case-insensitive) in a block
+ * @param headers Index
+ * @param block Block index, or -1 for the final block
+ * @param name Header name
+ * @return Header, or NULL if the block has none
+ */
+const http_header_t *http_headers_find(const http_headers_t *headers, int block, const char *name);
+
+/**
+ * @brief Next header with the same name in the same block
+ * @return Header, or NULL after the last one
+ */
+const http_header_t *http_headers_find_next(const http_headers_t *headers, const http_header_t *header);
+
+/**
+ * @brief Value of the first header with a name in the final block
+ * @param length Receives the value length (not NUL-terminated)
+ * @return Value, or NULL if there is no such header
+ */
+const char *http_headers_get(const http_headers_t *headers, const char *name, size_t *length);
+
+#endif // HTTP_HEADERS_H
@@ -0,0 +1,70 @@
+/* ============================================================================
+ * API Kit - HTTP Task
+ *
+ * Sends one compiled request on a worker thread so the UI keeps drawing.
+ * While it runs, the UI reads byte counts and throughput, and can cancel
+ * it: the transfer stops at curl's next progress callback instead of
+ * running into the request timeout.
+ * ============================================================================ */
+
+#ifndef HTTP_TASK_H
+#define HTTP_TASK_H
+
+#include <stdint.h>
+#include "http_client.h"
+#include "compiled_request.h"
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct http_task http_task_t;
+
+typedef struct {
+    uint64_t downloaded;        // Body bytes received, as transferred
+    uint64_t download_total;    // Expected body bytes, 0 if unknown
+    uint64_t uploaded;
+    uint64_t upload_total;
+    uint64_t elapsed_ns;        // Since the task started; once done, until it finished
+    double bytes_per_second;    // Download rate over the last quarter second or so
+} http_task_progress_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Start sending a request in the background
+ *
+ * The client and request belong to the task until http_task_finish: do not
+ * use them from another thread meanwhile.
+ *
+ * @param client HTTP client
+ * @param request Compiled request
+ * @return Task, or NULL on allocation failure
+ */
+http_task_t *http_task_start(http_client_t *client, const compiled_request_t *request);
+
+/**
+ * @brief Ask the transfer to stop; its response reports "Cancelled"
+ */
+void http_task_cancel(http_task_t *task);
+
+/**
+ * @brief Whether the response is ready (http_task_finish will not block)
+ */
+int http_task_is_done(const http_task_t *task);
+
+/**
+ * @brief Progress so far; call from one thread only (it updates the rate)
+ */
+http_task_progress_t http_task_progress(http_task_t *task);
+
+/**
+ * @brief Wait for the task and free it
+ * @param task Task (may be NULL)
+ * @return Response (free with http_response_free), or NULL if none could be made
+ */
+http_response_t *http_task_finish(http_task_t *task);
+
+#endif // HTTP_TASK_H
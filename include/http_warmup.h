@@ -0,0 +1,102 @@
+/* ============================================================================
+ * API Kit - Connection Warm-up
+ *
+ * Opens connections to the origins a workspace or run is about to use,
+ * before the first real request needs them. Each connection is made by an
+ * "OPTIONS *" request (a no-op for the server's resources), which leaves a
+ * resolved, connected and TLS-handshaked connection in the pool. libcurl's
+ * CONNECT_ONLY would not do: such connections are never reused by normal
+ * transfers.
+ *
+ * Warm-up connections are routed like the requests they are made for
+ * ("# @unix-socket", "# @resolve", "# @http-version"), or those requests
+ * could not reuse them. One target is kept per distinct origin and routing.
+ *
+ * The async engine warms its own pool with http_engine_warm_up. A client's
+ * pool cannot be filled from another thread (libcurl does not support
+ * sharing connections between concurrent threads), so http_warmup_start
+ * shares only the client's DNS cache and TLS sessions: its first requests
+ * skip the lookups and resume the TLS sessions, but still connect.
+ * ============================================================================ */
+
+#ifndef HTTP_WARMUP_H
+#define HTTP_WARMUP_H
+
+#include <stddef.h>
+#include "http_client.h"
+#include "compiled_request.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HTTP_WARMUP_TIMEOUT_MS 5000     // Per warm-up connection
+#define HTTP_WARMUP_MAX_TARGETS 64
+#define HTTP_ORIGIN_LENGTH 512          // "scheme://host:port" buffer size
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct http_warmup http_warmup_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Origin of a URL: "scheme://host:port", the port always given
+ * @param url URL
+ * @param origin Output buffer
+ * @param size Size of output buffer
+ * @return 0 on success, -1 if the URL has no host or does not fit
+ */
+int http_url_origin(const char *url, char *origin, size_t size);
+
+/**
+ * @brief Distinct origins and routings of a list of requests, in first-seen order
+ * @param requests Requests (entries whose URL does not parse are skipped)
+ * @param count Number of requests
+ * @param targets Receives up to max requests for "origin/" with the routing
+ *        of the requests to them (free each with compiled_request_destroy)
+ * @param max Capacity of targets
+ * @return Number of targets
+ */
+int http_warmup_targets(const compiled_request_t *const *requests, int count,
+                        compiled_request_t **targets, int max);
+
+/**
+ * @brief New easy handle that opens a connection to a target with "OPTIONS *"
+ * @param target Target from http_warmup_targets (must outlive the handle)
+ * @return Handle (free with curl_easy_cleanup), or NULL
+ */
+CURL *http_warmup_handle(const compiled_request_t *target);
+
+/**
+ * @brief Start warming the client's DNS cache and TLS sessions in the background
+ *
+ * The client stays usable meanwhile. Call http_warmup_finish before
+ * destroying the client.
+ *
+ * @param client HTTP client
+ * @param requests Requests about to be sent (their origins and routing are copied)
+ * @param count Number of requests
+ * @param connections Connections to open per target
+ * @return Warm-up, or NULL on failure
+ */
+http_warmup_t *http_warmup_start(http_client_t *client, const compiled_request_t *const *requests,
+                                 int count, int connections);
+
+/**
+ * @brief Whether the warm-up has finished (http_warmup_finish will not block)
+ */
+int http_warmup_is_done(const http_warmup_t *warmup);
+
+/**
+ * @brief Wait for the warm-up and free it
+ * @param warmup Warm-up (may be NULL)
+ * @return Connections opened
+ */
+int http_warmup_finish(http_warmup_t *warmup);
+
+#endif // HTTP_WARMUP_H
@@ -0,0 +1,132 @@
+/* ============================================================================
+ * API Kit - JSON Formatter
+ *
+ * Streaming pretty-printer for response bodies. Rather than writing an
+ * indented copy of the body, the formatter builds a compact line index over
+ * the raw buffer: each entry names the raw bytes that make up one
+ * pretty-printed line plus its indentation depth. Lines are rendered and
+ * highlighted on demand, so only what is on screen is ever materialized.
+ * ============================================================================ */
+
+#ifndef JSON_FORMAT_H
+#define JSON_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+// Depth marker for lines indexed as plain text (non-JSON or after a syntax error)
+#define JSON_LINE_PLAIN UINT32_MAX
+
+// One pretty-printed line, expressed as a slice of the raw body
+typedef struct {
+    uint32_t offset;   // First significant byte of the line in the raw body
+    uint32_t length;   // Raw bytes covered (may include insignificant whitespace)
+    uint32_t depth;    // Indentation level, or JSON_LINE_PLAIN
+} json_line_t;
+
+// Highlight classes produced when rendering a line
+typedef enum {
+    JSON_SPAN_PLAIN,
+    JSON_SPAN_PUNCT,
+    JSON_SPAN_KEY,
+    JSON_SPAN_STRING,
+    JSON_SPAN_NUMBER,
+    JSON_SPAN_LITERAL
+} json_span_kind_t;
+
+// Highlight span inside a rendered line
+typedef struct {
+    int start;
+    int length;
+    json_span_kind_t kind;
+} json_span_t;
+
+// Called for every completed line
+typedef void (*json_line_fn)(void *user_data, const json_line_t *line);
+
+// Streaming formatter state. Feed it consecutive slices of the same buffer.
+typedef struct {
+    const char *data;      // Whole raw body (lookahead may peek past a slice)
+    size_t size;
+    size_t pos;            // Next byte to consume
+    uint32_t depth;
+    int in_string;
+    int escaped;
+    int failed;            // Set on a structural error; the rest is indexed as plain text
+    int line_open;         // Current line has content
+    uint32_t line_start;
+    uint32_t line_end;     // One past the last significant byte
+    json_line_fn emit;
+    void *user_data;
+} json_formatter_t;
+
+/* ============================================================================
+ * FORMATTER API
+ * ============================================================================ */
+
+/**
+ * @brief Check whether a body looks like JSON (first significant byte is { or [)
+ * @param data Body bytes
+ * @param size Body size
+ * @return 1 if the body should be formatted as JSON, 0 otherwise
+ */
+int json_format_detect(const char *data, size_t size);
+
+/**
+ * @brief Initialize a formatter over a complete buffer
+ * @param formatter Formatter to initialize
+ * @param data Raw body (must outlive the formatter)
+ * @param size Body size (bodies larger than 4 GiB are indexed up to 4 GiB)
+ * @param emit Line callback
+ * @param user_data Passed to the callback
+ */
+void json_formatter_init(json_formatter_t *formatter, const char *data, size_t size,
+                         json_line_fn emit, void *user_data);
+
+/**
+ * @brief Consume up to max_bytes more of the buffer
+ * @param formatter Formatter state
+ * @param max_bytes Budget for this step
+ * @return 1 while input remains, 0 once the whole buffer has been indexed
+ */
+int json_formatter_step(json_formatter_t *formatter, size_t max_bytes);
+
+/**
+ * @brief Index a buffer as plain text, one line per newline
+ * @param data Raw bytes
+ * @param start Offset to start at
+ * @param size Buffer size
+ * @param max_bytes Budget for this step
+ * @param emit Line callback
+ * @param user_data Passed to the callback
+ * @return Offset at which to resume, equal to size when done
+ */
+size_t json_index_plain(const char *data, size_t start, size_t size, size_t max_bytes,
+                        json_line_fn emit, void *user_data);
+
+/**
+ * @brief Render one indexed JSON line with canonical spacing and highlights
+ * @param data Raw body
+ * @param line Line to render
+ * @param out Output buffer (always NUL-terminated, long lines are truncated)
+ * @param out_size Size of output buffer
+ * @param spans Span output array (may be NULL)
+ * @param max_spans Capacity of spans
+ * @param span_count Receives the number of spans written (may be NULL)
+ * @return Number of characters written to out
+ */
+int json_format_render_line(const char *data, const json_line_t *line,
+                            char *out, int out_size,
+                            json_span_t *spans, int max_spans, int *span_count);
+
+/**
+ * @brief Render a plain-text line (no highlighting, control bytes replaced)
+ * @return Number of characters written to out
+ */
+int json_format_render_plain(const char *data, const json_line_t *line, char *out, int out_size);
+
+#endif // JSON_FORMAT_H
@@ -0,0 +1,88 @@
+/* ============================================================================
+ * API Kit - JSON Path Extraction
+ *
+ * Finds the value at a simple path ($.a.b[0]['c d']) in a JSON document in
+ * one forward pass. Values off the path are skipped without being parsed,
+ * and nothing is allocated, so large bodies cost no more than a scan.
+ * ============================================================================ */
+
+#ifndef JSON_PATH_H
+#define JSON_PATH_H
+
+#include <stddef.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define JSON_PATH_MAX_STEPS 16
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    const char *key;        // Member name (points into json_path_t.text), NULL for an index
+    size_t key_length;
+    long index;             // Array index when key is NULL
+} json_path_step_t;
+
+typedef struct {
+    char text[256];         // Copy of the expression; keys point into it
+    int step_count;
+    json_path_step_t steps[JSON_PATH_MAX_STEPS];
+} json_path_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Compile a path expression
+ *
+ * Supported: "$" (the whole document), ".name", "['name']", "[\"name\"]"
+ * and "[N]". Keys are matched byte-for-byte against unescaped member names.
+ *
+ * @param expression Path expression starting with '$'
+ * @param path Compiled path
+ * @return 0 on success, -1 if the expression is invalid or too long
+ */
+int json_path_compile(const char *expression, json_path_t *path);
+
+/**
+ * @brief Find the value at a path
+ *
+ * @param json Document
+ * @param length Document length
+ * @param path Compiled path
+ * @param value Set to the start of the value's JSON text
+ * @param value_length Set to the length of the value's JSON text
+ * @return 0 if found, -1 if missing or the document is malformed on the way
+ */
+int json_path_find(const char *json, size_t length, const json_path_t *path,
+                   const char **value, size_t *value_length);
+
+/**
+ * @brief Convert a value found by json_path_find to text
+ *
+ * Strings are unescaped (\uXXXX becomes UTF-8); any other value is
+ * returned as its JSON text.
+ *
+ * @return Newly allocated NUL-terminated text, or NULL on allocation failure
+ */
+char *json_path_value_text(const char *value, size_t value_length);
+
+/**
+ * @brief Convert a value to text in a caller's buffer
+ *
+ * As json_path_value_text, without allocating: the text is never longer
+ * than the value.
+ *
+ * @param value Value's JSON text
+ * @param value_length Length of value
+ * @param text Receives value_length bytes at most, not NUL-terminated
+ * @return Length of the text
+ */
+size_t json_path_unescape(const char *value, size_t value_length, char *text);
+
+#endif // JSON_PATH_H
@@ -0,0 +1,127 @@
+/* ============================================================================
+ * API Kit - Latency Trends
+ *
+ * Keeps a time series of latency and status per endpoint, where an endpoint
+ * is a method and a normalized URL: scheme and host lowercased, query and
+ * fragment dropped, and path segments that look like identifiers (numbers,
+ * UUIDs, long hex strings) replaced by {id}, so /users/17 and /users/42 share
+ * one series.
+ *
+ * Every record refreshes the endpoint's summary: its series downsampled to
+ * TREND_SPARKLINE_POINTS with Largest-Triangle-Three-Buckets, which keeps
+ * spikes a plain average would flatten, and p50/p99 badges from an HDR
+ * histogram of the kept samples. The UI draws from the summary only and
+ * never touches the samples.
+ *
+ * The series are saved to a file between launches, like the DNS cache.
+ * ============================================================================ */
+
+#ifndef LATENCY_TREND_H
+#define LATENCY_TREND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define TREND_MAX_ENDPOINTS 128         // The least recently recorded is dropped beyond this
+#define TREND_MAX_SAMPLES 256           // Per endpoint; the oldest is dropped beyond this
+#define TREND_SPARKLINE_POINTS 24
+#define TREND_RECENT_SAMPLES 8          // Compared with the earlier ones to flag a regression
+#define TREND_REGRESSION_FACTOR 1.5     // Recent median this much above the earlier one
+#define TREND_KEY_LENGTH 560            // "METHOD normalized-url"
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    double x;
+    double y;
+} trend_point_t;
+
+// What the UI shows for an endpoint
+typedef struct {
+    int point_count;
+    trend_point_t points[TREND_SPARKLINE_POINTS];   // x: 0 (oldest sample) to 1 (newest), y: ms
+    double max_ms;              // Largest y, for scaling
+    uint64_t p50_us;            // Over the kept samples that got a response
+    uint64_t p99_us;
+    int samples;
+    int errors;                 // Samples without a response or with status >= 400
+    long last_status;
+    int regressed;              // Median of the last TREND_RECENT_SAMPLES is well above the rest
+} latency_trend_t;
+
+typedef struct latency_trends latency_trends_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Load saved series
+ * @param path File to read; a missing or unreadable file gives no series
+ * @return Trends, or NULL on allocation failure
+ */
+latency_trends_t *latency_trends_load(const char *path);
+
+/**
+ * @brief Write all series to a file
+ * @return 0 on success, -1 on failure
+ */
+int latency_trends_save(const latency_trends_t *trends, const char *path);
+
+/**
+ * @brief Free trends
+ * @param trends Trends (may be NULL)
+ */
+void latency_trends_destroy(latency_trends_t *trends);
+
+/**
+ * @brief Add a sample to an endpoint's series and refresh its summary
+ * @param trends Trends
+ * @param method Request method
+ * @param url Request URL as sent
+ * @param latency_us Time to the response (or the failure)
+ * @param status Status code, 0 if there was no response
+ * @param time_ms Wall-clock time of the sample, in ms since the epoch
+ */
+void latency_trends_record(latency_trends_t *trends, const char *method, const char *url,
+                           uint64_t latency_us, long status, int64_t time_ms);
+
+/**
+ * @brief Summary of an endpoint
+ * @return Summary (owned by trends, valid until the next record), or NULL
+ *         if the endpoint has no samples
+ */
+const latency_trend_t *latency_trends_find(const latency_trends_t *trends, const char *method, const char *url);
+
+/**
+ * @brief Endpoint key of a request
+ * @param method Request method
+ * @param url Request URL
+ * @param out Receives "METHOD normalized-url"
+ * @param size Size of out
+ * @return 0 on success, -1 if the key does not fit
+ */
+int latency_trend_endpoint(const char *method, const char *url, char *out, size_t size);
+
+/**
+ * @brief Downsample a series with Largest-Triangle-Three-Buckets
+ *
+ * Keeps the first and last points and, from each of threshold - 2 equal
+ * buckets in between, the point forming the largest triangle with the
+ * point kept before it and the average of the next bucket.
+ *
+ * @param points Points in increasing x
+ * @param count Number of points
+ * @param threshold Points wanted
+ * @param out Receives min(count, threshold) points
+ * @return Number of points written
+ */
+int latency_trend_lttb(const trend_point_t *points, int count, int threshold, trend_point_t *out);
+
+#endif // LATENCY_TREND_H
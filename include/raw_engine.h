@@ -0,0 +1,191 @@
+/* ============================================================================
+ * API Kit - Raw HTTP/1.1 Load Engine
+ *
+ * A minimal HTTP/1.1 client for saturation tests, where libcurl's cost per
+ * request limits what one machine can send. Requests are serialized to
+ * bytes once. Each worker thread is pinned to a CPU and owns an epoll
+ * instance and its share of the keep-alive connections; it keeps up to
+ * pipeline requests in flight on every connection, writes them in batches
+ * with writev and parses the responses incrementally, tracking only their
+ * framing and status. Response bodies are discarded.
+ *
+ * Only plain http:// is supported, over TCP or a Unix socket ("# @unix-socket"),
+ * and "# @resolve" entries are honoured. All requests of a load run must go
+ * to the same place; they are sent in rotation. Load runs need Linux
+ * (epoll); elsewhere raw_load_run fails.
+ *
+ * raw_load_run_processes spreads a run over forked worker processes, so
+ * they do not contend on one allocator and one file table. Every worker
+ * thread publishes its counters and latency histogram into its own slot of
+ * a shared memory region; a slot has a single writer, so the parent sums
+ * the slots while the run goes on without any locking.
+ * ============================================================================ */
+
+#ifndef RAW_ENGINE_H
+#define RAW_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "compiled_request.h"
+#include "hdr_histogram.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define RAW_LINE_MAX 128                // Bytes kept of a status or header line
+#define RAW_DEFAULT_TIMEOUT_MS 10000
+#define RAW_PROGRESS_INTERVAL_MS 1000   // Between progress reports of a multi-process run
+
+// Latency histogram (see hdr_histogram.h): microseconds, 32 buckets per power
+// of two (about 3% resolution) up to 2^32 us
+#define RAW_LATENCY_PRECISION 5
+#define RAW_LATENCY_RANGE 32
+#define RAW_LATENCY_SUB_BUCKETS (1 << RAW_LATENCY_PRECISION)
+#define RAW_LATENCY_BUCKETS HDR_BUCKET_COUNT(RAW_LATENCY_PRECISION, RAW_LATENCY_RANGE)
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * Incremental response parser. It stops after each complete response so
+ * the caller can match it to its request; bytes after it are left for the
+ * next call.
+ */
+typedef struct {
+    int state;
+    int status;                 // Status code of the last or current response
+    int complete;               // The last raw_parser_feed call ended a response
+    int keep_alive;             // The connection stays open after that response
+    int chunked;
+    int has_length;
+    uint64_t remaining;         // Body or chunk bytes still to skip
+    size_t line_length;
+    char line[RAW_LINE_MAX];
+} raw_parser_t;
+
+typedef struct {
+    int threads;                // Worker threads, each pinned to a CPU (0 = one per usable CPU)
+    int connections;            // Connections in total, split across threads (0 = one per thread)
+    int pipeline;               // Requests in flight per connection (0 = 1)
+    uint64_t requests;          // Stop after sending this many (0 = until duration)
+    long duration_ms;           // Stop after this long (0 = until requests)
+    long timeout_ms;            // Fail a connection that makes no progress this long (0 = default)
+} raw_load_options_t;
+
+typedef struct {
+    uint64_t sent;              // Requests written
+    uint64_t responses;         // Complete responses
+    uint64_t status[6];         // Responses by class: [2] = 2xx ... [5] = 5xx, [0] = other
+    uint64_t errors;            // Connections that failed, timed out or sent malformed responses
+    uint64_t unanswered;        // Requests lost with a failed connection or left at the end
+    uint64_t reconnects;        // Connections reopened
+    uint64_t bytes_received;
+    uint64_t elapsed_ns;
+    uint64_t latency[RAW_LATENCY_BUCKETS];  // Responses by latency (see raw_latency_percentile)
+} raw_load_stats_t;
+
+/**
+ * Called by the parent of a multi-process run with the totals so far
+ * (elapsed_ns is the time since the start). Counters are read while the
+ * workers update them, so they may be a moment apart from each other.
+ */
+typedef void (*raw_load_progress_fn)(void *user_data, const raw_load_stats_t *totals);
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Serialize a request to the bytes sent on the wire
+ *
+ * The request line uses the URL's path and query; a Host header is added
+ * unless the request has one, and Content-Length when it has a body.
+ *
+ * @param request Compiled request with an http:// URL
+ * @param size Receives the length
+ * @return Bytes (free with free()), or NULL if the URL is not plain HTTP
+ *         or on allocation failure
+ */
+char *raw_request_serialize(const compiled_request_t *request, size_t *size);
+
+/**
+ * @brief Reset a parser for a new connection
+ */
+void raw_parser_init(raw_parser_t *parser);
+
+/**
+ * @brief Parse response bytes
+ *
+ * Consumes bytes up to the end of the current response at most. When it
+ * ends one, parser->complete is set and status and keep_alive describe it.
+ * Interim (1xx) responses are skipped.
+ *
+ * @param parser Parser
+ * @param data Bytes received
+ * @param size Number of bytes
+ * @return Bytes consumed, or -1 if the response is malformed
+ */
+long raw_parser_feed(raw_parser_t *parser, const char *data, size_t size);
+
+/**
+ * @brief Tell the parser the server closed the connection
+ * @return 1 if that ends a response (a body read until close), 0 if no
+ *         response was in progress, -1 if one was cut short
+ */
+int raw_parser_finish(raw_parser_t *parser);
+
+/**
+ * @brief Send requests as fast as the connections allow
+ *
+ * Runs until options->requests have been sent and answered, or until
+ * options->duration_ms has passed, whichever comes first; with neither,
+ * every request is sent once. A connection that fails after receiving
+ * responses is reopened; one that fails before its first response is not.
+ *
+ * @param requests Compiled requests, sent in rotation
+ * @param count Number of requests
+ * @param options Load options
+ * @param stats Receives the totals
+ * @return 0 on success, -1 if the requests cannot be sent by this engine
+ *         (not plain HTTP/1.1, different targets) or the run could not start
+ */
+int raw_load_run(const compiled_request_t *const *requests, int count,
+                 const raw_load_options_t *options, raw_load_stats_t *stats);
+
+/**
+ * @brief Run the load in worker processes
+ *
+ * Forks processes children and gives each an equal share of the threads
+ * and connections (the duration applies to each). Requests are claimed
+ * from one counter in the shared region, so a process that gets through
+ * its responses faster sends more of them. Threads are pinned to
+ * different CPUs across all children. The parent only watches: it calls
+ * progress every RAW_PROGRESS_INTERVAL_MS until all children have
+ * exited, then sums their final counters into stats.
+ *
+ * @param requests Compiled requests, sent in rotation
+ * @param count Number of requests
+ * @param options Load options for the whole run
+ * @param processes Worker processes (at most one per thread)
+ * @param progress Live totals callback (may be NULL)
+ * @param user_data Passed to progress
+ * @param stats Receives the totals
+ * @return 0 on success, -1 if the requests cannot be sent by this engine,
+ *         the shared region could not be mapped, no child could be forked
+ *         or a child failed (stats still holds what the others sent)
+ */
+int raw_load_run_processes(const compiled_request_t *const *requests, int count,
+                           const raw_load_options_t *options, int processes,
+                           raw_load_progress_fn progress, void *user_data, raw_load_stats_t *stats);
+
+/**
+ * @brief Latency at a percentile of the recorded responses
+ * @param stats Totals of a run
+ * @param percentile 0 to 100
+ * @return Microseconds (the middle of the bucket), 0 if nothing was recorded
+ */
+uint64_t raw_latency_percentile(const raw_load_stats_t *stats, double percentile);
+
+#endif // RAW_ENGINE_H
@@ -0,0 +1,99 @@
+/* ============================================================================
+ * API Kit - Response Search
+ *
+ * Find-in-response over the raw body. A search runs on a worker thread and
+ * publishes match positions as it finds them, so the first hit can be shown
+ * long before a large body has been scanned completely. Navigating between
+ * matches only looks up the already collected positions.
+ * ============================================================================ */
+
+#ifndef RESPONSE_SEARCH_H
+#define RESPONSE_SEARCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef enum {
+    SEARCH_MODE_TEXT,          // Plain text, case-sensitive
+    SEARCH_MODE_IGNORE_CASE,   // Plain text, ASCII case-insensitive
+    SEARCH_MODE_REGEX          // POSIX extended regular expression, per line
+} search_mode_t;
+
+// Match position in the raw body
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} search_match_t;
+
+typedef struct response_search response_search_t;
+
+/* ============================================================================
+ * SEARCH API
+ * ============================================================================ */
+
+/**
+ * @brief Find the first occurrence of a needle (vectorized where available)
+ * @param haystack Bytes to search
+ * @param haystack_size Number of bytes
+ * @param needle Pattern bytes
+ * @param needle_size Pattern length (must be > 0)
+ * @param ignore_case Compare ASCII letters case-insensitively
+ * @return Offset of the match, or -1 if there is none
+ */
+long search_find(const char *haystack, size_t haystack_size,
+                 const char *needle, size_t needle_size, int ignore_case);
+
+/**
+ * @brief Start searching a body on a worker thread
+ * @param data Body to search; must stay valid until the search is destroyed
+ * @param size Body size
+ * @param pattern Search text or regular expression
+ * @param mode Search mode
+ * @return Search handle, or NULL on allocation failure or empty pattern
+ */
+response_search_t *response_search_start(const char *data, size_t size,
+                                         const char *pattern, search_mode_t mode);
+
+/**
+ * @brief Stop the worker and free the search
+ * @param search Search to destroy (may be NULL)
+ */
+void response_search_destroy(response_search_t *search);
+
+/**
+ * @brief Number of matches found so far (safe to call while searching)
+ */
+size_t response_search_match_count(const response_search_t *search);
+
+/**
+ * @brief Whether the whole body has been scanned
+ */
+int response_search_is_complete(const response_search_t *search);
+
+/**
+ * @brief Error message if the pattern could not be compiled, else NULL
+ */
+const char *response_search_error(const response_search_t *search);
+
+/**
+ * @brief Get a published match
+ * @param search Search handle
+ * @param index Match index, must be below response_search_match_count()
+ * @param match Receives the match
+ * @return 0 on success, -1 if the index is not available
+ */
+int response_search_get(const response_search_t *search, size_t index, search_match_t *match);
+
+/**
+ * @brief Index of the first published match starting at or after offset
+ * @param search Search handle
+ * @param offset Body offset
+ * @return Match index, or -1 if no such match has been found yet
+ */
+long response_search_find_from(const response_search_t *search, size_t offset);
+
+#endif // RESPONSE_SEARCH_H
@@ -0,0 +1,77 @@
+/* ============================================================================
+ * API Kit - Response View
+ *
+ * Owns a response body and formats it on a worker thread. The view publishes
+ * lines as they are indexed, so the first screen can be drawn while the rest
+ * of a large body is still being processed.
+ * ============================================================================ */
+
+#ifndef RESPONSE_VIEW_H
+#define RESPONSE_VIEW_H
+
+#include <stddef.h>
+#include "json_format.h"
+
+typedef struct response_view response_view_t;
+
+/**
+ * @brief Create a view and start formatting in the background
+ * @param body Response body; ownership moves to the view (freed on destroy)
+ * @param size Body size in bytes
+ * @return View handle, or NULL on allocation failure (body is freed)
+ */
+response_view_t *response_view_create(char *body, size_t size);
+
+/**
+ * @brief Stop the worker and free the view and its body
+ * @param view View to destroy (may be NULL)
+ */
+void response_view_destroy(response_view_t *view);
+
+/**
+ * @brief Number of lines published so far (safe to call while formatting)
+ */
+size_t response_view_line_count(const response_view_t *view);
+
+/**
+ * @brief Whether the worker has finished indexing the whole body
+ */
+int response_view_is_complete(const response_view_t *view);
+
+/**
+ * @brief Whether the body is being shown as formatted JSON
+ */
+int response_view_is_json(const response_view_t *view);
+
+/**
+ * @brief Access the raw body
+ * @param view View handle
+ * @param size Receives the body size (may be NULL)
+ * @return Raw body bytes (NUL-terminated)
+ */
+const char *response_view_body(const response_view_t *view, size_t *size);
+
+/**
+ * @brief Render a published line
+ * @param view View handle
+ * @param index Line index, must be below response_view_line_count()
+ * @param out Output buffer
+ * @param out_size Size of output buffer
+ * @param spans Highlight spans (may be NULL)
+ * @param max_spans Capacity of spans
+ * @param span_count Receives the number of spans written (may be NULL)
+ * @return Number of characters written, or -1 if the line is not available
+ */
+int response_view_render_line(const response_view_t *view, size_t index,
+                              char *out, int out_size,
+                              json_span_t *spans, int max_spans, int *span_count);
+
+/**
+ * @brief Find the published line containing a raw body offset
+ * @param view View handle
+ * @param offset Offset into the raw body
+ * @return Line index, or -1 if that part of the body is not indexed yet
+ */
+long response_view_line_for_offset(const response_view_t *view, size_t offset);
+
+#endif // RESPONSE_VIEW_H
@@ -10,6 +10,14 @@
 
 #include "http_client.h"
 #include "http_parser.h"
+#include "response_view.h"
+#include "response_search.h"
+#include "http_task.h"
+#include "compiled_request.h"
+#include "environment.h"
+#include "template.h"
+#include "capture.h"
+#include "latency_trend.h"
 
 /* ============================================================================
  * CONSTANTS
@@ -19,6 +27,7 @@
 #define MAX_COLLECTIONS_PER_WORKSPACE 10
 #define MAX_REQUESTS_PER_COLLECTION 20
 #define MAX_HISTORY_ITEMS 100
+#define MAX_NETWORK_PROFILES 8
 
 /* ============================================================================
  * TYPE DEFINITIONS
@@ -80,6 +89,14 @@ typedef struct {
     int prev_ctrl_f_combo;
 } keyboard_state_t;
 
+// Routing for requests ([network] and [network.workspaces."Name"] in config.toml)
+typedef struct {
+    char workspace[128];       // Workspace the profile applies to, empty = every workspace
+    char unix_socket[256];     // Unix domain socket to connect through, empty = TCP
+    char resolve[1024];        // "host:port:address" overrides, one per line
+    char http_version[24];     // "1.1", "2" or "2-prior-knowledge", empty = libcurl's choice
+} network_settings_t;
+
 // Application settings
 typedef struct {
     char data_folder_path[512];
@@ -88,6 +105,12 @@ typedef struct {
     int ctrl_b_enabled;
     int ctrl_f_enabled;
     int delete_key_enabled;
+    char trace_path[512];      // Chrome trace output ([debug] trace_file), empty = off
+    char environment[64];      // Active environment ([environment] active), empty = none
+    int cache_enabled;         // HTTP cache in <data folder>/cache ([cache] enabled)
+    int cache_memory_mb;       // In-memory part of the cache ([cache] memory_mb)
+    network_settings_t network[MAX_NETWORK_PROFILES];
+    int network_count;
 } settings_t;
 
 
@@ -103,11 +126,27 @@ typedef struct {
     char url[512];
     char headers[1024];
     char body[2048];
-    char response[8192];
+    char response[8192];          // Status line and headers of the last response
+    response_view_t *response_view;  // Body of the last response, formatted in the background
     int method_selected;
     int request_in_progress;
+    http_task_t *request_task;    // SEND running on a worker thread, NULL otherwise
+    char request_url[512];        // URL of the running SEND as it was sent, for history
     long last_status_code;
-    
+    compiled_request_t *compiled_request;  // Editor request as last compiled, reused while unchanged
+
+    // Environments ({{name}} variables)
+    environment_list_t environments;        // Loaded from <data folder>/environments.toml
+    int active_environment;                 // Index into environments.items, -1 = shared only
+    template_vars_t *variables;             // Values of the active environment
+
+    // Find-in-response
+    char response_search_text[256];
+    int response_search_mode;               // search_mode_t
+    response_search_t *response_search;     // Borrows the body owned by response_view
+    long response_search_current;           // Focused match index, -1 if none
+    int response_search_scroll;             // Scroll to the focused match on the next frame
+
     // UI state
     int show_sidebar;
     int show_settings_page;
@@ -117,6 +156,7 @@ typedef struct {
     // Data
     history_item_t history[MAX_HISTORY_ITEMS];
     int history_count;
+    latency_trends_t *latency_trends;       // Per-endpoint series, <data folder>/latency_trends.txt
     workspace_t workspaces[MAX_WORKSPACES];
     int workspace_count;
     int active_workspace;
@@ -168,8 +208,36 @@ void store_ensure_data_directory(void);
  * HISTORY MANAGEMENT API
  * ============================================================================ */
 
-// History operations
-void store_add_to_history(const char* method, const char* url, long status_code);
+// History operations; every send also goes into its endpoint's latency trend
+void store_add_to_history(const char* method, const char* url, long status_code, uint64_t latency_us);
+
+// Sparkline and badges of the endpoint a request belongs to, NULL if it has no samples
+const latency_trend_t* store_latency_trend(const char* method, const char* url);
+
+/* ============================================================================
+ * REQUEST COMPILATION API
+ * ============================================================================ */
+
+// Compiled form of the editor request with {{variables}} rendered; the text is
+// reparsed only when edited and the header list rebuilt only when the output changes
+compiled_request_t* store_compiled_request(http_method_t method);
+void store_free_request_cache(void);
+
+// Run the "# @capture" directives of the last compiled request against its response
+int store_apply_captures(const http_response_t* response);
+
+// The active workspace's requests with {{variables}} rendered and network
+// routes added, for connection warm-up; the caller destroys each entry.
+// Bodies are left out. Returns the count.
+int store_workspace_requests(compiled_request_t** requests, int max);
+
+/* ============================================================================
+ * ENVIRONMENT API
+ * ============================================================================ */
+
+// Environment operations
+void store_load_environments(void);
+void store_select_environment(int index);
 
 /* ============================================================================
  * COLLECTION MANAGEMENT API
@@ -0,0 +1,143 @@
+/* ============================================================================
+ * API Kit - Request Templates
+ *
+ * {{name}} placeholders in URLs, headers and bodies. A template is parsed
+ * once into a list of segments (literal spans of the source and variable
+ * slots); rendering walks the list and copies into a reusable buffer, so
+ * changing variable values (switching environments, per-iteration data in
+ * load runs) never reparses the text.
+ * ============================================================================ */
+
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include <stddef.h>
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+// Variable table: names are interned into slots that templates refer to by index
+typedef struct template_vars template_vars_t;
+
+// Compiled template (opaque)
+typedef struct template template_t;
+
+// Render output, reused across renders; grows but never shrinks
+typedef struct {
+    char *data;          // NUL-terminated
+    size_t length;
+    size_t capacity;
+} template_buffer_t;
+
+/* ============================================================================
+ * VARIABLES
+ * ============================================================================ */
+
+/**
+ * @brief Create an empty variable table
+ * @return Table, or NULL on allocation failure
+ */
+template_vars_t *template_vars_create(void);
+
+/**
+ * @brief Free a variable table and the values it owns
+ * @param vars Table to free (may be NULL)
+ */
+void template_vars_destroy(template_vars_t *vars);
+
+/**
+ * @brief Look up or add the slot for a variable name
+ * @param vars Variable table
+ * @param name Variable name
+ * @param length Length of name
+ * @return Slot index, or -1 on allocation failure
+ */
+int template_vars_slot(template_vars_t *vars, const char *name, size_t length);
+
+/**
+ * @brief Set a variable to a copy of value
+ * @param vars Variable table
+ * @param name Variable name (added if unknown)
+ * @param value Value, or NULL to unset
+ * @return 0 on success, -1 on allocation failure
+ */
+int template_vars_set(template_vars_t *vars, const char *name, const char *value);
+
+/**
+ * @brief Point a slot at caller-owned bytes without copying
+ *
+ * For per-iteration data in load runs: the bytes must stay valid until the
+ * slot is set again or the next render that uses it has finished.
+ */
+void template_vars_bind(template_vars_t *vars, int slot, const char *value, size_t length);
+
+/**
+ * @brief Unset every variable (slots and compiled templates stay valid)
+ */
+void template_vars_clear(template_vars_t *vars);
+
+/**
+ * @brief Number of slots in the table
+ */
+int template_vars_count(const template_vars_t *vars);
+
+/**
+ * @brief Current value of a variable
+ * @return Value, or NULL when unknown or unset (bound values are not NUL-terminated)
+ */
+const char *template_vars_get(const template_vars_t *vars, const char *name);
+
+/* ============================================================================
+ * TEMPLATES
+ * ============================================================================ */
+
+/**
+ * @brief Compile template text against a variable table
+ *
+ * Placeholders are {{name}} with optional spaces inside the braces; names
+ * use letters, digits and "_-.$". Anything else, including an unterminated
+ * "{{", is literal text. Unknown names are added to vars as unset slots.
+ *
+ * @param text Template text (NULL compiles as empty)
+ * @param vars Variable table the template's slots refer to
+ * @return Template, or NULL on allocation failure
+ */
+template_t *template_compile(const char *text, template_vars_t *vars);
+
+/**
+ * @brief Free a compiled template
+ * @param template Template to free (may be NULL)
+ */
+void template_destroy(template_t *template);
+
+/**
+ * @brief Number of placeholders in a template
+ */
+int template_placeholder_count(const template_t *template);
+
+/**
+ * @brief Slot of the index-th placeholder (in source order)
+ * @return Slot, or -1 if index is out of range
+ */
+int template_placeholder_slot(const template_t *template, int index);
+
+/**
+ * @brief Render a template into a buffer
+ *
+ * Unset variables are left in the output as the original placeholder text.
+ *
+ * @param template Compiled template
+ * @param vars The table the template was compiled against
+ * @param out Output buffer (replaced, not appended to)
+ * @return Number of unset placeholders, or -1 on allocation failure
+ */
+int template_render(const template_t *template, const template_vars_t *vars, template_buffer_t *out);
+
+/**
+ * @brief Free a render buffer's memory
+ * @param buffer Buffer to reset (may be NULL)
+ */
+void template_buffer_free(template_buffer_t *buffer);
+
+#endif // TEMPLATE_H
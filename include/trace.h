@@ -0,0 +1,92 @@
+/* ============================================================================
+ * API Kit - Tracing
+ *
+ * Records timed spans into per-thread ring buffers and writes them as Chrome
+ * trace-event JSON (viewable in Perfetto or chrome://tracing). Recording is
+ * lock-free; when tracing is off, trace_begin() is a single relaxed load.
+ *
+ * Usage:
+ *   uint64_t t = trace_begin();
+ *   ... work ...
+ *   trace_end("store_save_data", "store", t);
+ *
+ * Span names and categories must be string literals (only the pointers are
+ * stored). While tracing is active, SIGUSR1 writes the trace file from a
+ * helper thread, so a trace can be captured from a hung process.
+ * ============================================================================ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Events kept per thread buffer; older events are overwritten
+#define TRACE_BUFFER_EVENTS 16384
+
+extern int trace_enabled_flag;
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ */
+uint64_t trace_now_ns(void);
+
+/**
+ * @brief Start a span
+ * @return Start timestamp, or 0 when tracing is off
+ */
+static inline uint64_t trace_begin(void) {
+    return __builtin_expect(__atomic_load_n(&trace_enabled_flag, __ATOMIC_RELAXED), 0) ? trace_now_ns() : 0;
+}
+
+/**
+ * @brief Finish a span started with trace_begin()
+ * @param name Span name (string literal)
+ * @param category Category shown in the viewer (string literal)
+ * @param start_ns Value returned by trace_begin(); 0 records nothing
+ */
+void trace_end(const char *name, const char *category, uint64_t start_ns);
+
+/**
+ * @brief Record a span with explicit timing (e.g. phases reported by libcurl)
+ * @param name Span name (string literal)
+ * @param category Category (string literal)
+ * @param start_ns Start on the trace_now_ns() clock
+ * @param duration_ns Span length
+ */
+void trace_complete(const char *name, const char *category, uint64_t start_ns, uint64_t duration_ns);
+
+/**
+ * @brief Record a zero-length marker
+ */
+void trace_instant(const char *name, const char *category);
+
+/**
+ * @brief Name the calling thread in the trace (string literal)
+ */
+void trace_set_thread_name(const char *name);
+
+/**
+ * @brief Enable tracing and install the SIGUSR1 dump handler
+ * @param path Trace file written by trace_stop() and on SIGUSR1
+ * @return 0 on success, -1 on error
+ */
+int trace_start(const char *path);
+
+/**
+ * @brief Write the trace file and disable tracing
+ */
+void trace_stop(void);
+
+/**
+ * @brief Whether spans are currently being recorded
+ */
+int trace_is_enabled(void);
+
+/**
+ * @brief Write the events recorded since trace_start() as Chrome JSON
+ * @param path Output file
+ * @return Number of events written, or -1 on error
+ */
+int trace_dump(const char *path);
+
+#endif // TRACE_H
@@ -0,0 +1,115 @@
+/* ============================================================================
+ * API Kit - Work-Stealing Scheduler
+ *
+ * A fixed pool of worker threads, each with its own double-ended queue of
+ * tasks (a Chase-Lev deque). A worker pushes and pops tasks at the bottom
+ * of its own deque without locks; a worker that runs out steals from the
+ * top of a random other worker's deque, so slow tasks on one worker do not
+ * leave the others idle. Tasks submitted from outside the pool go through
+ * a shared queue that idle workers take from.
+ *
+ * work_scheduler_for runs a loop body over a range of indexes. The range is
+ * split in halves as it runs: a worker keeps the lower half and leaves the
+ * upper one in its deque, where a thief takes the biggest piece left. Use
+ * it for independent iterations or data rows.
+ *
+ * Every worker counts the tasks it ran, the tasks it stole and the time it
+ * spent in them, so the client side's utilization can be checked.
+ * ============================================================================ */
+
+#ifndef WORK_SCHEDULER_H
+#define WORK_SCHEDULER_H
+
+#include <stdint.h>
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct work_scheduler work_scheduler_t;
+
+/**
+ * A task. worker is the index of the worker thread running it, for
+ * per-worker state that needs no locking.
+ */
+typedef void (*work_fn)(void *arg, int worker);
+
+// Loop body of work_scheduler_for
+typedef void (*work_index_fn)(void *arg, uint64_t index, int worker);
+
+typedef struct {
+    uint64_t tasks;             // Tasks run
+    uint64_t steals;            // Tasks taken from another worker's deque
+    uint64_t busy_ns;           // Time spent running tasks
+    uint64_t elapsed_ns;        // Time since the scheduler was created
+} work_worker_stats_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Start a scheduler
+ * @param workers Worker threads (0 = one per usable CPU)
+ * @return Scheduler, or NULL on allocation failure
+ */
+work_scheduler_t *work_scheduler_create(int workers);
+
+/**
+ * @brief Stop the workers and free the scheduler
+ *
+ * Tasks still queued are dropped without running. Call work_scheduler_wait
+ * first to finish them.
+ *
+ * @param scheduler Scheduler (may be NULL)
+ */
+void work_scheduler_destroy(work_scheduler_t *scheduler);
+
+/**
+ * @brief Queue a task
+ *
+ * From a task of this scheduler the task goes to the bottom of the
+ * running worker's deque; from any other thread, to the shared queue.
+ *
+ * @param scheduler Scheduler
+ * @param fn Task function
+ * @param arg Passed to fn
+ * @return 0 on success, -1 on allocation failure
+ */
+int work_scheduler_submit(work_scheduler_t *scheduler, work_fn fn, void *arg);
+
+/**
+ * @brief Block until every queued task, and every task they queued, has run
+ *
+ * Must not be called from a task. If no worker thread could be started,
+ * the calling thread runs the tasks itself.
+ */
+void work_scheduler_wait(work_scheduler_t *scheduler);
+
+/**
+ * @brief Run fn for every index in [0, count) and wait for all of them
+ *
+ * @param scheduler Scheduler
+ * @param count Number of indexes
+ * @param grain Indexes a worker runs without splitting the range further (0 = 1)
+ * @param fn Loop body
+ * @param arg Passed to fn
+ * @return 0 on success, -1 on allocation failure (some indexes may have run)
+ */
+int work_scheduler_for(work_scheduler_t *scheduler, uint64_t count, uint64_t grain,
+                       work_index_fn fn, void *arg);
+
+/**
+ * @brief Number of worker threads
+ */
+int work_scheduler_workers(const work_scheduler_t *scheduler);
+
+/**
+ * @brief Counters of one worker, read while it may be running
+ * @param scheduler Scheduler
+ * @param worker Worker index
+ * @return Counters (all zero for an invalid index)
+ */
+work_worker_stats_t work_scheduler_worker_stats(const work_scheduler_t *scheduler, int worker);
+
+#endif // WORK_SCHEDULER_H
@@ -0,0 +1,144 @@
+/* ============================================================================
+ * API Kit - Response Captures Implementation
+ * ============================================================================ */
+
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * DIRECTIVE PARSING
+ * ============================================================================ */
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Copy [start, end) into out with surrounding blanks removed; -1 if empty or too long
+static int copy_trimmed(const char *start, const char *end, char *out, size_t out_size) {
+    start = skip_blanks(start, end);
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+
+    size_t length = (size_t)(end - start);
+    if (length == 0 || length >= out_size) return -1;
+    memcpy(out, start, length);
+    out[length] = '\0';
+    return 0;
+}
+
+static int parse_directive(const char *line, const char *end, capture_t *capture) {
+    const char *p = skip_blanks(line + strlen(CAPTURE_DIRECTIVE), end);
+    const char *equals = memchr(p, '=', (size_t)(end - p));
+    if (!equals || copy_trimmed(p, equals, capture->variable, sizeof(capture->variable)) != 0) {
+        return -1;
+    }
+
+    char source[300];
+    if (copy_trimmed(equals + 1, end, source, sizeof(source)) != 0) return -1;
+
+    if (strcmp(source, "status") == 0) {
+        capture->source = CAPTURE_STATUS;
+        return 0;
+    }
+    if (strncmp(source, "header ", 7) == 0) {
+        capture->source = CAPTURE_HEADER;
+        return copy_trimmed(source + 7, source + strlen(source), capture->header, sizeof(capture->header));
+    }
+    if (strcmp(source, "body") == 0) {
+        capture->source = CAPTURE_BODY;
+        return json_path_compile("$", &capture->path);
+    }
+    if (strncmp(source, "body ", 5) == 0) {
+        capture->source = CAPTURE_BODY;
+        const char *expression = skip_blanks(source + 5, source + strlen(source));
+        return json_path_compile(expression, &capture->path);
+    }
+    return -1;
+}
+
+int capture_parse(const char *headers, capture_list_t *list) {
+    list->count = 0;
+    if (!headers) return 0;
+
+    size_t directive_length = strlen(CAPTURE_DIRECTIVE);
+    const char *p = headers;
+    while (*p && list->count < MAX_CAPTURES) {
+        const char *end = strchr(p, '\n');
+        if (!end) end = p + strlen(p);
+
+        const char *line = skip_blanks(p, end);
+        if ((size_t)(end - line) > directive_length &&
+            strncmp(line, CAPTURE_DIRECTIVE, directive_length) == 0 &&
+            (line[directive_length] == ' ' || line[directive_length] == '\t')) {
+            capture_t *capture = &list->items[list->count];
+            memset(capture, 0, sizeof(*capture));
+            if (parse_directive(line, end, capture) == 0) {
+                list->count++;
+            }
+        }
+        p = *end ? end + 1 : end;
+    }
+    return list->count;
+}
+
+/* ============================================================================
+ * EXTRACTION
+ * ============================================================================ */
+
+// Value of a header in the final response (the last one if repeated), or NULL
+static char *find_header(const http_headers_t *headers, const char *name) {
+    const http_header_t *found = http_headers_find(headers, -1, name);
+    if (!found) return NULL;
+
+    for (const http_header_t *next = found; next; next = http_headers_find_next(headers, next)) {
+        found = next;
+    }
+
+    char *text = malloc(found->value_length + 1);
+    if (!text) return NULL;
+    memcpy(text, headers->text + found->value_offset, found->value_length);
+    text[found->value_length] = '\0';
+    return text;
+}
+
+static char *capture_value(const capture_t *capture, const http_response_t *response) {
+    switch (capture->source) {
+        case CAPTURE_STATUS: {
+            char *text = malloc(16);
+            if (text) snprintf(text, 16, "%ld", response->status_code);
+            return text;
+        }
+        case CAPTURE_HEADER:
+            return find_header(&response->header_fields, capture->header);
+        case CAPTURE_BODY: {
+            if (!response->body) return NULL;
+            if (capture->path.step_count == 0) {
+                return json_path_value_text(response->body, response->body_size);
+            }
+
+            const char *value;
+            size_t length;
+            if (json_path_find(response->body, response->body_size, &capture->path, &value, &length) != 0) {
+                return NULL;
+            }
+            return json_path_value_text(value, length);
+        }
+    }
+    return NULL;
+}
+
+int capture_apply(const capture_list_t *list, const http_response_t *response, template_vars_t *vars) {
+    if (!list || !response || !vars) return 0;
+
+    int set = 0;
+    for (int i = 0; i < list->count; i++) {
+        char *value = capture_value(&list->items[i], response);
+        if (!value) continue;
+
+        if (template_vars_set(vars, list->items[i].variable, value) == 0) set++;
+        free(value);
+    }
+    return set;
+}
@@ -0,0 +1,583 @@
+/* ============================================================================
+ * API Kit - Collection Runner Implementation
+ * ============================================================================ */
+
+#include "collection_runner.h"
+#include "capture.h"
+#include "compiled_request.h"
+#include "http_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ============================================================================
+ * INTERNAL TYPES
+ * ============================================================================ */
+
+typedef struct {
+    int *items;
+    int count;
+    int capacity;
+} index_list_t;
+
+typedef struct run_node {
+    struct collection_run *run;
+    int index;
+    const http_request_t *request;
+    http_method_t method;
+    template_t *url;
+    template_t *headers;
+    template_t *body;               // NULL for methods without a body
+    capture_list_t captures;
+    index_list_t uses;              // Slots referenced by the templates
+    index_list_t dependencies;
+    index_list_t dependents;
+    int waiting;                    // Dependencies not finished yet
+    compiled_request_t *compiled;   // While in flight
+    run_result_t result;
+} run_node_t;
+
+struct collection_run {
+    run_node_t *nodes;
+    int count;
+    template_vars_t *vars;
+    http_engine_t *engine;
+    run_options_t options;
+    int in_flight;                  // Submitted to the engine, response not seen yet
+
+    // Nodes whose dependencies are done, in the order they became ready
+    int *ready;
+    int ready_head;
+    int ready_tail;
+
+    template_buffer_t url_out;
+    template_buffer_t headers_out;
+    template_buffer_t body_out;
+    uint64_t start_ns;
+    uint64_t elapsed_ns;
+    int warm_connections;
+    http_connection_stats_t *connections;   // Of the last execution, copied from the engine
+    int connection_count;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int list_contains(const index_list_t *list, int value) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->items[i] == value) return 1;
+    }
+    return 0;
+}
+
+static int list_add(index_list_t *list, int value) {
+    if (list_contains(list, value)) return 0;
+
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 4;
+        int *items = realloc(list->items, (size_t)capacity * sizeof(int));
+        if (!items) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = value;
+    return 0;
+}
+
+/* ============================================================================
+ * PLANNING
+ * ============================================================================ */
+
+static int add_dependency(collection_run_t *run, int node, int dependency) {
+    if (node == dependency) return 0;
+    if (list_add(&run->nodes[node].dependencies, dependency) != 0) return -1;
+    return list_add(&run->nodes[dependency].dependents, node);
+}
+
+static int collect_uses(run_node_t *node) {
+    const template_t *templates[] = {node->url, node->headers, node->body};
+    for (int t = 0; t < 3; t++) {
+        int count = template_placeholder_count(templates[t]);
+        for (int i = 0; i < count; i++) {
+            if (list_add(&node->uses, template_placeholder_slot(templates[t], i)) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static int compile_node(collection_run_t *run, run_node_t *node) {
+    node->method = http_method_from_name(node->request->method);
+    node->url = template_compile(node->request->url, run->vars);
+    node->headers = template_compile(node->request->headers, run->vars);
+    if (!node->url || !node->headers) return -1;
+
+    if (node->method == HTTP_METHOD_POST || node->method == HTTP_METHOD_PUT ||
+        node->method == HTTP_METHOD_PATCH) {
+        node->body = template_compile(node->request->body, run->vars);
+        if (!node->body) return -1;
+    }
+
+    capture_parse(node->request->headers, &node->captures);
+    return collect_uses(node);
+}
+
+// "# @depends-on NAME" lines; names refer to the first request with that name
+static int add_declared_dependencies(collection_run_t *run, run_node_t *node) {
+    size_t directive_length = strlen(RUN_DEPENDS_DIRECTIVE);
+    const char *p = node->request->headers;
+    while (*p) {
+        const char *end = strchr(p, '\n');
+        if (!end) end = p + strlen(p);
+
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if ((size_t)(end - p) > directive_length &&
+            strncmp(p, RUN_DEPENDS_DIRECTIVE, directive_length) == 0) {
+            const char *name = p + directive_length;
+            const char *name_end = end;
+            while (name < name_end && (*name == ' ' || *name == '\t')) name++;
+            while (name_end > name && (name_end[-1] == ' ' || name_end[-1] == '\t' || name_end[-1] == '\r')) {
+                name_end--;
+            }
+
+            size_t length = (size_t)(name_end - name);
+            for (int i = 0; i < run->count && length > 0; i++) {
+                const char *other = run->nodes[i].request->name;
+                if (strncmp(other, name, length) == 0 && other[length] == '\0') {
+                    if (add_dependency(run, node->index, i) != 0) return -1;
+                    break;
+                }
+            }
+        }
+        p = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
+static int slot_of(collection_run_t *run, const char *name) {
+    return template_vars_slot(run->vars, name, strlen(name));
+}
+
+// Order every read and write of a variable as in a sequential run
+static int infer_dependencies(collection_run_t *run) {
+    int slot_count = template_vars_count(run->vars);
+    int *last_writer = malloc((size_t)(slot_count > 0 ? slot_count : 1) * sizeof(int));
+    if (!last_writer) return -1;
+    for (int s = 0; s < slot_count; s++) last_writer[s] = -1;
+
+    int status = 0;
+    for (int j = 0; j < run->count && status == 0; j++) {
+        run_node_t *node = &run->nodes[j];
+
+        // Read after write
+        for (int u = 0; u < node->uses.count && status == 0; u++) {
+            int writer = last_writer[node->uses.items[u]];
+            if (writer >= 0) status = add_dependency(run, j, writer);
+        }
+
+        for (int c = 0; c < node->captures.count && status == 0; c++) {
+            int slot = slot_of(run, node->captures.items[c].variable);
+            if (slot < 0 || slot >= slot_count) {
+                status = -1;
+                break;
+            }
+
+            // Write after write, and write after the reads of the previous value
+            int writer = last_writer[slot];
+            if (writer >= 0) status = add_dependency(run, j, writer);
+            for (int k = writer + 1; k < j && status == 0; k++) {
+                if (list_contains(&run->nodes[k].uses, slot)) status = add_dependency(run, j, k);
+            }
+            last_writer[slot] = j;
+        }
+
+        if (status == 0) status = add_declared_dependencies(run, node);
+    }
+
+    free(last_writer);
+    return status;
+}
+
+collection_run_t *collection_run_create(const http_request_t *requests, int count, template_vars_t *vars) {
+    if (!requests || count < 0 || !vars) return NULL;
+
+    collection_run_t *run = calloc(1, sizeof(collection_run_t));
+    if (!run) return NULL;
+    run->vars = vars;
+    run->count = count;
+    run->nodes = calloc((size_t)(count > 0 ? count : 1), sizeof(run_node_t));
+    run->ready = malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    if (!run->nodes || !run->ready) goto fail;
+
+    for (int i = 0; i < count; i++) {
+        run_node_t *node = &run->nodes[i];
+        node->run = run;
+        node->index = i;
+        node->request = &requests[i];
+        if (compile_node(run, node) != 0) goto fail;
+    }
+
+    // Capture variables need slots before the per-slot pass sizes its table
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < run->nodes[i].captures.count; c++) {
+            if (slot_of(run, run->nodes[i].captures.items[c].variable) < 0) goto fail;
+        }
+    }
+    if (infer_dependencies(run) != 0) goto fail;
+
+    for (int i = 0; i < count; i++) {
+        run_node_t *node = &run->nodes[i];
+        node->result.dependency_count = node->dependencies.count;
+        node->result.dependencies = node->dependencies.items;
+    }
+    return run;
+
+fail:
+    collection_run_destroy(run);
+    return NULL;
+}
+
+/* ============================================================================
+ * EXECUTION
+ * ============================================================================ */
+
+static void finish_node(collection_run_t *run, run_node_t *node);
+static void submit_ready(collection_run_t *run);
+
+static void skip_node(collection_run_t *run, run_node_t *node, const char *reason) {
+    if (node->result.state != RUN_PENDING) return;
+
+    node->result.state = RUN_SKIPPED;
+    snprintf(node->result.error, sizeof(node->result.error), "%s", reason);
+    node->result.start_ns = node->result.end_ns = now_ns() - run->start_ns;
+    finish_node(run, node);
+}
+
+static void finish_node(collection_run_t *run, run_node_t *node) {
+    if (run->options.on_result) {
+        run->options.on_result(run->options.user_data, node->index, &node->result);
+    }
+
+    for (int i = 0; i < node->dependents.count; i++) {
+        run_node_t *dependent = &run->nodes[node->dependents.items[i]];
+        if (dependent->result.state != RUN_PENDING) continue;
+
+        if (node->result.state == RUN_PASSED) {
+            if (--dependent->waiting == 0) {
+                run->ready[run->ready_tail++] = dependent->index;
+            }
+        } else {
+            char reason[128];
+            snprintf(reason, sizeof(reason), "dependency \"%.100s\" did not pass", node->request->name);
+            skip_node(run, dependent, reason);
+        }
+    }
+}
+
+static void on_response(void *user_data, http_response_t *response) {
+    run_node_t *node = user_data;
+    collection_run_t *run = node->run;
+    run_result_t *result = &node->result;
+
+    run->in_flight--;
+    result->end_ns = now_ns() - run->start_ns;
+    if (!response) {
+        result->state = RUN_FAILED;
+        snprintf(result->error, sizeof(result->error), "could not start request");
+    } else {
+        result->status_code = response->status_code;
+        result->body_size = response->body_size;
+        result->wire_size = response->wire_size;
+        result->attempts = response->attempt_count;
+        if (response->error_message) {
+            result->state = RUN_FAILED;
+            snprintf(result->error, sizeof(result->error), "%s", response->error_message);
+        } else if (response->status_code >= 400 || response->status_code == 0) {
+            result->state = RUN_FAILED;
+            snprintf(result->error, sizeof(result->error), "HTTP %ld", response->status_code);
+        } else {
+            result->state = RUN_PASSED;
+            capture_apply(&node->captures, response, run->vars);
+        }
+        http_response_free(response);
+    }
+
+    compiled_request_destroy(node->compiled);
+    node->compiled = NULL;
+    finish_node(run, node);
+
+    // Dependents start in this engine turn, not after its next poll
+    submit_ready(run);
+}
+
+// Render with the values captured so far and hand the request to the engine
+static void submit_node(collection_run_t *run, run_node_t *node) {
+    run_result_t *result = &node->result;
+    result->state = RUN_RUNNING;
+    result->start_ns = now_ns() - run->start_ns;
+
+    const char *body = NULL;
+    if (template_render(node->url, run->vars, &run->url_out) < 0 ||
+        template_render(node->headers, run->vars, &run->headers_out) < 0) {
+        goto fail;
+    }
+    if (node->body) {
+        if (template_render(node->body, run->vars, &run->body_out) < 0) goto fail;
+        body = run->body_out.data;
+    }
+
+    node->compiled = compiled_request_create(node->method, run->url_out.data, run->headers_out.data,
+                                             body, run->options.timeout_ms);
+    if (!node->compiled ||
+        compiled_request_add_routes(node->compiled, run->options.routes) != 0 ||
+        http_engine_submit(run->engine, node->compiled, on_response, node) != 0) {
+        goto fail;
+    }
+    run->in_flight++;
+    return;
+
+fail:
+    compiled_request_destroy(node->compiled);
+    node->compiled = NULL;
+    result->state = RUN_FAILED;
+    result->end_ns = result->start_ns;
+    snprintf(result->error, sizeof(result->error), "out of memory");
+    finish_node(run, node);
+}
+
+static void submit_ready(collection_run_t *run) {
+    while (run->ready_head < run->ready_tail) {
+        submit_node(run, &run->nodes[run->ready[run->ready_head++]]);
+    }
+}
+
+// Open connections to every origin the run will use, before the clock starts,
+// routed as its requests will be. URLs and headers are rendered with the
+// variables known now; ones that depend on captures may not resolve and are
+// skipped.
+static void warm_up(collection_run_t *run) {
+    compiled_request_t **requests = calloc((size_t)run->count, sizeof(compiled_request_t *));
+    if (!requests) return;
+
+    int count = 0;
+    for (int i = 0; i < run->count; i++) {
+        run_node_t *node = &run->nodes[i];
+        if (template_render(node->url, run->vars, &run->url_out) < 0 ||
+            template_render(node->headers, run->vars, &run->headers_out) < 0) {
+            continue;
+        }
+        requests[count] = compiled_request_create(node->method, run->url_out.data, run->headers_out.data,
+                                                  NULL, run->options.timeout_ms);
+        if (requests[count] && compiled_request_add_routes(requests[count], run->options.routes) != 0) {
+            compiled_request_destroy(requests[count]);
+            requests[count] = NULL;
+        }
+        if (requests[count]) count++;
+    }
+
+    int opened = http_engine_warm_up(run->engine, (const compiled_request_t *const *)requests, count,
+                                     run->options.warmup);
+    run->warm_connections = opened > 0 ? opened : 0;
+
+    for (int i = 0; i < count; i++) {
+        compiled_request_destroy(requests[i]);
+    }
+    free(requests);
+}
+
+http_engine_t *collection_run_engine_create(const run_options_t *options) {
+    run_options_t defaults = {0};
+    if (!options) options = &defaults;
+
+    http_engine_t *engine = http_engine_create(options->concurrency);
+    if (!engine) return NULL;
+    if (options->retry) {
+        http_engine_set_policy(engine, options->retry);
+    }
+    http_engine_set_rate(engine, options->rate, 0);
+    http_engine_set_multiplexing(engine, options->max_streams);
+    if (http_engine_set_host_limits(engine, NULL, options->host_rate, 0, options->host_connections) != 0) {
+        http_engine_destroy(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+// Reset every result and submit the requests without dependencies
+static void begin(collection_run_t *run) {
+    run->ready_head = 0;
+    run->ready_tail = 0;
+    run->in_flight = 0;
+    run->start_ns = now_ns();
+    for (int i = 0; i < run->count; i++) {
+        run_node_t *node = &run->nodes[i];
+        memset(node->result.error, 0, sizeof(node->result.error));
+        node->result.state = RUN_PENDING;
+        node->result.status_code = 0;
+        node->result.body_size = node->result.wire_size = 0;
+        node->result.attempts = 0;
+        node->result.start_ns = node->result.end_ns = 0;
+        node->waiting = node->dependencies.count;
+        if (node->waiting == 0) {
+            run->ready[run->ready_tail++] = i;
+        }
+    }
+
+    submit_ready(run);
+}
+
+// Nothing is in flight or ready: whatever is still pending waits on itself through a cycle
+static void complete(collection_run_t *run) {
+    for (int i = 0; i < run->count; i++) {
+        skip_node(run, &run->nodes[i], "dependency cycle");
+    }
+    run->elapsed_ns = now_ns() - run->start_ns;
+}
+
+static int count_not_passed(const collection_run_t *run) {
+    int not_passed = 0;
+    for (int i = 0; i < run->count; i++) {
+        if (run->nodes[i].result.state != RUN_PASSED) not_passed++;
+    }
+    return not_passed;
+}
+
+int collection_run_execute(collection_run_t *run, const run_options_t *options) {
+    if (!run) return -1;
+
+    run_options_t defaults = {0};
+    run->options = options ? *options : defaults;
+    run->engine = collection_run_engine_create(&run->options);
+    if (!run->engine) return -1;
+
+    run->warm_connections = 0;
+    if (run->options.warmup > 0) {
+        warm_up(run);
+    }
+
+    begin(run);
+    while (http_engine_run(run->engine, 100) > 0 || run->ready_head < run->ready_tail) {
+        submit_ready(run);
+    }
+    complete(run);
+
+    // The engine goes with the run's connections, so keep their statistics
+    free(run->connections);
+    run->connection_count = http_engine_connections(run->engine, NULL, 0);
+    run->connections = malloc((size_t)(run->connection_count > 0 ? run->connection_count : 1) *
+                              sizeof(http_connection_stats_t));
+    if (run->connections) {
+        http_engine_connections(run->engine, run->connections, run->connection_count);
+    } else {
+        run->connection_count = 0;
+    }
+    http_engine_destroy(run->engine);
+    run->engine = NULL;
+
+    return count_not_passed(run);
+}
+
+int collection_run_start(collection_run_t *run, http_engine_t *engine, const run_options_t *options) {
+    if (!run || !engine || run->engine) return -1;
+
+    run_options_t defaults = {0};
+    run->options = options ? *options : defaults;
+    run->engine = engine;
+    run->warm_connections = 0;
+    begin(run);
+    return 0;
+}
+
+int collection_run_pump(collection_run_t *run) {
+    if (!run || !run->engine) return 0;
+
+    submit_ready(run);
+    int unfinished = run->in_flight + (run->ready_tail - run->ready_head);
+    if (unfinished > 0) return unfinished;
+
+    complete(run);
+    run->engine = NULL;
+    return 0;
+}
+
+/* ============================================================================
+ * RESULTS
+ * ============================================================================ */
+
+const run_result_t *collection_run_result(const collection_run_t *run, int index) {
+    if (!run || index < 0 || index >= run->count) return NULL;
+    return &run->nodes[index].result;
+}
+
+uint64_t collection_run_elapsed_ns(const collection_run_t *run) {
+    return run ? run->elapsed_ns : 0;
+}
+
+int collection_run_warm_connections(const collection_run_t *run) {
+    return run ? run->warm_connections : 0;
+}
+
+const http_connection_stats_t *collection_run_connections(const collection_run_t *run, int *count) {
+    *count = run ? run->connection_count : 0;
+    return *count > 0 ? run->connections : NULL;
+}
+
+// Longest duration chain ending at node; marks: 0 = unvisited, 1 = visiting, 2 = done
+static uint64_t chain_ns(const collection_run_t *run, int index, uint64_t *memo, char *marks) {
+    if (marks[index] == 2) return memo[index];
+    if (marks[index] == 1) return 0;  // Cycle
+    marks[index] = 1;
+
+    const run_node_t *node = &run->nodes[index];
+    uint64_t longest = 0;
+    for (int i = 0; i < node->dependencies.count; i++) {
+        uint64_t chain = chain_ns(run, node->dependencies.items[i], memo, marks);
+        if (chain > longest) longest = chain;
+    }
+
+    memo[index] = longest + (node->result.end_ns - node->result.start_ns);
+    marks[index] = 2;
+    return memo[index];
+}
+
+uint64_t collection_run_critical_path_ns(const collection_run_t *run) {
+    if (!run || run->count == 0) return 0;
+
+    uint64_t *memo = calloc((size_t)run->count, sizeof(uint64_t));
+    char *marks = calloc((size_t)run->count, 1);
+    uint64_t longest = 0;
+    if (memo && marks) {
+        for (int i = 0; i < run->count; i++) {
+            uint64_t chain = chain_ns(run, i, memo, marks);
+            if (chain > longest) longest = chain;
+        }
+    }
+    free(memo);
+    free(marks);
+    return longest;
+}
+
+void collection_run_destroy(collection_run_t *run) {
+    if (!run) return;
+
+    for (int i = 0; run->nodes && i < run->count; i++) {
+        run_node_t *node = &run->nodes[i];
+        template_destroy(node->url);
+        template_destroy(node->headers);
+        template_destroy(node->body);
+        compiled_request_destroy(node->compiled);
+        free(node->uses.items);
+        free(node->dependencies.items);
+        free(node->dependents.items);
+    }
+    template_buffer_free(&run->url_out);
+    template_buffer_free(&run->headers_out);
+    template_buffer_free(&run->body_out);
+    free(run->nodes);
+    free(run->ready);
+    free(run->connections);
+    free(run);
+}
@@ -0,0 +1,240 @@
+/* ============================================================================
+ * API Kit - Compiled Requests Implementation
+ * ============================================================================ */
+
+#include "compiled_request.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define FNV_OFFSET 1469598103934665603ull
+#define FNV_PRIME 1099511628211ull
+
+/* ============================================================================
+ * HASHING
+ * ============================================================================ */
+
+static uint64_t hash_string(uint64_t hash, const char *text) {
+    if (text) {
+        for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+            hash = (hash ^ *p) * FNV_PRIME;
+        }
+    }
+    // Field separator, so "ab" + "c" and "a" + "bc" differ
+    return (hash ^ 0xFF) * FNV_PRIME;
+}
+
+uint64_t compiled_request_hash(http_method_t method, const char *url,
+                               const char *headers, const char *body) {
+    uint64_t hash = (FNV_OFFSET ^ (uint64_t)method) * FNV_PRIME;
+    hash = hash_string(hash, url);
+    hash = hash_string(hash, headers);
+    return hash_string(hash, body);
+}
+
+/* ============================================================================
+ * ROUTING DIRECTIVES
+ * ============================================================================ */
+
+// "HOST:PORT:ADDRESS" -> "HOST:PORT:ADDRESS:PORT", the CURLOPT_CONNECT_TO
+// form; IPv6 addresses are bracketed. Returns 0 if the entry is malformed.
+static int connect_to_entry(const char *p, const char *end, char *out, size_t size) {
+    const char *host_end = memchr(p, ':', (size_t)(end - p));
+    if (!host_end || host_end == p) return 0;
+    const char *port = host_end + 1;
+    const char *port_end = port;
+    while (port_end < end && *port_end >= '0' && *port_end <= '9') port_end++;
+    if (port_end == port || port_end == end || *port_end != ':') return 0;
+    const char *address = port_end + 1;
+    if (address == end) return 0;
+
+    int host_length = (int)(host_end - p), port_length = (int)(port_end - port);
+    int address_length = (int)(end - address);
+    int bracket = *address != '[' && memchr(address, ':', (size_t)address_length) != NULL;
+    int written = snprintf(out, size, "%.*s:%.*s:%s%.*s%s:%.*s", host_length, p, port_length, port,
+                           bracket ? "[" : "", address_length, address, bracket ? "]" : "",
+                           port_length, port);
+    return written > 0 && (size_t)written < size;
+}
+
+static int directive_matches(const char *p, const char *end, const char *directive, const char **value) {
+    size_t length = strlen(directive);
+    if ((size_t)(end - p) <= length || strncmp(p, directive, length) != 0) return 0;
+    if (p[length] != ' ' && p[length] != '\t') return 0;
+    p += length;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    *value = p;
+    return p < end;
+}
+
+// "1.1", "2" or "2-prior-knowledge"; CURL_HTTP_VERSION_NONE if unknown
+static long http_version_value(const char *p, const char *end) {
+    static const struct {
+        const char *name;
+        long version;
+    } versions[] = {
+        { "1.1", CURL_HTTP_VERSION_1_1 },
+        { "2", CURL_HTTP_VERSION_2TLS },
+        { "2-prior-knowledge", CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE },
+    };
+    size_t length = (size_t)(end - p);
+    for (size_t i = 0; i < sizeof(versions) / sizeof(versions[0]); i++) {
+        if (strlen(versions[i].name) == length && strncmp(versions[i].name, p, length) == 0) {
+            return versions[i].version;
+        }
+    }
+    return CURL_HTTP_VERSION_NONE;
+}
+
+// Apply a trimmed comment line if it is a routing directive; -1 on allocation failure
+static int compile_route(compiled_request_t *request, const char *p, const char *end) {
+    const char *value;
+    if (directive_matches(p, end, ROUTE_UNIX_SOCKET_DIRECTIVE, &value)) {
+        if (request->unix_socket) return 0;
+        size_t length = (size_t)(end - value);
+        request->unix_socket = malloc(length + 1);
+        if (!request->unix_socket) return -1;
+        memcpy(request->unix_socket, value, length);
+        request->unix_socket[length] = '\0';
+        return 0;
+    }
+    if (directive_matches(p, end, ROUTE_HTTP_VERSION_DIRECTIVE, &value)) {
+        if (request->http_version == CURL_HTTP_VERSION_NONE) {
+            request->http_version = http_version_value(value, end);
+        }
+        return 0;
+    }
+    if (directive_matches(p, end, ROUTE_RESOLVE_DIRECTIVE, &value)) {
+        char entry[512];
+        if (!connect_to_entry(value, end, entry, sizeof(entry))) return 0;
+        struct curl_slist *list = curl_slist_append(request->connect_to, entry);
+        if (!list) return -1;
+        request->connect_to = list;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * HEADER PARSING
+ * ============================================================================ */
+
+// Append each usable header line (or, with routes_only, apply just the
+// routing directives); returns -1 on allocation failure
+static int compile_lines(compiled_request_t *request, const char *text, int routes_only,
+                         int *has_content_type) {
+    *has_content_type = 0;
+    if (!text) return 0;
+
+    char line[1024];
+    const char *p = text;
+    while (*p) {
+        const char *end = strchr(p, '\n');
+        if (!end) end = p + strlen(p);
+        const char *next = *end ? end + 1 : end;
+
+        // Trim surrounding whitespace (including the '\r' of CRLF text)
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+
+        size_t length = (size_t)(end - p);
+        if (length > 0 && *p == '#') {
+            if (compile_route(request, p, end) != 0) return -1;
+        } else if (!routes_only && length > 0 && memchr(p, ':', length) != NULL) {
+            char *buffer = line;
+            if (length >= sizeof(line)) {
+                buffer = malloc(length + 1);
+                if (!buffer) return -1;
+            }
+            memcpy(buffer, p, length);
+            buffer[length] = '\0';
+
+            struct curl_slist *headers = curl_slist_append(request->headers, buffer);
+            if (buffer != line) free(buffer);
+            if (!headers) return -1;
+            request->headers = headers;
+            request->header_count++;
+
+            if (length >= 13 && strncasecmp(p, "Content-Type:", 13) == 0) {
+                *has_content_type = 1;
+            }
+        }
+        p = next;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+compiled_request_t *compiled_request_create(http_method_t method, const char *url,
+                                            const char *headers, const char *body,
+                                            long timeout_ms) {
+    if (!url) return NULL;
+
+    compiled_request_t *request = calloc(1, sizeof(compiled_request_t));
+    if (!request) return NULL;
+
+    request->method = method;
+    request->method_name = http_method_name(method);
+    request->timeout_ms = timeout_ms;
+    request->source_hash = compiled_request_hash(method, url, headers, body);
+
+    request->url = strdup(url);
+    if (!request->url) goto fail;
+
+    if (body && body[0] != '\0') {
+        request->body_size = strlen(body);
+        request->body = malloc(request->body_size + 1);
+        if (!request->body) goto fail;
+        memcpy(request->body, body, request->body_size + 1);
+    }
+
+    int has_content_type = 0;
+    if (compile_lines(request, headers, 0, &has_content_type) != 0) goto fail;
+
+    if (request->body && !has_content_type) {
+        struct curl_slist *list = curl_slist_append(request->headers, "Content-Type: application/json");
+        if (!list) goto fail;
+        request->headers = list;
+        request->header_count++;
+    }
+
+    return request;
+
+fail:
+    compiled_request_destroy(request);
+    return NULL;
+}
+
+int compiled_request_add_routes(compiled_request_t *request, const char *directives) {
+    int has_content_type;
+    return compile_lines(request, directives, 1, &has_content_type);
+}
+
+int compiled_request_copy_routes(compiled_request_t *request, const compiled_request_t *source) {
+    if (source->unix_socket && !request->unix_socket) {
+        request->unix_socket = strdup(source->unix_socket);
+        if (!request->unix_socket) return -1;
+    }
+    if (request->http_version == CURL_HTTP_VERSION_NONE) {
+        request->http_version = source->http_version;
+    }
+    for (const struct curl_slist *entry = source->connect_to; entry; entry = entry->next) {
+        struct curl_slist *list = curl_slist_append(request->connect_to, entry->data);
+        if (!list) return -1;
+        request->connect_to = list;
+    }
+    return 0;
+}
+
+void compiled_request_destroy(compiled_request_t *request) {
+    if (!request) return;
+
+    curl_slist_free_all(request->headers);
+    curl_slist_free_all(request->connect_to);
+    free(request->unix_socket);
+    free(request->url);
+    free(request->body);
+    free(request);
+}
@@ -0,0 +1,374 @@
+/* ============================================================================
+ * API Kit - Data Files Implementation
+ *
+ * A row belongs to the chunk holding its first byte: a chunk that starts
+ * inside a line skips to the next one, and the last row of a chunk is read
+ * to its end even past the chunk. Together the chunks cover every row once
+ * without any pass over the file beforehand.
+ * ============================================================================ */
+
+#include "data_file.h"
+#include "json_path.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define UTF8_BOM "\xEF\xBB\xBF"
+
+struct data_file {
+    const char *data;           // Mapping, or "" for an empty file
+    size_t size;
+    data_format_t format;
+    const char *rows;           // After the byte order mark and the CSV header
+    int column_count;           // CSV only
+    data_field_t columns[DATA_MAX_COLUMNS];
+    char *names;                // Unescaped CSV column names
+};
+
+/* ============================================================================
+ * PARSING
+ * ============================================================================ */
+
+static int reserve(data_row_t *row, size_t size) {
+    if (size <= row->capacity) return 0;
+    char *buffer = realloc(row->buffer, size);
+    if (!buffer) return -1;
+    row->buffer = buffer;
+    row->capacity = size;
+    return 0;
+}
+
+// Fields of a line: unquoted ones as they are, quoted ones with "" as a quote
+static int parse_csv(const data_file_t *file, const char *p, const char *end, data_row_t *row) {
+    char *out = row->buffer;
+    int count = 0;
+    for (;;) {
+        if (count == DATA_MAX_COLUMNS) return -1;
+        data_field_t *field = &row->fields[count++];
+
+        if (p < end && *p == '"') {
+            const char *start = ++p;
+            char *copy = out;
+            int doubled = 0;
+            for (;;) {
+                const char *quote = memchr(p, '"', (size_t)(end - p));
+                if (!quote) return -1;
+                memcpy(out, p, (size_t)(quote - p));
+                out += quote - p;
+                if (quote + 1 < end && quote[1] == '"') {
+                    *out++ = '"';
+                    p = quote + 2;
+                    doubled = 1;
+                    continue;
+                }
+                p = quote + 1;
+                if (doubled) {
+                    field->value = copy;
+                    field->value_length = (size_t)(out - copy);
+                } else {
+                    field->value = start;
+                    field->value_length = (size_t)(quote - start);
+                    out = copy;
+                }
+                break;
+            }
+            if (p < end && *p != ',') return -1;
+        } else {
+            const char *comma = memchr(p, ',', (size_t)(end - p));
+            const char *stop = comma ? comma : end;
+            field->value = p;
+            field->value_length = (size_t)(stop - p);
+            p = stop;
+        }
+
+        if (p == end) break;
+        p++;
+    }
+
+    row->field_count = count;
+    if (file->column_count == 0) return 0;     // The header itself
+    if (count != file->column_count) return -1;
+    for (int i = 0; i < count; i++) {
+        row->fields[i].name = file->columns[i].name;
+        row->fields[i].name_length = file->columns[i].name_length;
+    }
+    return 0;
+}
+
+static const char *skip_space(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Closing quote of a string whose content starts at p, NULL if unterminated
+static const char *string_end(const char *p, const char *end, int *escaped) {
+    while (p < end) {
+        if (*p == '"') return p;
+        if (*p == '\\') {
+            if (end - p < 2) return NULL;
+            *escaped = 1;
+            p += 2;
+            continue;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+// String at p: its content in place, or unescaped at *out. Returns the position after it.
+static const char *read_string(const char *p, const char *end, char **out, const char **text, size_t *length) {
+    int escaped = 0;
+    const char *quote = string_end(p + 1, end, &escaped);
+    if (!quote) return NULL;
+    if (!escaped) {
+        *text = p + 1;
+        *length = (size_t)(quote - p - 1);
+    } else {
+        *text = *out;
+        *length = json_path_unescape(p, (size_t)(quote + 1 - p), *out);
+        *out += *length;
+    }
+    return quote + 1;
+}
+
+// Object or array at p, as its JSON text. Returns the position after it.
+static const char *skip_nested(const char *p, const char *end) {
+    int depth = 0;
+    while (p < end) {
+        if (*p == '"') {
+            int escaped = 0;
+            const char *quote = string_end(p + 1, end, &escaped);
+            if (!quote) return NULL;
+            p = quote + 1;
+            continue;
+        }
+        if (*p == '{' || *p == '[') {
+            depth++;
+        } else if ((*p == '}' || *p == ']') && --depth == 0) {
+            return p + 1;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+// Members of a flat object: strings unescaped, other values as JSON text, null as NULL
+static int parse_jsonl(const char *p, const char *end, data_row_t *row) {
+    char *out = row->buffer;
+    int count = 0;
+    p = skip_space(p, end);
+    if (p >= end || *p != '{') return -1;
+    p = skip_space(p + 1, end);
+
+    if (p < end && *p == '}') {
+        p++;
+    } else {
+        for (;;) {
+            if (count == DATA_MAX_COLUMNS) return -1;
+            data_field_t *field = &row->fields[count++];
+            if (p >= end || *p != '"') return -1;
+            p = read_string(p, end, &out, &field->name, &field->name_length);
+            if (!p) return -1;
+            p = skip_space(p, end);
+            if (p >= end || *p != ':') return -1;
+            p = skip_space(p + 1, end);
+            if (p >= end) return -1;
+
+            const char *start = p;
+            if (*p == '"') {
+                p = read_string(p, end, &out, &field->value, &field->value_length);
+            } else if (*p == '{' || *p == '[') {
+                p = skip_nested(p, end);
+            } else {
+                while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t') p++;
+                if (p == start) return -1;
+            }
+            if (!p) return -1;
+            if (*start != '"') {
+                int null = p - start == 4 && memcmp(start, "null", 4) == 0;
+                field->value = null ? NULL : start;
+                field->value_length = null ? 0 : (size_t)(p - start);
+            }
+
+            p = skip_space(p, end);
+            if (p < end && *p == ',') {
+                p = skip_space(p + 1, end);
+                continue;
+            }
+            if (p < end && *p == '}') {
+                p++;
+                break;
+            }
+            return -1;
+        }
+    }
+
+    if (skip_space(p, end) != end) return -1;
+    row->field_count = count;
+    return 0;
+}
+
+/* ============================================================================
+ * FILES
+ * ============================================================================ */
+
+static data_format_t detect_format(const char *path, const char *rows, const char *end) {
+    const char *extension = strrchr(path, '.');
+    if (extension && strcasecmp(extension, ".csv") == 0) return DATA_FORMAT_CSV;
+    if (extension && (strcasecmp(extension, ".jsonl") == 0 || strcasecmp(extension, ".ndjson") == 0)) {
+        return DATA_FORMAT_JSONL;
+    }
+    while (rows < end && (*rows == ' ' || *rows == '\t' || *rows == '\r' || *rows == '\n')) rows++;
+    return rows < end && *rows == '{' ? DATA_FORMAT_JSONL : DATA_FORMAT_CSV;
+}
+
+// Column names from the first line; rows start after it
+static int read_header(data_file_t *file) {
+    const char *end = file->data + file->size;
+    const char *newline = file->rows < end ? memchr(file->rows, '\n', (size_t)(end - file->rows)) : NULL;
+    const char *line_end = newline ? newline : end;
+    if (line_end > file->rows && line_end[-1] == '\r') line_end--;
+    if (line_end == file->rows) return -1;
+
+    data_row_t header = {0};
+    size_t length = (size_t)(line_end - file->rows);
+    file->names = malloc(length + 1);
+    if (!file->names || reserve(&header, length + 1) != 0 ||
+        parse_csv(file, file->rows, line_end, &header) != 0) {
+        data_row_free(&header);
+        return -1;
+    }
+
+    // Values of the header row may point into its buffer, so copy them all
+    char *out = file->names;
+    for (int i = 0; i < header.field_count; i++) {
+        memcpy(out, header.fields[i].value, header.fields[i].value_length);
+        file->columns[i].name = out;
+        file->columns[i].name_length = header.fields[i].value_length;
+        out += header.fields[i].value_length;
+    }
+    file->column_count = header.field_count;
+    data_row_free(&header);
+    file->rows = newline ? newline + 1 : end;
+    return 0;
+}
+
+data_file_t *data_file_open(const char *path) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    data_file_t *file = NULL;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || !(file = calloc(1, sizeof(data_file_t)))) {
+        close(fd);
+        return NULL;
+    }
+
+    file->size = (size_t)st.st_size;
+    file->data = "";
+    if (file->size > 0) {
+        void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            free(file);
+            return NULL;
+        }
+        // Each chunk is read front to back once
+        madvise(data, file->size, MADV_SEQUENTIAL);
+        file->data = data;
+    }
+    close(fd);
+
+    const char *end = file->data + file->size;
+    file->rows = file->data;
+    if (file->size >= 3 && memcmp(file->data, UTF8_BOM, 3) == 0) file->rows += 3;
+    file->format = detect_format(path, file->rows, end);
+    if (file->format == DATA_FORMAT_CSV && read_header(file) != 0) {
+        data_file_close(file);
+        return NULL;
+    }
+    return file;
+}
+
+void data_file_close(data_file_t *file) {
+    if (!file) return;
+    if (file->size > 0) munmap((void *)file->data, file->size);
+    free(file->names);
+    free(file);
+}
+
+data_format_t data_file_format(const data_file_t *file) {
+    return file->format;
+}
+
+uint64_t data_file_size(const data_file_t *file) {
+    return file ? file->size : 0;
+}
+
+uint64_t data_file_chunk_count(const data_file_t *file, uint64_t chunk_size) {
+    if (!file || chunk_size == 0) return 0;
+    uint64_t rows_size = (uint64_t)(file->data + file->size - file->rows);
+    return (rows_size + chunk_size - 1) / chunk_size;
+}
+
+void data_file_chunk(const data_file_t *file, uint64_t chunk_size, uint64_t index, data_cursor_t *cursor) {
+    const char *end = file->data + file->size;
+    uint64_t rows_size = (uint64_t)(end - file->rows);
+    uint64_t start = index * chunk_size;
+    uint64_t stop = start + chunk_size;
+    if (start > rows_size) start = rows_size;
+    if (stop > rows_size) stop = rows_size;
+
+    // A chunk starting inside a line leaves that row to the chunk it started in
+    const char *begin = file->rows + start;
+    if (start > 0 && begin < end && begin[-1] != '\n') {
+        const char *newline = memchr(begin, '\n', (size_t)(end - begin));
+        begin = newline ? newline + 1 : end;
+    }
+    cursor->begin = begin;
+    cursor->next = begin;
+    cursor->end = file->rows + stop;
+}
+
+int data_file_next(const data_file_t *file, data_cursor_t *cursor, data_row_t *row) {
+    const char *end = file->data + file->size;
+    for (;;) {
+        if (cursor->next >= cursor->end) return 0;
+
+        const char *line = cursor->next;
+        const char *newline = memchr(line, '\n', (size_t)(end - line));
+        const char *line_end = newline ? newline : end;
+        cursor->next = newline ? newline + 1 : end;
+        if (line_end > line && line_end[-1] == '\r') line_end--;
+        if (skip_space(line, line_end) == line_end) continue;
+
+        row->offset = (uint64_t)(line - file->data);
+        row->field_count = 0;
+        if (reserve(row, (size_t)(line_end - line) + 1) != 0) return -1;
+        int status = file->format == DATA_FORMAT_CSV ? parse_csv(file, line, line_end, row) :
+                                                       parse_jsonl(line, line_end, row);
+        return status == 0 ? 1 : -1;
+    }
+}
+
+void data_file_release(const data_file_t *file, const data_cursor_t *cursor) {
+    if (!file || file->size == 0) return;
+
+    // Whole pages only: the neighbouring chunks may still be reading the edges
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t from = ((uintptr_t)cursor->begin + page - 1) & ~(page - 1);
+    uintptr_t to = (uintptr_t)cursor->next & ~(page - 1);
+    if (to > from) madvise((void *)from, to - from, MADV_DONTNEED);
+}
+
+void data_row_free(data_row_t *row) {
+    if (!row) return;
+    free(row->buffer);
+    row->buffer = NULL;
+    row->capacity = 0;
+}
@@ -0,0 +1,150 @@
+/* ============================================================================
+ * API Kit - DNS Cache Implementation
+ *
+ * File format: a magic line, then one "host port address expires" line per
+ * entry, expires in seconds since the epoch. Entries are kept in record
+ * order, so the oldest is first to go when the cache is full.
+ * ============================================================================ */
+
+#include "dns_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DNS_CACHE_MAGIC "apikit-dns 1"
+#define HOST_LENGTH 256
+#define ADDRESS_LENGTH 64
+
+typedef struct {
+    char host[HOST_LENGTH];
+    long port;
+    char address[ADDRESS_LENGTH];
+    time_t expires;
+} dns_entry_t;
+
+struct dns_cache {
+    dns_entry_t entries[DNS_CACHE_MAX_ENTRIES];
+    int count;
+};
+
+/* ============================================================================
+ * HELPERS
+ * ============================================================================ */
+
+// Numeric IPv4 or IPv6 address (these need no resolving)
+static int is_address(const char *host) {
+    if (host[0] == '[' || strchr(host, ':')) return 1;
+    return strspn(host, "0123456789.") == strlen(host);
+}
+
+static int find_entry(const dns_cache_t *cache, const char *host, long port) {
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].port == port && strcmp(cache->entries[i].host, host) == 0) return i;
+    }
+    return -1;
+}
+
+static void remove_entry(dns_cache_t *cache, int index) {
+    memmove(&cache->entries[index], &cache->entries[index + 1],
+            (size_t)(cache->count - index - 1) * sizeof(dns_entry_t));
+    cache->count--;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+dns_cache_t *dns_cache_load(const char *path) {
+    dns_cache_t *cache = calloc(1, sizeof(dns_cache_t));
+    if (!cache || !path) return cache;
+
+    FILE *file = fopen(path, "r");
+    if (!file) return cache;
+
+    char line[512];
+    time_t now = time(NULL);
+    if (fgets(line, sizeof(line), file) && strncmp(line, DNS_CACHE_MAGIC, strlen(DNS_CACHE_MAGIC)) == 0) {
+        while (cache->count < DNS_CACHE_MAX_ENTRIES && fgets(line, sizeof(line), file)) {
+            dns_entry_t *entry = &cache->entries[cache->count];
+            long long expires = 0;
+            if (sscanf(line, "%255s %ld %63s %lld", entry->host, &entry->port, entry->address, &expires) == 4 &&
+                (time_t)expires > now) {
+                entry->expires = (time_t)expires;
+                cache->count++;
+            }
+        }
+    }
+    fclose(file);
+    return cache;
+}
+
+int dns_cache_save(const dns_cache_t *cache, const char *path) {
+    if (!cache || !path) return -1;
+
+    // Write a temporary file and rename it, so a crash never leaves half a file
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE *file = fopen(temp_path, "w");
+    if (!file) return -1;
+
+    time_t now = time(NULL);
+    int ok = fprintf(file, "%s\n", DNS_CACHE_MAGIC) > 0;
+    for (int i = 0; ok && i < cache->count; i++) {
+        const dns_entry_t *entry = &cache->entries[i];
+        if (entry->expires <= now) continue;
+        ok = fprintf(file, "%s %ld %s %lld\n", entry->host, entry->port, entry->address,
+                     (long long)entry->expires) > 0;
+    }
+    if (fclose(file) != 0 || !ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+void dns_cache_record(dns_cache_t *cache, const char *host, long port, const char *address, time_t now) {
+    if (!cache || !host || !address || !host[0] || !address[0] || is_address(host)) return;
+    if (strlen(host) >= HOST_LENGTH || strlen(address) >= ADDRESS_LENGTH) return;
+
+    // The newest record goes last
+    int index = find_entry(cache, host, port);
+    if (index >= 0) {
+        remove_entry(cache, index);
+    } else if (cache->count == DNS_CACHE_MAX_ENTRIES) {
+        remove_entry(cache, 0);
+    }
+
+    dns_entry_t *entry = &cache->entries[cache->count++];
+    snprintf(entry->host, sizeof(entry->host), "%s", host);
+    entry->port = port;
+    snprintf(entry->address, sizeof(entry->address), "%s", address);
+    entry->expires = now + DNS_CACHE_TTL_SECONDS;
+}
+
+struct curl_slist *dns_cache_resolve_list(const dns_cache_t *cache, time_t now) {
+    if (!cache) return NULL;
+
+    struct curl_slist *list = NULL;
+    for (int i = 0; i < cache->count; i++) {
+        const dns_entry_t *entry = &cache->entries[i];
+        if (entry->expires <= now) continue;
+
+        // IPv6 addresses go in brackets
+        char line[HOST_LENGTH + ADDRESS_LENGTH + 32];
+        const char *open = strchr(entry->address, ':') ? "[" : "";
+        const char *close = open[0] ? "]" : "";
+        snprintf(line, sizeof(line), "+%s:%ld:%s%s%s", entry->host, entry->port, open, entry->address, close);
+        struct curl_slist *next = curl_slist_append(list, line);
+        if (!next) break;
+        list = next;
+    }
+    return list;
+}
+
+int dns_cache_count(const dns_cache_t *cache) {
+    return cache ? cache->count : 0;
+}
+
+void dns_cache_destroy(dns_cache_t *cache) {
+    free(cache);
+}
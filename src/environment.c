@@ -0,0 +1,100 @@
+/* ============================================================================
+ * API Kit - Environments Implementation
+ * ============================================================================ */
+
+#include "environment.h"
+#include "toml.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * LOADING
+ * ============================================================================ */
+
+static void load_variables(const toml_table_t *table, environment_t *environment) {
+    const char *key;
+    for (int i = 0; (key = toml_key_in(table, i)) != NULL; i++) {
+        if (environment->variable_count >= MAX_ENVIRONMENT_VARIABLES) break;
+
+        environment_variable_t *variable = &environment->variables[environment->variable_count];
+        toml_datum_t string = toml_string_in(table, key);
+        if (string.ok) {
+            snprintf(variable->value, sizeof(variable->value), "%s", string.u.s);
+            free(string.u.s);
+        } else {
+            // Numbers and booleans keep their TOML spelling; arrays and tables are skipped
+            toml_raw_t raw = toml_raw_in(table, key);
+            if (!raw) continue;
+            snprintf(variable->value, sizeof(variable->value), "%s", raw);
+        }
+        snprintf(variable->name, sizeof(variable->name), "%s", key);
+        environment->variable_count++;
+    }
+}
+
+int environment_load(const char *path, environment_list_t *list) {
+    memset(list, 0, sizeof(*list));
+    snprintf(list->shared.name, sizeof(list->shared.name), "%s", ENVIRONMENT_SHARED_NAME);
+
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+
+    char errbuf[200];
+    toml_table_t *root = toml_parse_file(file, errbuf, sizeof(errbuf));
+    fclose(file);
+
+    if (!root) {
+        printf("Error parsing %s: %s\n", path, errbuf);
+        return -1;
+    }
+
+    const char *key;
+    for (int i = 0; (key = toml_key_in(root, i)) != NULL; i++) {
+        toml_table_t *table = toml_table_in(root, key);
+        if (!table) continue;
+
+        if (strcmp(key, ENVIRONMENT_SHARED_NAME) == 0) {
+            load_variables(table, &list->shared);
+        } else if (list->count < MAX_ENVIRONMENTS) {
+            environment_t *environment = &list->items[list->count++];
+            snprintf(environment->name, sizeof(environment->name), "%s", key);
+            load_variables(table, environment);
+        }
+    }
+
+    toml_free(root);
+    return 0;
+}
+
+/* ============================================================================
+ * SELECTION
+ * ============================================================================ */
+
+int environment_find(const environment_list_t *list, const char *name) {
+    if (!list || !name) return -1;
+
+    for (int i = 0; i < list->count; i++) {
+        if (strcmp(list->items[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int set_variables(const environment_t *environment, template_vars_t *vars) {
+    for (int i = 0; i < environment->variable_count; i++) {
+        const environment_variable_t *variable = &environment->variables[i];
+        if (template_vars_set(vars, variable->name, variable->value) != 0) return -1;
+    }
+    return 0;
+}
+
+int environment_apply(const environment_list_t *list, int index, template_vars_t *vars) {
+    if (!list || !vars) return -1;
+
+    template_vars_clear(vars);
+    if (set_variables(&list->shared, vars) != 0) return -1;
+    if (index >= 0 && index < list->count) {
+        return set_variables(&list->items[index], vars);
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+/* ============================================================================
+ * API Kit - HDR Histogram Implementation
+ *
+ * With p = precision_bits, a value v below 2^(p+1) is its own bucket. A
+ * larger v with its highest bit at e is shifted right by s = e - p, which
+ * leaves p + 1 significant bits in [2^p, 2^(p+1)); its bucket is
+ * (s + 1) * 2^p plus the p bits below the leading one. Both cases agree at
+ * 2^(p+1), so the index is continuous and monotonic in v.
+ * ============================================================================ */
+
+#include "hdr_histogram.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HDR_FORMAT 'H'
+#define HDR_VERSION 1
+#define HDR_HEADER_SIZE 4
+
+/* ============================================================================
+ * BUCKETS
+ * ============================================================================ */
+
+static int bucket_index(const hdr_histogram_t *histogram, uint64_t value) {
+    if (histogram->range_bits < 64 && (value >> histogram->range_bits)) {
+        value = (1ull << histogram->range_bits) - 1;
+    }
+    int precision = histogram->precision_bits;
+    if (value < (2ull << precision)) return (int)value;
+
+    int shift = 63 - __builtin_clzll(value) - precision;
+    uint64_t sub_mask = (1ull << precision) - 1;
+    return ((shift + 1) << precision) + (int)((value >> shift) & sub_mask);
+}
+
+static uint64_t bucket_low(const hdr_histogram_t *histogram, int index) {
+    int precision = histogram->precision_bits;
+    if (index < (2 << precision)) return (uint64_t)index;
+
+    int shift = (index >> precision) - 1;
+    uint64_t sub = (uint64_t)(index & ((1 << precision) - 1)) | (1ull << precision);
+    return sub << shift;
+}
+
+static uint64_t bucket_width(const hdr_histogram_t *histogram, int index) {
+    int precision = histogram->precision_bits;
+    return index < (2 << precision) ? 1 : 1ull << ((index >> precision) - 1);
+}
+
+static uint64_t bucket_middle(const hdr_histogram_t *histogram, int index) {
+    return bucket_low(histogram, index) + bucket_width(histogram, index) / 2;
+}
+
+static uint64_t load_count(const hdr_histogram_t *histogram, int index) {
+    return __atomic_load_n(&histogram->counts[index], __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ * RECORDING
+ * ============================================================================ */
+
+int hdr_histogram_init(hdr_histogram_t *histogram, int precision_bits, int range_bits, uint64_t *counts) {
+    if (!histogram) return -1;
+    memset(histogram, 0, sizeof(*histogram));
+    if (precision_bits < HDR_PRECISION_MIN || precision_bits > HDR_PRECISION_MAX ||
+        range_bits <= precision_bits || range_bits > HDR_RANGE_MAX) {
+        return -1;
+    }
+
+    histogram->precision_bits = precision_bits;
+    histogram->range_bits = range_bits;
+    histogram->bucket_count = HDR_BUCKET_COUNT(precision_bits, range_bits);
+    if (!counts) {
+        counts = calloc((size_t)histogram->bucket_count, sizeof(uint64_t));
+        if (!counts) return -1;
+        histogram->owns_counts = 1;
+    }
+    histogram->counts = counts;
+    return 0;
+}
+
+void hdr_histogram_free(hdr_histogram_t *histogram) {
+    if (!histogram) return;
+    if (histogram->owns_counts) free(histogram->counts);
+    histogram->counts = NULL;
+    histogram->owns_counts = 0;
+}
+
+void hdr_histogram_record(hdr_histogram_t *histogram, uint64_t value) {
+    hdr_histogram_record_n(histogram, value, 1);
+}
+
+// Single writer, so a relaxed load and store instead of a locked add
+void hdr_histogram_record_n(hdr_histogram_t *histogram, uint64_t value, uint64_t n) {
+    uint64_t *count = &histogram->counts[bucket_index(histogram, value)];
+    __atomic_store_n(count, __atomic_load_n(count, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+void hdr_histogram_reset(hdr_histogram_t *histogram) {
+    for (int i = 0; i < histogram->bucket_count; i++) {
+        __atomic_store_n(&histogram->counts[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+void hdr_histogram_merge(hdr_histogram_t *target, const hdr_histogram_t *source) {
+    int same_layout = target->precision_bits == source->precision_bits &&
+                      target->range_bits == source->range_bits;
+    for (int i = 0; i < source->bucket_count; i++) {
+        uint64_t count = load_count(source, i);
+        if (count == 0) continue;
+        if (same_layout) {
+            __atomic_store_n(&target->counts[i], load_count(target, i) + count, __ATOMIC_RELAXED);
+        } else {
+            hdr_histogram_record_n(target, bucket_middle(source, i), count);
+        }
+    }
+}
+
+/* ============================================================================
+ * QUERIES
+ * ============================================================================ */
+
+uint64_t hdr_histogram_count(const hdr_histogram_t *histogram) {
+    uint64_t total = 0;
+    for (int i = 0; i < histogram->bucket_count; i++) total += load_count(histogram, i);
+    return total;
+}
+
+uint64_t hdr_histogram_percentile(const hdr_histogram_t *histogram, double percentile) {
+    uint64_t total = hdr_histogram_count(histogram);
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+    uint64_t seen = 0;
+    int last = 0;
+    for (int i = 0; i < histogram->bucket_count; i++) {
+        uint64_t count = load_count(histogram, i);
+        if (count == 0) continue;
+        seen += count;
+        last = i;
+        if (seen >= rank) return bucket_middle(histogram, i);
+    }
+    // Counts grew between the two passes
+    return bucket_middle(histogram, last);
+}
+
+uint64_t hdr_histogram_min(const hdr_histogram_t *histogram) {
+    for (int i = 0; i < histogram->bucket_count; i++) {
+        if (load_count(histogram, i)) return bucket_low(histogram, i);
+    }
+    return 0;
+}
+
+uint64_t hdr_histogram_max(const hdr_histogram_t *histogram) {
+    for (int i = histogram->bucket_count - 1; i >= 0; i--) {
+        if (load_count(histogram, i)) return bucket_low(histogram, i) + (bucket_width(histogram, i) - 1);
+    }
+    return 0;
+}
+
+double hdr_histogram_mean(const hdr_histogram_t *histogram) {
+    uint64_t total = 0;
+    double sum = 0;
+    for (int i = 0; i < histogram->bucket_count; i++) {
+        uint64_t count = load_count(histogram, i);
+        if (count == 0) continue;
+        total += count;
+        sum += (double)count * (double)bucket_middle(histogram, i);
+    }
+    return total > 0 ? sum / (double)total : 0.0;
+}
+
+/* ============================================================================
+ * SERIALIZATION
+ * ============================================================================ */
+
+// LEB128: seven bits per byte, low first, high bit set on all but the last
+static size_t put_varint(uint8_t *out, size_t capacity, size_t at, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        if (value) byte |= 0x80;
+        if (out && at < capacity) out[at] = byte;
+        at++;
+    } while (value);
+    return at;
+}
+
+static int get_varint(const uint8_t *data, size_t size, size_t *at, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *at < size; shift += 7) {
+        uint8_t byte = data[(*at)++];
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return 0;
+    }
+    return -1;
+}
+
+size_t hdr_histogram_encode(const hdr_histogram_t *histogram, uint8_t *out, size_t capacity) {
+    uint8_t header[HDR_HEADER_SIZE] = {
+        HDR_FORMAT, HDR_VERSION, (uint8_t)histogram->precision_bits, (uint8_t)histogram->range_bits
+    };
+    size_t at = 0;
+    for (int i = 0; i < HDR_HEADER_SIZE; i++) {
+        if (out && at < capacity) out[at] = header[i];
+        at++;
+    }
+
+    int next = 0;
+    for (int i = 0; i < histogram->bucket_count; i++) {
+        uint64_t count = load_count(histogram, i);
+        if (count == 0) continue;
+        at = put_varint(out, capacity, at, (uint64_t)(i - next));
+        at = put_varint(out, capacity, at, count);
+        next = i + 1;
+    }
+    return at;
+}
+
+int hdr_histogram_decode(hdr_histogram_t *histogram, const uint8_t *data, size_t size) {
+    if (!histogram || !data || size < HDR_HEADER_SIZE ||
+        data[0] != HDR_FORMAT || data[1] != HDR_VERSION) {
+        return -1;
+    }
+    if (hdr_histogram_init(histogram, data[2], data[3], NULL) != 0) return -1;
+
+    size_t at = HDR_HEADER_SIZE;
+    uint64_t next = 0;
+    while (at < size) {
+        uint64_t gap, count;
+        if (get_varint(data, size, &at, &gap) != 0 || get_varint(data, size, &at, &count) != 0 ||
+            gap >= (uint64_t)histogram->bucket_count - next || count == 0) {
+            hdr_histogram_free(histogram);
+            return -1;
+        }
+        histogram->counts[next + gap] = count;
+        next += gap + 1;
+    }
+    return 0;
+}
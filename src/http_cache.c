@@ -0,0 +1,767 @@
+/* ============================================================================
+ * API Kit - HTTP Cache Implementation
+ * ============================================================================ */
+
+#include "http_cache.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define CACHE_BUCKETS 1024
+#define CACHE_FILE_MAGIC "APIKIT-CACHE 1"
+
+/* ============================================================================
+ * INTERNAL TYPES
+ * ============================================================================ */
+
+typedef struct cache_entry {
+    uint64_t key;               // Hash of method and URL
+    char *url;
+    char *vary;                 // "name: value\n" per Vary field name ("" without Vary)
+    char *headers;              // Raw header text of the final response
+    size_t headers_size;
+    char *body;
+    size_t body_size;
+    long status_code;
+    time_t response_time;       // When the response (or its last 304) arrived
+    http_headers_t fields;      // Index over headers
+    size_t size;                // Bytes counted against max_memory
+    struct cache_entry *lru_prev;   // Towards the most recently used
+    struct cache_entry *lru_next;
+    struct cache_entry *hash_next;
+} cache_entry_t;
+
+struct http_cache {
+    pthread_mutex_t lock;
+    char *directory;            // NULL = memory only
+    size_t max_memory;
+    size_t memory;
+    cache_entry_t *buckets[CACHE_BUCKETS];
+    cache_entry_t *lru_head;    // Most recently used
+    cache_entry_t *lru_tail;
+    http_cache_stats_t stats;
+};
+
+typedef struct {
+    int no_store;
+    int no_cache;
+    long max_age;               // -1 = absent
+} cache_control_t;
+
+/* ============================================================================
+ * HELPERS
+ * ============================================================================ */
+
+static uint64_t cache_key(const char *method, const char *url) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char *p = method; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ull;
+    }
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    for (const char *p = url; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Call fn for each comma-separated, trimmed item of a header value
+static void for_each_item(const char *value, size_t length,
+                          void (*fn)(void *context, const char *item, size_t length), void *context) {
+    const char *end = value + length;
+    while (value < end) {
+        const char *comma = memchr(value, ',', (size_t)(end - value));
+        const char *item_end = comma ? comma : end;
+        const char *start = value;
+        while (start < item_end && is_blank(*start)) start++;
+        const char *stop = item_end;
+        while (stop > start && is_blank(stop[-1])) stop--;
+        if (stop > start) fn(context, start, (size_t)(stop - start));
+        value = comma ? comma + 1 : end;
+    }
+}
+
+static void add_directive(void *context, const char *item, size_t length) {
+    cache_control_t *cc = context;
+    if (length == 8 && strncasecmp(item, "no-store", 8) == 0) {
+        cc->no_store = 1;
+    } else if (length == 8 && strncasecmp(item, "no-cache", 8) == 0) {
+        cc->no_cache = 1;
+    } else if (length > 8 && strncasecmp(item, "max-age=", 8) == 0) {
+        const char *digits = item + 8 + (item[8] == '"');
+        cc->max_age = strtol(digits, NULL, 10);
+        if (cc->max_age < 0) cc->max_age = 0;
+    }
+}
+
+static cache_control_t response_cache_control(const http_headers_t *fields) {
+    cache_control_t cc = { .max_age = -1 };
+    for (const http_header_t *h = http_headers_find(fields, -1, "Cache-Control"); h;
+         h = http_headers_find_next(fields, h)) {
+        for_each_item(fields->text + h->value_offset, h->value_length, add_directive, &cc);
+    }
+    return cc;
+}
+
+// Value of a request header, or NULL
+static const char *request_header(const compiled_request_t *request, const char *name, size_t *length) {
+    size_t name_length = strlen(name);
+    for (const struct curl_slist *item = request->headers; item; item = item->next) {
+        const char *line = item->data;
+        if (strncasecmp(line, name, name_length) == 0 && line[name_length] == ':') {
+            const char *value = line + name_length + 1;
+            while (is_blank(*value)) value++;
+            *length = strlen(value);
+            return value;
+        }
+    }
+    return NULL;
+}
+
+static cache_control_t request_cache_control(const compiled_request_t *request) {
+    cache_control_t cc = { .max_age = -1 };
+    size_t length;
+    const char *value = request_header(request, "Cache-Control", &length);
+    if (value) for_each_item(value, length, add_directive, &cc);
+    return cc;
+}
+
+// Parse an HTTP date header; -1 if absent or invalid
+static time_t header_time(const http_headers_t *fields, const char *name) {
+    size_t length;
+    const char *value = http_headers_get(fields, name, &length);
+    if (!value || length >= 64) return -1;
+
+    char text[64];
+    memcpy(text, value, length);
+    text[length] = '\0';
+    return (time_t)curl_getdate(text, NULL);
+}
+
+/* ============================================================================
+ * VARY
+ * ============================================================================ */
+
+typedef struct {
+    const compiled_request_t *request;
+    char *text;
+    size_t length;
+    int wildcard;
+    int failed;
+} vary_builder_t;
+
+static void add_vary_field(void *context, const char *item, size_t length) {
+    vary_builder_t *builder = context;
+    if (length == 1 && item[0] == '*') {
+        builder->wildcard = 1;
+        return;
+    }
+
+    char name[128];
+    if (length >= sizeof(name)) length = sizeof(name) - 1;
+    for (size_t i = 0; i < length; i++) {
+        name[i] = (item[i] >= 'A' && item[i] <= 'Z') ? (char)(item[i] + 'a' - 'A') : item[i];
+    }
+    name[length] = '\0';
+
+    size_t value_length = 0;
+    const char *value = request_header(builder->request, name, &value_length);
+    if (!value) value = "";
+
+    char *text = realloc(builder->text, builder->length + length + value_length + 4);
+    if (!text) {
+        builder->failed = 1;
+        return;
+    }
+    builder->text = text;
+    builder->length += (size_t)sprintf(text + builder->length, "%s: %.*s\n", name, (int)value_length, value);
+}
+
+// The request's values for the fields a response varies on; NULL for "Vary: *"
+static char *vary_key(const http_headers_t *fields, const compiled_request_t *request) {
+    vary_builder_t builder = { .request = request };
+    for (const http_header_t *h = http_headers_find(fields, -1, "Vary"); h; h = http_headers_find_next(fields, h)) {
+        for_each_item(fields->text + h->value_offset, h->value_length, add_vary_field, &builder);
+    }
+    if (builder.wildcard || builder.failed) {
+        free(builder.text);
+        return NULL;
+    }
+    return builder.text ? builder.text : strdup("");
+}
+
+static int vary_matches(const cache_entry_t *entry, const compiled_request_t *request) {
+    char *key = vary_key(&entry->fields, request);
+    int matches = key && strcmp(key, entry->vary) == 0;
+    free(key);
+    return matches;
+}
+
+/* ============================================================================
+ * FRESHNESS
+ * ============================================================================ */
+
+static long freshness_lifetime(const cache_entry_t *entry) {
+    cache_control_t cc = response_cache_control(&entry->fields);
+    if (cc.max_age >= 0) return cc.max_age;
+
+    time_t date = header_time(&entry->fields, "Date");
+    if (date < 0) date = entry->response_time;
+
+    // An invalid Expires means already expired
+    if (http_headers_find(&entry->fields, -1, "Expires")) {
+        time_t expires = header_time(&entry->fields, "Expires");
+        return expires > date ? (long)(expires - date) : 0;
+    }
+
+    // Heuristic: 10% of the time since the last modification
+    time_t last_modified = header_time(&entry->fields, "Last-Modified");
+    if (last_modified >= 0 && last_modified < date) return (long)(date - last_modified) / 10;
+    return 0;
+}
+
+static long current_age(const cache_entry_t *entry, time_t now) {
+    long age = 0;
+    size_t length;
+    const char *value = http_headers_get(&entry->fields, "Age", &length);
+    if (value) age = strtol(value, NULL, 10);
+
+    time_t date = header_time(&entry->fields, "Date");
+    long apparent = date >= 0 && entry->response_time > date ? (long)(entry->response_time - date) : 0;
+    if (apparent > age) age = apparent;
+    if (age < 0) age = 0;
+
+    return age + (long)(now - entry->response_time);
+}
+
+static int is_fresh(const cache_entry_t *entry, time_t now) {
+    if (response_cache_control(&entry->fields).no_cache) return 0;
+    return freshness_lifetime(entry) > current_age(entry, now);
+}
+
+static int has_validator(const cache_entry_t *entry) {
+    return http_headers_find(&entry->fields, -1, "ETag") || http_headers_find(&entry->fields, -1, "Last-Modified");
+}
+
+// Status codes a cache may store without explicit freshness (RFC 9110 15.1)
+static int is_cacheable_status(long status) {
+    switch (status) {
+        case 200: case 203: case 204: case 300: case 301: case 308: case 404: case 410:
+            return 1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * ENTRIES
+ * ============================================================================ */
+
+static void entry_free(cache_entry_t *entry) {
+    if (!entry) return;
+
+    http_headers_free(&entry->fields);
+    free(entry->url);
+    free(entry->vary);
+    free(entry->headers);
+    free(entry->body);
+    free(entry);
+}
+
+// Point the index at new header text
+static int entry_set_headers(cache_entry_t *entry, char *headers, size_t size) {
+    free(entry->headers);
+    entry->headers = headers;
+    entry->headers_size = size;
+    http_headers_free(&entry->fields);
+    return http_headers_parse(&entry->fields, headers, size);
+}
+
+static void entry_update_size(cache_entry_t *entry) {
+    entry->size = sizeof(cache_entry_t) + strlen(entry->url) + strlen(entry->vary) +
+                  entry->headers_size + entry->body_size;
+}
+
+static http_response_t *entry_response(const cache_entry_t *entry, http_cache_result_t result) {
+    http_response_t *response = calloc(1, sizeof(http_response_t));
+    if (!response) return NULL;
+
+    http_headers_init(&response->header_fields);
+    response->body = malloc(entry->body_size + 1);
+    response->headers = malloc(entry->headers_size + 1);
+    if (!response->body || !response->headers) {
+        http_response_free(response);
+        return NULL;
+    }
+    memcpy(response->body, entry->body, entry->body_size);
+    response->body[entry->body_size] = '\0';
+    response->body_size = entry->body_size;
+    memcpy(response->headers, entry->headers, entry->headers_size);
+    response->headers[entry->headers_size] = '\0';
+    response->headers_size = entry->headers_size;
+    if (http_headers_parse(&response->header_fields, response->headers, response->headers_size) != 0) {
+        http_response_free(response);
+        return NULL;
+    }
+    response->status_code = entry->status_code;
+    response->cache_result = result;
+    return response;
+}
+
+/* ============================================================================
+ * MEMORY STORE
+ * ============================================================================ */
+
+static void lru_unlink(http_cache_t *cache, cache_entry_t *entry) {
+    if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+    else cache->lru_head = entry->lru_next;
+    if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+    else cache->lru_tail = entry->lru_prev;
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push_front(http_cache_t *cache, cache_entry_t *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) cache->lru_head->lru_prev = entry;
+    cache->lru_head = entry;
+    if (!cache->lru_tail) cache->lru_tail = entry;
+}
+
+static void remove_entry(http_cache_t *cache, cache_entry_t *entry) {
+    cache_entry_t **link = &cache->buckets[entry->key % CACHE_BUCKETS];
+    while (*link && *link != entry) link = &(*link)->hash_next;
+    if (*link) *link = entry->hash_next;
+
+    lru_unlink(cache, entry);
+    cache->memory -= entry->size;
+    entry_free(entry);
+}
+
+// Drop least recently used entries until the store is within its budget.
+// Entries larger than the whole budget only stay on disk.
+static void evict_over_limit(http_cache_t *cache) {
+    while (cache->memory > cache->max_memory && cache->lru_tail) {
+        remove_entry(cache, cache->lru_tail);
+        cache->stats.evictions++;
+    }
+}
+
+static void insert_entry(http_cache_t *cache, cache_entry_t *entry) {
+    cache_entry_t **bucket = &cache->buckets[entry->key % CACHE_BUCKETS];
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    lru_push_front(cache, entry);
+    cache->memory += entry->size;
+    evict_over_limit(cache);
+}
+
+static cache_entry_t *find_entry(http_cache_t *cache, uint64_t key, const compiled_request_t *request) {
+    for (cache_entry_t *entry = cache->buckets[key % CACHE_BUCKETS]; entry; entry = entry->hash_next) {
+        if (entry->key == key && strcmp(entry->url, request->url) == 0 && vary_matches(entry, request)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * DISK STORE
+ * ============================================================================ */
+
+static void entry_path(const http_cache_t *cache, uint64_t key, char *path, size_t size) {
+    snprintf(path, size, "%s/%016llx.cache", cache->directory, (unsigned long long)key);
+}
+
+// File: magic line, "status time url_size vary_size headers_size body_size" line, then the data
+static void disk_write(const http_cache_t *cache, const cache_entry_t *entry) {
+    if (!cache->directory) return;
+
+    char path[1024], temp[1040];
+    entry_path(cache, entry->key, path, sizeof(path));
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+
+    FILE *file = fopen(temp, "wb");
+    if (!file) return;
+
+    size_t url_size = strlen(entry->url);
+    size_t vary_size = strlen(entry->vary);
+    int ok = fprintf(file, "%s\n%ld %lld %zu %zu %zu %zu\n", CACHE_FILE_MAGIC, entry->status_code,
+                     (long long)entry->response_time, url_size, vary_size,
+                     entry->headers_size, entry->body_size) > 0 &&
+             fwrite(entry->url, 1, url_size, file) == url_size &&
+             fwrite(entry->vary, 1, vary_size, file) == vary_size &&
+             fwrite(entry->headers, 1, entry->headers_size, file) == entry->headers_size &&
+             fwrite(entry->body, 1, entry->body_size, file) == entry->body_size;
+    ok = fclose(file) == 0 && ok;
+
+    // Rename so readers never see a partial entry
+    if (!ok || rename(temp, path) != 0) {
+        remove(temp);
+    }
+}
+
+static void disk_remove(const http_cache_t *cache, uint64_t key) {
+    if (!cache->directory) return;
+
+    char path[1024];
+    entry_path(cache, key, path, sizeof(path));
+    remove(path);
+}
+
+static char *read_exact(FILE *file, size_t size) {
+    char *data = malloc(size + 1);
+    if (!data) return NULL;
+    if (fread(data, 1, size, file) != size) {
+        free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    return data;
+}
+
+static cache_entry_t *disk_read(const http_cache_t *cache, uint64_t key, const char *url) {
+    if (!cache->directory) return NULL;
+
+    char path[1024];
+    entry_path(cache, key, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    char magic[32];
+    long status;
+    long long response_time;
+    size_t url_size, vary_size, headers_size, body_size;
+    cache_entry_t *entry = NULL;
+    if (!fgets(magic, sizeof(magic), file) || strncmp(magic, CACHE_FILE_MAGIC "\n", sizeof(CACHE_FILE_MAGIC)) != 0 ||
+        fscanf(file, "%ld %lld %zu %zu %zu %zu", &status, &response_time, &url_size,
+               &vary_size, &headers_size, &body_size) != 6 || fgetc(file) != '\n') {
+        goto done;
+    }
+
+    entry = calloc(1, sizeof(cache_entry_t));
+    if (!entry) goto done;
+    http_headers_init(&entry->fields);
+    entry->key = key;
+    entry->status_code = status;
+    entry->response_time = (time_t)response_time;
+
+    char *headers = NULL;
+    if (!(entry->url = read_exact(file, url_size)) || strcmp(entry->url, url) != 0 ||
+        !(entry->vary = read_exact(file, vary_size)) ||
+        !(headers = read_exact(file, headers_size)) ||
+        entry_set_headers(entry, headers, headers_size) != 0 ||
+        !(entry->body = read_exact(file, body_size))) {
+        if (!entry->headers) free(headers);
+        entry_free(entry);
+        entry = NULL;
+        goto done;
+    }
+    entry->body_size = body_size;
+    entry_update_size(entry);
+
+done:
+    fclose(file);
+    return entry;
+}
+
+// Stored entry for a request, from memory or disk. Entries too large for
+// memory are returned with *transient set; the caller frees them.
+static cache_entry_t *acquire_entry(http_cache_t *cache, uint64_t key, const compiled_request_t *request,
+                                    int *transient) {
+    *transient = 0;
+    cache_entry_t *entry = find_entry(cache, key, request);
+    if (entry) return entry;
+
+    entry = disk_read(cache, key, request->url);
+    if (!entry) return NULL;
+    if (!vary_matches(entry, request)) {
+        entry_free(entry);
+        return NULL;
+    }
+
+    if (entry->size > cache->max_memory) {
+        *transient = 1;
+    } else {
+        insert_entry(cache, entry);
+    }
+    return entry;
+}
+
+static void release_entry(cache_entry_t *entry, int transient) {
+    if (transient) entry_free(entry);
+}
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+http_cache_t *http_cache_create(size_t max_memory, const char *directory) {
+    http_cache_t *cache = calloc(1, sizeof(http_cache_t));
+    if (!cache) return NULL;
+
+    if (directory) {
+        cache->directory = strdup(directory);
+        if (!cache->directory) {
+            free(cache);
+            return NULL;
+        }
+        if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+            printf("Cache directory %s is not usable; caching in memory only\n", directory);
+            free(cache->directory);
+            cache->directory = NULL;
+        }
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->max_memory = max_memory;
+    return cache;
+}
+
+void http_cache_destroy(http_cache_t *cache) {
+    if (!cache) return;
+
+    while (cache->lru_head) {
+        remove_entry(cache, cache->lru_head);
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->directory);
+    free(cache);
+}
+
+http_response_t *http_cache_lookup(http_cache_t *cache, const compiled_request_t *request,
+                                   struct curl_slist **conditional) {
+    if (conditional) *conditional = NULL;
+    if (!cache || !request || request->method != HTTP_METHOD_GET) return NULL;
+
+    cache_control_t request_cc = request_cache_control(request);
+    if (request_cc.no_store) return NULL;
+
+    uint64_t key = cache_key(request->method_name, request->url);
+    pthread_mutex_lock(&cache->lock);
+
+    int transient;
+    cache_entry_t *entry = acquire_entry(cache, key, request, &transient);
+
+    http_response_t *response = NULL;
+    if (entry && !request_cc.no_cache && is_fresh(entry, time(NULL))) {
+        response = entry_response(entry, HTTP_CACHE_HIT);
+        if (response) {
+            cache->stats.hits++;
+            if (!transient) {
+                lru_unlink(cache, entry);
+                lru_push_front(cache, entry);
+            }
+        }
+    } else if (entry && conditional) {
+        size_t length;
+        const char *etag = http_headers_get(&entry->fields, "ETag", &length);
+        const char *modified = etag ? NULL : http_headers_get(&entry->fields, "Last-Modified", &length);
+
+        if (etag || modified) {
+            struct curl_slist *list = NULL;
+            int ok = 1;
+            for (const struct curl_slist *item = request->headers; item && ok; item = item->next) {
+                struct curl_slist *grown = curl_slist_append(list, item->data);
+                ok = grown != NULL;
+                if (grown) list = grown;
+            }
+
+            char line[512];
+            snprintf(line, sizeof(line), "%s: %.*s", etag ? "If-None-Match" : "If-Modified-Since",
+                     (int)length, etag ? etag : modified);
+            struct curl_slist *grown = ok ? curl_slist_append(list, line) : NULL;
+            if (grown) {
+                *conditional = grown;
+            } else {
+                curl_slist_free_all(list);
+            }
+        }
+    }
+
+    release_entry(entry, transient);
+    pthread_mutex_unlock(&cache->lock);
+    return response;
+}
+
+// Replace the stored header fields with those of a 304 (RFC 9111 4.3.4)
+static int merge_not_modified(cache_entry_t *entry, const http_headers_t *update) {
+    const http_header_block_t *stored = http_headers_final(&entry->fields);
+    const http_header_block_t *fresh = http_headers_final(update);
+    if (!stored || !fresh) return -1;
+
+    // Every field is written back as "Name: value\r\n", whatever spacing and
+    // line endings it was received with, so size the text from that
+    size_t size = stored->line_length + 2 + 2;
+    for (int i = 0; i < stored->count; i++) {
+        const http_header_t *h = &entry->fields.items[stored->first + i];
+        size += h->name_length + h->value_length + 4;
+    }
+    for (int i = 0; i < fresh->count; i++) {
+        const http_header_t *h = &update->items[fresh->first + i];
+        size += h->name_length + h->value_length + 4;
+    }
+    char *text = malloc(size + 1);
+    if (!text) return -1;
+
+    size_t length = (size_t)sprintf(text, "%.*s\r\n", (int)stored->line_length, entry->headers + stored->line_offset);
+    for (int i = 0; i < stored->count; i++) {
+        const http_header_t *h = &entry->fields.items[stored->first + i];
+        char name[128];
+        snprintf(name, sizeof(name), "%.*s", (int)h->name_length, entry->headers + h->name_offset);
+        if (http_headers_find(update, -1, name)) continue;
+        length += (size_t)sprintf(text + length, "%s: %.*s\r\n", name,
+                                  (int)h->value_length, entry->headers + h->value_offset);
+    }
+    for (int i = 0; i < fresh->count; i++) {
+        const http_header_t *h = &update->items[fresh->first + i];
+        if (h->name_length == 14 && strncasecmp(update->text + h->name_offset, "Content-Length", 14) == 0) continue;
+        length += (size_t)sprintf(text + length, "%.*s: %.*s\r\n",
+                                  (int)h->name_length, update->text + h->name_offset,
+                                  (int)h->value_length, update->text + h->value_offset);
+    }
+    length += (size_t)sprintf(text + length, "\r\n");
+
+    return entry_set_headers(entry, text, length);
+}
+
+http_response_t *http_cache_store(http_cache_t *cache, const compiled_request_t *request,
+                                  http_response_t *response) {
+    if (!cache || !request || !response || response->error_message) return response;
+
+    uint64_t key = cache_key("GET", request->url);
+    pthread_mutex_lock(&cache->lock);
+
+    // A successful unsafe request invalidates what is stored for its URL
+    if (request->method != HTTP_METHOD_GET) {
+        if (response->status_code >= 200 && response->status_code < 400) {
+            cache_entry_t *entry = cache->buckets[key % CACHE_BUCKETS];
+            while (entry) {
+                cache_entry_t *next = entry->hash_next;
+                if (entry->key == key && strcmp(entry->url, request->url) == 0) {
+                    remove_entry(cache, entry);
+                }
+                entry = next;
+            }
+            disk_remove(cache, key);
+        }
+        pthread_mutex_unlock(&cache->lock);
+        return response;
+    }
+
+    time_t now = time(NULL);
+    if (response->status_code == 304) {
+        int transient;
+        cache_entry_t *entry = acquire_entry(cache, key, request, &transient);
+        if (entry) {
+            size_t old_size = entry->size;
+            if (merge_not_modified(entry, &response->header_fields) == 0) {
+                entry->response_time = now;
+                entry_update_size(entry);
+                if (!transient) cache->memory = cache->memory - old_size + entry->size;
+                disk_write(cache, entry);
+
+                http_response_t *stored = entry_response(entry, HTTP_CACHE_REVALIDATED);
+                if (stored) {
+                    cache->stats.revalidated++;
+                    http_response_free(response);
+                    response = stored;
+                }
+
+                // The merged headers may have grown the entry past the budget
+                if (!transient) {
+                    lru_unlink(cache, entry);
+                    lru_push_front(cache, entry);
+                    evict_over_limit(cache);
+                }
+            }
+            release_entry(entry, transient);
+        }
+        pthread_mutex_unlock(&cache->lock);
+        return response;
+    }
+
+    cache->stats.misses++;
+
+    const http_header_block_t *final = http_headers_final(&response->header_fields);
+    cache_control_t cc = response_cache_control(&response->header_fields);
+    cache_control_t request_cc = request_cache_control(request);
+
+    cache_entry_t *old = find_entry(cache, key, request);
+    if (old && (cc.no_store || request_cc.no_store)) {
+        remove_entry(cache, old);
+        disk_remove(cache, key);
+        old = NULL;
+    }
+    if (!final || cc.no_store || request_cc.no_store || !is_cacheable_status(response->status_code)) {
+        pthread_mutex_unlock(&cache->lock);
+        return response;
+    }
+
+    cache_entry_t *entry = calloc(1, sizeof(cache_entry_t));
+    size_t headers_size = response->headers_size - final->line_offset;
+    char *headers = entry ? malloc(headers_size + 1) : NULL;
+    if (!headers) {
+        free(entry);
+        pthread_mutex_unlock(&cache->lock);
+        return response;
+    }
+    memcpy(headers, response->headers + final->line_offset, headers_size);
+    headers[headers_size] = '\0';
+
+    http_headers_init(&entry->fields);
+    entry->key = key;
+    entry->status_code = response->status_code;
+    entry->response_time = now;
+    entry->url = strdup(request->url);
+    entry->body = malloc(response->body_size + 1);
+    if (entry_set_headers(entry, headers, headers_size) != 0 || !entry->url || !entry->body ||
+        !(entry->vary = vary_key(&entry->fields, request))) {
+        entry_free(entry);
+        pthread_mutex_unlock(&cache->lock);
+        return response;
+    }
+    memcpy(entry->body, response->body, response->body_size);
+    entry->body[response->body_size] = '\0';
+    entry->body_size = response->body_size;
+    entry_update_size(entry);
+
+    // Worth keeping only if it can be reused or revalidated
+    if (freshness_lifetime(entry) <= 0 && !has_validator(entry)) {
+        entry_free(entry);
+        pthread_mutex_unlock(&cache->lock);
+        return response;
+    }
+
+    if (old) remove_entry(cache, old);
+    disk_write(cache, entry);
+    insert_entry(cache, entry);
+    cache->stats.stores++;
+
+    pthread_mutex_unlock(&cache->lock);
+    return response;
+}
+
+http_cache_stats_t http_cache_stats(http_cache_t *cache) {
+    http_cache_stats_t stats = {0};
+    if (!cache) return stats;
+
+    pthread_mutex_lock(&cache->lock);
+    stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+    return stats;
+}
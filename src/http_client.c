@@ -1,7 +1,50 @@
 #include "http_client.h"
+#include "compiled_request.h"
+#include "http_cache.h"
+#include "dns_cache.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+// One mutex per kind of shared data, so a warm-up thread and a send only
+// wait for each other on the same structure
+struct http_share_locks {
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+};
+
+// Record the transfer and its phases from libcurl's timing info
+static void trace_request_phases(CURL *curl, uint64_t start_ns) {
+    curl_off_t dns = 0, connect = 0, tls = 0, pretransfer = 0, first_byte = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &first_byte);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+    // libcurl reports microseconds since the start of the transfer
+    trace_end("http_request", "http", start_ns);
+    if (dns > 0) {
+        trace_complete("dns", "http", start_ns, (uint64_t)dns * 1000);
+    }
+    if (connect > dns) {
+        trace_complete("connect", "http", start_ns + (uint64_t)dns * 1000, (uint64_t)(connect - dns) * 1000);
+    }
+    if (tls > connect) {
+        trace_complete("tls_handshake", "http", start_ns + (uint64_t)connect * 1000, (uint64_t)(tls - connect) * 1000);
+    }
+    if (first_byte > pretransfer) {
+        trace_complete("wait_first_byte", "http", start_ns + (uint64_t)pretransfer * 1000,
+                       (uint64_t)(first_byte - pretransfer) * 1000);
+    }
+    if (total > first_byte) {
+        trace_complete("download", "http", start_ns + (uint64_t)first_byte * 1000,
+                       (uint64_t)(total - first_byte) * 1000);
+    }
+}
 
 static size_t write_callback(void *contents, size_t size, size_t nmemb, http_response_t *response) {
     size_t realsize = size * nmemb;
@@ -29,19 +72,240 @@ static size_t header_callback(void *contents, size_t size, size_t nmemb, http_re
 
     response->headers = ptr;
     memcpy(&(response->headers[response->headers_size]), contents, realsize);
+    size_t offset = response->headers_size;
     response->headers_size += realsize;
     response->headers[response->headers_size] = 0;
 
+    // curl delivers one complete line per call
+    if (http_headers_add_line(&response->header_fields, response->headers, offset, realsize) != 0) {
+        return 0;
+    }
+
     return realsize;
 }
 
+// Allocate an empty response for the callbacks to append to
+static http_response_t *response_create(void) {
+    http_response_t *response = calloc(1, sizeof(http_response_t));
+    if (!response) {
+        return NULL;
+    }
+
+    http_headers_init(&response->header_fields);
+    response->body = malloc(1);
+    response->headers = malloc(1);
+    if (!response->body || !response->headers) {
+        http_response_free(response);
+        return NULL;
+    }
+    response->body[0] = '\0';
+    response->headers[0] = '\0';
+    return response;
+}
+
+// Publish transfer counters; a nonzero return makes curl abort the transfer
+static int progress_callback(void *data, curl_off_t download_total, curl_off_t downloaded,
+                             curl_off_t upload_total, curl_off_t uploaded) {
+    http_progress_t *progress = data;
+    __atomic_store_n(&progress->download_total, (uint64_t)download_total, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->downloaded, (uint64_t)downloaded, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->upload_total, (uint64_t)upload_total, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->uploaded, (uint64_t)uploaded, __ATOMIC_RELAXED);
+    return __atomic_load_n(&progress->cancel, __ATOMIC_RELAXED);
+}
+
+static void set_response_callbacks(CURL *curl, http_response_t *response) {
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, response);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "apikit/1.0");
+
+    // Offer every encoding this libcurl can decode; bodies arrive decoded
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+    // Progress is opt-in per transfer (http_transfer_set_progress)
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+}
+
+void http_transfer_set_progress(CURL *curl, http_progress_t *progress) {
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress ? progress_callback : NULL);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, progress);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, progress ? 0L : 1L);
+}
+
+// CURL_HTTP_VERSION_* of a finished transfer as 10, 11, 20 or 30
+static int http_version_number(long version) {
+    switch (version) {
+        case CURL_HTTP_VERSION_1_0: return 10;
+        case CURL_HTTP_VERSION_1_1: return 11;
+        case CURL_HTTP_VERSION_2_0: return 20;
+        case CURL_HTTP_VERSION_3: return 30;
+    }
+    return 0;
+}
+
+void http_transfer_finish(CURL *curl, http_response_t *response, CURLcode result, uint64_t trace_start_ns) {
+    if (trace_start_ns) {
+        trace_request_phases(curl, trace_start_ns);
+    }
+    
+    // Get response code
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->status_code);
+    long version = CURL_HTTP_VERSION_NONE;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &version);
+    response->http_version = http_version_number(version);
+
+    // libcurl counts body bytes before content decoding
+    curl_off_t wire_size = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &wire_size);
+    response->wire_size = wire_size > 0 ? (uint64_t)wire_size : 0;
+
+    // Handle curl errors - but ignore certain non-critical errors
+    if (result == CURLE_ABORTED_BY_CALLBACK) {
+        response->error_message = strdup("Cancelled");
+    } else if (result != CURLE_OK && result != CURLE_PARTIAL_FILE) {
+        response->error_message = strdup(curl_easy_strerror(result));
+    }
+}
+
+// Remember the address the transfer connected to, for the next run
+static void record_address(http_client_t *client) {
+    char *address = NULL, *url = NULL;
+    long port = 0;
+    curl_easy_getinfo(client->curl, CURLINFO_PRIMARY_IP, &address);
+    curl_easy_getinfo(client->curl, CURLINFO_PRIMARY_PORT, &port);
+    curl_easy_getinfo(client->curl, CURLINFO_EFFECTIVE_URL, &url);
+    if (!address || !address[0] || !url) return;
+
+    CURLU *parsed = curl_url();
+    char *host = NULL, *url_port = NULL;
+    if (parsed && curl_url_set(parsed, CURLUPART_URL, url, 0) == CURLUE_OK &&
+        curl_url_get(parsed, CURLUPART_HOST, &host, 0) == CURLUE_OK &&
+        curl_url_get(parsed, CURLUPART_PORT, &url_port, CURLU_DEFAULT_PORT) == CURLUE_OK &&
+        atol(url_port) == port) {
+        // A different port means the connection went to a proxy
+        dns_cache_record(client->dns, host, port, address, time(NULL));
+    }
+    curl_free(host);
+    curl_free(url_port);
+    curl_url_cleanup(parsed);
+}
+
+// Run the transfer configured on the handle and fill in status and errors.
+// Addresses are recorded only for routed-as-usual transfers: a socket path
+// or a pinned address says nothing about what the host name resolves to.
+static http_response_t *perform_request(http_client_t *client, http_response_t *response,
+                                        int record) {
+    uint64_t trace_start_ns = trace_begin();
+    CURLcode res = curl_easy_perform(client->curl);
+    http_transfer_finish(client->curl, response, res, trace_start_ns);
+
+    // The first transfer loaded the saved addresses into the handle's DNS
+    // cache, where they expire normally; loading them again would renew them
+    if (client->resolve) {
+        curl_easy_setopt(client->curl, CURLOPT_RESOLVE, NULL);
+        curl_slist_free_all(client->resolve);
+        client->resolve = NULL;
+    }
+    if (client->dns && record && response->status_code > 0) {
+        record_address(client);
+    }
+    return response;
+}
+
+// Method names
+const char *http_method_name(http_method_t method) {
+    switch (method) {
+        case HTTP_METHOD_GET: return "GET";
+        case HTTP_METHOD_POST: return "POST";
+        case HTTP_METHOD_PUT: return "PUT";
+        case HTTP_METHOD_DELETE: return "DELETE";
+        case HTTP_METHOD_PATCH: return "PATCH";
+    }
+    return "GET";
+}
+
+http_method_t http_method_from_name(const char *name) {
+    if (name) {
+        if (strcmp(name, "POST") == 0) return HTTP_METHOD_POST;
+        if (strcmp(name, "PUT") == 0) return HTTP_METHOD_PUT;
+        if (strcmp(name, "DELETE") == 0) return HTTP_METHOD_DELETE;
+        if (strcmp(name, "PATCH") == 0) return HTTP_METHOD_PATCH;
+    }
+    return HTTP_METHOD_GET;
+}
+
+static void share_lock(CURL *curl, curl_lock_data data, curl_lock_access access, void *user) {
+    (void)curl;
+    (void)access;
+    struct http_share_locks *share_locks = user;
+    pthread_mutex_lock(&share_locks->locks[data]);
+}
+
+static void share_unlock(CURL *curl, curl_lock_data data, void *user) {
+    (void)curl;
+    struct http_share_locks *share_locks = user;
+    pthread_mutex_unlock(&share_locks->locks[data]);
+}
+
+// Put the DNS cache and TLS sessions in a share handle, so a warm-up
+// (see http_warmup.h) can fill them from another thread. Connections are
+// not shared: libcurl does not support using them from concurrent threads.
+static int create_share(http_client_t *client) {
+    client->share_locks = malloc(sizeof(struct http_share_locks));
+    if (!client->share_locks) return -1;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&client->share_locks->locks[i], NULL);
+    }
+    client->share = curl_share_init();
+    if (!client->share) return -1;
+    curl_share_setopt(client->share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(client->share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(client->share, CURLSHOPT_USERDATA, client->share_locks);
+    curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(client->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    curl_easy_setopt(client->curl, CURLOPT_SHARE, client->share);
+    return 0;
+}
+
+// Load the previous run's DNS, Alt-Svc and HSTS state onto the handle
+static int restore_state(http_client_t *client, const char *state_dir) {
+    client->state_dir = strdup(state_dir);
+    if (!client->state_dir) return -1;
+
+    // libcurl reads these files now and writes them back on cleanup
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/alt-svc.txt", state_dir);
+    curl_easy_setopt(client->curl, CURLOPT_ALTSVC_CTRL,
+                     (long)(CURLALTSVC_H1 | CURLALTSVC_H2 | CURLALTSVC_H3));
+    curl_easy_setopt(client->curl, CURLOPT_ALTSVC, path);
+    snprintf(path, sizeof(path), "%s/hsts.txt", state_dir);
+    curl_easy_setopt(client->curl, CURLOPT_HSTS_CTRL, (long)CURLHSTS_ENABLE);
+    curl_easy_setopt(client->curl, CURLOPT_HSTS, path);
+
+    snprintf(path, sizeof(path), "%s/dns.txt", state_dir);
+    client->dns = dns_cache_load(path);
+    if (!client->dns) return -1;
+    client->resolve = dns_cache_resolve_list(client->dns, time(NULL));
+    if (client->resolve) {
+        curl_easy_setopt(client->curl, CURLOPT_RESOLVE, client->resolve);
+    }
+    return 0;
+}
+
 // Instance management
 http_client_t *http_client_create(void) {
+    return http_client_create_ex(NULL);
+}
+
+http_client_t *http_client_create_ex(const http_client_options_t *options) {
     // TODO: handle error gracefully (what should we do if we can not init curl)
     if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
         return NULL;
     }
-    http_client_t *client = malloc(sizeof(http_client_t));
+    http_client_t *client = calloc(1, sizeof(http_client_t));
     if (!client) {
         return NULL;
     }
@@ -51,11 +315,24 @@ http_client_t *http_client_create(void) {
         free(client);
         return NULL;
     }
+    if (create_share(client) != 0) {
+        http_client_destroy(client);
+        return NULL;
+    }
 
-    client->headers = NULL;
+    if (options && options->state_dir && restore_state(client, options->state_dir) != 0) {
+        http_client_destroy(client);
+        return NULL;
+    }
     return client;
 }
 
+void http_client_set_cache(http_client_t *client, struct http_cache *cache) {
+    if (client) {
+        client->cache = cache;
+    }
+}
+
 void http_client_destroy(http_client_t *client) {
     if (!client) return;
     
@@ -65,6 +342,23 @@ void http_client_destroy(http_client_t *client) {
     if (client->curl) {
         curl_easy_cleanup(client->curl);
     }
+    if (client->share) {
+        curl_share_cleanup(client->share);
+    }
+    if (client->share_locks) {
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+            pthread_mutex_destroy(&client->share_locks->locks[i]);
+        }
+        free(client->share_locks);
+    }
+    curl_slist_free_all(client->resolve);
+    if (client->dns) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/dns.txt", client->state_dir);
+        dns_cache_save(client->dns, path);
+        dns_cache_destroy(client->dns);
+    }
+    free(client->state_dir);
     free(client);
     curl_global_cleanup();
 }
@@ -81,45 +375,28 @@ http_response_t *http_request(
     }
 
     // Reset any previous headers
+    curl_easy_setopt(client->curl, CURLOPT_HTTPHEADER, NULL);
     if (client->headers) {
         curl_slist_free_all(client->headers);
         client->headers = NULL;
     }
 
     // Initialize response
-    http_response_t *response = calloc(1, sizeof(http_response_t));
+    http_response_t *response = response_create();
     if (!response) {
         return NULL;
     }
-    
-    // Explicitly initialize fields
-    response->body = NULL;
-    response->headers = NULL;
-    response->error_message = NULL;
-    response->body_size = 0;
-    response->headers_size = 0;
-    response->status_code = 0;
-
-    response->body = malloc(1);
-    response->headers = malloc(1);
-    if (!response->body || !response->headers) {
-        http_response_free(response);
-        return NULL;
-    }
-    response->body[0] = '\0';
-    response->headers[0] = '\0';
-    response->body_size = 0;
-    response->headers_size = 0;
 
     // Basic curl options
     curl_easy_setopt(client->curl, CURLOPT_URL, url);
-    curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, response);
-    curl_easy_setopt(client->curl, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(client->curl, CURLOPT_HEADERDATA, response);
-    curl_easy_setopt(client->curl, CURLOPT_USERAGENT, "apikit/1.0");
+    set_response_callbacks(client->curl, response);
 
-    // Set HTTP method
+    // Set HTTP method (clearing the verb and body left by an earlier request)
+    curl_easy_setopt(client->curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(client->curl, CURLOPT_CUSTOMREQUEST, NULL);
+    curl_easy_setopt(client->curl, CURLOPT_UNIX_SOCKET_PATH, NULL);
+    curl_easy_setopt(client->curl, CURLOPT_CONNECT_TO, NULL);
+    curl_easy_setopt(client->curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_NONE);
     switch (method) {
         case HTTP_METHOD_GET:
             curl_easy_setopt(client->curl, CURLOPT_HTTPGET, 1L);
@@ -147,6 +424,7 @@ http_response_t *http_request(
 
         // Set request body
         if (options->body) {
+            curl_easy_setopt(client->curl, CURLOPT_POSTFIELDSIZE, -1L);  // strlen()
             curl_easy_setopt(client->curl, CURLOPT_POSTFIELDS, options->body);
         }
 
@@ -170,17 +448,83 @@ http_response_t *http_request(
         }
     }
 
-    // Perform request
-    CURLcode res = curl_easy_perform(client->curl);
-    
-    // Get response code
-    curl_easy_getinfo(client->curl, CURLINFO_RESPONSE_CODE, &response->status_code);
+    return perform_request(client, response, 1);
+}
 
-    // Handle curl errors - but ignore certain non-critical errors
-    if (res != CURLE_OK && res != CURLE_PARTIAL_FILE) {
-        response->error_message = strdup(curl_easy_strerror(res));
+http_response_t *http_transfer_prepare(CURL *curl, const struct compiled_request *request) {
+    http_response_t *response = response_create();
+    if (!response) {
+        return NULL;
     }
 
+    curl_easy_setopt(curl, CURLOPT_URL, request->url);
+    set_response_callbacks(curl, response);
+
+    // HTTPGET also drops any body set by the previous request on this handle
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    if (request->body) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)request->body_size);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->body);
+    } else if (request->method == HTTP_METHOD_POST) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+    }
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST,
+                     request->method == HTTP_METHOD_GET || request->method == HTTP_METHOD_POST
+                         ? NULL : request->method_name);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, request->timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request->headers);
+    // Routing is per request too, so set (or clear) it on every prepare
+    curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, request->unix_socket);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_TO, request->connect_to);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, request->http_version);
+
+    return response;
+}
+
+http_response_t *http_request_compiled(http_client_t *client, const struct compiled_request *request) {
+    return http_request_tracked(client, request, NULL);
+}
+
+http_response_t *http_request_tracked(http_client_t *client, const struct compiled_request *request,
+                                      http_progress_t *progress) {
+    if (!client || !client->curl || !request) {
+        return NULL;
+    }
+
+    // A fresh cached response needs no request; a stale one is revalidated
+    struct curl_slist *conditional = NULL;
+    if (client->cache && request->method == HTTP_METHOD_GET) {
+        http_response_t *cached = http_cache_lookup(client->cache, request, &conditional);
+        if (cached) {
+            return cached;
+        }
+    }
+
+    http_response_t *response = http_transfer_prepare(client->curl, request);
+    if (!response) {
+        curl_slist_free_all(conditional);
+        return NULL;
+    }
+    if (conditional) {
+        curl_easy_setopt(client->curl, CURLOPT_HTTPHEADER, conditional);
+    }
+    if (progress) {
+        http_transfer_set_progress(client->curl, progress);
+    }
+
+    response = perform_request(client, response, !request->unix_socket && !request->connect_to);
+    if (progress) {
+        http_transfer_set_progress(client->curl, NULL);
+    }
+
+    // The next prepare sets HTTPHEADER again, so the list can go now
+    curl_easy_setopt(client->curl, CURLOPT_HTTPHEADER, request->headers);
+    curl_slist_free_all(conditional);
+
+    if (client->cache) {
+        response = http_cache_store(client->cache, request, response);
+    }
     return response;
 }
 
@@ -195,6 +539,8 @@ void http_response_free(http_response_t *response) {
         free(response->headers);
         response->headers = NULL;
     }
+    http_headers_free(&response->header_fields);
+    free(response->attempts);
     if (response->error_message) {
         free(response->error_message);
         response->error_message = NULL;
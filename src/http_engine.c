@@ -0,0 +1,1096 @@
+/* ============================================================================
+ * API Kit - Async HTTP Engine Implementation
+ * ============================================================================ */
+
+#include "http_engine.h"
+#include "http_warmup.h"
+#include "trace.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define LATENCY_SAMPLES 128         // Recent attempt latencies for the p95 hedge delay
+#define LATENCY_MIN_SAMPLES 20      // Below this, adaptive hedging stays off
+#define HOST_BUCKETS 64             // Hash buckets of the host table
+#define HOST_NAME_LENGTH 256
+#define LIMIT_SCAN_DEPTH 32         // Queued jobs checked past one held by its own limit
+#define CONNECTION_BUCKETS 256      // Hash buckets of the connection table
+
+#define FNV_OFFSET 1469598103934665603ull
+#define FNV_PRIME 1099511628211ull
+
+/* ============================================================================
+ * INTERNAL TYPES
+ * ============================================================================ */
+
+struct http_host;
+struct http_engine;
+
+// A connection requests were sent on, found by its local address
+typedef struct http_connection {
+    http_connection_stats_t stats;
+    uint64_t hash;                  // Of stats.local
+    struct http_connection *chain;  // Hash bucket link, newest first
+} http_connection_t;
+
+// A submitted request: one or more attempts, sequential (retries) or
+// overlapping (hedges). A job is in exactly one place: its host's start
+// queue, the backoff list, or on the multi handle with in_flight > 0.
+typedef struct http_job {
+    const compiled_request_t *request;
+    struct http_host *host;
+    http_token_bucket_t *limit;     // Per-request bucket (caller's), or NULL
+    http_engine_done_fn done;
+    void *user_data;
+    http_retry_policy_t policy;
+    uint64_t submit_ns;
+    uint64_t ready_ns;              // Backoff: earliest start of the next attempt
+    int in_flight;
+    int throttled;                  // Already counted in stats.throttled
+    uint64_t blocked_epoch;         // host->blocked_epoch when queued
+    int attempt_count;
+    http_attempt_t attempts[HTTP_MAX_ATTEMPTS];
+    struct http_job *next;          // Queue or backoff list link
+} http_job_t;
+
+// One attempt on the multi handle
+typedef struct http_transfer {
+    CURL *curl;
+    struct http_engine *engine;
+    http_job_t *job;
+    http_connection_t *connection;  // Set when the request is about to be sent
+    int opened_socket;              // A new connection was opened for it
+    int attempt;                    // Index into job->attempts
+    int hedge_refused;              // The budget turned its hedge down; not asked again
+    http_response_t *response;
+    uint64_t trace_start_ns;
+    struct http_transfer *next;     // Active list links
+    struct http_transfer *prev;
+} http_transfer_t;
+
+// Limits and start queue of one host name
+typedef struct http_host {
+    char name[HOST_NAME_LENGTH];
+    uint64_t hash;
+    int own_limits;                 // Set by name, so the defaults do not apply
+    http_token_bucket_t bucket;
+    int max_connections;            // 0 = no limit
+    int in_flight;
+    int queued;
+    http_job_t *queue_head;
+    http_job_t *queue_tail;
+    uint64_t blocked_epoch;         // Bumped whenever a limit holds the queue back
+    struct http_host *chain;        // Hash bucket link
+    struct http_host *next;         // All hosts, in creation order
+} http_host_t;
+
+struct http_engine {
+    CURLM *multi;
+    int max_concurrent;
+    int active;                     // Transfers added to the multi handle
+    http_transfer_t *active_list;
+    int queued;                     // Jobs in all host queues
+    int waiting;
+    http_job_t *backoff;            // Jobs waiting to retry (unordered)
+
+    http_token_bucket_t bucket;     // Engine-wide rate
+    http_host_t *hosts[HOST_BUCKETS];
+    http_host_t *host_list;
+    http_host_t *host_list_tail;
+    double host_rate;               // Defaults for hosts without their own limits
+    double host_burst;
+    int host_max_connections;
+
+    http_retry_policy_t policy;     // For new submissions
+    http_engine_stats_t stats;
+    uint64_t extra_attempts;        // Retries + hedges, against the budget
+    uint64_t random_state;
+
+    uint64_t latencies[LATENCY_SAMPLES];
+    int latency_count;
+    int latency_next;
+    uint64_t p95_ns;                // Of latencies, recomputed when stale
+    int p95_stale;
+
+    long pipewait;                  // CURLOPT_PIPEWAIT for new transfers
+    http_connection_t *connection_table[CONNECTION_BUCKETS];
+    http_connection_t **connections;    // In order of first use
+    int connection_count;
+    int connection_capacity;
+
+    // Idle easy handles, reused so their connections and settings carry over
+    CURL **idle;
+    int idle_count;
+    int idle_capacity;
+};
+
+/* ============================================================================
+ * HELPERS
+ * ============================================================================ */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64*, for backoff jitter
+static uint64_t next_random(http_engine_t *engine) {
+    uint64_t x = engine->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    engine->random_state = x;
+    return x * 2685821657736338717ull;
+}
+
+static int is_idempotent(http_method_t method) {
+    return method == HTTP_METHOD_GET || method == HTTP_METHOD_PUT || method == HTTP_METHOD_DELETE;
+}
+
+static unsigned failure_class(CURLcode result, long status) {
+    switch (result) {
+        case CURLE_OK:
+        case CURLE_PARTIAL_FILE:
+            break;
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_RESOLVE_PROXY:
+        case CURLE_COULDNT_CONNECT:
+            return HTTP_RETRY_CONNECT;
+        case CURLE_OPERATION_TIMEDOUT:
+            return HTTP_RETRY_TIMEOUT;
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+            return HTTP_RETRY_NETWORK;
+        default:
+            return 0;
+    }
+    if (status == 429) return HTTP_RETRY_429;
+    if (status == 502 || status == 503 || status == 504) return HTTP_RETRY_5XX;
+    return 0;
+}
+
+static int is_retryable(const http_job_t *job, CURLcode result, long status) {
+    unsigned failure = failure_class(result, status);
+    if (!(failure & job->policy.retry_on)) return 0;
+    return failure == HTTP_RETRY_CONNECT || is_idempotent(job->request->method);
+}
+
+static int budget_allows(http_engine_t *engine, const http_retry_policy_t *policy) {
+    double allowed = policy->budget_min + policy->budget_ratio * (double)engine->stats.requests;
+    if ((double)engine->extra_attempts < allowed) {
+        engine->extra_attempts++;
+        return 1;
+    }
+    engine->stats.budget_denied++;
+    return 0;
+}
+
+// Retry-After in milliseconds (delta-seconds or an HTTP date), or -1
+static long retry_after_ms(const http_response_t *response) {
+    size_t length;
+    const char *value = response ? http_headers_get(&response->header_fields, "Retry-After", &length) : NULL;
+    if (!value || length == 0 || length >= 64) return -1;
+
+    char text[64];
+    memcpy(text, value, length);
+    text[length] = '\0';
+    if (text[0] >= '0' && text[0] <= '9') return strtol(text, NULL, 10) * 1000;
+
+    time_t when = (time_t)curl_getdate(text, NULL);
+    if (when < 0) return -1;
+    time_t now = time(NULL);
+    return when > now ? (long)(when - now) * 1000 : 0;
+}
+
+// Full jitter: uniform in [0, min(max, base * 2^retry)]
+static uint64_t backoff_ns(http_engine_t *engine, const http_job_t *job, const http_response_t *response) {
+    const http_retry_policy_t *policy = &job->policy;
+    int retry = job->attempt_count - 1;
+    long bound = policy->backoff_base_ms;
+    for (int i = 0; i < retry && bound < policy->backoff_max_ms; i++) bound *= 2;
+    if (bound > policy->backoff_max_ms) bound = policy->backoff_max_ms;
+
+    long delay = bound > 0 ? (long)(next_random(engine) % (uint64_t)(bound + 1)) : 0;
+    long server = retry_after_ms(response);
+    if (server > policy->backoff_max_ms) server = policy->backoff_max_ms;
+    if (server > delay) delay = server;
+    return (uint64_t)delay * 1000000ull;
+}
+
+static void record_latency(http_engine_t *engine, uint64_t latency_ns) {
+    engine->latencies[engine->latency_next] = latency_ns;
+    engine->latency_next = (engine->latency_next + 1) % LATENCY_SAMPLES;
+    if (engine->latency_count < LATENCY_SAMPLES) engine->latency_count++;
+    engine->p95_stale = 1;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Hedge delay for a policy, or 0 when hedging is off
+static uint64_t hedge_delay_ns(http_engine_t *engine, const http_retry_policy_t *policy) {
+    if (policy->hedge_after_ms > 0) return (uint64_t)policy->hedge_after_ms * 1000000ull;
+    if (policy->hedge_after_ms != HTTP_HEDGE_P95 || engine->latency_count < LATENCY_MIN_SAMPLES) return 0;
+
+    if (engine->p95_stale) {
+        uint64_t sorted[LATENCY_SAMPLES];
+        memcpy(sorted, engine->latencies, (size_t)engine->latency_count * sizeof(uint64_t));
+        qsort(sorted, (size_t)engine->latency_count, sizeof(uint64_t), compare_u64);
+        engine->p95_ns = sorted[(engine->latency_count * 95) / 100];
+        engine->p95_stale = 0;
+    }
+    return engine->p95_ns;
+}
+
+/* ============================================================================
+ * RATE LIMITS
+ * ============================================================================ */
+
+static void bucket_refill(http_token_bucket_t *bucket, uint64_t now) {
+    if (bucket->rate <= 0 || now <= bucket->updated_ns) return;
+    bucket->tokens += (double)(now - bucket->updated_ns) * bucket->rate / 1e9;
+    if (bucket->tokens > bucket->burst) bucket->tokens = bucket->burst;
+    bucket->updated_ns = now;
+}
+
+static int bucket_ready(http_token_bucket_t *bucket, uint64_t now) {
+    if (bucket->rate <= 0) return 1;
+    bucket_refill(bucket, now);
+    return bucket->tokens >= 1.0;
+}
+
+static void bucket_take(http_token_bucket_t *bucket) {
+    if (bucket->rate > 0) bucket->tokens -= 1.0;
+}
+
+// Nanoseconds until the bucket holds a whole token
+static uint64_t bucket_wait_ns(http_token_bucket_t *bucket, uint64_t now) {
+    if (bucket_ready(bucket, now)) return 0;
+    return (uint64_t)((1.0 - bucket->tokens) * 1e9 / bucket->rate) + 1;
+}
+
+// Host name of a URL, lowercased and without userinfo or port
+static void url_host(const char *url, char *name, size_t size) {
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+    const char *end = start + strcspn(start, "/?#");
+    for (const char *p = start; p < end; p++) {
+        if (*p == '@') start = p + 1;
+    }
+    if (*start == '[') {
+        const char *close = memchr(start, ']', (size_t)(end - start));
+        if (close) end = close + 1;
+    } else {
+        const char *colon = memchr(start, ':', (size_t)(end - start));
+        if (colon) end = colon;
+    }
+
+    size_t length = (size_t)(end - start);
+    if (length >= size) length = size - 1;
+    for (size_t i = 0; i < length; i++) {
+        name[i] = (char)tolower((unsigned char)start[i]);
+    }
+    name[length] = '\0';
+}
+
+static uint64_t host_hash(const char *name) {
+    uint64_t hash = FNV_OFFSET;
+    for (const char *p = name; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// Find or create the host entry for a lowercased name
+static http_host_t *host_get(http_engine_t *engine, const char *name) {
+    uint64_t hash = host_hash(name);
+    http_host_t **bucket = &engine->hosts[hash % HOST_BUCKETS];
+    for (http_host_t *host = *bucket; host; host = host->chain) {
+        if (host->hash == hash && strcmp(host->name, name) == 0) return host;
+    }
+
+    http_host_t *host = calloc(1, sizeof(http_host_t));
+    if (!host) return NULL;
+    snprintf(host->name, sizeof(host->name), "%s", name);
+    host->hash = hash;
+    http_token_bucket_init(&host->bucket, engine->host_rate, engine->host_burst);
+    host->max_connections = engine->host_max_connections;
+    host->chain = *bucket;
+    *bucket = host;
+    if (engine->host_list_tail) engine->host_list_tail->next = host;
+    else engine->host_list = host;
+    engine->host_list_tail = host;
+    return host;
+}
+
+// Whether the engine and host limits allow one more attempt to the host
+static int host_admits(http_engine_t *engine, http_host_t *host, uint64_t now) {
+    if (host->max_connections > 0 && host->in_flight >= host->max_connections) return 0;
+    return bucket_ready(&engine->bucket, now) && bucket_ready(&host->bucket, now);
+}
+
+static void take_tokens(http_engine_t *engine, http_job_t *job) {
+    bucket_take(&engine->bucket);
+    bucket_take(&job->host->bucket);
+    if (job->limit) bucket_take(job->limit);
+}
+
+/* ============================================================================
+ * CONNECTION STATISTICS
+ * ============================================================================ */
+
+static http_connection_t *connection_add(http_engine_t *engine, const char *local, uint64_t hash) {
+    if (engine->connection_count == engine->connection_capacity) {
+        int capacity = engine->connection_capacity ? engine->connection_capacity * 2 : 16;
+        http_connection_t **connections = realloc(engine->connections,
+                                                  (size_t)capacity * sizeof(http_connection_t *));
+        if (!connections) return NULL;
+        engine->connections = connections;
+        engine->connection_capacity = capacity;
+    }
+    http_connection_t *connection = calloc(1, sizeof(http_connection_t));
+    if (!connection) return NULL;
+
+    snprintf(connection->stats.local, sizeof(connection->stats.local), "%s", local);
+    connection->hash = hash;
+    connection->chain = engine->connection_table[hash % CONNECTION_BUCKETS];
+    engine->connection_table[hash % CONNECTION_BUCKETS] = connection;
+    engine->connections[engine->connection_count++] = connection;
+    return connection;
+}
+
+// A transfer opens a connection through this, so the next request on the
+// same local address is known to be on a new connection
+static curl_socket_t open_socket(void *user_data, curlsocktype purpose, struct curl_sockaddr *address) {
+    (void)purpose;
+    http_transfer_t *transfer = user_data;
+    transfer->opened_socket = 1;
+    return socket(address->family, address->socktype, address->protocol);
+}
+
+// Called when the request is about to go out on a new or reused connection
+static int attach_connection(void *user_data, char *primary_ip, char *local_ip,
+                             int primary_port, int local_port) {
+    http_transfer_t *transfer = user_data;
+    http_engine_t *engine = transfer->engine;
+
+    char local[64];
+    if (local_port > 0) {
+        snprintf(local, sizeof(local), "%s:%d", local_ip, local_port);
+    } else {
+        snprintf(local, sizeof(local), "unix");
+    }
+    uint64_t hash = host_hash(local);
+
+    // A local address seen before is the same connection unless this
+    // transfer opened one (the port was reused after a close). Unix
+    // sockets have no local address to tell them apart.
+    http_connection_t *connection = NULL;
+    if (!transfer->opened_socket || local_port == 0) {
+        connection = engine->connection_table[hash % CONNECTION_BUCKETS];
+        while (connection && (connection->hash != hash || strcmp(connection->stats.local, local) != 0)) {
+            connection = connection->chain;
+        }
+    }
+    transfer->opened_socket = 0;
+    if (!connection) {
+        connection = connection_add(engine, local, hash);
+        if (!connection) return CURL_PREREQFUNC_OK;
+        if (primary_port > 0) {
+            snprintf(connection->stats.remote, sizeof(connection->stats.remote), "%s:%d",
+                     primary_ip, primary_port);
+        }
+    }
+
+    connection->stats.streams++;
+    transfer->connection = connection;
+    return CURL_PREREQFUNC_OK;
+}
+
+/* ============================================================================
+ * HANDLE POOL
+ * ============================================================================ */
+
+static CURL *acquire_handle(http_engine_t *engine) {
+    if (engine->idle_count > 0) {
+        return engine->idle[--engine->idle_count];
+    }
+    return curl_easy_init();
+}
+
+static void release_handle(http_engine_t *engine, CURL *curl) {
+    if (engine->idle_count == engine->idle_capacity) {
+        int capacity = engine->idle_capacity ? engine->idle_capacity * 2 : 16;
+        CURL **idle = realloc(engine->idle, (size_t)capacity * sizeof(CURL *));
+        if (!idle) {
+            curl_easy_cleanup(curl);
+            return;
+        }
+        engine->idle = idle;
+        engine->idle_capacity = capacity;
+    }
+    engine->idle[engine->idle_count++] = curl;
+}
+
+/* ============================================================================
+ * JOBS AND TRANSFERS
+ * ============================================================================ */
+
+static void enqueue(http_engine_t *engine, http_job_t *job) {
+    http_host_t *host = job->host;
+    job->next = NULL;
+    job->blocked_epoch = host->blocked_epoch;
+    if (host->queue_tail) {
+        host->queue_tail->next = job;
+    } else {
+        host->queue_head = job;
+    }
+    host->queue_tail = job;
+    host->queued++;
+    engine->queued++;
+}
+
+// Unlink the first of the host's queued jobs whose own limit has a token
+static http_job_t *dequeue_ready(http_engine_t *engine, http_host_t *host, uint64_t now) {
+    http_job_t *previous = NULL;
+    http_job_t *job = host->queue_head;
+    for (int depth = 0; job && depth < LIMIT_SCAN_DEPTH; depth++) {
+        if (!job->limit || bucket_ready(job->limit, now)) {
+            if (previous) previous->next = job->next;
+            else host->queue_head = job->next;
+            if (host->queue_tail == job) host->queue_tail = previous;
+            host->queued--;
+            engine->queued--;
+            return job;
+        }
+        if (!job->throttled) {
+            job->throttled = 1;
+            engine->stats.throttled++;
+        }
+        previous = job;
+        job = job->next;
+    }
+    return NULL;
+}
+
+static void unlink_active(http_engine_t *engine, http_transfer_t *transfer) {
+    if (transfer->prev) transfer->prev->next = transfer->next;
+    else engine->active_list = transfer->next;
+    if (transfer->next) transfer->next->prev = transfer->prev;
+    engine->active--;
+    transfer->job->in_flight--;
+    transfer->job->host->in_flight--;
+}
+
+// Take a transfer off the multi handle and free it (the response is the caller's)
+static void retire_transfer(http_engine_t *engine, http_transfer_t *transfer) {
+    curl_multi_remove_handle(engine->multi, transfer->curl);
+    unlink_active(engine, transfer);
+    release_handle(engine, transfer->curl);
+    free(transfer);
+}
+
+// Hand the response to the job's callback and free the job
+static void deliver(http_engine_t *engine, http_job_t *job, http_response_t *response) {
+    // Cancel attempts still racing this one
+    http_transfer_t *transfer = engine->active_list;
+    while (transfer && job->in_flight > 0) {
+        http_transfer_t *next = transfer->next;
+        if (transfer->job == job) {
+            http_attempt_t *attempt = &job->attempts[transfer->attempt];
+            attempt->end_ns = now_ns() - job->submit_ns;
+            attempt->outcome = HTTP_ATTEMPT_CANCELLED;
+            http_response_free(transfer->response);
+            retire_transfer(engine, transfer);
+        }
+        transfer = next;
+    }
+
+    if (response && job->attempt_count > 0) {
+        response->attempts = malloc((size_t)job->attempt_count * sizeof(http_attempt_t));
+        if (response->attempts) {
+            memcpy(response->attempts, job->attempts, (size_t)job->attempt_count * sizeof(http_attempt_t));
+            response->attempt_count = job->attempt_count;
+        }
+    }
+
+    http_engine_done_fn done = job->done;
+    void *user_data = job->user_data;
+    free(job);
+
+    // Last, so the callback may submit (and the engine state is consistent)
+    done(user_data, response);
+}
+
+// Start the job's next attempt; returns -1 if it could not be started
+static int start_attempt(http_engine_t *engine, http_job_t *job, int hedge) {
+    http_transfer_t *transfer = calloc(1, sizeof(http_transfer_t));
+    if (!transfer) return -1;
+
+    transfer->engine = engine;
+    transfer->job = job;
+    transfer->curl = acquire_handle(engine);
+    if (transfer->curl) {
+        transfer->response = http_transfer_prepare(transfer->curl, job->request);
+    }
+    if (!transfer->curl || !transfer->response) {
+        if (transfer->curl) release_handle(engine, transfer->curl);
+        free(transfer);
+        return -1;
+    }
+
+    curl_easy_setopt(transfer->curl, CURLOPT_PRIVATE, transfer);
+    curl_easy_setopt(transfer->curl, CURLOPT_PIPEWAIT, engine->pipewait);
+    curl_easy_setopt(transfer->curl, CURLOPT_OPENSOCKETFUNCTION, open_socket);
+    curl_easy_setopt(transfer->curl, CURLOPT_OPENSOCKETDATA, transfer);
+    curl_easy_setopt(transfer->curl, CURLOPT_PREREQFUNCTION, attach_connection);
+    curl_easy_setopt(transfer->curl, CURLOPT_PREREQDATA, transfer);
+    transfer->trace_start_ns = trace_begin();
+    if (curl_multi_add_handle(engine->multi, transfer->curl) != CURLM_OK) {
+        http_response_free(transfer->response);
+        release_handle(engine, transfer->curl);
+        free(transfer);
+        return -1;
+    }
+
+    transfer->attempt = job->attempt_count++;
+    http_attempt_t *attempt = &job->attempts[transfer->attempt];
+    memset(attempt, 0, sizeof(*attempt));
+    attempt->start_ns = now_ns() - job->submit_ns;
+    attempt->hedge = hedge;
+
+    engine->active++;
+    engine->stats.attempts++;
+    job->in_flight++;
+    job->host->in_flight++;
+    transfer->prev = NULL;
+    transfer->next = engine->active_list;
+    if (engine->active_list) engine->active_list->prev = transfer;
+    engine->active_list = transfer;
+    return 0;
+}
+
+static int has_free_slot(const http_engine_t *engine) {
+    return engine->max_concurrent <= 0 || engine->active < engine->max_concurrent;
+}
+
+// Move jobs whose backoff has elapsed to the start queue
+static void promote_backoff(http_engine_t *engine, uint64_t now) {
+    http_job_t **link = &engine->backoff;
+    while (*link) {
+        http_job_t *job = *link;
+        if (job->ready_ns <= now) {
+            *link = job->next;
+            engine->waiting--;
+            enqueue(engine, job);
+        } else {
+            link = &job->next;
+        }
+    }
+}
+
+// Start queued jobs while below the concurrency limit, one host at a time
+// in turn so a host held back by its limits does not delay the others
+static void start_queued(http_engine_t *engine, uint64_t now) {
+    int started = 1;
+    while (started && engine->queued > 0 && has_free_slot(engine)) {
+        started = 0;
+        for (http_host_t *host = engine->host_list; host && has_free_slot(engine); host = host->next) {
+            if (host->queued == 0) continue;
+
+            http_job_t *job = host_admits(engine, host, now) ? dequeue_ready(engine, host, now) : NULL;
+            if (!job) {
+                host->blocked_epoch++;
+                continue;
+            }
+            if (job->blocked_epoch != host->blocked_epoch && !job->throttled) {
+                job->throttled = 1;
+                engine->stats.throttled++;
+            }
+
+            take_tokens(engine, job);
+            started = 1;
+            if (start_attempt(engine, job, 0) != 0) {
+                deliver(engine, job, NULL);
+            }
+        }
+    }
+}
+
+// When an attempt may be hedged, or UINT64_MAX if it never will be
+static uint64_t hedge_due_ns(http_engine_t *engine, const http_transfer_t *transfer) {
+    const http_job_t *job = transfer->job;
+    if (transfer->hedge_refused || job->in_flight != 1 || job->attempt_count >= job->policy.max_attempts ||
+        !is_idempotent(job->request->method)) {
+        return UINT64_MAX;
+    }
+    uint64_t delay = hedge_delay_ns(engine, &job->policy);
+    if (delay == 0) return UINT64_MAX;
+    return job->submit_ns + job->attempts[transfer->attempt].start_ns + delay;
+}
+
+// Duplicate attempts that have run longer than the hedge delay
+static void start_hedges(http_engine_t *engine, uint64_t now) {
+    for (http_transfer_t *transfer = engine->active_list; transfer && has_free_slot(engine);
+         transfer = transfer->next) {
+        http_job_t *job = transfer->job;
+        if (now < hedge_due_ns(engine, transfer)) continue;
+        if (!host_admits(engine, job->host, now) || (job->limit && !bucket_ready(job->limit, now))) {
+            continue;
+        }
+        if (!budget_allows(engine, &job->policy)) {
+            transfer->hedge_refused = 1;
+            continue;
+        }
+
+        // New transfers go to the list head, so the walk does not visit it
+        take_tokens(engine, job);
+        if (start_attempt(engine, job, 1) == 0) {
+            engine->stats.hedges++;
+        }
+    }
+}
+
+// Deliver, retry or drop every finished transfer
+static void dispatch_completions(http_engine_t *engine) {
+    CURLMsg *message;
+    int remaining;
+    while ((message = curl_multi_info_read(engine->multi, &remaining)) != NULL) {
+        if (message->msg != CURLMSG_DONE) continue;
+
+        CURL *curl = message->easy_handle;
+        CURLcode result = message->data.result;
+        http_transfer_t *transfer = NULL;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&transfer);
+
+        http_job_t *job = transfer->job;
+        http_response_t *response = transfer->response;
+        http_transfer_finish(curl, response, result, transfer->trace_start_ns);
+        if (transfer->connection && response->http_version) {
+            transfer->connection->stats.http_version = response->http_version;
+        }
+
+        http_attempt_t *attempt = &job->attempts[transfer->attempt];
+        attempt->end_ns = now_ns() - job->submit_ns;
+        attempt->status_code = response->status_code;
+        attempt->curl_result = (int)result;
+        retire_transfer(engine, transfer);
+
+        if (!is_retryable(job, result, response->status_code)) {
+            attempt->outcome = HTTP_ATTEMPT_WON;
+            if (result == CURLE_OK) record_latency(engine, attempt->end_ns - attempt->start_ns);
+            if (attempt->hedge) engine->stats.hedge_wins++;
+            deliver(engine, job, response);
+            continue;
+        }
+
+        // A sibling is still running: let it decide the outcome
+        if (job->in_flight > 0) {
+            attempt->outcome = HTTP_ATTEMPT_FAILED;
+            http_response_free(response);
+            continue;
+        }
+
+        if (job->attempt_count >= job->policy.max_attempts || !budget_allows(engine, &job->policy)) {
+            attempt->outcome = HTTP_ATTEMPT_WON;
+            deliver(engine, job, response);
+            continue;
+        }
+
+        attempt->outcome = HTTP_ATTEMPT_FAILED;
+        job->ready_ns = now_ns() + backoff_ns(engine, job, response);
+        http_response_free(response);
+        engine->stats.retries++;
+        job->next = engine->backoff;
+        engine->backoff = job;
+        engine->waiting++;
+    }
+}
+
+// Milliseconds until the next backoff, hedge or rate-limited start is due,
+// capped at limit_ms
+static int next_timer_ms(http_engine_t *engine, uint64_t now, int limit_ms) {
+    uint64_t limit = (uint64_t)limit_ms * 1000000ull;
+    uint64_t next = limit;
+
+    // Hosts at their connection cap, or all hosts when the engine is full,
+    // wait for a completion rather than a timer
+    for (http_host_t *host = engine->host_list; host && has_free_slot(engine); host = host->next) {
+        if (host->queued == 0 || (host->max_connections > 0 && host->in_flight >= host->max_connections)) {
+            continue;
+        }
+        uint64_t wait = bucket_wait_ns(&engine->bucket, now);
+        uint64_t host_wait = bucket_wait_ns(&host->bucket, now);
+        if (host_wait > wait) wait = host_wait;
+
+        uint64_t job_wait = UINT64_MAX;
+        const http_job_t *job = host->queue_head;
+        for (int depth = 0; job && depth < LIMIT_SCAN_DEPTH && job_wait > 0; depth++, job = job->next) {
+            uint64_t own = job->limit ? bucket_wait_ns(job->limit, now) : 0;
+            if (own < job_wait) job_wait = own;
+        }
+        if (job_wait != UINT64_MAX && job_wait > wait) wait = job_wait;
+        if (wait < next) next = wait;
+    }
+
+    for (const http_job_t *job = engine->backoff; job; job = job->next) {
+        uint64_t wait = job->ready_ns > now ? job->ready_ns - now : 0;
+        if (wait < next) next = wait;
+    }
+
+    // A hedge held back by a full engine or host also waits for a completion,
+    // and a rate-limited one for its tokens
+    for (const http_transfer_t *transfer = engine->active_list; transfer && has_free_slot(engine);
+         transfer = transfer->next) {
+        const http_job_t *job = transfer->job;
+        const http_host_t *host = job->host;
+        uint64_t due = hedge_due_ns(engine, transfer);
+        if (due == UINT64_MAX || (host->max_connections > 0 && host->in_flight >= host->max_connections)) {
+            continue;
+        }
+        uint64_t wait = due > now ? due - now : 0;
+        uint64_t tokens = bucket_wait_ns(&engine->bucket, now);
+        if (tokens > wait) wait = tokens;
+        tokens = bucket_wait_ns(&job->host->bucket, now);
+        if (tokens > wait) wait = tokens;
+        tokens = job->limit ? bucket_wait_ns(job->limit, now) : 0;
+        if (tokens > wait) wait = tokens;
+        if (wait < next) next = wait;
+    }
+    return (int)((next + 999999ull) / 1000000ull);
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+void http_token_bucket_init(http_token_bucket_t *bucket, double rate, double burst) {
+    if (!bucket) return;
+
+    bucket->rate = rate > 0 ? rate : 0;
+    bucket->burst = burst > 0 ? burst : bucket->rate / 100;
+    if (bucket->burst < 1.0) bucket->burst = 1.0;
+    bucket->tokens = bucket->burst;
+    bucket->updated_ns = now_ns();
+}
+
+http_retry_policy_t http_retry_policy_default(void) {
+    http_retry_policy_t policy = {
+        .max_attempts = 3,
+        .retry_on = HTTP_RETRY_CONNECT | HTTP_RETRY_NETWORK | HTTP_RETRY_429 | HTTP_RETRY_5XX,
+        .backoff_base_ms = 100,
+        .backoff_max_ms = 2000,
+        .budget_ratio = 0.1,
+        .budget_min = 10,
+        .hedge_after_ms = 0
+    };
+    return policy;
+}
+
+http_engine_t *http_engine_create(int max_concurrent) {
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        return NULL;
+    }
+
+    http_engine_t *engine = calloc(1, sizeof(http_engine_t));
+    if (!engine) {
+        curl_global_cleanup();
+        return NULL;
+    }
+
+    engine->multi = curl_multi_init();
+    if (!engine->multi) {
+        free(engine);
+        curl_global_cleanup();
+        return NULL;
+    }
+    engine->max_concurrent = max_concurrent;
+    engine->policy.max_attempts = 1;
+    engine->random_state = now_ns() | 1;
+    return engine;
+}
+
+void http_engine_destroy(http_engine_t *engine) {
+    if (!engine) return;
+
+    // Abandon in-flight transfers; a job goes with its last transfer
+    while (engine->active_list) {
+        http_transfer_t *transfer = engine->active_list;
+        http_job_t *job = transfer->job;
+        http_response_free(transfer->response);
+        curl_multi_remove_handle(engine->multi, transfer->curl);
+        unlink_active(engine, transfer);
+        curl_easy_cleanup(transfer->curl);
+        free(transfer);
+        if (job->in_flight == 0) free(job);
+    }
+
+    while (engine->host_list) {
+        http_host_t *host = engine->host_list;
+        while (host->queue_head) {
+            http_job_t *job = host->queue_head;
+            host->queue_head = job->next;
+            free(job);
+        }
+        engine->host_list = host->next;
+        free(host);
+    }
+    while (engine->backoff) {
+        http_job_t *job = engine->backoff;
+        engine->backoff = job->next;
+        free(job);
+    }
+
+    for (int i = 0; i < engine->idle_count; i++) {
+        curl_easy_cleanup(engine->idle[i]);
+    }
+    free(engine->idle);
+    for (int i = 0; i < engine->connection_count; i++) {
+        free(engine->connections[i]);
+    }
+    free(engine->connections);
+    curl_multi_cleanup(engine->multi);
+    free(engine);
+    curl_global_cleanup();
+}
+
+void http_engine_set_policy(http_engine_t *engine, const http_retry_policy_t *policy) {
+    if (!engine || !policy) return;
+
+    engine->policy = *policy;
+    if (engine->policy.max_attempts < 1) engine->policy.max_attempts = 1;
+    if (engine->policy.max_attempts > HTTP_MAX_ATTEMPTS) engine->policy.max_attempts = HTTP_MAX_ATTEMPTS;
+}
+
+void http_engine_set_rate(http_engine_t *engine, double rate, double burst) {
+    if (!engine) return;
+    http_token_bucket_init(&engine->bucket, rate, burst);
+}
+
+int http_engine_set_host_limits(http_engine_t *engine, const char *host, double rate, double burst,
+                                int max_connections) {
+    if (!engine) return -1;
+
+    if (host) {
+        char name[HOST_NAME_LENGTH];
+        url_host(host, name, sizeof(name));
+        http_host_t *entry = host_get(engine, name);
+        if (!entry) return -1;
+        entry->own_limits = 1;
+        http_token_bucket_init(&entry->bucket, rate, burst);
+        entry->max_connections = max_connections;
+        return 0;
+    }
+
+    engine->host_rate = rate;
+    engine->host_burst = burst;
+    engine->host_max_connections = max_connections;
+    for (http_host_t *entry = engine->host_list; entry; entry = entry->next) {
+        if (entry->own_limits) continue;
+        http_token_bucket_init(&entry->bucket, rate, burst);
+        entry->max_connections = max_connections;
+    }
+    return 0;
+}
+
+void http_engine_set_multiplexing(http_engine_t *engine, int max_streams) {
+    if (!engine) return;
+
+    curl_multi_setopt(engine->multi, CURLMOPT_PIPELINING,
+                      max_streams == HTTP_MULTIPLEX_OFF ? (long)CURLPIPE_NOTHING : (long)CURLPIPE_MULTIPLEX);
+    // 100 is libcurl's default limit
+    curl_multi_setopt(engine->multi, CURLMOPT_MAX_CONCURRENT_STREAMS, max_streams > 0 ? (long)max_streams : 100L);
+    engine->pipewait = max_streams > 0;
+
+    // Without a cap, every request that finds the connections full opens
+    // its own instead of waiting for a stream
+    long connections = 0;
+    if (max_streams > 0 && engine->max_concurrent > 0) {
+        connections = (engine->max_concurrent + max_streams - 1) / max_streams;
+    }
+    curl_multi_setopt(engine->multi, CURLMOPT_MAX_HOST_CONNECTIONS, connections);
+}
+
+int http_engine_connections(const http_engine_t *engine, http_connection_stats_t *connections, int max) {
+    if (!engine) return 0;
+    for (int i = 0; connections && i < engine->connection_count && i < max; i++) {
+        connections[i] = engine->connections[i]->stats;
+    }
+    return engine->connection_count;
+}
+
+http_engine_stats_t http_engine_stats(const http_engine_t *engine) {
+    http_engine_stats_t stats = {0};
+    return engine ? engine->stats : stats;
+}
+
+int http_engine_submit(http_engine_t *engine, const compiled_request_t *request,
+                       http_engine_done_fn done, void *user_data) {
+    return http_engine_submit_limited(engine, request, NULL, done, user_data);
+}
+
+int http_engine_submit_limited(http_engine_t *engine, const compiled_request_t *request,
+                               http_token_bucket_t *limit, http_engine_done_fn done, void *user_data) {
+    if (!engine || !request || !done) return -1;
+
+    char name[HOST_NAME_LENGTH];
+    url_host(request->url, name, sizeof(name));
+    http_host_t *host = host_get(engine, name);
+    http_job_t *job = host ? calloc(1, sizeof(http_job_t)) : NULL;
+    if (!job) return -1;
+
+    job->request = request;
+    job->host = host;
+    job->limit = limit;
+    job->done = done;
+    job->user_data = user_data;
+    job->policy = engine->policy;
+    job->submit_ns = now_ns();
+    engine->stats.requests++;
+    enqueue(engine, job);
+    return 0;
+}
+
+int http_engine_warm_up(http_engine_t *engine, const compiled_request_t *const *requests, int count,
+                        int connections) {
+    if (!engine || connections < 1 || http_engine_pending(engine) > 0) return -1;
+
+    compiled_request_t **targets = calloc(HTTP_WARMUP_MAX_TARGETS, sizeof(compiled_request_t *));
+    if (!targets) return -1;
+    int target_count = http_warmup_targets(requests, count, targets, HTTP_WARMUP_MAX_TARGETS);
+    int total = target_count * connections;
+    CURL **handles = calloc((size_t)(total > 0 ? total : 1), sizeof(CURL *));
+    http_host_t **hosts = calloc((size_t)(total > 0 ? total : 1), sizeof(http_host_t *));
+    if (!handles || !hosts) {
+        for (int i = 0; i < target_count; i++) {
+            compiled_request_destroy(targets[i]);
+        }
+        free(targets);
+        free(handles);
+        free(hosts);
+        return -1;
+    }
+
+    // Keep every warmed connection, and the usual four per transfer slot
+    long keep = engine->max_concurrent > 0 ? engine->max_concurrent * 4L : 256;
+    curl_multi_setopt(engine->multi, CURLMOPT_MAXCONNECTS, total > keep ? (long)total : keep);
+
+    int remaining = 0;
+    for (int i = 0; i < total; i++) {
+        char name[HOST_NAME_LENGTH];
+        url_host(targets[i / connections]->url, name, sizeof(name));
+        hosts[i] = host_get(engine, name);
+        handles[i] = hosts[i] ? http_warmup_handle(targets[i / connections]) : NULL;
+        if (handles[i]) {
+            curl_easy_setopt(handles[i], CURLOPT_PRIVATE, (char *)&handles[i]);
+            remaining++;
+        }
+    }
+
+    // Warm-up requests obey the concurrency, host and rate limits like any other
+    int opened = 0, next = 0;
+    while (remaining > 0) {
+        uint64_t now = now_ns();
+        for (; next < total && has_free_slot(engine); next++) {
+            if (!handles[next]) continue;
+            if (!host_admits(engine, hosts[next], now)) break;
+            bucket_take(&engine->bucket);
+            bucket_take(&hosts[next]->bucket);
+            if (curl_multi_add_handle(engine->multi, handles[next]) != CURLM_OK) {
+                curl_easy_cleanup(handles[next]);
+                handles[next] = NULL;
+                remaining--;
+                continue;
+            }
+            hosts[next]->in_flight++;
+            engine->active++;
+        }
+
+        int running = 0;
+        curl_multi_perform(engine->multi, &running);
+        CURLMsg *message;
+        int queued;
+        while ((message = curl_multi_info_read(engine->multi, &queued)) != NULL) {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            CURL **slot = NULL;
+            long status = 0;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char **)&slot);
+            curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &status);
+            if (status > 0) opened++;
+
+            // The connection stays in the multi handle's pool
+            curl_multi_remove_handle(engine->multi, *slot);
+            curl_easy_cleanup(*slot);
+            *slot = NULL;
+            hosts[slot - handles]->in_flight--;
+            engine->active--;
+            remaining--;
+        }
+
+        if (remaining > 0) {
+            int wait_ms = 100;
+            if (next < total && has_free_slot(engine)) {
+                uint64_t wait = bucket_wait_ns(&engine->bucket, now);
+                uint64_t host_wait = bucket_wait_ns(&hosts[next]->bucket, now);
+                if (host_wait > wait) wait = host_wait;
+                if (wait < 100000000ull) wait_ms = (int)((wait + 999999ull) / 1000000ull);
+            }
+            curl_multi_poll(engine->multi, NULL, 0, wait_ms, NULL);
+        }
+    }
+
+    for (int i = 0; i < target_count; i++) {
+        compiled_request_destroy(targets[i]);
+    }
+    free(targets);
+    free(handles);
+    free(hosts);
+    return opened;
+}
+
+int http_engine_run(http_engine_t *engine, int timeout_ms) {
+    if (!engine) return 0;
+
+    uint64_t now = now_ns();
+    promote_backoff(engine, now);
+    start_queued(engine, now);
+    if (engine->active > 0) {
+        int running = 0;
+        curl_multi_perform(engine->multi, &running);
+        dispatch_completions(engine);
+
+        // Completions free slots and may have submitted follow-up requests
+        now = now_ns();
+        promote_backoff(engine, now);
+        start_queued(engine, now);
+        start_hedges(engine, now);
+    }
+
+    // Sleep until network activity, or until the next retry, hedge or token is due
+    if (engine->active > 0 || engine->waiting > 0 || engine->queued > 0) {
+        int wait_ms = next_timer_ms(engine, now_ns(), timeout_ms);
+        if (engine->active > 0) {
+            curl_multi_poll(engine->multi, NULL, 0, wait_ms, NULL);
+        } else if (wait_ms > 0) {
+            struct timespec ts = { wait_ms / 1000, (long)(wait_ms % 1000) * 1000000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return engine->active + engine->queued + engine->waiting;
+}
+
+int http_engine_pending(const http_engine_t *engine) {
+    return engine ? engine->active + engine->queued + engine->waiting : 0;
+}
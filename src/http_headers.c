@@ -0,0 +1,222 @@
+/* ============================================================================
+ * API Kit - Response Header Index Implementation
+ * ============================================================================ */
+
+#include "http_headers.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* ============================================================================
+ * HELPERS
+ * ============================================================================ */
+
+static uint32_t hash_name(const char *name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)name[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void reset_buckets(http_headers_t *headers) {
+    for (int i = 0; i < HTTP_HEADER_BUCKETS; i++) {
+        headers->bucket_head[i] = -1;
+        headers->bucket_tail[i] = -1;
+    }
+}
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static http_header_block_t *add_block(http_headers_t *headers) {
+    if (headers->block_count == headers->block_capacity) {
+        int capacity = headers->block_capacity ? headers->block_capacity * 2 : 4;
+        http_header_block_t *blocks = realloc(headers->blocks, (size_t)capacity * sizeof(http_header_block_t));
+        if (!blocks) return NULL;
+        headers->blocks = blocks;
+        headers->block_capacity = capacity;
+    }
+
+    http_header_block_t *block = &headers->blocks[headers->block_count++];
+    memset(block, 0, sizeof(*block));
+    block->first = headers->count;
+    reset_buckets(headers);
+    return block;
+}
+
+static int name_equals(const http_headers_t *headers, const http_header_t *header,
+                       const char *name, size_t length, uint32_t hash) {
+    return header->hash == hash && header->name_length == length &&
+           strncasecmp(headers->text + header->name_offset, name, length) == 0;
+}
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+void http_headers_init(http_headers_t *headers) {
+    memset(headers, 0, sizeof(*headers));
+    reset_buckets(headers);
+}
+
+void http_headers_free(http_headers_t *headers) {
+    if (!headers) return;
+
+    free(headers->items);
+    free(headers->blocks);
+    http_headers_init(headers);
+}
+
+int http_headers_add_line(http_headers_t *headers, const char *text, size_t offset, size_t length) {
+    if (offset + length > UINT32_MAX) return -1;
+    headers->text = text;
+
+    const char *line = text + offset;
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+    if (length == 0) return 0;
+
+    // Status line: a new response (redirect hop, 1xx or the final one)
+    if (length > 5 && strncmp(line, "HTTP/", 5) == 0) {
+        http_header_block_t *block = add_block(headers);
+        if (!block) return -1;
+        block->line_offset = (uint32_t)offset;
+        block->line_length = (uint32_t)length;
+
+        const char *code = memchr(line, ' ', length);
+        block->status_code = code ? strtol(code + 1, NULL, 10) : 0;
+        return 0;
+    }
+
+    const char *colon = memchr(line, ':', length);
+    if (is_blank(line[0]) || !colon || colon == line) return 0;
+
+    // Headers without a status line (e.g. from file:// URLs) get an anonymous block
+    if (headers->block_count == 0 && !add_block(headers)) return -1;
+
+    if (headers->count == headers->capacity) {
+        int capacity = headers->capacity ? headers->capacity * 2 : 16;
+        http_header_t *items = realloc(headers->items, (size_t)capacity * sizeof(http_header_t));
+        if (!items) return -1;
+        headers->items = items;
+        headers->capacity = capacity;
+    }
+
+    size_t name_length = (size_t)(colon - line);
+    while (name_length > 0 && is_blank(line[name_length - 1])) name_length--;
+
+    const char *value = colon + 1;
+    const char *end = line + length;
+    while (value < end && is_blank(*value)) value++;
+    while (end > value && is_blank(end[-1])) end--;
+
+    int index = headers->count++;
+    http_header_t *header = &headers->items[index];
+    header->name_offset = (uint32_t)offset;
+    header->name_length = (uint32_t)name_length;
+    header->value_offset = (uint32_t)(value - text);
+    header->value_length = (uint32_t)(end - value);
+    header->hash = hash_name(line, name_length);
+    header->next = -1;
+
+    // Append to the bucket so same-name headers stay in arrival order
+    int bucket = (int)(header->hash & (HTTP_HEADER_BUCKETS - 1));
+    if (headers->bucket_tail[bucket] >= 0) {
+        headers->items[headers->bucket_tail[bucket]].next = index;
+    } else {
+        headers->bucket_head[bucket] = index;
+    }
+    headers->bucket_tail[bucket] = index;
+
+    headers->blocks[headers->block_count - 1].count++;
+    return 0;
+}
+
+int http_headers_parse(http_headers_t *headers, const char *text, size_t length) {
+    size_t offset = 0;
+    while (offset < length) {
+        const char *newline = memchr(text + offset, '\n', length - offset);
+        size_t line_length = newline ? (size_t)(newline - (text + offset)) + 1 : length - offset;
+        if (http_headers_add_line(headers, text, offset, line_length) != 0) return -1;
+        offset += line_length;
+    }
+    return 0;
+}
+
+const http_header_block_t *http_headers_final(const http_headers_t *headers) {
+    if (!headers || headers->block_count == 0) return NULL;
+    return &headers->blocks[headers->block_count - 1];
+}
+
+const http_header_t *http_headers_find(const http_headers_t *headers, int block, const char *name) {
+    if (!headers || !name || headers->block_count == 0) return NULL;
+    if (block < 0) block = headers->block_count - 1;
+    if (block >= headers->block_count) return NULL;
+
+    size_t length = strlen(name);
+    uint32_t hash = hash_name(name, length);
+
+    // Only the final block is hashed; earlier hops are short and rarely searched
+    if (block == headers->block_count - 1) {
+        int index = headers->bucket_head[hash & (HTTP_HEADER_BUCKETS - 1)];
+        for (; index >= 0; index = headers->items[index].next) {
+            if (name_equals(headers, &headers->items[index], name, length, hash)) {
+                return &headers->items[index];
+            }
+        }
+        return NULL;
+    }
+
+    const http_header_block_t *b = &headers->blocks[block];
+    for (int i = b->first; i < b->first + b->count; i++) {
+        if (name_equals(headers, &headers->items[i], name, length, hash)) {
+            return &headers->items[i];
+        }
+    }
+    return NULL;
+}
+
+const http_header_t *http_headers_find_next(const http_headers_t *headers, const http_header_t *header) {
+    if (!headers || !header) return NULL;
+
+    const char *name = headers->text + header->name_offset;
+    int index = (int)(header - headers->items);
+    const http_header_block_t *final = http_headers_final(headers);
+
+    if (index >= final->first) {
+        for (int i = header->next; i >= 0; i = headers->items[i].next) {
+            if (name_equals(headers, &headers->items[i], name, header->name_length, header->hash)) {
+                return &headers->items[i];
+            }
+        }
+        return NULL;
+    }
+
+    // Earlier block: scan to the end of the block the header belongs to
+    int end = index + 1;
+    for (int b = 0; b < headers->block_count; b++) {
+        const http_header_block_t *block = &headers->blocks[b];
+        if (index >= block->first && index < block->first + block->count) {
+            end = block->first + block->count;
+            break;
+        }
+    }
+    for (int i = index + 1; i < end; i++) {
+        if (name_equals(headers, &headers->items[i], name, header->name_length, header->hash)) {
+            return &headers->items[i];
+        }
+    }
+    return NULL;
+}
+
+const char *http_headers_get(const http_headers_t *headers, const char *name, size_t *length) {
+    const http_header_t *header = http_headers_find(headers, -1, name);
+    if (!header) return NULL;
+
+    if (length) *length = header->value_length;
+    return headers->text + header->value_offset;
+}
@@ -1,9 +1,11 @@
 #include "http_parser.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 int http_parse_file(const char* filename, http_collection_t* collection) {
+    uint64_t trace_start_ns = trace_begin();
     FILE *file = fopen(filename, "r");
     if (!file) {
         return -1; // File doesn't exist or can't be opened
@@ -24,6 +26,16 @@ int http_parse_file(const char* filename, http_collection_t* collection) {
         // Remove newline
         line[strcspn(line, "\n")] = 0;
         
+        // Directives ("# @capture ...") belong to the request's header block,
+        // wherever they appear before the body
+        if (strncmp(line, "# @", 3) == 0 && !reading_body) {
+            if (strlen(current_headers) > 0) {
+                strncat(current_headers, "\n", sizeof(current_headers) - strlen(current_headers) - 1);
+            }
+            strncat(current_headers, line, sizeof(current_headers) - strlen(current_headers) - 1);
+            continue;
+        }
+
         // Skip comments that don't start with ###
         if (line[0] == '#' && !(line[0] == '#' && line[1] == '#' && line[2] == '#')) {
             continue;
@@ -152,10 +164,12 @@ int http_parse_file(const char* filename, http_collection_t* collection) {
     }
     
     fclose(file);
+    trace_end("http_parse_file", "parser", trace_start_ns);
     return 0;
 }
 
 int http_save_file(const char* filename, const http_collection_t* collection) {
+    uint64_t trace_start_ns = trace_begin();
     FILE *file = fopen(filename, "w");
     if (!file) {
         return -1;
@@ -205,6 +219,7 @@ int http_save_file(const char* filename, const http_collection_t* collection) {
     }
     
     fclose(file);
+    trace_end("http_save_file", "parser", trace_start_ns);
     return 0;
 }
 
@@ -0,0 +1,111 @@
+/* ============================================================================
+ * API Kit - HTTP Task Implementation
+ *
+ * The worker owns the client while the transfer runs. It shares only the
+ * progress counters and the cancel flag (atomics, see http_progress_t) and
+ * the done flag, stored with release semantics once the response is set.
+ * ============================================================================ */
+
+#include "http_task.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#define RATE_WINDOW_NS 250000000ull    // Shortest interval between rate samples
+
+struct http_task {
+    http_client_t *client;
+    const compiled_request_t *request;
+    http_progress_t progress;
+    http_response_t *response;
+    int done;                   // Atomic: response is set
+
+    pthread_t worker;
+    int worker_started;
+
+    // Throughput, updated by http_task_progress
+    uint64_t start_ns;
+    uint64_t end_ns;            // Set before done
+    uint64_t sample_ns;
+    uint64_t sample_bytes;
+    double bytes_per_second;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void *send_worker(void *arg) {
+    http_task_t *task = arg;
+    task->response = http_request_tracked(task->client, task->request, &task->progress);
+    task->end_ns = now_ns();
+    __atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+http_task_t *http_task_start(http_client_t *client, const compiled_request_t *request) {
+    if (!client || !request) return NULL;
+
+    http_task_t *task = calloc(1, sizeof(http_task_t));
+    if (!task) return NULL;
+
+    task->client = client;
+    task->request = request;
+    task->start_ns = now_ns();
+    task->sample_ns = task->start_ns;
+
+    if (pthread_create(&task->worker, NULL, send_worker, task) == 0) {
+        task->worker_started = 1;
+    } else {
+        // No thread available: send inline rather than not at all
+        send_worker(task);
+    }
+    return task;
+}
+
+void http_task_cancel(http_task_t *task) {
+    if (!task) return;
+    __atomic_store_n(&task->progress.cancel, 1, __ATOMIC_RELAXED);
+}
+
+int http_task_is_done(const http_task_t *task) {
+    return task && __atomic_load_n(&task->done, __ATOMIC_ACQUIRE);
+}
+
+http_task_progress_t http_task_progress(http_task_t *task) {
+    http_task_progress_t progress = {0};
+    if (!task) return progress;
+
+    progress.downloaded = __atomic_load_n(&task->progress.downloaded, __ATOMIC_RELAXED);
+    progress.download_total = __atomic_load_n(&task->progress.download_total, __ATOMIC_RELAXED);
+    progress.uploaded = __atomic_load_n(&task->progress.uploaded, __ATOMIC_RELAXED);
+    progress.upload_total = __atomic_load_n(&task->progress.upload_total, __ATOMIC_RELAXED);
+
+    uint64_t now = now_ns();
+    progress.elapsed_ns = (http_task_is_done(task) ? task->end_ns : now) - task->start_ns;
+    if (now - task->sample_ns >= RATE_WINDOW_NS) {
+        uint64_t bytes = progress.downloaded > task->sample_bytes ? progress.downloaded - task->sample_bytes : 0;
+        task->bytes_per_second = (double)bytes * 1e9 / (double)(now - task->sample_ns);
+        task->sample_ns = now;
+        task->sample_bytes = progress.downloaded;
+    }
+    progress.bytes_per_second = task->bytes_per_second;
+    return progress;
+}
+
+http_response_t *http_task_finish(http_task_t *task) {
+    if (!task) return NULL;
+
+    if (task->worker_started) {
+        pthread_join(task->worker, NULL);
+    }
+    http_response_t *response = task->response;
+    free(task);
+    return response;
+}
@@ -0,0 +1,200 @@
+/* ============================================================================
+ * API Kit - Connection Warm-up Implementation
+ * ============================================================================ */
+
+#include "http_warmup.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+
+struct http_warmup {
+    http_client_t *client;
+    compiled_request_t **targets;
+    int target_count;
+    int connections;
+    int opened;
+    int done;                   // Atomic: opened is final
+
+    pthread_t worker;
+    int worker_started;
+};
+
+/* ============================================================================
+ * HELPERS
+ * ============================================================================ */
+
+static size_t discard_body(void *contents, size_t size, size_t nmemb, void *user_data) {
+    (void)contents;
+    (void)user_data;
+    return size * nmemb;
+}
+
+// Whether two requests connect the same way
+static int same_routes(const compiled_request_t *a, const compiled_request_t *b) {
+    if (a->http_version != b->http_version) return 0;
+    if (!a->unix_socket != !b->unix_socket) return 0;
+    if (a->unix_socket && strcmp(a->unix_socket, b->unix_socket) != 0) return 0;
+
+    const struct curl_slist *x = a->connect_to, *y = b->connect_to;
+    for (; x && y; x = x->next, y = y->next) {
+        if (strcmp(x->data, y->data) != 0) return 0;
+    }
+    return !x && !y;
+}
+
+// Open the connections on a private multi handle sharing the client's DNS
+// cache and TLS sessions
+static void *warmup_worker(void *arg) {
+    http_warmup_t *warmup = arg;
+    int total = warmup->target_count * warmup->connections;
+    CURLM *multi = curl_multi_init();
+    CURL **handles = calloc((size_t)(total > 0 ? total : 1), sizeof(CURL *));
+    if (!multi || !handles) {
+        curl_multi_cleanup(multi);
+        free(handles);
+        __atomic_store_n(&warmup->done, 1, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    // Every connection must survive into the pool when its handle is removed
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)total);
+    for (int i = 0; i < total; i++) {
+        handles[i] = http_warmup_handle(warmup->targets[i / warmup->connections]);
+        if (!handles[i]) continue;
+        curl_easy_setopt(handles[i], CURLOPT_SHARE, warmup->client->share);
+        curl_multi_add_handle(multi, handles[i]);
+    }
+
+    int running = 1;
+    while (running > 0) {
+        if (curl_multi_perform(multi, &running) != CURLM_OK) break;
+        if (running > 0) curl_multi_poll(multi, NULL, 0, 100, NULL);
+    }
+
+    int opened = 0;
+    for (int i = 0; i < total; i++) {
+        if (!handles[i]) continue;
+        long status = 0;
+        curl_easy_getinfo(handles[i], CURLINFO_RESPONSE_CODE, &status);
+        if (status > 0) opened++;
+        curl_multi_remove_handle(multi, handles[i]);
+        curl_easy_cleanup(handles[i]);
+    }
+    free(handles);
+    curl_multi_cleanup(multi);
+
+    warmup->opened = opened;
+    __atomic_store_n(&warmup->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+int http_url_origin(const char *url, char *origin, size_t size) {
+    if (!url || !origin || size == 0) return -1;
+
+    CURLU *parsed = curl_url();
+    char *scheme = NULL, *host = NULL, *port = NULL;
+    int result = -1;
+    if (parsed && curl_url_set(parsed, CURLUPART_URL, url, CURLU_GUESS_SCHEME) == CURLUE_OK &&
+        curl_url_get(parsed, CURLUPART_SCHEME, &scheme, 0) == CURLUE_OK &&
+        curl_url_get(parsed, CURLUPART_HOST, &host, 0) == CURLUE_OK &&
+        curl_url_get(parsed, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+        int length = snprintf(origin, size, "%s://%s:%s", scheme, host, port);
+        result = length > 0 && (size_t)length < size ? 0 : -1;
+    }
+    curl_free(scheme);
+    curl_free(host);
+    curl_free(port);
+    curl_url_cleanup(parsed);
+    return result;
+}
+
+int http_warmup_targets(const compiled_request_t *const *requests, int count,
+                        compiled_request_t **targets, int max) {
+    int found = 0;
+    for (int i = 0; i < count && found < max; i++) {
+        char origin[HTTP_ORIGIN_LENGTH];
+        if (!requests[i] || http_url_origin(requests[i]->url, origin, sizeof(origin) - 1) != 0) continue;
+        strcat(origin, "/");
+
+        int seen = 0;
+        for (int j = 0; j < found && !seen; j++) {
+            seen = strcmp(targets[j]->url, origin) == 0 && same_routes(targets[j], requests[i]);
+        }
+        if (seen) continue;
+
+        compiled_request_t *target = compiled_request_create(HTTP_METHOD_GET, origin, NULL, NULL,
+                                                             HTTP_WARMUP_TIMEOUT_MS);
+        if (!target || compiled_request_copy_routes(target, requests[i]) != 0) {
+            compiled_request_destroy(target);
+            continue;
+        }
+        targets[found++] = target;
+    }
+    return found;
+}
+
+CURL *http_warmup_handle(const compiled_request_t *target) {
+    CURL *curl = curl_easy_init();
+    if (!curl) return NULL;
+
+    curl_easy_setopt(curl, CURLOPT_URL, target->url);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "OPTIONS");
+    curl_easy_setopt(curl, CURLOPT_REQUEST_TARGET, "*");
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_body);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "apikit/1.0");
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, target->timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, target->unix_socket);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_TO, target->connect_to);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, target->http_version);
+    return curl;
+}
+
+http_warmup_t *http_warmup_start(http_client_t *client, const compiled_request_t *const *requests,
+                                 int count, int connections) {
+    if (!client || !client->share || (count > 0 && !requests) || connections < 1) return NULL;
+
+    http_warmup_t *warmup = calloc(1, sizeof(http_warmup_t));
+    if (!warmup) return NULL;
+    warmup->targets = calloc(HTTP_WARMUP_MAX_TARGETS, sizeof(compiled_request_t *));
+    if (!warmup->targets) {
+        free(warmup);
+        return NULL;
+    }
+
+    warmup->client = client;
+    warmup->connections = connections;
+    warmup->target_count = http_warmup_targets(requests, count, warmup->targets, HTTP_WARMUP_MAX_TARGETS);
+
+    if (pthread_create(&warmup->worker, NULL, warmup_worker, warmup) == 0) {
+        warmup->worker_started = 1;
+    } else {
+        // No thread available: warm up inline rather than not at all
+        warmup_worker(warmup);
+    }
+    return warmup;
+}
+
+int http_warmup_is_done(const http_warmup_t *warmup) {
+    return warmup && __atomic_load_n(&warmup->done, __ATOMIC_ACQUIRE);
+}
+
+int http_warmup_finish(http_warmup_t *warmup) {
+    if (!warmup) return 0;
+
+    if (warmup->worker_started) {
+        pthread_join(warmup->worker, NULL);
+    }
+    int opened = warmup->opened;
+    for (int i = 0; i < warmup->target_count; i++) {
+        compiled_request_destroy(warmup->targets[i]);
+    }
+    free(warmup->targets);
+    free(warmup);
+    return opened;
+}
@@ -0,0 +1,329 @@
+/* ============================================================================
+ * API Kit - JSON Formatter Implementation
+ *
+ * Builds the pretty-print line index in a single forward pass and renders
+ * individual lines with canonical spacing and highlight spans.
+ * ============================================================================ */
+
+#include "json_format.h"
+#include <string.h>
+
+#define JSON_INDENT_WIDTH 2
+
+/* ============================================================================
+ * UTILITY FUNCTIONS
+ * ============================================================================ */
+
+static int is_json_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int is_json_delimiter(char c) {
+    return is_json_space(c) || c == ',' || c == ':' || c == ']' || c == '}' || c == '[' || c == '{' || c == '"';
+}
+
+int json_format_detect(const char *data, size_t size) {
+    if (!data) return 0;
+
+    for (size_t i = 0; i < size; i++) {
+        if (is_json_space(data[i])) continue;
+        return data[i] == '{' || data[i] == '[';
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * LINE INDEXING
+ * ============================================================================ */
+
+static void begin_token(json_formatter_t *f, size_t pos) {
+    if (!f->line_open) {
+        f->line_open = 1;
+        f->line_start = (uint32_t)pos;
+    }
+    f->line_end = (uint32_t)(pos + 1);
+}
+
+static void end_line(json_formatter_t *f) {
+    if (!f->line_open) return;
+
+    json_line_t line = {
+        .offset = f->line_start,
+        .length = f->line_end - f->line_start,
+        .depth = f->depth
+    };
+    f->line_open = 0;
+    f->emit(f->user_data, &line);
+}
+
+static size_t next_significant(const json_formatter_t *f, size_t pos) {
+    while (pos < f->size && is_json_space(f->data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+void json_formatter_init(json_formatter_t *formatter, const char *data, size_t size,
+                         json_line_fn emit, void *user_data) {
+    memset(formatter, 0, sizeof(*formatter));
+    formatter->data = data;
+    formatter->size = size > UINT32_MAX ? UINT32_MAX : size;
+    formatter->emit = emit;
+    formatter->user_data = user_data;
+}
+
+int json_formatter_step(json_formatter_t *f, size_t max_bytes) {
+    size_t end = f->pos + max_bytes;
+    if (end > f->size || end < f->pos) {
+        end = f->size;
+    }
+
+    while (f->pos < end) {
+        if (f->failed) {
+            f->pos = json_index_plain(f->data, f->pos, f->size, end - f->pos, f->emit, f->user_data);
+            return f->pos < f->size;
+        }
+
+        size_t pos = f->pos;
+        char c = f->data[pos];
+
+        if (f->in_string) {
+            f->line_end = (uint32_t)(pos + 1);
+            if (f->escaped) {
+                f->escaped = 0;
+            } else if (c == '\\') {
+                f->escaped = 1;
+            } else if (c == '"') {
+                f->in_string = 0;
+            }
+            f->pos++;
+            continue;
+        }
+
+        switch (c) {
+            case ' ': case '\t': case '\n': case '\r':
+                break;
+
+            case '"':
+                begin_token(f, pos);
+                f->in_string = 1;
+                break;
+
+            case '{':
+            case '[': {
+                begin_token(f, pos);
+                // Keep empty containers on one line: "key": {}
+                size_t next = next_significant(f, pos + 1);
+                char close = c == '{' ? '}' : ']';
+                if (next < f->size && f->data[next] == close) {
+                    f->line_end = (uint32_t)(next + 1);
+                    f->pos = next + 1;
+                    continue;
+                }
+                end_line(f);
+                f->depth++;
+                break;
+            }
+
+            case '}':
+            case ']':
+                if (f->depth == 0) {
+                    // Unbalanced input: index the remainder as plain text
+                    end_line(f);
+                    f->failed = 1;
+                    continue;
+                }
+                end_line(f);
+                f->depth--;
+                begin_token(f, pos);
+                break;
+
+            case ',':
+                begin_token(f, pos);
+                end_line(f);
+                break;
+
+            default:
+                begin_token(f, pos);
+                break;
+        }
+        f->pos++;
+    }
+
+    if (f->pos >= f->size) {
+        end_line(f);
+        return 0;
+    }
+    return 1;
+}
+
+size_t json_index_plain(const char *data, size_t start, size_t size, size_t max_bytes,
+                        json_line_fn emit, void *user_data) {
+    if (size > UINT32_MAX) size = UINT32_MAX;
+
+    size_t pos = start;
+    size_t budget_end = start + max_bytes;
+    if (budget_end > size || budget_end < start) {
+        budget_end = size;
+    }
+
+    while (pos < budget_end) {
+        const char *nl = memchr(data + pos, '\n', size - pos);
+        size_t line_end = nl ? (size_t)(nl - data) : size;
+
+        json_line_t line = {
+            .offset = (uint32_t)pos,
+            .length = (uint32_t)(line_end - pos),
+            .depth = JSON_LINE_PLAIN
+        };
+        if (line.length > 0 && data[line_end - 1] == '\r') {
+            line.length--;
+        }
+        emit(user_data, &line);
+
+        pos = nl ? line_end + 1 : size;
+    }
+    return pos;
+}
+
+/* ============================================================================
+ * LINE RENDERING
+ * ============================================================================ */
+
+typedef struct {
+    char *out;
+    int size;
+    int len;
+    json_span_t *spans;
+    int max_spans;
+    int count;
+} render_buf_t;
+
+static int render_full(const render_buf_t *b) {
+    return b->len >= b->size - 1;
+}
+
+static void render_put(render_buf_t *b, char c, json_span_kind_t kind) {
+    if (render_full(b)) return;
+
+    // Raw control bytes would break the single-line layout
+    if ((unsigned char)c < 0x20) c = ' ';
+    b->out[b->len] = c;
+
+    if (b->spans && b->max_spans > 0) {
+        json_span_t *last = b->count > 0 ? &b->spans[b->count - 1] : NULL;
+        if (last && (last->kind == kind || b->count == b->max_spans) &&
+            last->start + last->length == b->len) {
+            // Extend the previous span; once the array is full the last span
+            // absorbs the rest of the line so coverage stays contiguous
+            if (last->kind != kind) last->kind = JSON_SPAN_PLAIN;
+            last->length++;
+        } else if (b->count < b->max_spans) {
+            b->spans[b->count].start = b->len;
+            b->spans[b->count].length = 1;
+            b->spans[b->count].kind = kind;
+            b->count++;
+        }
+    }
+    b->len++;
+}
+
+static void render_indent(render_buf_t *b, uint32_t depth) {
+    for (uint32_t i = 0; i < depth * JSON_INDENT_WIDTH && !render_full(b); i++) {
+        render_put(b, ' ', JSON_SPAN_PLAIN);
+    }
+}
+
+int json_format_render_line(const char *data, const json_line_t *line,
+                            char *out, int out_size,
+                            json_span_t *spans, int max_spans, int *span_count) {
+    render_buf_t b = { out, out_size, 0, spans, max_spans, 0 };
+    if (out_size <= 0) return 0;
+
+    const char *p = data + line->offset;
+    const char *end = p + line->length;
+
+    render_indent(&b, line->depth);
+
+    int first = 1;      // Only the line's first token can be a key
+    while (p < end && !render_full(&b)) {
+        char c = *p;
+
+        if (is_json_space(c)) {
+            p++;
+            continue;
+        }
+        int key_candidate = first;
+        first = 0;
+
+        if (c == '"') {
+            // Rendered as a value, and only as far as it fits: a string can
+            // be megabytes long, and the line is rendered every frame
+            int first_span = b.count;
+            int closed = 0;
+            render_put(&b, *p++, JSON_SPAN_STRING);
+            while (p < end && !render_full(&b)) {
+                char s = *p++;
+                render_put(&b, s, JSON_SPAN_STRING);
+                if (s == '\\' && p < end) {
+                    render_put(&b, *p++, JSON_SPAN_STRING);
+                } else if (s == '"') {
+                    closed = 1;
+                    break;
+                }
+            }
+
+            // The first string is a key if a colon follows it
+            const char *peek = p;
+            while (peek < end && is_json_space(*peek)) peek++;
+            if (key_candidate && closed && peek < end && *peek == ':') {
+                for (int i = first_span; i < b.count; i++) {
+                    if (b.spans[i].kind == JSON_SPAN_STRING) b.spans[i].kind = JSON_SPAN_KEY;
+                }
+            }
+            continue;
+        }
+
+        if (c == ':') {
+            render_put(&b, ':', JSON_SPAN_PUNCT);
+            render_put(&b, ' ', JSON_SPAN_PUNCT);
+            p++;
+            continue;
+        }
+
+        if (c == ',' || c == '{' || c == '}' || c == '[' || c == ']') {
+            render_put(&b, c, JSON_SPAN_PUNCT);
+            p++;
+            continue;
+        }
+
+        json_span_kind_t kind = JSON_SPAN_PLAIN;
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            kind = JSON_SPAN_NUMBER;
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            kind = JSON_SPAN_LITERAL;
+        }
+        while (p < end && !is_json_delimiter(*p) && !render_full(&b)) {
+            render_put(&b, *p++, kind);
+        }
+    }
+
+    out[b.len] = '\0';
+    if (span_count) *span_count = b.count;
+    return b.len;
+}
+
+int json_format_render_plain(const char *data, const json_line_t *line, char *out, int out_size) {
+    if (out_size <= 0) return 0;
+
+    int len = (int)line->length;
+    if (len > out_size - 1) len = out_size - 1;
+
+    const char *p = data + line->offset;
+    for (int i = 0; i < len; i++) {
+        char c = p[i];
+        out[i] = (unsigned char)c < 0x20 ? ' ' : c;
+    }
+    out[len] = '\0';
+    return len;
+}
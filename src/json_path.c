@@ -0,0 +1,314 @@
+/* ============================================================================
+ * API Kit - JSON Path Extraction Implementation
+ * ============================================================================ */
+
+#include "json_path.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * PATH COMPILATION
+ * ============================================================================ */
+
+static int is_key_char(char c) {
+    return c != '\0' && c != '.' && c != '[' && c != ']' && c != ' ';
+}
+
+int json_path_compile(const char *expression, json_path_t *path) {
+    if (!expression || !path) return -1;
+
+    size_t length = strlen(expression);
+    if (length >= sizeof(path->text)) return -1;
+    memcpy(path->text, expression, length + 1);
+    path->step_count = 0;
+
+    const char *p = path->text;
+    if (*p != '$') return -1;
+    p++;
+
+    while (*p) {
+        if (path->step_count == JSON_PATH_MAX_STEPS) return -1;
+        json_path_step_t *step = &path->steps[path->step_count];
+
+        if (*p == '.') {
+            const char *start = ++p;
+            while (is_key_char(*p)) p++;
+            if (p == start) return -1;
+            step->key = start;
+            step->key_length = (size_t)(p - start);
+            step->index = -1;
+        } else if (*p == '[' && (p[1] == '\'' || p[1] == '"')) {
+            char quote = p[1];
+            const char *start = p + 2;
+            const char *end = strchr(start, quote);
+            if (!end || end[1] != ']') return -1;
+            step->key = start;
+            step->key_length = (size_t)(end - start);
+            step->index = -1;
+            p = end + 2;
+        } else if (*p == '[') {
+            char *end;
+            long index = strtol(p + 1, &end, 10);
+            if (end == p + 1 || *end != ']' || index < 0) return -1;
+            step->key = NULL;
+            step->key_length = 0;
+            step->index = index;
+            p = end + 1;
+        } else {
+            return -1;
+        }
+        path->step_count++;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * SCANNING
+ * ============================================================================ */
+
+typedef struct {
+    const char *p;
+    const char *end;
+} cursor_t;
+
+static void skip_whitespace(cursor_t *c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\n' || *c->p == '\r')) {
+        c->p++;
+    }
+}
+
+// Cursor on the opening quote; leaves it past the closing quote
+static int skip_string(cursor_t *c) {
+    const char *p = c->p + 1;
+    for (;;) {
+        const char *quote = memchr(p, '"', (size_t)(c->end - p));
+        if (!quote) return -1;
+
+        // The quote is escaped if an odd number of backslashes precede it
+        const char *q = quote;
+        while (q > p && q[-1] == '\\') q--;
+        if (((quote - q) & 1) == 0) {
+            c->p = quote + 1;
+            return 0;
+        }
+        p = quote + 1;
+    }
+}
+
+// Skips any value without looking inside it beyond bracket depth
+static int skip_value(cursor_t *c) {
+    skip_whitespace(c);
+    if (c->p >= c->end) return -1;
+
+    char first = *c->p;
+    if (first == '"') return skip_string(c);
+
+    if (first == '{' || first == '[') {
+        int depth = 0;
+        while (c->p < c->end) {
+            char ch = *c->p;
+            if (ch == '"') {
+                if (skip_string(c) != 0) return -1;
+                continue;
+            }
+            if (ch == '{' || ch == '[') depth++;
+            else if (ch == '}' || ch == ']') {
+                if (--depth == 0) {
+                    c->p++;
+                    return 0;
+                }
+            }
+            c->p++;
+        }
+        return -1;
+    }
+
+    // Number or literal
+    const char *start = c->p;
+    while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']' &&
+           *c->p != ' ' && *c->p != '\t' && *c->p != '\n' && *c->p != '\r') {
+        c->p++;
+    }
+    return c->p > start ? 0 : -1;
+}
+
+// Compare a member name (cursor on its opening quote) with a key; advances past it
+static int match_key(cursor_t *c, const char *key, size_t key_length, int *matched) {
+    const char *start = c->p + 1;
+    if (skip_string(c) != 0) return -1;
+    const char *end = c->p - 1;
+    size_t length = (size_t)(end - start);
+
+    if (!memchr(start, '\\', length)) {
+        *matched = length == key_length && memcmp(start, key, key_length) == 0;
+        return 0;
+    }
+
+    // Rare: escaped member name
+    char *text = json_path_value_text(start - 1, length + 2);
+    if (!text) return -1;
+    *matched = strlen(text) == key_length && memcmp(text, key, key_length) == 0;
+    free(text);
+    return 0;
+}
+
+// Cursor on an object; moves to the value of the member named key
+static int enter_member(cursor_t *c, const json_path_step_t *step) {
+    c->p++;
+    for (;;) {
+        skip_whitespace(c);
+        if (c->p >= c->end || *c->p != '"') return -1;
+
+        int matched = 0;
+        if (match_key(c, step->key, step->key_length, &matched) != 0) return -1;
+
+        skip_whitespace(c);
+        if (c->p >= c->end || *c->p != ':') return -1;
+        c->p++;
+        skip_whitespace(c);
+        if (matched) return 0;
+
+        if (skip_value(c) != 0) return -1;
+        skip_whitespace(c);
+        if (c->p >= c->end || *c->p != ',') return -1;
+        c->p++;
+    }
+}
+
+// Cursor on an array; moves to the element at step->index
+static int enter_element(cursor_t *c, const json_path_step_t *step) {
+    c->p++;
+    for (long i = 0;; i++) {
+        skip_whitespace(c);
+        if (c->p >= c->end || *c->p == ']') return -1;
+        if (i == step->index) return 0;
+
+        if (skip_value(c) != 0) return -1;
+        skip_whitespace(c);
+        if (c->p >= c->end || *c->p != ',') return -1;
+        c->p++;
+    }
+}
+
+int json_path_find(const char *json, size_t length, const json_path_t *path,
+                   const char **value, size_t *value_length) {
+    if (!json || !path || !value || !value_length) return -1;
+
+    cursor_t c = { json, json + length };
+    skip_whitespace(&c);
+
+    for (int i = 0; i < path->step_count; i++) {
+        const json_path_step_t *step = &path->steps[i];
+        if (c.p >= c.end) return -1;
+
+        if (step->key) {
+            if (*c.p != '{' || enter_member(&c, step) != 0) return -1;
+        } else {
+            if (*c.p != '[' || enter_element(&c, step) != 0) return -1;
+        }
+    }
+
+    const char *start = c.p;
+    if (skip_value(&c) != 0) return -1;
+    *value = start;
+    *value_length = (size_t)(c.p - start);
+    return 0;
+}
+
+/* ============================================================================
+ * VALUE CONVERSION
+ * ============================================================================ */
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static long read_hex4(const char *p, const char *end) {
+    if (end - p < 4) return -1;
+    long code = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) return -1;
+        code = code * 16 + digit;
+    }
+    return code;
+}
+
+static char *write_utf8(char *out, long code) {
+    if (code < 0x80) {
+        *out++ = (char)code;
+    } else if (code < 0x800) {
+        *out++ = (char)(0xC0 | (code >> 6));
+        *out++ = (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        *out++ = (char)(0xE0 | (code >> 12));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (code >> 18));
+        *out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code & 0x3F));
+    }
+    return out;
+}
+
+size_t json_path_unescape(const char *value, size_t value_length, char *text) {
+    if (value_length < 2 || value[0] != '"') {
+        memcpy(text, value, value_length);
+        return value_length;
+    }
+
+    const char *p = value + 1;
+    const char *end = value + value_length - 1;
+    char *out = text;
+    while (p < end) {
+        if (*p != '\\' || p + 1 >= end) {
+            *out++ = *p++;
+            continue;
+        }
+
+        char escape = p[1];
+        p += 2;
+        switch (escape) {
+            case 'n': *out++ = '\n'; break;
+            case 't': *out++ = '\t'; break;
+            case 'r': *out++ = '\r'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'u': {
+                long code = read_hex4(p, end);
+                if (code < 0) {
+                    *out++ = 'u';
+                    break;
+                }
+                p += 4;
+                // Surrogate pair
+                if (code >= 0xD800 && code <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    long low = read_hex4(p + 2, end);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                out = write_utf8(out, code);
+                break;
+            }
+            default: *out++ = escape; break;  // \" \\ \/
+        }
+    }
+    return (size_t)(out - text);
+}
+
+char *json_path_value_text(const char *value, size_t value_length) {
+    if (!value) return NULL;
+
+    // Unescaped text is never longer than the escaped form
+    char *text = malloc(value_length + 1);
+    if (!text) return NULL;
+    text[json_path_unescape(value, value_length, text)] = '\0';
+    return text;
+}
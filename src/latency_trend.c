@@ -0,0 +1,365 @@
+/* ============================================================================
+ * API Kit - Latency Trends Implementation
+ *
+ * File format: a magic line, then per endpoint an "endpoint KEY" line
+ * followed by one "time_ms latency_us status" line per sample, oldest
+ * first. Samples of an endpoint are a ring, so recording is O(1) until the
+ * summary is refreshed, which only walks TREND_MAX_SAMPLES.
+ * ============================================================================ */
+
+#include "latency_trend.h"
+#include "hdr_histogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define TREND_MAGIC "apikit-trends 1"
+#define ENDPOINT_PREFIX "endpoint "
+#define TREND_PRECISION 5               // Badges: about 3%
+#define TREND_RANGE 32                  //   up to 2^32 us
+
+typedef struct {
+    int64_t time_ms;
+    uint32_t latency_us;
+    uint16_t status;
+} trend_sample_t;
+
+typedef struct {
+    char key[TREND_KEY_LENGTH];
+    uint64_t hash;
+    trend_sample_t samples[TREND_MAX_SAMPLES];
+    int first;                  // Oldest sample in the ring
+    int count;
+    latency_trend_t summary;
+} trend_endpoint_t;
+
+struct latency_trends {
+    trend_endpoint_t endpoints[TREND_MAX_ENDPOINTS];
+    int count;
+    hdr_histogram_t histogram;  // Scratch for the badges, over counts
+    uint64_t counts[HDR_BUCKET_COUNT(TREND_PRECISION, TREND_RANGE)];
+};
+
+/* ============================================================================
+ * ENDPOINT KEYS
+ * ============================================================================ */
+
+static int append(char *out, size_t size, size_t *used, const char *text, size_t length) {
+    if (*used + length >= size) return -1;
+    memcpy(out + *used, text, length);
+    *used += length;
+    out[*used] = '\0';
+    return 0;
+}
+
+static int all_of(const char *text, size_t length, const char *allowed) {
+    for (size_t i = 0; i < length; i++) {
+        if (!strchr(allowed, tolower((unsigned char)text[i]))) return 0;
+    }
+    return 1;
+}
+
+// Numbers, UUIDs and long hex strings name one resource of many
+static int is_identifier(const char *segment, size_t length) {
+    if (length == 0) return 0;
+    if (all_of(segment, length, "0123456789")) return 1;
+    if (length >= 16 && all_of(segment, length, "0123456789abcdef")) return 1;
+    if (length == 36 && segment[8] == '-' && segment[13] == '-' && segment[18] == '-' && segment[23] == '-') {
+        return all_of(segment, length, "0123456789abcdef-");
+    }
+    return 0;
+}
+
+// FNV-1a
+static uint64_t hash_key(const char *key) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+int latency_trend_endpoint(const char *method, const char *url, char *out, size_t size) {
+    if (!method || !url || !out || size == 0) return -1;
+    out[0] = '\0';
+    size_t used = 0;
+    if (append(out, size, &used, method, strlen(method)) != 0 || append(out, size, &used, " ", 1) != 0) {
+        return -1;
+    }
+
+    // Scheme and host are case-insensitive
+    const char *path = url;
+    const char *scheme_end = strstr(url, "://");
+    if (scheme_end) {
+        path = scheme_end + 3;
+        path += strcspn(path, "/?#");
+        for (const char *p = url; p < path; p++) {
+            char lower = (char)tolower((unsigned char)*p);
+            if (append(out, size, &used, &lower, 1) != 0) return -1;
+        }
+    }
+
+    size_t path_length = strcspn(path, "?#");
+    size_t path_start = used;
+    const char *end = path + path_length;
+    for (const char *segment = path; segment < end;) {
+        size_t length = strcspn(segment, "/?#");
+        if (segment + length > end) length = (size_t)(end - segment);
+        int failed = is_identifier(segment, length) ? append(out, size, &used, "{id}", 4) :
+                                                      append(out, size, &used, segment, length);
+        if (failed) return -1;
+        segment += length;
+        if (segment < end) {
+            if (append(out, size, &used, "/", 1) != 0) return -1;
+            segment++;
+        }
+    }
+
+    // "/users/" and "/users" are one endpoint, "" and "/" too
+    if (used - path_start > 1 && out[used - 1] == '/') out[--used] = '\0';
+    if (used == path_start && scheme_end && append(out, size, &used, "/", 1) != 0) return -1;
+    return 0;
+}
+
+/* ============================================================================
+ * DOWNSAMPLING
+ * ============================================================================ */
+
+int latency_trend_lttb(const trend_point_t *points, int count, int threshold, trend_point_t *out) {
+    if (!points || !out || count <= 0 || threshold <= 0) return 0;
+    if (threshold >= count) {
+        memcpy(out, points, (size_t)count * sizeof(trend_point_t));
+        return count;
+    }
+    if (threshold < 3) {
+        out[0] = points[0];
+        if (threshold == 2) out[1] = points[count - 1];
+        return threshold;
+    }
+
+    double every = (double)(count - 2) / (double)(threshold - 2);
+    int kept = 0, previous = 0;
+    out[kept++] = points[0];
+    for (int bucket = 0; bucket < threshold - 2; bucket++) {
+        // Average of the next bucket (the last point after the last bucket)
+        int next_start = (int)((bucket + 1) * every) + 1;
+        int next_end = (int)((bucket + 2) * every) + 1;
+        if (next_end > count) next_end = count;
+        double average_x = 0, average_y = 0;
+        for (int i = next_start; i < next_end; i++) {
+            average_x += points[i].x;
+            average_y += points[i].y;
+        }
+        int next_count = next_end - next_start;
+        if (next_count > 0) {
+            average_x /= next_count;
+            average_y /= next_count;
+        } else {
+            average_x = points[count - 1].x;
+            average_y = points[count - 1].y;
+        }
+
+        // The point of this bucket with the largest triangle
+        int start = (int)(bucket * every) + 1;
+        int end = (int)((bucket + 1) * every) + 1;
+        const trend_point_t *a = &points[previous];
+        double largest = -1;
+        int chosen = start;
+        for (int i = start; i < end && i < count - 1; i++) {
+            double area = (a->x - average_x) * (points[i].y - a->y) - (a->x - points[i].x) * (average_y - a->y);
+            if (area < 0) area = -area;
+            if (area > largest) {
+                largest = area;
+                chosen = i;
+            }
+        }
+        out[kept++] = points[chosen];
+        previous = chosen;
+    }
+    out[kept++] = points[count - 1];
+    return kept;
+}
+
+/* ============================================================================
+ * SERIES
+ * ============================================================================ */
+
+static const trend_sample_t *sample_at(const trend_endpoint_t *endpoint, int index) {
+    return &endpoint->samples[(endpoint->first + index) % TREND_MAX_SAMPLES];
+}
+
+static int find_endpoint(const latency_trends_t *trends, const char *key, uint64_t hash) {
+    for (int i = 0; i < trends->count; i++) {
+        if (trends->endpoints[i].hash == hash && strcmp(trends->endpoints[i].key, key) == 0) return i;
+    }
+    return -1;
+}
+
+// Existing endpoint, or a new one in place of the one recorded longest ago
+static trend_endpoint_t *add_endpoint(latency_trends_t *trends, const char *key) {
+    uint64_t hash = hash_key(key);
+    int index = find_endpoint(trends, key, hash);
+    if (index >= 0) return &trends->endpoints[index];
+
+    if (trends->count < TREND_MAX_ENDPOINTS) {
+        index = trends->count++;
+    } else {
+        index = 0;
+        int64_t oldest = INT64_MAX;
+        for (int i = 0; i < trends->count; i++) {
+            const trend_endpoint_t *endpoint = &trends->endpoints[i];
+            int64_t newest = endpoint->count ? sample_at(endpoint, endpoint->count - 1)->time_ms : INT64_MIN;
+            if (newest < oldest) {
+                oldest = newest;
+                index = i;
+            }
+        }
+    }
+    trend_endpoint_t *endpoint = &trends->endpoints[index];
+    memset(endpoint, 0, sizeof(*endpoint));
+    snprintf(endpoint->key, sizeof(endpoint->key), "%s", key);
+    endpoint->hash = hash;
+    return endpoint;
+}
+
+static void push_sample(trend_endpoint_t *endpoint, uint64_t latency_us, long status, int64_t time_ms) {
+    trend_sample_t *sample;
+    if (endpoint->count < TREND_MAX_SAMPLES) {
+        sample = &endpoint->samples[(endpoint->first + endpoint->count++) % TREND_MAX_SAMPLES];
+    } else {
+        sample = &endpoint->samples[endpoint->first];
+        endpoint->first = (endpoint->first + 1) % TREND_MAX_SAMPLES;
+    }
+    sample->time_ms = time_ms;
+    sample->latency_us = latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us;
+    sample->status = status < 0 || status > UINT16_MAX ? 0 : (uint16_t)status;
+}
+
+// Median latency of samples [from, to) that got a response, 0 if none did
+static uint64_t median_us(latency_trends_t *trends, const trend_endpoint_t *endpoint, int from, int to) {
+    hdr_histogram_reset(&trends->histogram);
+    for (int i = from; i < to; i++) {
+        const trend_sample_t *sample = sample_at(endpoint, i);
+        if (sample->status > 0) hdr_histogram_record(&trends->histogram, sample->latency_us);
+    }
+    return hdr_histogram_percentile(&trends->histogram, 50);
+}
+
+static void refresh_summary(latency_trends_t *trends, trend_endpoint_t *endpoint) {
+    latency_trend_t *summary = &endpoint->summary;
+    memset(summary, 0, sizeof(*summary));
+    int count = endpoint->count;
+    summary->samples = count;
+    if (count == 0) return;
+
+    trend_point_t points[TREND_MAX_SAMPLES];
+    hdr_histogram_reset(&trends->histogram);
+    for (int i = 0; i < count; i++) {
+        const trend_sample_t *sample = sample_at(endpoint, i);
+        points[i].x = count > 1 ? (double)i / (double)(count - 1) : 1.0;
+        points[i].y = (double)sample->latency_us / 1e3;
+        if (points[i].y > summary->max_ms) summary->max_ms = points[i].y;
+        if (sample->status > 0) hdr_histogram_record(&trends->histogram, sample->latency_us);
+        if (sample->status == 0 || sample->status >= 400) summary->errors++;
+    }
+    summary->point_count = latency_trend_lttb(points, count, TREND_SPARKLINE_POINTS, summary->points);
+    summary->p50_us = hdr_histogram_percentile(&trends->histogram, 50);
+    summary->p99_us = hdr_histogram_percentile(&trends->histogram, 99);
+    summary->last_status = sample_at(endpoint, count - 1)->status;
+
+    if (count >= 2 * TREND_RECENT_SAMPLES) {
+        uint64_t before = median_us(trends, endpoint, 0, count - TREND_RECENT_SAMPLES);
+        uint64_t recent = median_us(trends, endpoint, count - TREND_RECENT_SAMPLES, count);
+        summary->regressed = before > 0 && (double)recent > TREND_REGRESSION_FACTOR * (double)before;
+    }
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+static latency_trends_t *trends_create(void) {
+    latency_trends_t *trends = calloc(1, sizeof(latency_trends_t));
+    if (!trends) return NULL;
+    hdr_histogram_init(&trends->histogram, TREND_PRECISION, TREND_RANGE, trends->counts);
+    return trends;
+}
+
+latency_trends_t *latency_trends_load(const char *path) {
+    latency_trends_t *trends = trends_create();
+    if (!trends || !path) return trends;
+
+    FILE *file = fopen(path, "r");
+    if (!file) return trends;
+
+    char line[TREND_KEY_LENGTH + 32];
+    trend_endpoint_t *endpoint = NULL;
+    if (fgets(line, sizeof(line), file) && strncmp(line, TREND_MAGIC, strlen(TREND_MAGIC)) == 0) {
+        while (fgets(line, sizeof(line), file)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (strncmp(line, ENDPOINT_PREFIX, strlen(ENDPOINT_PREFIX)) == 0) {
+                endpoint = add_endpoint(trends, line + strlen(ENDPOINT_PREFIX));
+                continue;
+            }
+            long long time_ms = 0;
+            unsigned long long latency_us = 0;
+            long status = 0;
+            if (endpoint && sscanf(line, "%lld %llu %ld", &time_ms, &latency_us, &status) == 3) {
+                push_sample(endpoint, latency_us, status, time_ms);
+            }
+        }
+    }
+    fclose(file);
+
+    for (int i = 0; i < trends->count; i++) refresh_summary(trends, &trends->endpoints[i]);
+    return trends;
+}
+
+int latency_trends_save(const latency_trends_t *trends, const char *path) {
+    if (!trends || !path) return -1;
+
+    // Write a temporary file and rename it, so a crash never leaves half a file
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE *file = fopen(temp_path, "w");
+    if (!file) return -1;
+
+    int ok = fprintf(file, "%s\n", TREND_MAGIC) > 0;
+    for (int e = 0; ok && e < trends->count; e++) {
+        const trend_endpoint_t *endpoint = &trends->endpoints[e];
+        ok = fprintf(file, ENDPOINT_PREFIX "%s\n", endpoint->key) > 0;
+        for (int i = 0; ok && i < endpoint->count; i++) {
+            const trend_sample_t *sample = sample_at(endpoint, i);
+            ok = fprintf(file, "%lld %u %u\n", (long long)sample->time_ms, (unsigned)sample->latency_us,
+                         (unsigned)sample->status) > 0;
+        }
+    }
+    if (fclose(file) != 0 || !ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+void latency_trends_destroy(latency_trends_t *trends) {
+    free(trends);
+}
+
+void latency_trends_record(latency_trends_t *trends, const char *method, const char *url,
+                           uint64_t latency_us, long status, int64_t time_ms) {
+    char key[TREND_KEY_LENGTH];
+    if (!trends || latency_trend_endpoint(method, url, key, sizeof(key)) != 0) return;
+
+    trend_endpoint_t *endpoint = add_endpoint(trends, key);
+    push_sample(endpoint, latency_us, status, time_ms);
+    refresh_summary(trends, endpoint);
+}
+
+const latency_trend_t *latency_trends_find(const latency_trends_t *trends, const char *method, const char *url) {
+    char key[TREND_KEY_LENGTH];
+    if (!trends || latency_trend_endpoint(method, url, key, sizeof(key)) != 0) return NULL;
+
+    int index = find_endpoint(trends, key, hash_key(key));
+    return index >= 0 && trends->endpoints[index].count > 0 ? &trends->endpoints[index].summary : NULL;
+}
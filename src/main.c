@@ -12,6 +12,7 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <stdbool.h>
+#include <unistd.h>
 
 #define GL_SILENCE_DEPRECATION
 #include <OpenGL/gl3.h>
@@ -21,13 +22,19 @@
 #include "nuklear_glfw_gl3.h"
 
 #include "http_client.h"
+#include "http_cache.h"
+#include "http_warmup.h"
 #include "store.h"
+#include "trace.h"
 
 /* ============================================================================
  * CONSTANTS AND CONFIGURATION
  * ============================================================================ */
 
 #define SIDEBAR_WIDTH 300
+#define RESPONSE_ROW_HEIGHT 18
+#define RESPONSE_LINE_MAX 1024    // Longer lines are truncated on screen
+#define RESPONSE_MAX_SPANS 64
 
 /* ============================================================================
  * FORWARD DECLARATIONS
@@ -45,6 +52,8 @@ static void ui_collections_tab(struct nk_context *ctx);
 static void ui_workspace_dropdown(struct nk_context *ctx);
 static void ui_collection_tree(struct nk_context *ctx);
 static void ui_drag_preview(struct nk_context *ctx);
+static void ui_response_search(struct nk_context *ctx);
+static void ui_response_body(struct nk_context *ctx, int height);
 
 // Theme and styling
 static void apply_theme(void);
@@ -179,6 +188,40 @@ static void ui_sidebar(struct nk_context *ctx, int width, int height) {
     nk_end(ctx);
 }
 
+// "12.3 ms" for short latencies, whole ms or seconds for longer ones
+static void format_latency(char *out, size_t size, uint64_t latency_us) {
+    if (latency_us < 10000) {
+        snprintf(out, size, "%.1f ms", (double)latency_us / 1e3);
+    } else if (latency_us < 1000000) {
+        snprintf(out, size, "%.0f ms", (double)latency_us / 1e3);
+    } else {
+        snprintf(out, size, "%.2f s", (double)latency_us / 1e6);
+    }
+}
+
+// One row: the endpoint's latency sparkline, then its p50/p99 badge (red if it regressed)
+static void ui_latency_trend(struct nk_context *ctx, const latency_trend_t *trend) {
+    struct nk_color color = trend->regressed ? nk_rgb(255, 80, 80) : nk_rgb(120, 170, 255);
+    nk_layout_row_dynamic(ctx, 15, 2);
+
+    struct nk_rect bounds;
+    if (nk_widget(&bounds, ctx) != NK_WIDGET_INVALID && trend->point_count > 1) {
+        float points[TREND_SPARKLINE_POINTS * 2];
+        double top = trend->max_ms > 0 ? trend->max_ms : 1;
+        for (int i = 0; i < trend->point_count; i++) {
+            points[2 * i] = bounds.x + (float)trend->points[i].x * bounds.w;
+            points[2 * i + 1] = bounds.y + bounds.h - 1 - (float)(trend->points[i].y / top) * (bounds.h - 2);
+        }
+        nk_stroke_polyline(nk_window_get_canvas(ctx), points, trend->point_count, 1.0f, color);
+    }
+
+    char p50[32], p99[32], badge[80];
+    format_latency(p50, sizeof(p50), trend->p50_us);
+    format_latency(p99, sizeof(p99), trend->p99_us);
+    snprintf(badge, sizeof(badge), "p50 %s  p99 %s", p50, p99);
+    nk_label_colored(ctx, badge, NK_TEXT_RIGHT, trend->regressed ? color : nk_rgb(180, 180, 180));
+}
+
 static void ui_history_tab(struct nk_context *ctx) {
     app_state_t* state = store_get_state();
     
@@ -192,7 +235,8 @@ static void ui_history_tab(struct nk_context *ctx) {
             continue;
         }
         
-        nk_layout_row_dynamic(ctx, 60, 1);
+        const latency_trend_t *trend = store_latency_trend(item->method, item->url);
+        nk_layout_row_dynamic(ctx, trend ? 80 : 60, 1);
         if (nk_group_begin(ctx, item->url, NK_WINDOW_BORDER)) {
             nk_layout_row_dynamic(ctx, 15, 2);
             nk_label(ctx, item->method, NK_TEXT_LEFT);
@@ -217,6 +261,7 @@ static void ui_history_tab(struct nk_context *ctx) {
                 else if (strcmp(item->method, "DELETE") == 0) state->method_selected = 3;
                 else if (strcmp(item->method, "PATCH") == 0) state->method_selected = 4;
             }
+            if (trend) ui_latency_trend(ctx, trend);
             nk_group_end(ctx);
         }
     }
@@ -282,11 +327,26 @@ static void ui_workspace_dropdown(struct nk_context *ctx) {
 	}
 }
 
+// Requests of the active workspace, each with its endpoint's latency trend
 static void ui_collection_tree(struct nk_context *ctx) {
-    // collection_t tree would be implemented here
-    // For now, just a placeholder
-    nk_layout_row_dynamic(ctx, 20, 1);
-    nk_label(ctx, "collection_t tree placeholder...", NK_TEXT_LEFT);
+    app_state_t* state = store_get_state();
+    if (state->workspace_count == 0) return;
+
+    workspace_t* workspace = &state->workspaces[state->active_workspace];
+    for (int c = 0; c < workspace->collection_count; c++) {
+        collection_t* collection = &workspace->collections[c];
+        nk_layout_row_dynamic(ctx, 20, 1);
+        nk_label(ctx, collection->name, NK_TEXT_LEFT);
+
+        for (int r = 0; r < collection->request_count; r++) {
+            request_item_t* request = &collection->requests[r];
+            nk_layout_row_dynamic(ctx, 18, 1);
+            nk_label(ctx, request->name, NK_TEXT_LEFT);
+
+            const latency_trend_t *trend = store_latency_trend(request->method, request->url);
+            if (trend) ui_latency_trend(ctx, trend);
+        }
+    }
 }
 
 static void ui_drag_preview(struct nk_context *ctx) {
@@ -380,26 +440,131 @@ static void ui_settings_page(struct nk_context *ctx, int x, int width, int heigh
     nk_end(ctx);
 }
 
+static void format_bytes(char *out, size_t size, uint64_t bytes) {
+    if (bytes < 1024) {
+        snprintf(out, size, "%llu B", (unsigned long long)bytes);
+    } else if (bytes < 1024 * 1024) {
+        snprintf(out, size, "%.1f KB", (double)bytes / 1024);
+    } else {
+        snprintf(out, size, "%.1f MB", (double)bytes / (1024 * 1024));
+    }
+}
+
+// Status, sizes, redirect hops and the final response's headers, from the header index
+static void format_response_headers(char *out, size_t size, const http_response_t *response) {
+    const http_headers_t *headers = &response->header_fields;
+    static const char *cache_results[] = {"", " (cached)", " (revalidated)"};
+    int length = snprintf(out, size, "Status: %ld%s\n", response->status_code,
+                          cache_results[response->cache_result]);
+
+    // Decoded size, and the transferred size when the body was compressed
+    char decoded[32], wire[32];
+    format_bytes(decoded, sizeof(decoded), response->body_size);
+    size_t encoding_length = 0;
+    const char *encoding = http_headers_get(headers, "Content-Encoding", &encoding_length);
+    if (encoding && response->wire_size > 0 && length < (int)size) {
+        format_bytes(wire, sizeof(wire), response->wire_size);
+        length += snprintf(out + length, size - (size_t)length, "Size: %s (%s %.*s, %.1fx)\n",
+                           decoded, wire, (int)encoding_length, encoding,
+                           (double)response->body_size / (double)response->wire_size);
+    } else if (length < (int)size) {
+        length += snprintf(out + length, size - (size_t)length, "Size: %s\n", decoded);
+    }
+
+    for (int i = 0; i + 1 < headers->block_count && length < (int)size; i++) {
+        const http_header_block_t *block = &headers->blocks[i];
+        length += snprintf(out + length, size - (size_t)length, "Via: %.*s\n",
+                           (int)block->line_length, headers->text + block->line_offset);
+    }
+
+    const http_header_block_t *final = http_headers_final(headers);
+    if (length < (int)size) {
+        length += snprintf(out + length, size - (size_t)length, "\n--- Headers ---\n%s",
+                           final ? "" : "No headers");
+    }
+    for (int i = 0; final && i < final->count && length < (int)size; i++) {
+        const http_header_t *header = &headers->items[final->first + i];
+        length += snprintf(out + length, size - (size_t)length, "%.*s: %.*s\n",
+                           (int)header->name_length, headers->text + header->name_offset,
+                           (int)header->value_length, headers->text + header->value_offset);
+    }
+}
+
+// Span of the running SEND, from the click to the response being shown
+static uint64_t send_trace_ns;
+
+// Show a finished SEND's response (NULL if it could not be sent) and record it in history
+// with the time it took
+static void show_response(app_state_t *state, const char *method_name, http_response_t *response,
+                          uint64_t latency_us) {
+    // The search borrows the old body, so it goes first
+    response_search_destroy(state->response_search);
+    state->response_search = NULL;
+    state->response_search_current = -1;
+    response_view_destroy(state->response_view);
+    state->response_view = NULL;
+
+    if (response && response->error_message && strcmp(response->error_message, "Cancelled") == 0) {
+        snprintf(state->response, sizeof(state->response), "Request cancelled.");
+        state->last_status_code = 0;
+    } else if (response) {
+        // Captures read the body, so they run before it is handed to the viewer
+        store_apply_captures(response);
+
+        state->last_status_code = response->status_code;
+        format_response_headers(state->response, sizeof(state->response), response);
+
+        // Hand the body to the viewer, which formats it on a worker thread
+        state->response_view = response_view_create(response->body, response->body_size);
+        response->body = NULL;
+
+        store_add_to_history(method_name, state->request_url, response->status_code, latency_us);
+    } else {
+        strncpy(state->response, "Request failed!", sizeof(state->response));
+        state->last_status_code = 0;
+
+        // Add failed request to history
+        store_add_to_history(method_name, state->request_url, 0, latency_us);
+    }
+    http_response_free(response);
+    trace_end("send", "ui", send_trace_ns);
+}
+
 static void ui_main_panel(struct nk_context *ctx, http_client_t *client, int x, int width, int height) {
     app_state_t* state = store_get_state();
     
     if (nk_begin(ctx, "API Kit", nk_rect(x, 0, width, height), NK_WINDOW_NO_SCROLLBAR)) {
         // Method dropdown, URL input, and Send button in same row with fixed sizes
         static const char *methods[] = {"GET", "POST", "PUT", "DELETE", "PATCH"};
-        nk_layout_row_begin(ctx, NK_STATIC, 40, 3);
+        nk_layout_row_begin(ctx, NK_STATIC, 40, 4);
         nk_layout_row_push(ctx, 100);  // Fixed 100px for dropdown
         state->method_selected = nk_combo(ctx, methods, 5, state->method_selected, 25, nk_vec2(120, 200));
-        nk_layout_row_push(ctx, width - 180);  // Remaining space minus button and dropdown
+        nk_layout_row_push(ctx, width - 320);  // Remaining space minus button and dropdowns
         nk_edit_string_zero_terminated(ctx,
                                        NK_EDIT_FIELD,
                                        state->url, 
                                        sizeof(state->url),
                                        nk_filter_default);
 
+        // Environment dropdown; entry 0 is "no environment" (shared variables only)
+        const char *environment_names[MAX_ENVIRONMENTS + 1];
+        environment_names[0] = "No environment";
+        for (int i = 0; i < state->environments.count; i++) {
+            environment_names[i + 1] = state->environments.items[i].name;
+        }
+        nk_layout_row_push(ctx, 140);
+        int environment_selected = nk_combo(ctx, environment_names, state->environments.count + 1,
+                                            state->active_environment + 1, 25, nk_vec2(160, 200));
+        if (environment_selected != state->active_environment + 1) {
+            store_select_environment(environment_selected - 1);
+        }
+
         nk_layout_row_push(ctx, 80);
-        if (nk_button_label(ctx, "SEND") && !state->request_in_progress) {
-            state->request_in_progress = 1;
-            
+        if (state->request_in_progress) {
+            if (nk_button_label(ctx, "CANCEL")) {
+                http_task_cancel(state->request_task);
+            }
+        } else if (nk_button_label(ctx, "SEND")) {
             // Convert method selection to enum
             http_method_t method = HTTP_METHOD_GET;
             switch (state->method_selected) {
@@ -409,68 +574,50 @@ static void ui_main_panel(struct nk_context *ctx, http_client_t *client, int x,
                 case 3: method = HTTP_METHOD_DELETE; break;
                 case 4: method = HTTP_METHOD_PATCH; break;
             }
-            
-            // Parse headers (simple implementation)
-            const char *headers[10] = {NULL}; // Max 10 headers
-            int header_count = 0;
-            char headers_copy[1024];
-            strncpy(headers_copy, state->headers, sizeof(headers_copy));
-            
-            char *line = strtok(headers_copy, "\n");
-            while (line && header_count < 9) {
-                if (strlen(line) > 0) {
-                    headers[header_count++] = line;
-                }
-                line = strtok(NULL, "\n");
-            }
-            
-            // Prepare request options
-            http_request_options_t options = {
-                .headers = headers,
-                .timeout_ms = 10000,
-                .content_type = "application/json"
-            };
-            
-            // Add body for POST/PUT/PATCH
-            if (method != HTTP_METHOD_GET && method != HTTP_METHOD_DELETE) {
-                if (strlen(state->body) > 0) {
-                    options.body = state->body;
-                }
-            }
-            
-            // Make HTTP request
-            http_response_t* response = http_request(client, method, state->url, &options);
-            
-            if (response) {
-                state->last_status_code = response->status_code;
-                snprintf(state->response, sizeof(state->response),
-                         "Status: %ld\n\n--- Headers ---\n%s\n--- Body ---\n%s", 
-                         response->status_code,
-                         response->headers ? response->headers : "No headers",
-                         response->body ? response->body : "No response body");
-                
-                // Add to history
-                const char* method_name = methods[state->method_selected];
-                store_add_to_history(method_name, state->url, response->status_code);
-                
-                http_response_free(response);
+
+            // Templates are parsed once per edit; {{variables}} are rendered on every send.
+            // The request is not recompiled until the task is finished.
+            compiled_request_t* request = store_compiled_request(method);
+            send_trace_ns = trace_begin();
+            memcpy(state->request_url, state->url, sizeof(state->request_url));
+            state->request_task = request ? http_task_start(client, request) : NULL;
+            if (state->request_task) {
+                state->request_in_progress = 1;
             } else {
-                strncpy(state->response, "Request failed!", sizeof(state->response));
-                state->last_status_code = 0;
-                
-                // Add failed request to history
-                const char* method_name = methods[state->method_selected];
-                store_add_to_history(method_name, state->url, 0);
+                show_response(state, http_method_name(method), NULL, 0);
             }
-            
-            state->request_in_progress = 0;
         }
         nk_layout_row_end(ctx);
-        
+
+        // Deliver the response once the worker has it
+        if (state->request_in_progress && http_task_is_done(state->request_task)) {
+            uint64_t latency_us = http_task_progress(state->request_task).elapsed_ns / 1000;
+            http_response_t* response = http_task_finish(state->request_task);
+            state->request_task = NULL;
+            state->request_in_progress = 0;
+            show_response(state, http_method_name(state->compiled_request->method), response, latency_us);
+        }
+
         // Status indicator
         if (state->request_in_progress) {
-            nk_layout_row_static(ctx, 20, 200, 1);
-            nk_label_colored(ctx, "Sending request...", NK_TEXT_LEFT, nk_rgb(255, 165, 0));
+            http_task_progress_t progress = http_task_progress(state->request_task);
+            char received[32], total[32], rate[32];
+            format_bytes(received, sizeof(received), progress.downloaded);
+            format_bytes(rate, sizeof(rate), (uint64_t)progress.bytes_per_second);
+            char status_text[128];
+            if (progress.download_total > 0) {
+                format_bytes(total, sizeof(total), progress.download_total);
+                snprintf(status_text, sizeof(status_text), "Receiving... %s of %s (%s/s), %.1f s",
+                         received, total, rate, (double)progress.elapsed_ns / 1e9);
+            } else if (progress.downloaded > 0) {
+                snprintf(status_text, sizeof(status_text), "Receiving... %s (%s/s), %.1f s",
+                         received, rate, (double)progress.elapsed_ns / 1e9);
+            } else {
+                snprintf(status_text, sizeof(status_text), "Sending request... %.1f s",
+                         (double)progress.elapsed_ns / 1e9);
+            }
+            nk_layout_row_static(ctx, 20, 600, 1);
+            nk_label_colored(ctx, status_text, NK_TEXT_LEFT, nk_rgb(255, 165, 0));
         } else if (state->last_status_code > 0) {
             nk_layout_row_static(ctx, 20, 300, 1);
             char status_text[100];
@@ -503,14 +650,164 @@ static void ui_main_panel(struct nk_context *ctx, http_client_t *client, int x,
         // Response section
         nk_layout_row_static(ctx, 20, 100, 1);
         nk_label(ctx, "Response:", NK_TEXT_LEFT);
-        nk_layout_row_dynamic(ctx, 200, 1);
-        nk_edit_string_zero_terminated(ctx, NK_EDIT_BOX | NK_EDIT_READ_ONLY, 
-                                       state->response, 
+        nk_layout_row_dynamic(ctx, state->response_view ? 100 : 200, 1);
+        nk_edit_string_zero_terminated(ctx, NK_EDIT_BOX | NK_EDIT_READ_ONLY,
+                                       state->response,
                                        sizeof(state->response), nk_filter_default);
+        ui_response_search(ctx);
+        ui_response_body(ctx, 240);
     }
     nk_end(ctx);
 }
 
+static struct nk_color response_span_color(struct nk_context *ctx, json_span_kind_t kind) {
+    switch (kind) {
+        case JSON_SPAN_KEY:     return nk_rgb(156, 220, 254);
+        case JSON_SPAN_STRING:  return nk_rgb(206, 145, 120);
+        case JSON_SPAN_NUMBER:  return nk_rgb(181, 206, 168);
+        case JSON_SPAN_LITERAL: return nk_rgb(86, 156, 214);
+        case JSON_SPAN_PUNCT:   return nk_rgb(212, 212, 212);
+        default:                return ctx->style.text.color;
+    }
+}
+
+static void ui_response_line(struct nk_context *ctx, const response_view_t *view, size_t index, int focused) {
+    char text[RESPONSE_LINE_MAX];
+    json_span_t spans[RESPONSE_MAX_SPANS];
+    int span_count = 0;
+
+    int len = response_view_render_line(view, index, text, sizeof(text), spans, RESPONSE_MAX_SPANS, &span_count);
+    if (len < 0) return;
+
+    struct nk_color focus_color = nk_rgb(255, 230, 0);
+    if (span_count == 0) {
+        nk_layout_row_dynamic(ctx, RESPONSE_ROW_HEIGHT, 1);
+        nk_text_colored(ctx, text, len, NK_TEXT_LEFT, focused ? focus_color : ctx->style.text.color);
+        return;
+    }
+
+    // One static cell per highlight span, sized to its text
+    const struct nk_user_font *font = ctx->style.font;
+    nk_layout_row_begin(ctx, NK_STATIC, RESPONSE_ROW_HEIGHT, span_count);
+    for (int i = 0; i < span_count; i++) {
+        const char *span_text = text + spans[i].start;
+        float span_width = font->width(font->userdata, font->height, span_text, spans[i].length);
+        nk_layout_row_push(ctx, span_width + ctx->style.text.padding.x * 2);
+        nk_text_colored(ctx, span_text, spans[i].length, NK_TEXT_LEFT,
+                        focused ? focus_color : response_span_color(ctx, spans[i].kind));
+    }
+    nk_layout_row_end(ctx);
+}
+
+static void ui_response_search(struct nk_context *ctx) {
+    app_state_t* state = store_get_state();
+    if (!state->response_view) return;
+
+    static const char *modes[] = {"Text", "Ignore case", "Regex"};
+    nk_layout_row_begin(ctx, NK_STATIC, 30, 5);
+    nk_layout_row_push(ctx, 250);
+    nk_flags edit_state = nk_edit_string_zero_terminated(ctx, NK_EDIT_FIELD | NK_EDIT_SIG_ENTER,
+                                                         state->response_search_text,
+                                                         sizeof(state->response_search_text),
+                                                         nk_filter_default);
+    nk_layout_row_push(ctx, 160);
+    state->response_search_mode = nk_combo(ctx, modes, 3, state->response_search_mode, 25, nk_vec2(180, 120));
+    nk_layout_row_push(ctx, 70);
+    int find = nk_button_label(ctx, "Find") || (edit_state & NK_EDIT_COMMITED);
+    nk_layout_row_push(ctx, 40);
+    int prev = nk_button_label(ctx, "<");
+    nk_layout_row_push(ctx, 40);
+    int next = nk_button_label(ctx, ">");
+    nk_layout_row_end(ctx);
+
+    if (find) {
+        size_t body_size = 0;
+        const char *body = response_view_body(state->response_view, &body_size);
+        response_search_destroy(state->response_search);
+        state->response_search = response_search_start(body, body_size, state->response_search_text,
+                                                       (search_mode_t)state->response_search_mode);
+        state->response_search_current = -1;
+        state->response_search_scroll = 1;  // Jump to the first match as soon as it arrives
+    }
+
+    response_search_t *search = state->response_search;
+    if (!search) return;
+
+    // Navigation only walks the collected matches; nothing is rescanned
+    size_t count = response_search_match_count(search);
+    if (state->response_search_current < 0 && state->response_search_scroll && count > 0) {
+        state->response_search_current = 0;
+    }
+    if (next && count > 0) {
+        if ((size_t)(state->response_search_current + 1) < count) {
+            state->response_search_current++;
+        } else if (response_search_is_complete(search)) {
+            state->response_search_current = 0;
+        }
+        state->response_search_scroll = 1;
+    }
+    if (prev && count > 0) {
+        if (state->response_search_current > 0) {
+            state->response_search_current--;
+        } else if (response_search_is_complete(search)) {
+            state->response_search_current = (long)count - 1;
+        }
+        state->response_search_scroll = 1;
+    }
+
+    char status[128];
+    const char *error = response_search_error(search);
+    if (error) {
+        snprintf(status, sizeof(status), "Invalid pattern: %s", error);
+    } else if (count == 0) {
+        snprintf(status, sizeof(status), response_search_is_complete(search) ? "No matches" : "Searching...");
+    } else {
+        snprintf(status, sizeof(status), "Match %ld of %zu%s", state->response_search_current + 1, count,
+                 response_search_is_complete(search) ? "" : "+");
+    }
+    nk_layout_row_static(ctx, 20, 400, 1);
+    nk_label(ctx, status, NK_TEXT_LEFT);
+}
+
+static void ui_response_body(struct nk_context *ctx, int height) {
+    app_state_t* state = store_get_state();
+    const response_view_t *view = state->response_view;
+    if (!view) return;
+
+    // Line holding the focused search match
+    long focused_line = -1;
+    search_match_t match;
+    if (state->response_search_current >= 0 &&
+        response_search_get(state->response_search, (size_t)state->response_search_current, &match) == 0) {
+        focused_line = response_view_line_for_offset(view, match.offset);
+    }
+    if (state->response_search_scroll && focused_line >= 0) {
+        int row_height = RESPONSE_ROW_HEIGHT + (int)ctx->style.window.spacing.y;
+        long first_row = focused_line > 3 ? focused_line - 3 : 0;
+        nk_group_set_scroll(ctx, "response_body", 0, (nk_uint)(first_row * row_height));
+        state->response_search_scroll = 0;
+    }
+
+    // Only the visible rows are rendered; the worker keeps indexing meanwhile
+    size_t line_count = response_view_line_count(view);
+    nk_layout_row_dynamic(ctx, height, 1);
+    struct nk_list_view list;
+    if (nk_list_view_begin(ctx, &list, "response_body", NK_WINDOW_BORDER,
+                           RESPONSE_ROW_HEIGHT, (int)line_count)) {
+        for (int i = list.begin; i < list.end; i++) {
+            ui_response_line(ctx, view, (size_t)i, i == focused_line);
+        }
+        nk_list_view_end(&list);
+    }
+
+    if (!response_view_is_complete(view)) {
+        char progress[64];
+        snprintf(progress, sizeof(progress), "Formatting... %zu lines", line_count);
+        nk_layout_row_static(ctx, 20, 300, 1);
+        nk_label_colored(ctx, progress, NK_TEXT_LEFT, nk_rgb(255, 165, 0));
+    }
+}
+
 // Root UI function that orchestrates all components
 static void draw_ui(struct nk_context *ctx, http_client_t *client) {
     app_state_t* state = store_get_state();
@@ -557,23 +854,72 @@ static void draw_ui(struct nk_context *ctx, http_client_t *client) {
  * MAIN FUNCTION AND INITIALIZATION
  * ============================================================================ */
 
+// DNS lookups and TLS sessions for the active workspace's hosts, made when it is selected
+static http_warmup_t *warmup;
+static int warmed_workspace = -1;
+
+static void update_warmup(http_client_t *client) {
+    app_state_t *state = store_get_state();
+    if (warmup && http_warmup_is_done(warmup)) {
+        http_warmup_finish(warmup);
+        warmup = NULL;
+    }
+    if (warmup || state->workspace_count == 0 || state->active_workspace == warmed_workspace) return;
+
+    compiled_request_t *requests[MAX_COLLECTIONS_PER_WORKSPACE * MAX_REQUESTS_PER_COLLECTION];
+    int count = store_workspace_requests(requests, MAX_COLLECTIONS_PER_WORKSPACE * MAX_REQUESTS_PER_COLLECTION);
+    warmup = http_warmup_start(client, (const compiled_request_t *const *)requests, count, 1);
+    for (int i = 0; i < count; i++) {
+        compiled_request_destroy(requests[i]);
+    }
+    warmed_workspace = state->active_workspace;
+}
+
 int main() {
     // Load settings first
     store_load_settings();
+
+    // Tracing: APIKIT_TRACE overrides [debug] trace_file
+    trace_set_thread_name("main");
+    const char *trace_file = getenv("APIKIT_TRACE");
+    if (!trace_file || trace_file[0] == '\0') {
+        trace_file = store_get_state()->settings.trace_path;
+    }
+    if (trace_file[0] != '\0' && trace_start(trace_file) == 0) {
+        printf("Tracing to %s (kill -USR1 %d to write it now)\n", trace_file, (int)getpid());
+    }
     
     // Load saved data
     store_load_data();
+    store_load_environments();
     
-    http_client_t *client = http_client_create();
+    // DNS results, Alt-Svc and HSTS carry over between launches in <data folder>/network
+    char network_dir[600];
+    snprintf(network_dir, sizeof(network_dir), "%s/network", store_get_state()->settings.data_folder_path);
+    store_ensure_data_directory();
+    mkdir(network_dir, 0755);
+    http_client_options_t client_options = { .state_dir = network_dir };
+    http_client_t *client = http_client_create_ex(&client_options);
     if (!client) {
         printf("Failed to create HTTP client\n");
         return -1;
     }
+
+    // Repeated GETs are answered or revalidated from <data folder>/cache
+    http_cache_t *cache = NULL;
+    const settings_t *settings = &store_get_state()->settings;
+    if (settings->cache_enabled) {
+        char cache_dir[600];
+        snprintf(cache_dir, sizeof(cache_dir), "%s/cache", settings->data_folder_path);
+        cache = http_cache_create((size_t)settings->cache_memory_mb << 20, cache_dir);
+        http_client_set_cache(client, cache);
+    }
     
     // Initialize GLFW
     if (!glfwInit()) {
         printf("Failed to initialize GLFW\n");
         http_client_destroy(client);
+        http_cache_destroy(cache);
         return -1;
     }
 
@@ -591,6 +937,7 @@ int main() {
         printf("Failed to create GLFW window\n");
         glfwTerminate();
         http_client_destroy(client);
+        http_cache_destroy(cache);
         return -1;
     }
 
@@ -605,6 +952,7 @@ int main() {
         glfwDestroyWindow(window);
         glfwTerminate();
         http_client_destroy(client);
+        http_cache_destroy(cache);
         return -1;
     }
 
@@ -619,10 +967,15 @@ int main() {
 
     // Main loop
     while (!glfwWindowShouldClose(window)) {
+        uint64_t trace_frame_ns = trace_begin();
         glfwPollEvents();
         nk_glfw3_new_frame(&glfw);
         
+        update_warmup(client);
+
+        uint64_t trace_ui_ns = trace_begin();
         draw_ui(ctx, client);
+        trace_end("draw_ui", "frame", trace_ui_ns);
         
         int width = 0;
         int height = 0;
@@ -632,16 +985,39 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT);
         glClearColor(0.10F, 0.18F, 0.24F, 1.0F);
         
+        uint64_t trace_render_ns = trace_begin();
         nk_glfw3_render(&glfw, NK_ANTI_ALIASING_ON, 512 * 1024, 128 * 1024);
+        trace_end("render", "frame", trace_render_ns);
+
+        uint64_t trace_swap_ns = trace_begin();
         glfwSwapBuffers(window);
+        trace_end("swap_buffers", "frame", trace_swap_ns);
+        trace_end("frame", "frame", trace_frame_ns);
+    }
+
+    http_warmup_finish(warmup);
+    warmup = NULL;
+
+    // A SEND still running is abandoned
+    if (store_get_state()->request_task) {
+        http_task_cancel(store_get_state()->request_task);
+        http_response_free(http_task_finish(store_get_state()->request_task));
+        store_get_state()->request_task = NULL;
     }
 
     store_save_data();
-    
+
     // Cleanup
+    response_search_destroy(store_get_state()->response_search);
+    store_get_state()->response_search = NULL;
+    response_view_destroy(store_get_state()->response_view);
+    store_get_state()->response_view = NULL;
+    store_free_request_cache();
     nk_glfw3_shutdown(&glfw);
     glfwDestroyWindow(window);
     glfwTerminate();
     http_client_destroy(client);
+    http_cache_destroy(cache);
+    trace_stop();
     return 0;
 }
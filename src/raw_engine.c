@@ -0,0 +1,1124 @@
+/* ============================================================================
+ * API Kit - Raw HTTP/1.1 Load Engine Implementation
+ *
+ * Workers share only the serialized requests, the target address and an
+ * atomic counter they claim requests from in batches, so a run with a
+ * request limit needs no locks. A connection's in-flight requests are a
+ * ring of request indexes, oldest first; the unwritten tail of the ring is
+ * also queued as iovecs pointing straight into the serialized bytes, and
+ * is written with one gather call whenever the socket is writable. When
+ * the server announces it is closing, the requests still in flight are
+ * sent again on a new connection.
+ * ============================================================================ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // pthread_attr_setaffinity_np, CPU_* macros
+#endif
+
+#include "raw_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define RAW_MAX_EVENTS 256
+#define RAW_READ_BUFFER (64 * 1024)
+#define RAW_CLAIM_BATCH 64              // Requests claimed from the shared counter at once
+#define RAW_MAX_IOV 64                  // iovecs per gather write
+#define RAW_WAIT_MS 100                 // Longest epoll wait, bounds deadline and timeout checks
+
+enum {
+    PARSE_STATUS_LINE,
+    PARSE_HEADER_LINE,
+    PARSE_BODY,
+    PARSE_CHUNK_SIZE,
+    PARSE_CHUNK_DATA,
+    PARSE_CHUNK_END,
+    PARSE_TRAILER,
+    PARSE_UNTIL_CLOSE
+};
+
+/* ============================================================================
+ * SERIALIZATION
+ * ============================================================================ */
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} raw_buffer_t;
+
+static int buffer_append(raw_buffer_t *buffer, const char *data, size_t length) {
+    if (buffer->length + length + 1 > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 256;
+        while (buffer->length + length + 1 > capacity) capacity *= 2;
+        char *grown = realloc(buffer->data, capacity);
+        if (!grown) return -1;
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    return 0;
+}
+
+static int buffer_append_string(raw_buffer_t *buffer, const char *text) {
+    return buffer_append(buffer, text, strlen(text));
+}
+
+static int header_is(const char *entry, const char *name) {
+    size_t length = strlen(name);
+    return strncasecmp(entry, name, length) == 0 && entry[length] == ':';
+}
+
+char *raw_request_serialize(const compiled_request_t *request, size_t *size) {
+    if (!request || !request->url) return NULL;
+
+    CURLU *url = curl_url();
+    char *scheme = NULL, *host = NULL, *port = NULL, *path = NULL, *query = NULL;
+    raw_buffer_t out = {0};
+    int ok = 0;
+
+    if (!url || curl_url_set(url, CURLUPART_URL, request->url, CURLU_GUESS_SCHEME) != CURLUE_OK ||
+        curl_url_get(url, CURLUPART_SCHEME, &scheme, 0) != CURLUE_OK || strcmp(scheme, "http") != 0 ||
+        curl_url_get(url, CURLUPART_HOST, &host, 0) != CURLUE_OK ||
+        curl_url_get(url, CURLUPART_PATH, &path, 0) != CURLUE_OK) {
+        goto done;
+    }
+    curl_url_get(url, CURLUPART_PORT, &port, 0);     // Absent for the default port
+    curl_url_get(url, CURLUPART_QUERY, &query, 0);
+
+    int has_host = 0, has_length = 0;
+    for (const struct curl_slist *h = request->headers; h; h = h->next) {
+        has_host |= header_is(h->data, "Host");
+        has_length |= header_is(h->data, "Content-Length");
+    }
+
+    if (buffer_append_string(&out, request->method_name) != 0 ||
+        buffer_append(&out, " ", 1) != 0 ||
+        buffer_append_string(&out, path[0] ? path : "/") != 0 ||
+        (query && (buffer_append(&out, "?", 1) != 0 || buffer_append_string(&out, query) != 0)) ||
+        buffer_append_string(&out, " HTTP/1.1\r\n") != 0) {
+        goto done;
+    }
+    if (!has_host &&
+        (buffer_append_string(&out, "Host: ") != 0 || buffer_append_string(&out, host) != 0 ||
+         (port && (buffer_append(&out, ":", 1) != 0 || buffer_append_string(&out, port) != 0)) ||
+         buffer_append(&out, "\r\n", 2) != 0)) {
+        goto done;
+    }
+
+    // Same header list libcurl gets: "Name;" sends an empty value, "Name:" sends nothing
+    for (const struct curl_slist *h = request->headers; h; h = h->next) {
+        const char *entry = h->data;
+        size_t length = strlen(entry);
+        const char *colon = strchr(entry, ':');
+        if (colon) {
+            const char *value = colon + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            if (*value == '\0') continue;
+            if (buffer_append(&out, entry, length) != 0) goto done;
+        } else if (length > 0 && entry[length - 1] == ';') {
+            if (buffer_append(&out, entry, length - 1) != 0 || buffer_append(&out, ":", 1) != 0) goto done;
+        } else {
+            continue;
+        }
+        if (buffer_append(&out, "\r\n", 2) != 0) goto done;
+    }
+
+    if (request->body && !has_length) {
+        char field[48];
+        snprintf(field, sizeof(field), "Content-Length: %zu\r\n", request->body_size);
+        if (buffer_append_string(&out, field) != 0) goto done;
+    }
+    if (buffer_append(&out, "\r\n", 2) != 0) goto done;
+    if (request->body && buffer_append(&out, request->body, request->body_size) != 0) goto done;
+    ok = 1;
+
+done:
+    curl_free(scheme);
+    curl_free(host);
+    curl_free(port);
+    curl_free(path);
+    curl_free(query);
+    curl_url_cleanup(url);
+    if (!ok) {
+        free(out.data);
+        return NULL;
+    }
+    if (size) *size = out.length;
+    return out.data;
+}
+
+/* ============================================================================
+ * RESPONSE PARSER
+ * ============================================================================ */
+
+// Case-insensitive search for a token in a header value
+static int value_has(const char *value, const char *token) {
+    size_t length = strlen(token);
+    for (; *value; value++) {
+        if (strncasecmp(value, token, length) == 0) return 1;
+    }
+    return 0;
+}
+
+// Collect a line into parser->line (truncated to RAW_LINE_MAX - 1 bytes)
+// Returns its length once complete, or -1 if all of data was taken and it is not
+static long read_line(raw_parser_t *parser, const char *data, size_t size, size_t *used) {
+    const char *newline = memchr(data, '\n', size);
+    size_t take = newline ? (size_t)(newline - data) : size;
+    size_t room = RAW_LINE_MAX - 1 - parser->line_length;
+    size_t copy = take < room ? take : room;
+    memcpy(parser->line + parser->line_length, data, copy);
+    parser->line_length += copy;
+    *used = newline ? take + 1 : size;
+    if (!newline) return -1;
+
+    size_t length = parser->line_length;
+    if (length > 0 && parser->line[length - 1] == '\r') length--;
+    parser->line[length] = '\0';
+    parser->line_length = 0;
+    return (long)length;
+}
+
+static void end_response(raw_parser_t *parser) {
+    parser->complete = 1;
+    parser->state = PARSE_STATUS_LINE;
+}
+
+static int parse_status_line(raw_parser_t *parser) {
+    const char *line = parser->line;
+    if (strncmp(line, "HTTP/1.", 7) != 0 || !isdigit((unsigned char)line[7]) || line[8] != ' ' ||
+        !isdigit((unsigned char)line[9]) || !isdigit((unsigned char)line[10]) ||
+        !isdigit((unsigned char)line[11])) {
+        return -1;
+    }
+    parser->status = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+    parser->keep_alive = line[7] != '0';    // HTTP/1.0 closes unless told otherwise
+    parser->chunked = 0;
+    parser->has_length = 0;
+    parser->remaining = 0;
+    parser->state = PARSE_HEADER_LINE;
+    return 0;
+}
+
+static int parse_header_line(raw_parser_t *parser, long length) {
+    const char *line = parser->line;
+    if (length > 0) {
+        const char *colon = strchr(line, ':');
+        if (!colon) return -1;
+        const char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') value++;
+
+        if (header_is(line, "Content-Length")) {
+            char *end;
+            if (!isdigit((unsigned char)*value)) return -1;
+            parser->remaining = strtoull(value, &end, 10);
+            parser->has_length = 1;
+        } else if (header_is(line, "Transfer-Encoding")) {
+            parser->chunked = value_has(value, "chunked");
+        } else if (header_is(line, "Connection")) {
+            if (value_has(value, "close")) parser->keep_alive = 0;
+            else if (value_has(value, "keep-alive")) parser->keep_alive = 1;
+        }
+        return 0;
+    }
+
+    // End of the header block
+    if (parser->status < 200) {
+        if (parser->status == 101) return -1;   // Protocol switch: not HTTP any more
+        parser->state = PARSE_STATUS_LINE;      // Interim response, the real one follows
+    } else if (parser->status == 204 || parser->status == 304) {
+        end_response(parser);
+    } else if (parser->chunked) {
+        parser->state = PARSE_CHUNK_SIZE;
+    } else if (parser->has_length) {
+        if (parser->remaining == 0) end_response(parser);
+        else parser->state = PARSE_BODY;
+    } else {
+        parser->keep_alive = 0;
+        parser->state = PARSE_UNTIL_CLOSE;
+    }
+    return 0;
+}
+
+void raw_parser_init(raw_parser_t *parser) {
+    memset(parser, 0, sizeof(*parser));
+    parser->state = PARSE_STATUS_LINE;
+    parser->keep_alive = 1;
+}
+
+long raw_parser_feed(raw_parser_t *parser, const char *data, size_t size) {
+    size_t used = 0;
+    parser->complete = 0;
+
+    while (used < size && !parser->complete) {
+        if (parser->state == PARSE_BODY || parser->state == PARSE_CHUNK_DATA) {
+            size_t available = size - used;
+            size_t skip = parser->remaining < available ? (size_t)parser->remaining : available;
+            used += skip;
+            parser->remaining -= skip;
+            if (parser->remaining == 0) {
+                if (parser->state == PARSE_BODY) end_response(parser);
+                else parser->state = PARSE_CHUNK_END;
+            }
+            continue;
+        }
+        if (parser->state == PARSE_UNTIL_CLOSE) {
+            used = size;
+            continue;
+        }
+
+        size_t taken;
+        long length = read_line(parser, data + used, size - used, &taken);
+        used += taken;
+        if (length < 0) continue;
+
+        switch (parser->state) {
+        case PARSE_STATUS_LINE:
+            if (length == 0) break;                 // Stray CRLF between responses
+            if (parse_status_line(parser) != 0) return -1;
+            break;
+        case PARSE_HEADER_LINE:
+            if (parse_header_line(parser, length) != 0) return -1;
+            break;
+        case PARSE_CHUNK_SIZE: {
+            char *end;
+            if (!isxdigit((unsigned char)parser->line[0])) return -1;
+            parser->remaining = strtoull(parser->line, &end, 16);
+            parser->state = parser->remaining == 0 ? PARSE_TRAILER : PARSE_CHUNK_DATA;
+            break;
+        }
+        case PARSE_CHUNK_END:
+            if (length != 0) return -1;
+            parser->state = PARSE_CHUNK_SIZE;
+            break;
+        case PARSE_TRAILER:
+            if (length == 0) end_response(parser);
+            break;
+        }
+    }
+    return (long)used;
+}
+
+int raw_parser_finish(raw_parser_t *parser) {
+    if (parser->state == PARSE_UNTIL_CLOSE) {
+        end_response(parser);
+        return 1;
+    }
+    if (parser->state == PARSE_STATUS_LINE && parser->line_length == 0) return 0;
+    return -1;
+}
+
+/* ============================================================================
+ * LATENCY HISTOGRAM
+ * ============================================================================ */
+
+// The stats' buckets as a histogram; the counts stay where they are
+static void latency_histogram(hdr_histogram_t *histogram, const raw_load_stats_t *stats) {
+    hdr_histogram_init(histogram, RAW_LATENCY_PRECISION, RAW_LATENCY_RANGE, (uint64_t *)stats->latency);
+}
+
+uint64_t raw_latency_percentile(const raw_load_stats_t *stats, double percentile) {
+    hdr_histogram_t histogram;
+    latency_histogram(&histogram, stats);
+    return hdr_histogram_percentile(&histogram, percentile);
+}
+
+/* ============================================================================
+ * LOAD RUN
+ * ============================================================================ */
+
+#ifdef __linux__
+
+enum {
+    CONN_CLOSED,
+    CONN_CONNECTING,
+    CONN_OPEN
+};
+
+typedef struct {
+    struct sockaddr_storage address;
+    socklen_t address_length;
+} raw_target_t;
+
+typedef struct raw_load raw_load_t;
+
+typedef struct {
+    int fd;
+    int state;
+    uint32_t index;             // Position in the worker's connections
+    uint32_t generation;        // Bumped per socket, so stale events can be told apart
+    int want_write;             // EPOLLOUT registered
+    uint64_t answered;          // Responses since the connection was opened
+    uint64_t progress_ns;       // Last connect or read
+    raw_parser_t parser;
+
+    int *inflight;              // Ring of request indexes, pipeline entries
+    uint64_t *queued_ns;        // When each request in the ring was queued
+    int inflight_head, inflight_count;
+    struct iovec *iov;          // Unwritten tail of the ring
+    int iov_start, iov_count;
+} raw_conn_t;
+
+typedef struct {
+    raw_load_t *load;
+    pthread_t thread;
+    int started;
+    int epoll_fd;
+    int cpu;                    // CPU to pin the thread to, -1 = any
+
+    raw_conn_t *conns;
+    int conn_count;
+    int live;                   // Connections not given up or finished
+    int inflight;               // Requests in flight on all connections
+
+    int next_request;
+    uint64_t quota;             // Requests claimed, not yet queued
+    int exhausted;              // Nothing left to claim
+    char *buffer;
+
+    raw_load_stats_t *stats;    // Slot the worker alone writes (see add)
+    hdr_histogram_t latency;    // Over stats->latency
+} raw_worker_t;
+
+struct raw_load {
+    char **bytes;
+    size_t *sizes;
+    int count;
+    int pipeline;
+    raw_target_t target;
+    uint64_t limit;             // Requests to send (0 = until the deadline)
+    uint64_t claimed;           // Atomic, unless claim points elsewhere
+    uint64_t *claim;            // Counter requests are claimed from (&claimed or shared memory)
+    uint64_t deadline_ns;       // 0 = none
+    uint64_t timeout_ns;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Counters have one writer and may be read from elsewhere while the run
+// goes on: plain load and store, but atomic so neither is torn
+static void add(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+// The "# @resolve" address for host:port, if the request has one
+static const char *connect_to_address(const compiled_request_t *request, const char *host,
+                                      const char *port, char *address, size_t size) {
+    char prefix[320];
+    int prefix_length = snprintf(prefix, sizeof(prefix), "%s:%s:", host, port);
+    if (prefix_length < 0 || (size_t)prefix_length >= sizeof(prefix)) return NULL;
+
+    for (const struct curl_slist *entry = request->connect_to; entry; entry = entry->next) {
+        if (strncmp(entry->data, prefix, (size_t)prefix_length) != 0) continue;
+        const char *value = entry->data + prefix_length;
+        const char *port_colon = strrchr(value, ':');
+        if (!port_colon) continue;
+        size_t length = (size_t)(port_colon - value);
+        if (length >= 2 && value[0] == '[' && value[length - 1] == ']') {
+            value++;
+            length -= 2;
+        }
+        if (length == 0 || length >= size) continue;
+        memcpy(address, value, length);
+        address[length] = '\0';
+        return address;
+    }
+    return NULL;
+}
+
+static int resolve_target(const compiled_request_t *request, raw_target_t *target) {
+    memset(target, 0, sizeof(*target));
+    if (request->unix_socket) {
+        struct sockaddr_un *address = (struct sockaddr_un *)&target->address;
+        if (strlen(request->unix_socket) >= sizeof(address->sun_path)) return -1;
+        address->sun_family = AF_UNIX;
+        strcpy(address->sun_path, request->unix_socket);
+        target->address_length = sizeof(*address);
+        return 0;
+    }
+
+    CURLU *url = curl_url();
+    char *host = NULL, *port = NULL;
+    int result = -1;
+    if (url && curl_url_set(url, CURLUPART_URL, request->url, CURLU_GUESS_SCHEME) == CURLUE_OK &&
+        curl_url_get(url, CURLUPART_HOST, &host, 0) == CURLUE_OK &&
+        curl_url_get(url, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+        char pinned[256];
+        const char *name = connect_to_address(request, host, port, pinned, sizeof(pinned));
+        if (!name) {
+            // getaddrinfo wants IPv6 literals without brackets
+            size_t length = strlen(host);
+            name = host;
+            if (length >= 2 && host[0] == '[' && length - 2 < sizeof(pinned)) {
+                memcpy(pinned, host + 1, length - 2);
+                pinned[length - 2] = '\0';
+                name = pinned;
+            }
+        }
+
+        struct addrinfo hints, *found = NULL;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(name, port, &hints, &found) == 0 && found &&
+            found->ai_addrlen <= sizeof(target->address)) {
+            memcpy(&target->address, found->ai_addr, found->ai_addrlen);
+            target->address_length = found->ai_addrlen;
+            result = 0;
+        }
+        if (found) freeaddrinfo(found);
+    }
+    curl_free(host);
+    curl_free(port);
+    curl_url_cleanup(url);
+    return result;
+}
+
+// Next request to queue, or -1 when the run has none left for this worker
+static int take_request(raw_worker_t *worker) {
+    raw_load_t *load = worker->load;
+    if (worker->quota == 0) {
+        if (worker->exhausted) return -1;
+        if (load->limit == 0) {
+            worker->quota = RAW_CLAIM_BATCH;
+        } else {
+            uint64_t first = __atomic_fetch_add(load->claim, RAW_CLAIM_BATCH, __ATOMIC_RELAXED);
+            if (first >= load->limit) {
+                worker->exhausted = 1;
+                return -1;
+            }
+            uint64_t left = load->limit - first;
+            worker->quota = left < RAW_CLAIM_BATCH ? left : RAW_CLAIM_BATCH;
+        }
+    }
+    worker->quota--;
+    int index = worker->next_request;
+    worker->next_request = (index + 1) % load->count;
+    return index;
+}
+
+static int has_requests(const raw_worker_t *worker) {
+    return worker->quota > 0 || !worker->exhausted;
+}
+
+static uint64_t event_tag(const raw_conn_t *conn) {
+    return (uint64_t)conn->generation << 32 | conn->index;
+}
+
+static void watch(raw_worker_t *worker, raw_conn_t *conn, int want_write) {
+    if (conn->want_write == want_write) return;
+    struct epoll_event event = { .events = EPOLLIN | (want_write ? EPOLLOUT : 0), .data.u64 = event_tag(conn) };
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    conn->want_write = want_write;
+}
+
+static void queue_write(raw_worker_t *worker, raw_conn_t *conn, int request) {
+    int pipeline = worker->load->pipeline;
+    if (conn->iov_start + conn->iov_count == pipeline) {
+        memmove(conn->iov, conn->iov + conn->iov_start, (size_t)conn->iov_count * sizeof(struct iovec));
+        conn->iov_start = 0;
+    }
+    struct iovec *iov = &conn->iov[conn->iov_start + conn->iov_count++];
+    iov->iov_base = worker->load->bytes[request];
+    iov->iov_len = worker->load->sizes[request];
+}
+
+static void conn_open(raw_worker_t *worker, raw_conn_t *conn);
+
+static void conn_close(raw_worker_t *worker, raw_conn_t *conn) {
+    if (conn->fd >= 0) {
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    conn->state = CONN_CLOSED;
+    conn->want_write = 0;
+}
+
+// Drop the connection and its requests; reopen it if it ever worked
+static void conn_fail(raw_worker_t *worker, raw_conn_t *conn) {
+    add(&worker->stats->errors, 1);
+    add(&worker->stats->unanswered, (uint64_t)conn->inflight_count);
+    worker->inflight -= conn->inflight_count;
+    conn->inflight_count = 0;
+    conn->iov_count = 0;
+    conn_close(worker, conn);
+
+    if (conn->answered > 0 && has_requests(worker)) {
+        add(&worker->stats->reconnects, 1);
+        conn_open(worker, conn);
+    } else {
+        worker->live--;
+    }
+}
+
+// The server closed cleanly: send what is still in flight on a new connection
+static void conn_reopen(raw_worker_t *worker, raw_conn_t *conn) {
+    conn_close(worker, conn);
+    if (conn->inflight_count == 0 && !has_requests(worker)) {
+        worker->live--;
+        return;
+    }
+    add(&worker->stats->reconnects, 1);
+    conn_open(worker, conn);
+}
+
+static void conn_open(raw_worker_t *worker, raw_conn_t *conn) {
+    const raw_target_t *target = &worker->load->target;
+    conn->fd = socket(target->address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    conn->state = CONN_CONNECTING;
+    conn->generation++;
+    conn->answered = 0;
+    conn->iov_start = 0;
+    conn->iov_count = 0;
+    conn->progress_ns = now_ns();
+    raw_parser_init(&conn->parser);
+    if (conn->fd < 0) {
+        conn_fail(worker, conn);
+        return;
+    }
+    if (target->address.ss_family != AF_UNIX) {
+        int one = 1;
+        setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    struct epoll_event event = { .events = EPOLLIN | EPOLLOUT, .data.u64 = event_tag(conn) };
+    conn->want_write = 1;
+    if ((connect(conn->fd, (const struct sockaddr *)&target->address, target->address_length) != 0 &&
+         errno != EINPROGRESS) ||
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, conn->fd, &event) != 0) {
+        conn_fail(worker, conn);
+    }
+}
+
+// Top the pipeline up and write whatever is unwritten
+static void conn_send(raw_worker_t *worker, raw_conn_t *conn) {
+    int pipeline = worker->load->pipeline;
+    uint64_t queued_ns = conn->inflight_count < pipeline ? now_ns() : 0;
+    while (conn->inflight_count < pipeline) {
+        int request = take_request(worker);
+        if (request < 0) break;
+        int slot = (conn->inflight_head + conn->inflight_count++) % pipeline;
+        conn->inflight[slot] = request;
+        conn->queued_ns[slot] = queued_ns;
+        worker->inflight++;
+        queue_write(worker, conn, request);
+    }
+
+    while (conn->iov_count > 0) {
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = conn->iov + conn->iov_start;
+        message.msg_iovlen = (size_t)(conn->iov_count < RAW_MAX_IOV ? conn->iov_count : RAW_MAX_IOV);
+
+        // sendmsg is writev with MSG_NOSIGNAL: a reset connection must not raise SIGPIPE
+        ssize_t written = sendmsg(conn->fd, &message, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(worker, conn, 1);
+                return;
+            }
+            conn_fail(worker, conn);
+            return;
+        }
+
+        size_t left = (size_t)written;
+        while (left > 0) {
+            struct iovec *iov = &conn->iov[conn->iov_start];
+            if (left >= iov->iov_len) {
+                left -= iov->iov_len;
+                conn->iov_start++;
+                conn->iov_count--;
+                add(&worker->stats->sent, 1);
+            } else {
+                iov->iov_base = (char *)iov->iov_base + left;
+                iov->iov_len -= left;
+                left = 0;
+            }
+        }
+    }
+    conn->iov_start = 0;
+    watch(worker, conn, 0);
+}
+
+// The oldest request in flight was answered (when the bytes were read)
+static void count_answer(raw_worker_t *worker, raw_conn_t *conn) {
+    int class = conn->parser.status / 100;
+    uint64_t latency_us = (conn->progress_ns - conn->queued_ns[conn->inflight_head]) / 1000;
+    add(&worker->stats->status[class >= 1 && class <= 5 ? class : 0], 1);
+    add(&worker->stats->responses, 1);
+    hdr_histogram_record(&worker->latency, latency_us);
+    conn->answered++;
+    conn->inflight_head = (conn->inflight_head + 1) % worker->load->pipeline;
+    conn->inflight_count--;
+    worker->inflight--;
+}
+
+// Account the responses in data; returns -1 if the connection was closed or failed
+static int conn_parse(raw_worker_t *worker, raw_conn_t *conn, const char *data, size_t size) {
+    raw_parser_t *parser = &conn->parser;
+    size_t used = 0;
+    while (used < size) {
+        long consumed = raw_parser_feed(parser, data + used, size - used);
+        if (consumed < 0 || (parser->complete && conn->inflight_count == 0)) {
+            conn_fail(worker, conn);
+            return -1;
+        }
+        used += (size_t)consumed;
+        if (!parser->complete) continue;
+
+        count_answer(worker, conn);
+        if (!parser->keep_alive) {
+            conn_reopen(worker, conn);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void conn_readable(raw_worker_t *worker, raw_conn_t *conn) {
+    for (;;) {
+        ssize_t n = recv(conn->fd, worker->buffer, RAW_READ_BUFFER, 0);
+        if (n > 0) {
+            add(&worker->stats->bytes_received, (uint64_t)n);
+            conn->progress_ns = now_ns();
+            if (conn_parse(worker, conn, worker->buffer, (size_t)n) != 0) return;
+            if (n < RAW_READ_BUFFER) break;
+        } else if (n == 0) {
+            int finished = raw_parser_finish(&conn->parser);
+            if (finished == 1 && conn->inflight_count > 0) {
+                count_answer(worker, conn);
+                conn_reopen(worker, conn);
+            } else if (finished == 0 && conn->inflight_count == 0) {
+                conn_reopen(worker, conn);      // Idle keep-alive connection timed out
+            } else {
+                conn_fail(worker, conn);
+            }
+            return;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            conn_fail(worker, conn);
+            return;
+        }
+    }
+    conn_send(worker, conn);
+}
+
+static void conn_event(raw_worker_t *worker, raw_conn_t *conn, uint32_t events) {
+    if (conn->state == CONN_CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            conn_fail(worker, conn);
+            return;
+        }
+        conn->state = CONN_OPEN;
+        conn->progress_ns = now_ns();
+
+        // Requests left over from a closed connection go first
+        int pipeline = worker->load->pipeline;
+        for (int i = 0; i < conn->inflight_count; i++) {
+            queue_write(worker, conn, conn->inflight[(conn->inflight_head + i) % pipeline]);
+        }
+        conn_send(worker, conn);
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        conn_readable(worker, conn);
+    } else if (events & EPOLLOUT) {
+        conn_send(worker, conn);
+    }
+}
+
+static void check_timeouts(raw_worker_t *worker, uint64_t now) {
+    for (int i = 0; i < worker->conn_count; i++) {
+        raw_conn_t *conn = &worker->conns[i];
+        if (conn->state == CONN_CLOSED) continue;
+        if (conn->state == CONN_OPEN && conn->inflight_count == 0) continue;
+        if (now - conn->progress_ns > worker->load->timeout_ns) {
+            conn_fail(worker, conn);
+        }
+    }
+}
+
+static void *load_worker(void *arg) {
+    raw_worker_t *worker = arg;
+    raw_load_t *load = worker->load;
+
+    worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (worker->epoll_fd < 0) {
+        add(&worker->stats->errors, (uint64_t)worker->conn_count);
+        return NULL;
+    }
+    worker->live = worker->conn_count;
+    for (int i = 0; i < worker->conn_count; i++) {
+        conn_open(worker, &worker->conns[i]);
+    }
+
+    struct epoll_event events[RAW_MAX_EVENTS];
+    uint64_t checked_ns = now_ns();
+    while (worker->live > 0 && (worker->inflight > 0 || has_requests(worker))) {
+        uint64_t now = now_ns();
+        int wait_ms = RAW_WAIT_MS;
+        if (load->deadline_ns) {
+            if (now >= load->deadline_ns) break;
+            uint64_t left_ms = (load->deadline_ns - now + 999999) / 1000000;
+            if (left_ms < (uint64_t)wait_ms) wait_ms = (int)left_ms;
+        }
+
+        int ready = epoll_wait(worker->epoll_fd, events, RAW_MAX_EVENTS, wait_ms);
+        for (int i = 0; i < ready; i++) {
+            // Events for a socket closed earlier in this batch are dropped
+            raw_conn_t *conn = &worker->conns[(uint32_t)events[i].data.u64];
+            if (conn->state != CONN_CLOSED && (uint32_t)(events[i].data.u64 >> 32) == conn->generation) {
+                conn_event(worker, conn, events[i].events);
+            }
+        }
+
+        now = now_ns();
+        if (now - checked_ns >= RAW_WAIT_MS * 1000000ull) {
+            check_timeouts(worker, now);
+            checked_ns = now;
+        }
+    }
+
+    add(&worker->stats->unanswered, (uint64_t)worker->inflight);
+    for (int i = 0; i < worker->conn_count; i++) {
+        conn_close(worker, &worker->conns[i]);
+    }
+    close(worker->epoll_fd);
+    return NULL;
+}
+
+// Sum one slot into a total while its writer may still be updating it
+static void sum_stats(raw_load_stats_t *total, const raw_load_stats_t *slot) {
+    total->sent += __atomic_load_n(&slot->sent, __ATOMIC_RELAXED);
+    total->responses += __atomic_load_n(&slot->responses, __ATOMIC_RELAXED);
+    for (int c = 0; c < 6; c++) total->status[c] += __atomic_load_n(&slot->status[c], __ATOMIC_RELAXED);
+    total->errors += __atomic_load_n(&slot->errors, __ATOMIC_RELAXED);
+    total->unanswered += __atomic_load_n(&slot->unanswered, __ATOMIC_RELAXED);
+    total->reconnects += __atomic_load_n(&slot->reconnects, __ATOMIC_RELAXED);
+    total->bytes_received += __atomic_load_n(&slot->bytes_received, __ATOMIC_RELAXED);
+    hdr_histogram_t total_latency, slot_latency;
+    latency_histogram(&total_latency, total);
+    latency_histogram(&slot_latency, slot);
+    hdr_histogram_merge(&total_latency, &slot_latency);
+}
+
+// Serialize the requests and check they can share one set of connections
+static int load_prepare(raw_load_t *load, const compiled_request_t *const *requests, int count,
+                        const raw_load_options_t *options) {
+    memset(load, 0, sizeof(*load));
+    load->count = count;
+    load->pipeline = options->pipeline > 0 ? options->pipeline : 1;
+    load->limit = options->requests;
+    if (load->limit == 0 && options->duration_ms <= 0) load->limit = (uint64_t)count;
+    load->claim = &load->claimed;
+    load->timeout_ns = (uint64_t)(options->timeout_ms > 0 ? options->timeout_ms : RAW_DEFAULT_TIMEOUT_MS) *
+                       1000000ull;
+    load->bytes = calloc((size_t)count, sizeof(char *));
+    load->sizes = calloc((size_t)count, sizeof(size_t));
+    if (!load->bytes || !load->sizes) return -1;
+
+    // Everything must go to one place over HTTP/1.x
+    for (int i = 0; i < count; i++) {
+        raw_target_t target;
+        long version = requests[i]->http_version;
+        if ((version != CURL_HTTP_VERSION_NONE && version != CURL_HTTP_VERSION_1_0 &&
+             version != CURL_HTTP_VERSION_1_1) ||
+            resolve_target(requests[i], &target) != 0) {
+            return -1;
+        }
+        if (i == 0) {
+            load->target = target;
+        } else if (target.address_length != load->target.address_length ||
+                   memcmp(&target.address, &load->target.address, target.address_length) != 0) {
+            return -1;
+        }
+        load->bytes[i] = raw_request_serialize(requests[i], &load->sizes[i]);
+        if (!load->bytes[i]) return -1;
+    }
+    return 0;
+}
+
+static void load_free(raw_load_t *load) {
+    if (load->bytes) {
+        for (int i = 0; i < load->count; i++) free(load->bytes[i]);
+    }
+    free(load->bytes);
+    free(load->sizes);
+}
+
+// Usable CPUs and their count (0 if unknown)
+static int usable_cpus(cpu_set_t *cpus) {
+    CPU_ZERO(cpus);
+    return sched_getaffinity(0, sizeof(*cpus), cpus) == 0 ? CPU_COUNT(cpus) : 0;
+}
+
+// The index-th usable CPU, wrapping around
+static int nth_cpu(const cpu_set_t *cpus, int cpu_count, int index) {
+    int target = index % cpu_count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, cpus) && target-- == 0) return cpu;
+    }
+    return -1;
+}
+
+static void free_workers(raw_worker_t *workers, int count) {
+    if (!workers) return;
+    for (int w = 0; w < count; w++) {
+        for (int i = 0; i < workers[w].conn_count; i++) {
+            free(workers[w].conns[i].inflight);
+            free(workers[w].conns[i].queued_ns);
+            free(workers[w].conns[i].iov);
+        }
+        free(workers[w].conns);
+        free(workers[w].buffer);
+    }
+    free(workers);
+}
+
+// Run threads workers over connections connections, publishing to
+// slots[0..threads), worker w pinned to the (first_cpu + w)-th usable CPU.
+// Returns the number of workers used (never more than connections), or -1
+// on allocation failure.
+static int load_execute(raw_load_t *load, int threads, int connections, int first_cpu,
+                        raw_load_stats_t *slots) {
+    if (threads > connections) threads = connections;
+    cpu_set_t cpus;
+    int cpu_count = usable_cpus(&cpus);
+
+    raw_worker_t *workers = calloc((size_t)threads, sizeof(raw_worker_t));
+    if (!workers) return -1;
+    for (int w = 0; w < threads; w++) {
+        raw_worker_t *worker = &workers[w];
+        worker->load = load;
+        worker->epoll_fd = -1;
+        worker->cpu = cpu_count > 0 ? nth_cpu(&cpus, cpu_count, first_cpu + w) : -1;
+        worker->stats = &slots[w];
+        latency_histogram(&worker->latency, worker->stats);
+        worker->next_request = (first_cpu + w) % load->count;
+        worker->buffer = malloc(RAW_READ_BUFFER);
+        worker->conn_count = connections / threads + (w < connections % threads);
+        worker->conns = calloc((size_t)worker->conn_count, sizeof(raw_conn_t));
+        if (!worker->buffer || !worker->conns) {
+            worker->conn_count = 0;
+            free_workers(workers, threads);
+            return -1;
+        }
+        for (int i = 0; i < worker->conn_count; i++) {
+            raw_conn_t *conn = &worker->conns[i];
+            conn->fd = -1;
+            conn->index = (uint32_t)i;
+            conn->inflight = malloc((size_t)load->pipeline * sizeof(int));
+            conn->queued_ns = malloc((size_t)load->pipeline * sizeof(uint64_t));
+            conn->iov = malloc((size_t)load->pipeline * sizeof(struct iovec));
+            if (!conn->inflight || !conn->queued_ns || !conn->iov) {
+                free_workers(workers, threads);
+                return -1;
+            }
+        }
+    }
+
+    for (int w = 0; w < threads; w++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (workers[w].cpu >= 0) {
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            CPU_SET(workers[w].cpu, &pinned);
+            pthread_attr_setaffinity_np(&attr, sizeof(pinned), &pinned);
+        }
+        if (pthread_create(&workers[w].thread, &attr, load_worker, &workers[w]) == 0) {
+            workers[w].started = 1;
+        } else {
+            // No thread available: run this share inline rather than not at all
+            load_worker(&workers[w]);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    for (int w = 0; w < threads; w++) {
+        if (workers[w].started) pthread_join(workers[w].thread, NULL);
+    }
+    free_workers(workers, threads);
+    return threads;
+}
+
+// Threads for a run: one per usable CPU unless told otherwise
+static int thread_count(const raw_load_options_t *options) {
+    if (options->threads > 0) return options->threads;
+    cpu_set_t cpus;
+    int cpu_count = usable_cpus(&cpus);
+    return cpu_count > 0 ? cpu_count : 1;
+}
+
+int raw_load_run(const compiled_request_t *const *requests, int count,
+                 const raw_load_options_t *options, raw_load_stats_t *stats) {
+    if (!requests || count <= 0 || !options || !stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+
+    raw_load_t load;
+    memset(&load, 0, sizeof(load));
+    int threads = thread_count(options);
+    int connections = options->connections > 0 ? options->connections : threads;
+    raw_load_stats_t *slots = calloc((size_t)threads, sizeof(raw_load_stats_t));
+    int result = -1;
+    if (!slots || load_prepare(&load, requests, count, options) != 0) goto done;
+
+    uint64_t start_ns = now_ns();
+    if (options->duration_ms > 0) {
+        load.deadline_ns = start_ns + (uint64_t)options->duration_ms * 1000000ull;
+    }
+    int used = load_execute(&load, threads, connections, 0, slots);
+    if (used < 0) goto done;
+    for (int w = 0; w < used; w++) sum_stats(stats, &slots[w]);
+    stats->elapsed_ns = now_ns() - start_ns;
+    result = 0;
+
+done:
+    load_free(&load);
+    free(slots);
+    return result;
+}
+
+int raw_load_run_processes(const compiled_request_t *const *requests, int count,
+                           const raw_load_options_t *options, int processes,
+                           raw_load_progress_fn progress, void *user_data, raw_load_stats_t *stats) {
+    if (!requests || count <= 0 || !options || !stats || processes <= 0) return -1;
+    memset(stats, 0, sizeof(*stats));
+
+    // Every process gets at least one thread and every thread one connection
+    int threads = thread_count(options);
+    if (threads < processes) threads = processes;
+    int connections = options->connections > 0 ? options->connections : threads;
+    if (threads > connections) threads = connections;
+    if (processes > threads) processes = threads;
+
+    raw_load_t load;
+    memset(&load, 0, sizeof(load));
+    // The slots, then the counter all processes claim requests from
+    size_t region_size = (size_t)threads * sizeof(raw_load_stats_t) + sizeof(uint64_t);
+    raw_load_stats_t *slots = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t *children = calloc((size_t)processes, sizeof(pid_t));
+    int result = -1;
+    if (slots == MAP_FAILED) slots = NULL;
+    if (!slots || !children || load_prepare(&load, requests, count, options) != 0) goto done;
+    load.claim = (uint64_t *)&slots[threads];
+
+    // Children inherit the prepared requests; the region is all they share
+    uint64_t start_ns = now_ns();
+    int first_thread = 0, forked = 0;
+    for (int p = 0; p < processes; p++) {
+        int process_threads = threads / processes + (p < threads % processes);
+        int process_connections = connections / processes + (p < connections % processes);
+
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            if (options->duration_ms > 0) {
+                load.deadline_ns = now_ns() + (uint64_t)options->duration_ms * 1000000ull;
+            }
+            int used = load_execute(&load, process_threads, process_connections, first_thread,
+                                    &slots[first_thread]);
+            _exit(used < 0 ? 1 : 0);
+        }
+        if (child > 0) children[forked++] = child;
+        first_thread += process_threads;
+    }
+    if (forked == 0) goto done;
+
+    // Watch until every child has exited
+    int running = forked, failed = 0;
+    uint64_t report_ns = start_ns + RAW_PROGRESS_INTERVAL_MS * 1000000ull;
+    while (running > 0) {
+        struct timespec pause = { 0, 10 * 1000000L };
+        nanosleep(&pause, NULL);
+        for (int p = 0; p < forked; p++) {
+            if (children[p] <= 0) continue;
+            int status = 0;
+            pid_t reaped = waitpid(children[p], &status, WNOHANG);
+            if (reaped == 0 || (reaped < 0 && errno == EINTR)) continue;
+
+            // A child that could not run its share, or was killed, fails the run
+            if (reaped < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+            children[p] = 0;
+            running--;
+        }
+
+        uint64_t now = now_ns();
+        if (progress && running > 0 && now >= report_ns) {
+            raw_load_stats_t totals;
+            memset(&totals, 0, sizeof(totals));
+            for (int t = 0; t < threads; t++) sum_stats(&totals, &slots[t]);
+            totals.elapsed_ns = now - start_ns;
+            progress(user_data, &totals);
+            report_ns += RAW_PROGRESS_INTERVAL_MS * 1000000ull;
+        }
+    }
+
+    for (int t = 0; t < threads; t++) sum_stats(stats, &slots[t]);
+    stats->elapsed_ns = now_ns() - start_ns;
+    result = failed > 0 ? -1 : 0;
+
+done:
+    load_free(&load);
+    free(children);
+    if (slots) munmap(slots, region_size);
+    return result;
+}
+
+#else
+
+int raw_load_run(const compiled_request_t *const *requests, int count,
+                 const raw_load_options_t *options, raw_load_stats_t *stats) {
+    (void)requests;
+    (void)count;
+    (void)options;
+    if (stats) memset(stats, 0, sizeof(*stats));
+    return -1;
+}
+
+int raw_load_run_processes(const compiled_request_t *const *requests, int count,
+                           const raw_load_options_t *options, int processes,
+                           raw_load_progress_fn progress, void *user_data, raw_load_stats_t *stats) {
+    (void)processes;
+    (void)progress;
+    (void)user_data;
+    return raw_load_run(requests, count, options, stats);
+}
+
+#endif // __linux__
@@ -0,0 +1,338 @@
+/* ============================================================================
+ * API Kit - Response Search Implementation
+ *
+ * Plain-text search compares the first and last byte of the needle against
+ * 16 candidate positions at a time (SSE2 where available) and only verifies
+ * positions where both agree. Regular expressions are matched line by line
+ * with POSIX regexec. Matches are appended into fixed-size blocks and
+ * published with release semantics, like the response view's line index.
+ * ============================================================================ */
+
+#include "response_search.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <regex.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MATCHES_PER_BLOCK 4096
+#define SCAN_CHUNK_BYTES (1024 * 1024)   // Stop flag is checked between chunks
+#define SEARCH_ERROR_MAX 128
+
+#define PUBLISHED_COMPLETE ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+struct response_search {
+    const char *data;
+    size_t size;
+    search_mode_t mode;
+    char *pattern;
+    size_t pattern_size;
+
+    regex_t regex;
+    int regex_compiled;
+    char error[SEARCH_ERROR_MAX];
+
+    // Match storage: block table sized up front so it never reallocates
+    search_match_t **blocks;
+    size_t block_capacity;
+    size_t match_count;       // Written by the worker only
+    size_t published;         // Atomic: visible match count, plus PUBLISHED_COMPLETE
+
+    pthread_t worker;
+    int worker_started;
+    int stop;                 // Atomic: set by destroy
+};
+
+/* ============================================================================
+ * PLAIN TEXT MATCHING
+ * ============================================================================ */
+
+static int bytes_equal(const char *a, const char *b, size_t n, int ignore_case) {
+    if (!ignore_case) {
+        return memcmp(a, b, n) == 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+long search_find(const char *haystack, size_t haystack_size,
+                 const char *needle, size_t needle_size, int ignore_case) {
+    if (!haystack || !needle || needle_size == 0 || needle_size > haystack_size) {
+        return -1;
+    }
+
+    size_t last = needle_size - 1;
+    unsigned char first_lo = (unsigned char)needle[0];
+    unsigned char first_up = first_lo;
+    unsigned char last_lo = (unsigned char)needle[last];
+    unsigned char last_up = last_lo;
+    if (ignore_case) {
+        first_lo = (unsigned char)tolower(first_lo);
+        first_up = (unsigned char)toupper(first_lo);
+        last_lo = (unsigned char)tolower(last_lo);
+        last_up = (unsigned char)toupper(last_lo);
+    }
+
+    size_t candidates = haystack_size - needle_size + 1;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i v_first_lo = _mm_set1_epi8((char)first_lo);
+    const __m128i v_first_up = _mm_set1_epi8((char)first_up);
+    const __m128i v_last_lo = _mm_set1_epi8((char)last_lo);
+    const __m128i v_last_up = _mm_set1_epi8((char)last_up);
+
+    for (; i + 16 <= candidates; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i *)(haystack + i + last));
+        __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, v_first_lo),
+                                        _mm_cmpeq_epi8(block_first, v_first_up));
+        __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, v_last_lo),
+                                       _mm_cmpeq_epi8(block_last, v_last_up));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last));
+
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctz(mask);
+            if (bytes_equal(haystack + pos + 1, needle + 1, needle_size - 1, ignore_case)) {
+                return (long)pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < candidates; i++) {
+        unsigned char c = (unsigned char)haystack[i];
+        if (c != first_lo && c != first_up) {
+            if (!ignore_case) {
+                // Let memchr skip ahead to the next candidate
+                const char *next = memchr(haystack + i, first_lo, candidates - i);
+                if (!next) break;
+                i = (size_t)(next - haystack);
+            } else {
+                continue;
+            }
+        }
+        if (bytes_equal(haystack + i, needle, needle_size, ignore_case)) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * WORKER
+ * ============================================================================ */
+
+static int stopped(const response_search_t *search) {
+    return __atomic_load_n(&search->stop, __ATOMIC_RELAXED);
+}
+
+static int add_match(response_search_t *search, size_t offset, size_t length) {
+    size_t block = search->match_count / MATCHES_PER_BLOCK;
+    if (block >= search->block_capacity) return -1;
+
+    if (!search->blocks[block]) {
+        search->blocks[block] = malloc(sizeof(search_match_t) * MATCHES_PER_BLOCK);
+        if (!search->blocks[block]) return -1;
+    }
+
+    search_match_t *match = &search->blocks[block][search->match_count % MATCHES_PER_BLOCK];
+    match->offset = (uint32_t)offset;
+    match->length = (uint32_t)length;
+    search->match_count++;
+
+    // Publish every match so the first one reaches the UI immediately
+    __atomic_store_n(&search->published, search->match_count, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static void search_plain(response_search_t *search) {
+    int ignore_case = search->mode == SEARCH_MODE_IGNORE_CASE;
+    size_t pos = 0;
+
+    while (pos < search->size && !stopped(search)) {
+        // Scan a bounded window, overlapping by the needle length
+        size_t window_end = pos + SCAN_CHUNK_BYTES + search->pattern_size - 1;
+        if (window_end > search->size) window_end = search->size;
+
+        long found = search_find(search->data + pos, window_end - pos,
+                                 search->pattern, search->pattern_size, ignore_case);
+        if (found < 0) {
+            if (window_end == search->size) break;
+            pos = window_end - (search->pattern_size - 1);
+            continue;
+        }
+
+        size_t offset = pos + (size_t)found;
+        if (add_match(search, offset, search->pattern_size) != 0) break;
+        pos = offset + search->pattern_size;
+    }
+}
+
+static void search_regex(response_search_t *search) {
+    size_t pos = 0;
+
+    while (pos < search->size && !stopped(search)) {
+        const char *nl = memchr(search->data + pos, '\n', search->size - pos);
+        size_t line_end = nl ? (size_t)(nl - search->data) : search->size;
+        size_t cursor = pos;
+
+        while (cursor <= line_end) {
+            regmatch_t match;
+            int flags = cursor > pos ? REG_NOTBOL : 0;
+#ifdef REG_STARTEND
+            match.rm_so = (regoff_t)cursor;
+            match.rm_eo = (regoff_t)line_end;
+            if (regexec(&search->regex, search->data, 1, &match, flags | REG_STARTEND) != 0) break;
+            size_t start = (size_t)match.rm_so;
+            size_t end = (size_t)match.rm_eo;
+#else
+            // Without REG_STARTEND each line has to be copied to be terminated
+            size_t len = line_end - cursor;
+            char *line = malloc(len + 1);
+            if (!line) return;
+            memcpy(line, search->data + cursor, len);
+            line[len] = '\0';
+            int rc = regexec(&search->regex, line, 1, &match, flags);
+            free(line);
+            if (rc != 0) break;
+            size_t start = cursor + (size_t)match.rm_so;
+            size_t end = cursor + (size_t)match.rm_eo;
+#endif
+            if (end > start && add_match(search, start, end - start) != 0) return;
+            cursor = end > start ? end : end + 1;
+        }
+
+        pos = line_end + 1;
+    }
+}
+
+static void *search_worker(void *arg) {
+    response_search_t *search = arg;
+    trace_set_thread_name("response_search");
+    uint64_t trace_start_ns = trace_begin();
+
+    if (search->mode == SEARCH_MODE_REGEX) {
+        if (search->regex_compiled) {
+            search_regex(search);
+        }
+    } else {
+        search_plain(search);
+    }
+
+    __atomic_store_n(&search->published, search->match_count | PUBLISHED_COMPLETE, __ATOMIC_RELEASE);
+    trace_end("response_search", "response", trace_start_ns);
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+response_search_t *response_search_start(const char *data, size_t size,
+                                         const char *pattern, search_mode_t mode) {
+    if (!pattern || pattern[0] == '\0') return NULL;
+
+    response_search_t *search = calloc(1, sizeof(response_search_t));
+    if (!search) return NULL;
+
+    search->data = data;
+    search->size = data ? (size > UINT32_MAX ? UINT32_MAX : size) : 0;
+    search->mode = mode;
+    search->pattern = strdup(pattern);
+    search->pattern_size = strlen(pattern);
+
+    // Matches never overlap and are at least one byte long
+    search->block_capacity = search->size / MATCHES_PER_BLOCK + 1;
+    search->blocks = calloc(search->block_capacity, sizeof(search_match_t *));
+    if (!search->pattern || !search->blocks) {
+        response_search_destroy(search);
+        return NULL;
+    }
+
+    if (mode == SEARCH_MODE_REGEX) {
+        int rc = regcomp(&search->regex, pattern, REG_EXTENDED | REG_NEWLINE);
+        if (rc != 0) {
+            regerror(rc, &search->regex, search->error, sizeof(search->error));
+        } else {
+            search->regex_compiled = 1;
+        }
+    }
+
+    if (pthread_create(&search->worker, NULL, search_worker, search) == 0) {
+        search->worker_started = 1;
+    } else {
+        search_worker(search);
+    }
+    return search;
+}
+
+void response_search_destroy(response_search_t *search) {
+    if (!search) return;
+
+    if (search->worker_started) {
+        __atomic_store_n(&search->stop, 1, __ATOMIC_RELAXED);
+        pthread_join(search->worker, NULL);
+    }
+    if (search->regex_compiled) {
+        regfree(&search->regex);
+    }
+    if (search->blocks) {
+        for (size_t i = 0; i < search->block_capacity; i++) {
+            free(search->blocks[i]);
+        }
+        free(search->blocks);
+    }
+    free(search->pattern);
+    free(search);
+}
+
+size_t response_search_match_count(const response_search_t *search) {
+    if (!search) return 0;
+    return __atomic_load_n(&search->published, __ATOMIC_ACQUIRE) & ~PUBLISHED_COMPLETE;
+}
+
+int response_search_is_complete(const response_search_t *search) {
+    if (!search) return 1;
+    return (__atomic_load_n(&search->published, __ATOMIC_ACQUIRE) & PUBLISHED_COMPLETE) != 0;
+}
+
+const char *response_search_error(const response_search_t *search) {
+    if (!search || search->error[0] == '\0') return NULL;
+    return search->error;
+}
+
+int response_search_get(const response_search_t *search, size_t index, search_match_t *match) {
+    if (!search || !match || index >= response_search_match_count(search)) {
+        return -1;
+    }
+    *match = search->blocks[index / MATCHES_PER_BLOCK][index % MATCHES_PER_BLOCK];
+    return 0;
+}
+
+long response_search_find_from(const response_search_t *search, size_t offset) {
+    size_t count = response_search_match_count(search);
+    size_t lo = 0;
+    size_t hi = count;
+
+    // Matches are published in ascending offset order
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (search->blocks[mid / MATCHES_PER_BLOCK][mid % MATCHES_PER_BLOCK].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count ? (long)lo : -1;
+}
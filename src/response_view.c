@@ -0,0 +1,260 @@
+/* ============================================================================
+ * API Kit - Response View Implementation
+ *
+ * The worker appends line records into fixed-size blocks and publishes the
+ * line count with release semantics. Readers load the count with acquire
+ * semantics, so published lines can be read without taking a lock and
+ * blocks never move once written.
+ *
+ * A line is stored as its start offset and depth only (6 bytes); its end is
+ * the start of the next line, since every significant byte of the body
+ * belongs to exactly one line. While indexing is in progress the newest
+ * line is therefore held back until its successor exists.
+ * ============================================================================ */
+
+#include "response_view.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define LINES_PER_BLOCK 4096
+#define FIRST_STEP_BYTES (16 * 1024)    // Small first step so the first screen appears at once
+#define STEP_BYTES (256 * 1024)
+
+#define DEPTH_PLAIN 0xFFFF
+#define DEPTH_MAX (DEPTH_PLAIN - 1)
+
+// Set in the published count once the whole body has been indexed
+#define PUBLISHED_COMPLETE ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+typedef struct {
+    uint32_t offsets[LINES_PER_BLOCK];
+    uint16_t depths[LINES_PER_BLOCK];
+} line_block_t;
+
+struct response_view {
+    char *body;
+    size_t size;
+    int is_json;
+
+    // Line index: block table sized up front so it never reallocates
+    line_block_t **blocks;
+    size_t block_capacity;
+    size_t line_count;        // Written by the worker only
+    size_t published;         // Atomic: visible line count, plus PUBLISHED_COMPLETE
+
+    pthread_t worker;
+    int worker_started;
+    int stop;                 // Atomic: set by destroy
+    int failed;               // Out of memory while indexing
+};
+
+/* ============================================================================
+ * WORKER
+ * ============================================================================ */
+
+static void append_line(void *user_data, const json_line_t *line) {
+    response_view_t *view = user_data;
+    if (view->failed) return;
+
+    size_t block = view->line_count / LINES_PER_BLOCK;
+    size_t slot = view->line_count % LINES_PER_BLOCK;
+    if (block >= view->block_capacity) {
+        view->failed = 1;
+        return;
+    }
+    if (!view->blocks[block]) {
+        view->blocks[block] = malloc(sizeof(line_block_t));
+        if (!view->blocks[block]) {
+            view->failed = 1;
+            return;
+        }
+    }
+
+    uint16_t depth = DEPTH_PLAIN;
+    if (line->depth != JSON_LINE_PLAIN) {
+        depth = line->depth > DEPTH_MAX ? DEPTH_MAX : (uint16_t)line->depth;
+    }
+    view->blocks[block]->offsets[slot] = line->offset;
+    view->blocks[block]->depths[slot] = depth;
+    view->line_count++;
+}
+
+static void publish(response_view_t *view, int complete) {
+    // The newest line's end is unknown until the next line starts
+    size_t visible = view->line_count;
+    if (!complete && visible > 0) {
+        visible--;
+    }
+    __atomic_store_n(&view->published, visible | (complete ? PUBLISHED_COMPLETE : 0), __ATOMIC_RELEASE);
+}
+
+static void *format_worker(void *arg) {
+    response_view_t *view = arg;
+    size_t step = FIRST_STEP_BYTES;
+    trace_set_thread_name("response_format");
+    uint64_t trace_start_ns = trace_begin();
+
+    if (view->is_json) {
+        json_formatter_t formatter;
+        json_formatter_init(&formatter, view->body, view->size, append_line, view);
+        while (!__atomic_load_n(&view->stop, __ATOMIC_RELAXED) && !view->failed) {
+            uint64_t trace_step_ns = trace_begin();
+            int more = json_formatter_step(&formatter, step);
+            publish(view, 0);
+            trace_end("format_step", "response", trace_step_ns);
+            if (!more) break;
+            step = STEP_BYTES;
+        }
+    } else {
+        size_t pos = 0;
+        while (pos < view->size && !__atomic_load_n(&view->stop, __ATOMIC_RELAXED) && !view->failed) {
+            uint64_t trace_step_ns = trace_begin();
+            pos = json_index_plain(view->body, pos, view->size, step, append_line, view);
+            publish(view, 0);
+            trace_end("index_step", "response", trace_step_ns);
+            step = STEP_BYTES;
+        }
+    }
+
+    publish(view, 1);
+    trace_end("response_format", "response", trace_start_ns);
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+response_view_t *response_view_create(char *body, size_t size) {
+    response_view_t *view = calloc(1, sizeof(response_view_t));
+    if (!view) {
+        free(body);
+        return NULL;
+    }
+
+    view->body = body;
+    view->size = body ? size : 0;
+    view->is_json = json_format_detect(body, view->size);
+
+    // Every line consumes at least one byte of input
+    view->block_capacity = (view->size + 1) / LINES_PER_BLOCK + 1;
+    view->blocks = calloc(view->block_capacity, sizeof(line_block_t *));
+    if (!view->blocks) {
+        free(body);
+        free(view);
+        return NULL;
+    }
+
+    if (pthread_create(&view->worker, NULL, format_worker, view) == 0) {
+        view->worker_started = 1;
+    } else {
+        // No thread available: format inline rather than show nothing
+        format_worker(view);
+    }
+    return view;
+}
+
+void response_view_destroy(response_view_t *view) {
+    if (!view) return;
+
+    if (view->worker_started) {
+        __atomic_store_n(&view->stop, 1, __ATOMIC_RELAXED);
+        pthread_join(view->worker, NULL);
+    }
+
+    for (size_t i = 0; i < view->block_capacity; i++) {
+        free(view->blocks[i]);
+    }
+    free(view->blocks);
+    free(view->body);
+    free(view);
+}
+
+size_t response_view_line_count(const response_view_t *view) {
+    if (!view) return 0;
+    return __atomic_load_n(&view->published, __ATOMIC_ACQUIRE) & ~PUBLISHED_COMPLETE;
+}
+
+int response_view_is_complete(const response_view_t *view) {
+    if (!view) return 1;
+    return (__atomic_load_n(&view->published, __ATOMIC_ACQUIRE) & PUBLISHED_COMPLETE) != 0;
+}
+
+int response_view_is_json(const response_view_t *view) {
+    return view ? view->is_json : 0;
+}
+
+const char *response_view_body(const response_view_t *view, size_t *size) {
+    if (!view) {
+        if (size) *size = 0;
+        return NULL;
+    }
+    if (size) *size = view->size;
+    return view->body;
+}
+
+int response_view_render_line(const response_view_t *view, size_t index,
+                              char *out, int out_size,
+                              json_span_t *spans, int max_spans, int *span_count) {
+    if (span_count) *span_count = 0;
+    if (!view) return -1;
+
+    size_t published = __atomic_load_n(&view->published, __ATOMIC_ACQUIRE);
+    size_t count = published & ~PUBLISHED_COMPLETE;
+    if (index >= count) {
+        return -1;
+    }
+
+    const line_block_t *block = view->blocks[index / LINES_PER_BLOCK];
+    size_t slot = index % LINES_PER_BLOCK;
+    json_line_t line = { .offset = block->offsets[slot] };
+
+    // While indexing, a published line always has a stored successor
+    size_t end = view->size;
+    if (index + 1 < count || !(published & PUBLISHED_COMPLETE)) {
+        size_t next = index + 1;
+        end = view->blocks[next / LINES_PER_BLOCK]->offsets[next % LINES_PER_BLOCK];
+    }
+    line.length = (uint32_t)(end - line.offset);
+
+    if (block->depths[slot] == DEPTH_PLAIN) {
+        // Trim the line terminator that separates it from its successor
+        while (line.length > 0 && (view->body[line.offset + line.length - 1] == '\n' ||
+                                   view->body[line.offset + line.length - 1] == '\r')) {
+            line.length--;
+        }
+        line.depth = JSON_LINE_PLAIN;
+        return json_format_render_plain(view->body, &line, out, out_size);
+    }
+
+    line.depth = block->depths[slot];
+    return json_format_render_line(view->body, &line, out, out_size, spans, max_spans, span_count);
+}
+
+long response_view_line_for_offset(const response_view_t *view, size_t offset) {
+    size_t count = response_view_line_count(view);
+    if (count == 0 || offset >= view->size) return -1;
+
+    // Last line whose start is at or before the offset
+    size_t lo = 0;
+    size_t hi = count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (view->blocks[mid / LINES_PER_BLOCK]->offsets[mid % LINES_PER_BLOCK] <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Beyond the last published line the body may not be indexed yet
+    if (lo == count - 1 && !response_view_is_complete(view)) {
+        size_t next = count;
+        if (offset >= view->blocks[next / LINES_PER_BLOCK]->offsets[next % LINES_PER_BLOCK]) {
+            return -1;
+        }
+    }
+    return (long)lo;
+}
@@ -0,0 +1,847 @@
+/* ============================================================================
+ * API Kit - Collection Runner CLI
+ *
+ * Runs one or more .http files as a single dependency graph (see
+ * collection_runner.h) and prints each result and a summary. Exits with 1
+ * if any request did not pass.
+ *
+ * With --raw the requests are instead sent as a load test through the raw
+ * HTTP/1.1 engine (see raw_engine.h): rendered once with the environment,
+ * then repeated in rotation, without captures or dependencies.
+ *
+ * With --iterations the whole run is repeated as that many independent
+ * virtual users, spread over a work-stealing pool of worker threads (see
+ * work_scheduler.h): every iteration has its own variables and captures,
+ * and a worker whose iterations finish early takes waiting ones from the
+ * others. Per-worker utilization shows whether the client side kept up.
+ *
+ * With --data the run is repeated once per row of a CSV or JSONL file (see
+ * data_file.h), with the row's columns as variables over the environment.
+ * A worker of the same pool claims chunks of the memory-mapped file in turn
+ * and keeps up to --concurrency rows in flight on one engine across them,
+ * so rows share connections instead of opening their own.
+ * ============================================================================ */
+
+#include "collection_runner.h"
+#include "environment.h"
+#include "raw_engine.h"
+#include "work_scheduler.h"
+#include "hdr_histogram.h"
+#include "data_file.h"
+#include <curl/curl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_RUN_FILES 64
+#define MAX_ROUTES_LENGTH 4096
+#define MAX_CONNECTION_LINES 32
+#define LATENCY_PRECISION 5             // Request durations: microseconds, about 3%
+#define LATENCY_RANGE 32                //   up to 2^32 us
+#define DATA_MAX_LANES 256              // Rows in flight per worker with --concurrency 0
+#define DATA_CHUNKS_PER_WORKER 16       // Smaller files are cut finer, down to DATA_MIN_CHUNK
+#define DATA_MIN_CHUNK (64u << 10)
+
+static const char *state_names[] = {"PENDING", "RUNNING", "PASS", "FAIL", "SKIP"};
+
+typedef struct {
+    const http_request_t *requests;
+    int quiet;
+} run_output_t;
+
+// Totals of the iterations (or data rows) one worker ran; only that worker writes them
+typedef struct {
+    uint64_t iterations;
+    uint64_t failed_iterations;
+    uint64_t malformed_rows;    // Data rows that could not be read
+    uint64_t counts[RUN_SKIPPED + 1];
+    uint64_t latency_ns;
+    hdr_histogram_t latency;    // Request durations in microseconds
+    char padding[64];           // Keep workers' tallies on separate cache lines
+} iteration_tally_t;
+
+typedef struct {
+    const http_request_t *requests;
+    int count;
+    const environment_list_t *environments;
+    int environment;
+    const run_options_t *options;
+    int quiet;
+    iteration_tally_t *tallies; // One per worker
+} iteration_job_t;
+
+typedef struct {
+    const iteration_job_t *job;
+    uint64_t iteration;
+} iteration_output_t;
+
+struct data_job;
+
+// A data row in flight, with its own variables and run
+typedef struct {
+    const struct data_job *job;
+    template_vars_t *vars;
+    collection_run_t *run;
+    data_row_t row;             // Bound values point into it or the mapping
+    int busy;
+} data_lane_t;
+
+// A worker's engine and lanes, set up on its first chunk
+typedef struct {
+    int started;                // 1 once set up, -1 if that failed
+    http_engine_t *engine;
+    data_lane_t *lanes;
+    int lane_count;
+} data_worker_t;
+
+typedef struct data_job {
+    const http_request_t *requests;
+    int count;
+    const environment_list_t *environments;
+    int environment;
+    const run_options_t *options;
+    int quiet;
+    const data_file_t *data;
+    uint64_t chunk_size;
+    uint64_t chunk_count;
+    uint64_t next_chunk;        // Next chunk to claim (atomic)
+    iteration_tally_t *tallies; // One per worker
+    data_worker_t *workers;     // One per worker
+} data_job_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *program) {
+    printf("Usage: %s [options] FILE.http...\n"
+           "  --env NAME              Environment to use\n"
+           "  --environments FILE     Environments file (default data/environments.toml)\n"
+           "  --concurrency N         Requests in flight at once (default 16, 0 = no limit)\n"
+           "  --timeout MS            Per-request timeout (default 10000)\n"
+           "  --retries N             Retry connect, network, 429 and 5xx failures up to N times\n"
+           "  --hedge MS|p95          Send a duplicate of requests slower than MS (or the p95)\n"
+           "  --rate RPS              Start at most RPS requests per second in total\n"
+           "  --host-rate RPS         Start at most RPS requests per second to each host\n"
+           "  --host-connections N    Keep at most N requests in flight to each host\n"
+           "  --warmup N              Open N connections per origin before the clock starts\n"
+           "  --unix-socket PATH      Connect through a Unix domain socket\n"
+           "  --resolve H:P:ADDR      Connect to ADDR for host H, port P (repeatable)\n"
+           "  --http VERSION          1.1, 2 (negotiated over TLS) or 2-prior-knowledge\n"
+           "  --max-streams N         Multiplex up to N requests per HTTP/2 connection (0 = off)\n"
+           "  --iterations N          Run the files N times as independent users on --threads workers\n"
+           "  --data FILE             Run the files once per CSV/JSONL row on --threads workers,\n"
+           "                          with --concurrency rows in flight on each\n"
+           "  --quiet                 Print only failures and the summary\n"
+           "Load testing (plain http:// to one origin):\n"
+           "  --raw                   Send through the raw HTTP/1.1 engine instead\n"
+           "  --connections N         Connections in total (default one per thread)\n"
+           "  --pipeline N            Requests in flight per connection (default 1)\n"
+           "  --threads N             Worker threads, pinned per CPU (default one per CPU; also --iterations)\n"
+           "  --processes N           Spread the threads over N worker processes\n"
+           "  --requests N            Stop after N requests\n"
+           "  --duration MS           Stop after MS milliseconds\n",
+           program);
+}
+
+static void print_connections(const collection_run_t *run, int quiet) {
+    int count = 0;
+    const http_connection_stats_t *connections = collection_run_connections(run, &count);
+    if (count == 0) return;
+
+    uint64_t streams = 0, min_streams = UINT64_MAX, max_streams = 0;
+    int http2 = 0;
+    for (int i = 0; i < count; i++) {
+        const http_connection_stats_t *connection = &connections[i];
+        streams += connection->streams;
+        if (connection->streams < min_streams) min_streams = connection->streams;
+        if (connection->streams > max_streams) max_streams = connection->streams;
+        if (connection->http_version >= 20) http2++;
+    }
+    printf("Used %d connections (%d HTTP/2 or later): %llu-%llu requests each, %.1f on average\n",
+           count, http2, (unsigned long long)min_streams, (unsigned long long)max_streams,
+           (double)streams / count);
+    if (quiet) return;
+
+    for (int i = 0; i < count && i < MAX_CONNECTION_LINES; i++) {
+        const http_connection_stats_t *connection = &connections[i];
+        char version[16] = "-";
+        if (connection->http_version >= 20) {
+            snprintf(version, sizeof(version), "HTTP/%d", connection->http_version / 10);
+        } else if (connection->http_version > 0) {
+            snprintf(version, sizeof(version), "HTTP/1.%d", connection->http_version % 10);
+        }
+        printf("  %-22s -> %-22s %-8s %8llu requests\n",
+               connection->local, connection->remote[0] ? connection->remote : "-", version,
+               (unsigned long long)connection->streams);
+    }
+    if (count > MAX_CONNECTION_LINES) {
+        printf("  ... and %d more\n", count - MAX_CONNECTION_LINES);
+    }
+}
+
+static void print_latency(const hdr_histogram_t *latency) {
+    if (hdr_histogram_count(latency) == 0) return;
+    printf("Latency: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+           (double)hdr_histogram_percentile(latency, 50) / 1e3, (double)hdr_histogram_percentile(latency, 90) / 1e3,
+           (double)hdr_histogram_percentile(latency, 99) / 1e3, (double)hdr_histogram_percentile(latency, 99.9) / 1e3,
+           (double)hdr_histogram_max(latency) / 1e3);
+}
+
+static void print_load_progress(void *user_data, const raw_load_stats_t *totals) {
+    uint64_t *previous = user_data;
+    printf("%6.1f s  %llu responses (%llu in the last second), p50 %.2f ms, p99 %.2f ms, %llu errors\n",
+           (double)totals->elapsed_ns / 1e9, (unsigned long long)totals->responses,
+           (unsigned long long)(totals->responses - *previous),
+           (double)raw_latency_percentile(totals, 50) / 1e3, (double)raw_latency_percentile(totals, 99) / 1e3,
+           (unsigned long long)totals->errors);
+    fflush(stdout);
+    *previous = totals->responses;
+}
+
+// Render every request once and hand them all to the raw engine
+static int run_raw(const http_request_t *requests, int count, template_vars_t *vars, const char *routes,
+                   long timeout_ms, const raw_load_options_t *options, int processes) {
+    compiled_request_t **compiled = calloc((size_t)count, sizeof(compiled_request_t *));
+    template_buffer_t rendered[3] = {{0}};
+    int status = 1;
+    if (!compiled) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const char *texts[] = {requests[i].url, requests[i].headers, requests[i].body};
+        for (int t = 0; t < 3; t++) {
+            template_t *template = template_compile(texts[t], vars);
+            int unset = template ? template_render(template, vars, &rendered[t]) : -1;
+            template_destroy(template);
+            if (unset < 0) {
+                printf("Out of memory\n");
+                goto done;
+            }
+        }
+        http_method_t method = http_method_from_name(requests[i].method);
+        int has_body = method == HTTP_METHOD_POST || method == HTTP_METHOD_PUT || method == HTTP_METHOD_PATCH;
+        compiled[i] = compiled_request_create(method, rendered[0].data, rendered[1].data,
+                                              has_body ? rendered[2].data : NULL, timeout_ms);
+        if (!compiled[i] || compiled_request_add_routes(compiled[i], routes) != 0) {
+            printf("Out of memory\n");
+            goto done;
+        }
+    }
+
+    raw_load_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    uint64_t previous = 0;
+    int failed = processes > 0 ?
+        raw_load_run_processes((const compiled_request_t *const *)compiled, count, options, processes,
+                               print_load_progress, &previous, &stats) :
+        raw_load_run((const compiled_request_t *const *)compiled, count, options, &stats);
+    if (failed && processes > 0 && stats.sent > 0) {
+        printf("A load process failed; its share of the run is missing\n");
+        goto done;
+    }
+    if (failed) {
+        printf("The raw engine needs plain http:// requests over HTTP/1.1, all to one origin\n");
+        goto done;
+    }
+
+    double seconds = (double)stats.elapsed_ns / 1e9;
+    printf("Sent %llu requests in %.3f s: %llu responses, %.0f per second\n",
+           (unsigned long long)stats.sent, seconds, (unsigned long long)stats.responses,
+           seconds > 0 ? (double)stats.responses / seconds : 0.0);
+    printf("Status: %llu 2xx, %llu 3xx, %llu 4xx, %llu 5xx, %llu other\n",
+           (unsigned long long)stats.status[2], (unsigned long long)stats.status[3],
+           (unsigned long long)stats.status[4], (unsigned long long)stats.status[5],
+           (unsigned long long)stats.status[0]);
+    printf("Received %llu bytes; %llu failed connections, %llu reconnects, %llu unanswered requests\n",
+           (unsigned long long)stats.bytes_received, (unsigned long long)stats.errors,
+           (unsigned long long)stats.reconnects, (unsigned long long)stats.unanswered);
+    hdr_histogram_t latency;
+    hdr_histogram_init(&latency, RAW_LATENCY_PRECISION, RAW_LATENCY_RANGE, stats.latency);
+    print_latency(&latency);
+    status = stats.responses > 0 && stats.errors == 0 &&
+             stats.status[0] + stats.status[4] + stats.status[5] == 0 ? 0 : 1;
+
+done:
+    for (int i = 0; i < count; i++) compiled_request_destroy(compiled[i]);
+    free(compiled);
+    for (int t = 0; t < 3; t++) template_buffer_free(&rendered[t]);
+    return status;
+}
+
+static void print_result(void *user_data, int index, const run_result_t *result) {
+    const run_output_t *output = user_data;
+    if (output->quiet && result->state == RUN_PASSED) return;
+
+    const http_request_t *request = &output->requests[index];
+    printf("[%3d] %-4s %3ld %-6s %s  %.1f ms", index + 1, state_names[result->state],
+           result->status_code, request->method, request->url,
+           (double)(result->end_ns - result->start_ns) / 1e6);
+    if (result->attempts > 1) {
+        printf("  [%d attempts]", result->attempts);
+    }
+    if (result->error[0]) {
+        printf("  (%s)", result->error);
+    }
+    printf("\n");
+}
+
+static void print_iteration_result(void *user_data, int index, const run_result_t *result) {
+    const iteration_output_t *output = user_data;
+    if (output->job->quiet || result->state == RUN_PASSED) return;
+
+    // One printf per line, so lines from different workers do not interleave
+    const http_request_t *request = &output->job->requests[index];
+    printf("#%-5llu [%3d] %-4s %3ld %-6s %s  %.1f ms%s%s%s\n", (unsigned long long)output->iteration + 1,
+           index + 1, state_names[result->state], result->status_code, request->method, request->url,
+           (double)(result->end_ns - result->start_ns) / 1e6,
+           result->error[0] ? "  (" : "", result->error, result->error[0] ? ")" : "");
+}
+
+// Count a finished run's results into a worker's tally
+static void tally_run(iteration_tally_t *tally, const collection_run_t *run, int count) {
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        const run_result_t *result = collection_run_result(run, i);
+        tally->counts[result->state]++;
+        tally->latency_ns += result->end_ns - result->start_ns;
+        if (result->state != RUN_SKIPPED) {
+            hdr_histogram_record(&tally->latency, (result->end_ns - result->start_ns) / 1000);
+        }
+        if (result->state != RUN_PASSED) failed = 1;
+    }
+    tally->failed_iterations += (uint64_t)failed;
+}
+
+// One tally per worker, each with its own histogram
+static iteration_tally_t *create_tallies(int workers) {
+    iteration_tally_t *tallies = calloc((size_t)(workers > 0 ? workers : 1), sizeof(iteration_tally_t));
+    for (int w = 0; tallies && w < workers; w++) {
+        if (hdr_histogram_init(&tallies[w].latency, LATENCY_PRECISION, LATENCY_RANGE, NULL) != 0) {
+            for (int i = 0; i < w; i++) hdr_histogram_free(&tallies[i].latency);
+            free(tallies);
+            return NULL;
+        }
+    }
+    return tallies;
+}
+
+static void destroy_tallies(iteration_tally_t *tallies, int workers) {
+    for (int w = 0; tallies && w < workers; w++) hdr_histogram_free(&tallies[w].latency);
+    free(tallies);
+}
+
+// Add the workers' tallies into total, whose histogram is set up
+static void sum_tallies(iteration_tally_t *total, const iteration_tally_t *tallies, int workers) {
+    for (int w = 0; w < workers; w++) {
+        hdr_histogram_merge(&total->latency, &tallies[w].latency);
+        total->iterations += tallies[w].iterations;
+        total->failed_iterations += tallies[w].failed_iterations;
+        total->malformed_rows += tallies[w].malformed_rows;
+        total->latency_ns += tallies[w].latency_ns;
+        for (int s = 0; s <= RUN_SKIPPED; s++) total->counts[s] += tallies[w].counts[s];
+    }
+}
+
+static void print_workers(const work_scheduler_t *scheduler, const iteration_tally_t *tallies, int workers,
+                          const char *unit) {
+    for (int w = 0; w < workers; w++) {
+        work_worker_stats_t stats = work_scheduler_worker_stats(scheduler, w);
+        printf("  worker %-3d %8llu %-10s  %6llu tasks  %6llu stolen  %5.1f%% busy\n", w,
+               (unsigned long long)tallies[w].iterations, unit, (unsigned long long)stats.tasks,
+               (unsigned long long)stats.steals,
+               stats.elapsed_ns > 0 ? 100.0 * (double)stats.busy_ns / (double)stats.elapsed_ns : 0.0);
+    }
+}
+
+// One virtual user: plan and execute the whole run with its own variables
+static void run_iteration(void *arg, uint64_t iteration, int worker) {
+    const iteration_job_t *job = arg;
+    iteration_tally_t *tally = &job->tallies[worker];
+    iteration_output_t output = { job, iteration };
+    run_options_t options = *job->options;
+    options.on_result = print_iteration_result;
+    options.user_data = &output;
+
+    tally->iterations++;
+    template_vars_t *vars = template_vars_create();
+    collection_run_t *run = NULL;
+    if (vars) {
+        environment_apply(job->environments, job->environment, vars);
+        run = collection_run_create(job->requests, job->count, vars);
+    }
+    if (!run || collection_run_execute(run, &options) < 0) {
+        printf("#%-5llu failed to start\n", (unsigned long long)iteration + 1);
+        tally->failed_iterations++;
+        tally->counts[RUN_FAILED] += (uint64_t)job->count;
+    } else {
+        tally_run(tally, run, job->count);
+    }
+    collection_run_destroy(run);
+    template_vars_destroy(vars);
+}
+
+static int run_iterations(const http_request_t *requests, int count, const environment_list_t *environments,
+                          int environment, const run_options_t *options, int quiet, uint64_t iterations,
+                          int threads) {
+    // Once up front, rather than from every worker's engine at the same time
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        printf("Failed to start the HTTP engine\n");
+        return 1;
+    }
+    work_scheduler_t *scheduler = work_scheduler_create(threads);
+    int workers = work_scheduler_workers(scheduler);
+    iteration_tally_t *tallies = create_tallies(workers);
+    iteration_tally_t total = {0};
+    int status = 1;
+    if (!scheduler || !tallies || hdr_histogram_init(&total.latency, LATENCY_PRECISION, LATENCY_RANGE, NULL) != 0) {
+        printf("Out of memory\n");
+        goto done;
+    }
+
+    iteration_job_t job = { requests, count, environments, environment, options, quiet, tallies };
+    uint64_t start_ns = now_ns();
+    int failed_to_queue = work_scheduler_for(scheduler, iterations, 1, run_iteration, &job);
+    double seconds = (double)(now_ns() - start_ns) / 1e9;
+
+    sum_tallies(&total, tallies, workers);
+    printf("Ran %llu iterations of %d requests in %.3f s (%.1f per second, sum of latencies %.3f s): "
+           "%llu failed\n",
+           (unsigned long long)total.iterations, count, seconds, seconds > 0 ? (double)total.iterations / seconds : 0.0,
+           (double)total.latency_ns / 1e9, (unsigned long long)total.failed_iterations);
+    printf("Requests: %llu passed, %llu failed, %llu skipped\n",
+           (unsigned long long)total.counts[RUN_PASSED], (unsigned long long)total.counts[RUN_FAILED],
+           (unsigned long long)total.counts[RUN_SKIPPED]);
+    print_latency(&total.latency);
+    print_workers(scheduler, tallies, workers, "iterations");
+
+    status = failed_to_queue == 0 && total.iterations == iterations && total.failed_iterations == 0 ? 0 : 1;
+
+done:
+    work_scheduler_destroy(scheduler);
+    destroy_tallies(tallies, workers);
+    hdr_histogram_free(&total.latency);
+    curl_global_cleanup();
+    return status;
+}
+
+static void print_row_result(void *user_data, int index, const run_result_t *result) {
+    const data_lane_t *lane = user_data;
+    if (lane->job->quiet || result->state == RUN_PASSED) return;
+
+    // Rows are named by their byte offset: counting lines would take a pass over the file
+    const http_request_t *request = &lane->job->requests[index];
+    printf("row@%-10llu [%3d] %-4s %3ld %-6s %s  %.1f ms%s%s%s\n", (unsigned long long)lane->row.offset,
+           index + 1, state_names[result->state], result->status_code, request->method, request->url,
+           (double)(result->end_ns - result->start_ns) / 1e6,
+           result->error[0] ? "  (" : "", result->error, result->error[0] ? ")" : "");
+}
+
+static int start_data_worker(const data_job_t *job, data_worker_t *worker) {
+    int lanes = job->options->concurrency > 0 ? job->options->concurrency : DATA_MAX_LANES;
+    worker->engine = collection_run_engine_create(job->options);
+    worker->lanes = calloc((size_t)lanes, sizeof(data_lane_t));
+    if (!worker->engine || !worker->lanes) return -1;
+
+    worker->lane_count = lanes;
+    for (int l = 0; l < lanes; l++) {
+        data_lane_t *lane = &worker->lanes[l];
+        lane->job = job;
+        lane->vars = template_vars_create();
+        if (!lane->vars) return -1;
+        environment_apply(job->environments, job->environment, lane->vars);
+        lane->run = collection_run_create(job->requests, job->count, lane->vars);
+        if (!lane->run) return -1;
+    }
+    return 0;
+}
+
+static void destroy_data_worker(data_worker_t *worker) {
+    for (int l = 0; l < worker->lane_count; l++) {
+        collection_run_destroy(worker->lanes[l].run);
+        template_vars_destroy(worker->lanes[l].vars);
+        data_row_free(&worker->lanes[l].row);
+    }
+    free(worker->lanes);
+    http_engine_destroy(worker->engine);
+}
+
+// The row's fields over the environment, without copying them; then send its requests
+static void start_row(data_lane_t *lane, http_engine_t *engine) {
+    const data_job_t *job = lane->job;
+    environment_apply(job->environments, job->environment, lane->vars);
+    for (int f = 0; f < lane->row.field_count; f++) {
+        const data_field_t *field = &lane->row.fields[f];
+        int slot = template_vars_slot(lane->vars, field->name, field->name_length);
+        template_vars_bind(lane->vars, slot, field->value, field->value_length);
+    }
+
+    run_options_t options = *job->options;
+    options.on_result = print_row_result;
+    options.user_data = lane;
+    collection_run_start(lane->run, engine, &options);
+    lane->busy = 1;
+}
+
+// Point the cursor at the next unclaimed chunk; 0 once all are claimed
+static int claim_chunk(data_job_t *job, data_cursor_t *cursor) {
+    uint64_t chunk = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED);
+    if (chunk >= job->chunk_count) return 0;
+    data_file_chunk(job->data, job->chunk_size, chunk, cursor);
+    return 1;
+}
+
+// Next row from the worker's chunk, or from the next one it claims when that
+// runs dry. Returns 1 for a row, 0 once every chunk is claimed and read.
+static int next_data_row(data_job_t *job, data_cursor_t *cursor, int *more, data_row_t *row,
+                         iteration_tally_t *tally) {
+    while (*more) {
+        int status = data_file_next(job->data, cursor, row);
+        if (status > 0) return 1;
+        if (status < 0) {
+            tally->malformed_rows++;
+            if (!job->quiet) printf("row@%-10llu malformed, skipped\n", (unsigned long long)row->offset);
+            continue;
+        }
+        // Rows of it still in flight fault their pages back in if they need them
+        data_file_release(job->data, cursor);
+        *more = claim_chunk(job, cursor);
+    }
+    return 0;
+}
+
+// A row per idle lane, all on the worker's engine, from chunks claimed until
+// none is left. Lanes keep running across chunks rather than waiting at each
+// chunk's end for its slowest row.
+static void run_data_worker(void *arg, uint64_t index, int worker) {
+    (void)index;
+    data_job_t *job = arg;
+    data_worker_t *state = &job->workers[worker];
+    iteration_tally_t *tally = &job->tallies[worker];
+    if (state->started == 0) {
+        state->started = start_data_worker(job, state) == 0 ? 1 : -1;
+        if (state->started < 0) printf("Worker %d failed to start; its rows fail\n", worker);
+    }
+
+    data_cursor_t cursor;
+    int more = claim_chunk(job, &cursor);
+    if (state->started < 0) {
+        data_row_t row = {0};
+        while (next_data_row(job, &cursor, &more, &row, tally)) {
+            tally->iterations++;
+            tally->failed_iterations++;
+            tally->counts[RUN_FAILED] += (uint64_t)job->count;
+        }
+        data_row_free(&row);
+        return;
+    }
+
+    int active = 0;
+    while (more || active > 0) {
+        for (int l = 0; l < state->lane_count && more; l++) {
+            data_lane_t *lane = &state->lanes[l];
+            if (lane->busy || !next_data_row(job, &cursor, &more, &lane->row, tally)) continue;
+            tally->iterations++;
+            start_row(lane, state->engine);
+            active++;
+        }
+        if (active == 0) break;
+
+        http_engine_run(state->engine, 100);
+        for (int l = 0; l < state->lane_count; l++) {
+            data_lane_t *lane = &state->lanes[l];
+            if (lane->busy && collection_run_pump(lane->run) == 0) {
+                tally_run(tally, lane->run, job->count);
+                lane->busy = 0;
+                active--;
+            }
+        }
+    }
+}
+
+static int run_data(const http_request_t *requests, int count, const environment_list_t *environments,
+                    int environment, const run_options_t *options, int quiet, const char *path, int threads) {
+    data_file_t *data = data_file_open(path);
+    if (!data) {
+        printf("Failed to read %s\n", path);
+        return 1;
+    }
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        printf("Failed to start the HTTP engine\n");
+        data_file_close(data);
+        return 1;
+    }
+    work_scheduler_t *scheduler = work_scheduler_create(threads);
+    int workers = work_scheduler_workers(scheduler);
+    iteration_tally_t *tallies = create_tallies(workers);
+    data_worker_t *states = calloc((size_t)(workers > 0 ? workers : 1), sizeof(data_worker_t));
+    iteration_tally_t total = {0};
+    int status = 1;
+    if (!scheduler || !tallies || !states ||
+        hdr_histogram_init(&total.latency, LATENCY_PRECISION, LATENCY_RANGE, NULL) != 0) {
+        printf("Out of memory\n");
+        goto done;
+    }
+
+    // Enough chunks to even out the workers, big enough that claiming them costs nothing
+    uint64_t chunk_size = data_file_size(data) / ((uint64_t)(workers > 0 ? workers : 1) * DATA_CHUNKS_PER_WORKER);
+    if (chunk_size < DATA_MIN_CHUNK) chunk_size = DATA_MIN_CHUNK;
+    if (chunk_size > DATA_CHUNK_SIZE) chunk_size = DATA_CHUNK_SIZE;
+
+    data_job_t job = { requests, count, environments, environment, options, quiet, data, chunk_size,
+                       data_file_chunk_count(data, chunk_size), 0, tallies, states };
+    uint64_t start_ns = now_ns();
+    int failed_to_queue = work_scheduler_for(scheduler, (uint64_t)(workers > 0 ? workers : 1), 1,
+                                             run_data_worker, &job);
+    double seconds = (double)(now_ns() - start_ns) / 1e9;
+
+    sum_tallies(&total, tallies, workers);
+    uint64_t sent = total.counts[RUN_PASSED] + total.counts[RUN_FAILED];
+    printf("Ran %llu rows of %d requests from %s (%.1f MB) in %.3f s (%.1f rows, %.1f requests per second, "
+           "sum of latencies %.3f s): %llu failed, %llu malformed\n",
+           (unsigned long long)total.iterations, count, path, (double)data_file_size(data) / (1024 * 1024),
+           seconds, seconds > 0 ? (double)total.iterations / seconds : 0.0,
+           seconds > 0 ? (double)sent / seconds : 0.0, (double)total.latency_ns / 1e9,
+           (unsigned long long)total.failed_iterations, (unsigned long long)total.malformed_rows);
+    printf("Requests: %llu passed, %llu failed, %llu skipped\n",
+           (unsigned long long)total.counts[RUN_PASSED], (unsigned long long)total.counts[RUN_FAILED],
+           (unsigned long long)total.counts[RUN_SKIPPED]);
+    print_latency(&total.latency);
+    print_workers(scheduler, tallies, workers, "rows");
+
+    status = failed_to_queue == 0 && total.failed_iterations == 0 && total.malformed_rows == 0 ? 0 : 1;
+
+done:
+    work_scheduler_destroy(scheduler);
+    for (int w = 0; states && w < workers; w++) destroy_data_worker(&states[w]);
+    free(states);
+    destroy_tallies(tallies, workers);
+    hdr_histogram_free(&total.latency);
+    curl_global_cleanup();
+    data_file_close(data);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    const char *environment_name = NULL;
+    const char *environments_path = "data/environments.toml";
+    const char *files[MAX_RUN_FILES];
+    int file_count = 0;
+    run_options_t options = { .concurrency = 16, .timeout_ms = 10000 };
+    run_output_t output = {0};
+    raw_load_options_t raw_options = {0};
+    int raw = 0, processes = 0;
+    uint64_t iterations = 0;
+    const char *data_path = NULL;
+    char routes[MAX_ROUTES_LENGTH] = "";
+    http_retry_policy_t policy = http_retry_policy_default();
+    policy.max_attempts = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            output.quiet = 1;
+        } else if (strcmp(arg, "--raw") == 0) {
+            raw = 1;
+        } else if (strncmp(arg, "--", 2) != 0) {
+            if (file_count == MAX_RUN_FILES) {
+                printf("Too many files (max %d)\n", MAX_RUN_FILES);
+                return 1;
+            }
+            files[file_count++] = arg;
+        } else if (!value) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            i++;
+            if (strcmp(arg, "--env") == 0) {
+                environment_name = value;
+            } else if (strcmp(arg, "--environments") == 0) {
+                environments_path = value;
+            } else if (strcmp(arg, "--concurrency") == 0) {
+                options.concurrency = atoi(value);
+            } else if (strcmp(arg, "--timeout") == 0) {
+                options.timeout_ms = atol(value);
+            } else if (strcmp(arg, "--retries") == 0) {
+                policy.max_attempts = atoi(value) + 1;
+                options.retry = &policy;
+            } else if (strcmp(arg, "--hedge") == 0) {
+                policy.hedge_after_ms = strcmp(value, "p95") == 0 ? HTTP_HEDGE_P95 : atol(value);
+                if (policy.max_attempts < 2) policy.max_attempts = 2;
+                options.retry = &policy;
+            } else if (strcmp(arg, "--rate") == 0) {
+                options.rate = atof(value);
+            } else if (strcmp(arg, "--host-rate") == 0) {
+                options.host_rate = atof(value);
+            } else if (strcmp(arg, "--host-connections") == 0) {
+                options.host_connections = atoi(value);
+            } else if (strcmp(arg, "--warmup") == 0) {
+                options.warmup = atoi(value);
+            } else if (strcmp(arg, "--connections") == 0) {
+                raw_options.connections = atoi(value);
+            } else if (strcmp(arg, "--pipeline") == 0) {
+                raw_options.pipeline = atoi(value);
+            } else if (strcmp(arg, "--threads") == 0) {
+                raw_options.threads = atoi(value);
+            } else if (strcmp(arg, "--processes") == 0) {
+                processes = atoi(value);
+            } else if (strcmp(arg, "--iterations") == 0) {
+                iterations = strtoull(value, NULL, 10);
+            } else if (strcmp(arg, "--data") == 0) {
+                data_path = value;
+            } else if (strcmp(arg, "--requests") == 0) {
+                raw_options.requests = strtoull(value, NULL, 10);
+            } else if (strcmp(arg, "--duration") == 0) {
+                raw_options.duration_ms = atol(value);
+            } else if (strcmp(arg, "--max-streams") == 0) {
+                options.max_streams = atoi(value) > 0 ? atoi(value) : HTTP_MULTIPLEX_OFF;
+            } else if (strcmp(arg, "--unix-socket") == 0 || strcmp(arg, "--resolve") == 0 ||
+                       strcmp(arg, "--http") == 0) {
+                // Same directives as in a request's header block
+                const char *directive = strcmp(arg, "--unix-socket") == 0 ? ROUTE_UNIX_SOCKET_DIRECTIVE :
+                                        strcmp(arg, "--resolve") == 0 ? ROUTE_RESOLVE_DIRECTIVE :
+                                        ROUTE_HTTP_VERSION_DIRECTIVE;
+                size_t used = strlen(routes);
+                int written = snprintf(routes + used, sizeof(routes) - used, "%s %s\n", directive, value);
+                if (written < 0 || (size_t)written >= sizeof(routes) - used) {
+                    printf("Too many routes\n");
+                    return 1;
+                }
+                options.routes = routes;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    if (file_count == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // All files form one run, in the order given
+    http_request_t *requests = malloc((size_t)file_count * sizeof(((http_collection_t *)0)->requests));
+    http_collection_t *collection = malloc(sizeof(http_collection_t));
+    if (!requests || !collection) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    int count = 0;
+    for (int f = 0; f < file_count; f++) {
+        if (http_parse_file(files[f], collection) != 0) {
+            printf("Failed to read %s\n", files[f]);
+            return 1;
+        }
+        memcpy(&requests[count], collection->requests, (size_t)collection->count * sizeof(http_request_t));
+        count += collection->count;
+    }
+    free(collection);
+
+    environment_list_t *environments = malloc(sizeof(environment_list_t));
+    template_vars_t *vars = template_vars_create();
+    if (!environments || !vars) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    if (environment_load(environments_path, environments) != 0) {
+        return 1;
+    }
+    int environment = -1;
+    if (environment_name) {
+        environment = environment_find(environments, environment_name);
+        if (environment < 0) {
+            printf("Unknown environment: %s\n", environment_name);
+            return 1;
+        }
+    }
+    environment_apply(environments, environment, vars);
+
+    if (raw) {
+        raw_options.timeout_ms = options.timeout_ms;
+        int status = run_raw(requests, count, vars, options.routes, options.timeout_ms, &raw_options,
+                             processes);
+        template_vars_destroy(vars);
+        free(environments);
+        free(requests);
+        return status;
+    }
+
+    if (data_path) {
+        int status = run_data(requests, count, environments, environment, &options, output.quiet,
+                              data_path, raw_options.threads);
+        template_vars_destroy(vars);
+        free(environments);
+        free(requests);
+        return status;
+    }
+
+    if (iterations > 0) {
+        int status = run_iterations(requests, count, environments, environment, &options, output.quiet,
+                                    iterations, raw_options.threads);
+        template_vars_destroy(vars);
+        free(environments);
+        free(requests);
+        return status;
+    }
+
+    collection_run_t *run = collection_run_create(requests, count, vars);
+    if (!run) {
+        printf("Failed to plan the run\n");
+        return 1;
+    }
+
+    output.requests = requests;
+    options.on_result = print_result;
+    options.user_data = &output;
+    int not_passed = collection_run_execute(run, &options);
+    if (not_passed < 0) {
+        printf("Failed to start the HTTP engine\n");
+        return 1;
+    }
+
+    if (options.warmup > 0) {
+        printf("Warmed up %d connections\n", collection_run_warm_connections(run));
+    }
+
+    int counts[RUN_SKIPPED + 1] = {0};
+    uint64_t total_ns = 0, body_bytes = 0, wire_bytes = 0;
+    hdr_histogram_t latency;
+    if (hdr_histogram_init(&latency, LATENCY_PRECISION, LATENCY_RANGE, NULL) != 0) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        const run_result_t *result = collection_run_result(run, i);
+        counts[result->state]++;
+        total_ns += result->end_ns - result->start_ns;
+        if (result->state != RUN_SKIPPED) hdr_histogram_record(&latency, (result->end_ns - result->start_ns) / 1000);
+        body_bytes += result->body_size;
+        wire_bytes += result->wire_size;
+    }
+    printf("Ran %d requests in %.3f s (critical path %.3f s, sum of latencies %.3f s): "
+           "%d passed, %d failed, %d skipped\n",
+           count, (double)collection_run_elapsed_ns(run) / 1e9,
+           (double)collection_run_critical_path_ns(run) / 1e9, (double)total_ns / 1e9,
+           counts[RUN_PASSED], counts[RUN_FAILED], counts[RUN_SKIPPED]);
+    printf("Received %llu body bytes, %llu on the wire\n",
+           (unsigned long long)body_bytes, (unsigned long long)wire_bytes);
+    print_latency(&latency);
+    hdr_histogram_free(&latency);
+    print_connections(run, output.quiet);
+
+    collection_run_destroy(run);
+    template_vars_destroy(vars);
+    free(environments);
+    free(requests);
+    return not_passed == 0 ? 0 : 1;
+}
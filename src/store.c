@@ -7,6 +7,7 @@
 
 #include "store.h"
 #include "toml.h"
+#include "trace.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -24,9 +25,18 @@ static app_state_t app_state = {
     .headers = "Content-Type: application/json\nAuthorization: Bearer your-token",
     .body = "{\n  \"message\": \"Hello from API Kit!\",\n  \"data\": {\n    \"key\": \"value\"\n  }\n}",
     .response = "Response will appear here...",
+    .response_view = NULL,
     .method_selected = 0,
     .request_in_progress = 0,
     .last_status_code = 0,
+    .compiled_request = NULL,
+    .active_environment = -1,
+    .variables = NULL,
+    .response_search_text = "",
+    .response_search_mode = SEARCH_MODE_IGNORE_CASE,
+    .response_search = NULL,
+    .response_search_current = -1,
+    .response_search_scroll = 0,
     .show_sidebar = 1,
     .show_settings_page = 0,
     .search_text = "",
@@ -61,7 +71,11 @@ static app_state_t app_state = {
         .keybindings_enabled = 1,
         .ctrl_b_enabled = 1,
         .ctrl_f_enabled = 1,
-        .delete_key_enabled = 1
+        .delete_key_enabled = 1,
+        .trace_path = "",
+        .environment = "",
+        .cache_enabled = 1,
+        .cache_memory_mb = 32
     }
 };
 
@@ -255,7 +269,14 @@ void store_ensure_default_workspace(void) {
  * HISTORY MANAGEMENT
  * ============================================================================ */
 
-void store_add_to_history(const char* method, const char* url, long status_code) {
+void store_add_to_history(const char* method, const char* url, long status_code, uint64_t latency_us) {
+    if (app_state.latency_trends) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        latency_trends_record(app_state.latency_trends, method, url, latency_us, status_code,
+                              (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+    }
+
     if (app_state.history_count < MAX_HISTORY_ITEMS) {
         history_item_t* item = &app_state.history[app_state.history_count];
         strncpy(item->method, method, sizeof(item->method) - 1);
@@ -270,8 +291,224 @@ void store_add_to_history(const char* method, const char* url, long status_code)
         strftime(item->timestamp, sizeof(item->timestamp), "%H:%M:%S", tm_info);
         
         app_state.history_count++;
-        store_save_data();
     }
+    store_save_data();
+}
+
+const latency_trend_t* store_latency_trend(const char* method, const char* url) {
+    return latency_trends_find(app_state.latency_trends, method, url);
+}
+
+/* ============================================================================
+ * REQUEST COMPILATION
+ * ============================================================================ */
+
+// Templates of the editor text, kept until the text is edited
+static struct {
+    int compiled;
+    uint64_t source_hash;
+    template_t *url;
+    template_t *headers;
+    template_t *body;
+    template_buffer_t url_out;
+    template_buffer_t headers_out;
+    template_buffer_t body_out;
+    capture_list_t captures;
+    int workspace;                // Workspace whose network settings the compiled request has
+} request_templates;
+
+static void free_request_templates(void) {
+    template_destroy(request_templates.url);
+    template_destroy(request_templates.headers);
+    template_destroy(request_templates.body);
+    request_templates.url = NULL;
+    request_templates.headers = NULL;
+    request_templates.body = NULL;
+    request_templates.captures.count = 0;
+    request_templates.compiled = 0;
+}
+
+static int ensure_variables(void) {
+    if (!app_state.variables) {
+        app_state.variables = template_vars_create();
+    }
+    return app_state.variables ? 0 : -1;
+}
+
+// Routing directives from the network settings, the active workspace's
+// before the defaults so they take precedence (see compiled_request_add_routes)
+static void network_routes(char* out, size_t size) {
+    const char* workspace = app_state.workspace_count > 0 ?
+        app_state.workspaces[app_state.active_workspace].name : "";
+    size_t used = 0;
+    out[0] = '\0';
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < app_state.settings.network_count; i++) {
+            const network_settings_t* network = &app_state.settings.network[i];
+            int matches = pass == 0 ? network->workspace[0] && strcmp(network->workspace, workspace) == 0
+                                    : network->workspace[0] == '\0';
+            if (!matches) continue;
+
+            if (network->unix_socket[0] && used < size) {
+                used += snprintf(out + used, size - used, "%s %s\n", ROUTE_UNIX_SOCKET_DIRECTIVE,
+                                 network->unix_socket);
+            }
+            if (network->http_version[0] && used < size) {
+                used += snprintf(out + used, size - used, "%s %s\n", ROUTE_HTTP_VERSION_DIRECTIVE,
+                                 network->http_version);
+            }
+            const char* p = network->resolve;
+            while (*p && used < size) {
+                size_t length = strcspn(p, "\n");
+                if (length > 0) {
+                    used += snprintf(out + used, size - used, "%s %.*s\n", ROUTE_RESOLVE_DIRECTIVE,
+                                     (int)length, p);
+                }
+                p += length;
+                if (*p) p++;
+            }
+        }
+    }
+    if (used >= size) out[size - 1] = '\0';
+}
+
+compiled_request_t* store_compiled_request(http_method_t method) {
+    if (ensure_variables() != 0) return NULL;
+
+    // Only POST/PUT/PATCH send the editor body
+    const char* body = NULL;
+    if (method == HTTP_METHOD_POST || method == HTTP_METHOD_PUT || method == HTTP_METHOD_PATCH) {
+        body = app_state.body;
+    }
+
+    uint64_t source_hash = compiled_request_hash(method, app_state.url, app_state.headers, body);
+    if (!request_templates.compiled || request_templates.source_hash != source_hash) {
+        free_request_templates();
+        request_templates.url = template_compile(app_state.url, app_state.variables);
+        request_templates.headers = template_compile(app_state.headers, app_state.variables);
+        request_templates.body = template_compile(body, app_state.variables);
+        if (!request_templates.url || !request_templates.headers || !request_templates.body) {
+            free_request_templates();
+            return NULL;
+        }
+        capture_parse(app_state.headers, &request_templates.captures);
+        request_templates.source_hash = source_hash;
+        request_templates.compiled = 1;
+    }
+
+    if (template_render(request_templates.url, app_state.variables, &request_templates.url_out) < 0 ||
+        template_render(request_templates.headers, app_state.variables, &request_templates.headers_out) < 0 ||
+        template_render(request_templates.body, app_state.variables, &request_templates.body_out) < 0) {
+        return NULL;
+    }
+
+    const char* url = request_templates.url_out.data;
+    const char* headers = request_templates.headers_out.data;
+    const char* rendered_body = request_templates.body_out.data;
+    uint64_t hash = compiled_request_hash(method, url, headers, rendered_body);
+    if (app_state.compiled_request && app_state.compiled_request->source_hash == hash &&
+        request_templates.workspace == app_state.active_workspace) {
+        return app_state.compiled_request;
+    }
+
+    compiled_request_destroy(app_state.compiled_request);
+    app_state.compiled_request = compiled_request_create(method, url, headers, rendered_body, 10000);
+    if (app_state.compiled_request && app_state.settings.network_count > 0) {
+        char routes[2048];
+        network_routes(routes, sizeof(routes));
+        if (compiled_request_add_routes(app_state.compiled_request, routes) != 0) {
+            compiled_request_destroy(app_state.compiled_request);
+            app_state.compiled_request = NULL;
+        }
+    }
+    request_templates.workspace = app_state.active_workspace;
+    return app_state.compiled_request;
+}
+
+int store_apply_captures(const http_response_t* response) {
+    if (!request_templates.compiled || request_templates.captures.count == 0) return 0;
+    if (ensure_variables() != 0) return 0;
+
+    // Captured values live in the variable table until the environment changes
+    return capture_apply(&request_templates.captures, response, app_state.variables);
+}
+
+// Render one field of a workspace request; NULL if it cannot be
+static const char* render_field(const char* text, template_buffer_t* out) {
+    template_t* field = template_compile(text, app_state.variables);
+    int rendered = field ? template_render(field, app_state.variables, out) : -1;
+    template_destroy(field);
+    return rendered >= 0 ? out->data : NULL;
+}
+
+int store_workspace_requests(compiled_request_t** requests, int max) {
+    if (app_state.workspace_count == 0 || ensure_variables() != 0) return 0;
+
+    char routes[2048] = "";
+    if (app_state.settings.network_count > 0) network_routes(routes, sizeof(routes));
+
+    const workspace_t* workspace = &app_state.workspaces[app_state.active_workspace];
+    template_buffer_t url = {0}, headers = {0};
+    int count = 0;
+    for (int c = 0; c < workspace->collection_count; c++) {
+        const collection_t* collection = &workspace->collections[c];
+        for (int r = 0; r < collection->request_count && count < max; r++) {
+            const request_item_t* item = &collection->requests[r];
+            if (!render_field(item->url, &url) || !render_field(item->headers, &headers)) continue;
+
+            compiled_request_t* request = compiled_request_create(http_method_from_name(item->method),
+                                                                  url.data, headers.data, NULL, 0);
+            if (request && compiled_request_add_routes(request, routes) != 0) {
+                compiled_request_destroy(request);
+                request = NULL;
+            }
+            if (request) requests[count++] = request;
+        }
+    }
+    template_buffer_free(&url);
+    template_buffer_free(&headers);
+    return count;
+}
+
+void store_free_request_cache(void) {
+    free_request_templates();
+    template_buffer_free(&request_templates.url_out);
+    template_buffer_free(&request_templates.headers_out);
+    template_buffer_free(&request_templates.body_out);
+    compiled_request_destroy(app_state.compiled_request);
+    app_state.compiled_request = NULL;
+    template_vars_destroy(app_state.variables);
+    app_state.variables = NULL;
+}
+
+/* ============================================================================
+ * ENVIRONMENTS
+ * ============================================================================ */
+
+void store_load_environments(void) {
+    char path[768];
+    snprintf(path, sizeof(path), "%s/environments.toml", app_state.settings.data_folder_path);
+    environment_load(path, &app_state.environments);
+
+    app_state.active_environment = environment_find(&app_state.environments, app_state.settings.environment);
+    if (ensure_variables() == 0) {
+        environment_apply(&app_state.environments, app_state.active_environment, app_state.variables);
+    }
+}
+
+void store_select_environment(int index) {
+    if (index < 0 || index >= app_state.environments.count) index = -1;
+    if (index == app_state.active_environment) return;
+
+    app_state.active_environment = index;
+    snprintf(app_state.settings.environment, sizeof(app_state.settings.environment), "%s",
+             index >= 0 ? app_state.environments.items[index].name : "");
+
+    // Slots survive the switch, so the compiled templates are only re-rendered
+    if (ensure_variables() == 0) {
+        environment_apply(&app_state.environments, index, app_state.variables);
+    }
+    store_save_settings();
 }
 
 /* ============================================================================
@@ -410,7 +647,69 @@ void store_delete_selected_item(void) {
  * SETTINGS PERSISTENCE
  * ============================================================================ */
 
+static void save_network_settings(FILE* file, const network_settings_t* network) {
+    if (network->workspace[0]) {
+        fprintf(file, "\n[network.workspaces.\"%s\"]\n", network->workspace);
+    } else {
+        fprintf(file, "\n[network]\n");
+    }
+    if (network->unix_socket[0]) {
+        fprintf(file, "unix_socket = \"%s\"\n", network->unix_socket);
+    }
+    if (network->http_version[0]) {
+        fprintf(file, "http_version = \"%s\"\n", network->http_version);
+    }
+    fprintf(file, "resolve = [");
+    const char* p = network->resolve;
+    int first = 1;
+    while (*p) {
+        size_t length = strcspn(p, "\n");
+        if (length > 0) {
+            fprintf(file, "%s\"%.*s\"", first ? "" : ", ", (int)length, p);
+            first = 0;
+        }
+        p += length;
+        if (*p) p++;
+    }
+    fprintf(file, "]\n");
+}
+
+// Read one [network] table into the next free profile
+static void load_network_settings(const toml_table_t* table, const char* workspace) {
+    if (app_state.settings.network_count >= MAX_NETWORK_PROFILES) return;
+    network_settings_t* network = &app_state.settings.network[app_state.settings.network_count++];
+    memset(network, 0, sizeof(*network));
+    snprintf(network->workspace, sizeof(network->workspace), "%s", workspace);
+
+    toml_datum_t unix_socket = toml_string_in(table, "unix_socket");
+    if (unix_socket.ok) {
+        snprintf(network->unix_socket, sizeof(network->unix_socket), "%s", unix_socket.u.s);
+        free(unix_socket.u.s);
+    }
+
+    toml_datum_t http_version = toml_string_in(table, "http_version");
+    if (http_version.ok) {
+        snprintf(network->http_version, sizeof(network->http_version), "%s", http_version.u.s);
+        free(http_version.u.s);
+    }
+
+    toml_array_t* resolve = toml_array_in(table, "resolve");
+    size_t used = 0;
+    for (int i = 0; resolve && i < toml_array_nelem(resolve); i++) {
+        toml_datum_t entry = toml_string_at(resolve, i);
+        if (!entry.ok) continue;
+        int written = snprintf(network->resolve + used, sizeof(network->resolve) - used, "%s\n", entry.u.s);
+        free(entry.u.s);
+        if (written < 0 || (size_t)written >= sizeof(network->resolve) - used) {
+            network->resolve[used] = '\0';
+            break;
+        }
+        used += (size_t)written;
+    }
+}
+
 void store_save_settings(void) {
+    uint64_t trace_start_ns = trace_begin();
     FILE *file = fopen("config.toml", "w");
     if (file) {
         fprintf(file, "# API Kit Configuration\n\n");
@@ -421,9 +720,20 @@ void store_save_settings(void) {
         fprintf(file, "enabled = %s\n", app_state.settings.keybindings_enabled ? "true" : "false");
         fprintf(file, "ctrl_b_enabled = %s\n", app_state.settings.ctrl_b_enabled ? "true" : "false");
         fprintf(file, "ctrl_f_enabled = %s\n", app_state.settings.ctrl_f_enabled ? "true" : "false");
-        fprintf(file, "delete_key_enabled = %s\n", app_state.settings.delete_key_enabled ? "true" : "false");
+        fprintf(file, "delete_key_enabled = %s\n\n", app_state.settings.delete_key_enabled ? "true" : "false");
+        fprintf(file, "[debug]\n");
+        fprintf(file, "trace_file = \"%s\"\n\n", app_state.settings.trace_path);
+        fprintf(file, "[environment]\n");
+        fprintf(file, "active = \"%s\"\n\n", app_state.settings.environment);
+        fprintf(file, "[cache]\n");
+        fprintf(file, "enabled = %s\n", app_state.settings.cache_enabled ? "true" : "false");
+        fprintf(file, "memory_mb = %d\n", app_state.settings.cache_memory_mb);
+        for (int i = 0; i < app_state.settings.network_count; i++) {
+            save_network_settings(file, &app_state.settings.network[i]);
+        }
         fclose(file);
     }
+    trace_end("store_save_settings", "store", trace_start_ns);
 }
 
 void store_load_settings(void) {
@@ -479,6 +789,54 @@ void store_load_settings(void) {
         }
     }
     
+    // Parse [debug] section
+    toml_table_t *debug = toml_table_in(config, "debug");
+    if (debug) {
+        toml_datum_t trace_file = toml_string_in(debug, "trace_file");
+        if (trace_file.ok) {
+            strncpy(app_state.settings.trace_path, trace_file.u.s, sizeof(app_state.settings.trace_path) - 1);
+            app_state.settings.trace_path[sizeof(app_state.settings.trace_path) - 1] = '\0';
+            free(trace_file.u.s);
+        }
+    }
+
+    // Parse [environment] section
+    toml_table_t *environment = toml_table_in(config, "environment");
+    if (environment) {
+        toml_datum_t active = toml_string_in(environment, "active");
+        if (active.ok) {
+            strncpy(app_state.settings.environment, active.u.s, sizeof(app_state.settings.environment) - 1);
+            app_state.settings.environment[sizeof(app_state.settings.environment) - 1] = '\0';
+            free(active.u.s);
+        }
+    }
+
+    // Parse [cache] section
+    toml_table_t *cache = toml_table_in(config, "cache");
+    if (cache) {
+        toml_datum_t enabled = toml_bool_in(cache, "enabled");
+        if (enabled.ok) {
+            app_state.settings.cache_enabled = enabled.u.b;
+        }
+        toml_datum_t memory_mb = toml_int_in(cache, "memory_mb");
+        if (memory_mb.ok && memory_mb.u.i >= 0) {
+            app_state.settings.cache_memory_mb = (int)memory_mb.u.i;
+        }
+    }
+
+    // Parse [network] and its [network.workspaces."Name"] tables
+    app_state.settings.network_count = 0;
+    toml_table_t *network = toml_table_in(config, "network");
+    if (network) {
+        load_network_settings(network, "");
+        toml_table_t *workspaces = toml_table_in(network, "workspaces");
+        const char *key;
+        for (int i = 0; workspaces && (key = toml_key_in(workspaces, i)) != NULL; i++) {
+            toml_table_t *workspace = toml_table_in(workspaces, key);
+            if (workspace) load_network_settings(workspace, key);
+        }
+    }
+    
     toml_free(config);
 }
 
@@ -487,6 +845,7 @@ void store_load_settings(void) {
  * ============================================================================ */
 
 void store_save_data(void) {
+    uint64_t trace_start_ns = trace_begin();
     store_ensure_data_directory();
     
     // Save history in HTTP format
@@ -526,6 +885,10 @@ void store_save_data(void) {
     char history_path[512];
     snprintf(history_path, sizeof(history_path), "%s/history.http", app_state.settings.data_folder_path);
     http_save_file(history_path, &history_collection);
+
+    char trends_path[sizeof(app_state.settings.data_folder_path) + sizeof("/latency_trends.txt")];
+    snprintf(trends_path, sizeof(trends_path), "%s/latency_trends.txt", app_state.settings.data_folder_path);
+    latency_trends_save(app_state.latency_trends, trends_path);
     
     // Save each workspace to its own file
     for (int w = 0; w < app_state.workspace_count; w++) {
@@ -564,9 +927,12 @@ void store_save_data(void) {
         // Save workspace to its file
         http_save_file(workspace->filename, &workspace_collection);
     }
+
+    trace_end("store_save_data", "store", trace_start_ns);
 }
 
 void store_load_data(void) {
+    uint64_t trace_start_ns = trace_begin();
     store_ensure_data_directory();
     
     // Load history from HTTP format
@@ -616,6 +982,13 @@ void store_load_data(void) {
         }
     }
     
+    char trends_path[sizeof(app_state.settings.data_folder_path) + sizeof("/latency_trends.txt")];
+    snprintf(trends_path, sizeof(trends_path), "%s/latency_trends.txt", app_state.settings.data_folder_path);
+    latency_trends_destroy(app_state.latency_trends);
+    app_state.latency_trends = latency_trends_load(trends_path);
+
     // Scan and load all workspaces from data directory
     store_scan_and_load_workspaces();
+
+    trace_end("store_load_data", "store", trace_start_ns);
 }
@@ -0,0 +1,337 @@
+/* ============================================================================
+ * API Kit - Request Templates Implementation
+ * ============================================================================ */
+
+#include "template.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * INTERNAL TYPES
+ * ============================================================================ */
+
+typedef struct {
+    char *name;
+    const char *value;      // NULL = unset
+    size_t value_length;
+    char *owned;            // Copy made by template_vars_set, if any
+} template_var_t;
+
+struct template_vars {
+    template_var_t *items;
+    int count;
+    int capacity;
+};
+
+// A literal span of the source, or a placeholder when slot >= 0; a
+// placeholder's span is its "{{...}}" text, rendered when the slot is unset
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+    int slot;
+} template_segment_t;
+
+struct template {
+    char *source;
+    template_segment_t *segments;
+    int segment_count;
+    int placeholder_count;
+};
+
+/* ============================================================================
+ * VARIABLES
+ * ============================================================================ */
+
+template_vars_t *template_vars_create(void) {
+    return calloc(1, sizeof(template_vars_t));
+}
+
+void template_vars_destroy(template_vars_t *vars) {
+    if (!vars) return;
+
+    for (int i = 0; i < vars->count; i++) {
+        free(vars->items[i].name);
+        free(vars->items[i].owned);
+    }
+    free(vars->items);
+    free(vars);
+}
+
+static int find_slot(const template_vars_t *vars, const char *name, size_t length) {
+    for (int i = 0; i < vars->count; i++) {
+        const char *item = vars->items[i].name;
+        if (strncmp(item, name, length) == 0 && item[length] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int template_vars_slot(template_vars_t *vars, const char *name, size_t length) {
+    if (!vars || !name) return -1;
+
+    int slot = find_slot(vars, name, length);
+    if (slot >= 0) return slot;
+
+    if (vars->count == vars->capacity) {
+        int capacity = vars->capacity ? vars->capacity * 2 : 16;
+        template_var_t *items = realloc(vars->items, (size_t)capacity * sizeof(template_var_t));
+        if (!items) return -1;
+        vars->items = items;
+        vars->capacity = capacity;
+    }
+
+    char *copy = malloc(length + 1);
+    if (!copy) return -1;
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+
+    template_var_t *var = &vars->items[vars->count];
+    memset(var, 0, sizeof(*var));
+    var->name = copy;
+    return vars->count++;
+}
+
+int template_vars_set(template_vars_t *vars, const char *name, const char *value) {
+    if (!vars || !name) return -1;
+
+    int slot = template_vars_slot(vars, name, strlen(name));
+    if (slot < 0) return -1;
+
+    template_var_t *var = &vars->items[slot];
+    char *owned = NULL;
+    size_t length = 0;
+    if (value) {
+        length = strlen(value);
+        owned = malloc(length + 1);
+        if (!owned) return -1;
+        memcpy(owned, value, length + 1);
+    }
+
+    free(var->owned);
+    var->owned = owned;
+    var->value = owned;
+    var->value_length = length;
+    return 0;
+}
+
+void template_vars_bind(template_vars_t *vars, int slot, const char *value, size_t length) {
+    if (!vars || slot < 0 || slot >= vars->count) return;
+
+    template_var_t *var = &vars->items[slot];
+    var->value = value;
+    var->value_length = value ? length : 0;
+}
+
+void template_vars_clear(template_vars_t *vars) {
+    if (!vars) return;
+
+    for (int i = 0; i < vars->count; i++) {
+        free(vars->items[i].owned);
+        vars->items[i].owned = NULL;
+        vars->items[i].value = NULL;
+        vars->items[i].value_length = 0;
+    }
+}
+
+int template_vars_count(const template_vars_t *vars) {
+    return vars ? vars->count : 0;
+}
+
+const char *template_vars_get(const template_vars_t *vars, const char *name) {
+    if (!vars || !name) return NULL;
+
+    int slot = find_slot(vars, name, strlen(name));
+    return slot >= 0 ? vars->items[slot].value : NULL;
+}
+
+/* ============================================================================
+ * COMPILATION
+ * ============================================================================ */
+
+static int is_name_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '-' || c == '.' || c == '$';
+}
+
+// Parse "{{ name }}" at p; returns the placeholder length or 0 if it is not one
+static size_t parse_placeholder(const char *p, const char **name, size_t *name_length) {
+    const char *q = p + 2;
+    while (*q == ' ' || *q == '\t') q++;
+
+    const char *start = q;
+    while (is_name_char(*q)) q++;
+    const char *end = q;
+
+    while (*q == ' ' || *q == '\t') q++;
+    if (end == start || q[0] != '}' || q[1] != '}') return 0;
+
+    *name = start;
+    *name_length = (size_t)(end - start);
+    return (size_t)(q + 2 - p);
+}
+
+static int add_segment(template_t *template, int *capacity, size_t offset, size_t length, int slot) {
+    // Merge adjacent literal spans (left behind by rejected "{{")
+    if (slot < 0 && template->segment_count > 0) {
+        template_segment_t *last = &template->segments[template->segment_count - 1];
+        if (last->slot < 0 && last->offset + last->length == offset) {
+            last->length += (uint32_t)length;
+            return 0;
+        }
+    }
+
+    if (template->segment_count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 8;
+        template_segment_t *segments = realloc(template->segments, (size_t)grown * sizeof(template_segment_t));
+        if (!segments) return -1;
+        template->segments = segments;
+        *capacity = grown;
+    }
+
+    template_segment_t *segment = &template->segments[template->segment_count++];
+    segment->offset = (uint32_t)offset;
+    segment->length = (uint32_t)length;
+    segment->slot = slot;
+    return 0;
+}
+
+template_t *template_compile(const char *text, template_vars_t *vars) {
+    if (!vars) return NULL;
+    if (!text) text = "";
+
+    size_t length = strlen(text);
+    if (length > UINT32_MAX) return NULL;
+
+    template_t *template = calloc(1, sizeof(template_t));
+    if (!template) return NULL;
+
+    template->source = malloc(length + 1);
+    if (!template->source) goto fail;
+    memcpy(template->source, text, length + 1);
+
+    int capacity = 0;
+    size_t literal_start = 0;
+    const char *source = template->source;
+    for (const char *p = strstr(source, "{{"); p; p = strstr(p, "{{")) {
+        const char *name;
+        size_t name_length;
+        size_t placeholder_length = parse_placeholder(p, &name, &name_length);
+        if (placeholder_length == 0) {
+            p++;
+            continue;
+        }
+
+        size_t offset = (size_t)(p - source);
+        if (offset > literal_start &&
+            add_segment(template, &capacity, literal_start, offset - literal_start, -1) != 0) {
+            goto fail;
+        }
+
+        int slot = template_vars_slot(vars, name, name_length);
+        if (slot < 0 || add_segment(template, &capacity, offset, placeholder_length, slot) != 0) {
+            goto fail;
+        }
+        template->placeholder_count++;
+
+        p += placeholder_length;
+        literal_start = (size_t)(p - source);
+    }
+
+    if (length > literal_start &&
+        add_segment(template, &capacity, literal_start, length - literal_start, -1) != 0) {
+        goto fail;
+    }
+
+    return template;
+
+fail:
+    template_destroy(template);
+    return NULL;
+}
+
+void template_destroy(template_t *template) {
+    if (!template) return;
+
+    free(template->segments);
+    free(template->source);
+    free(template);
+}
+
+int template_placeholder_count(const template_t *template) {
+    return template ? template->placeholder_count : 0;
+}
+
+int template_placeholder_slot(const template_t *template, int index) {
+    if (!template || index < 0) return -1;
+
+    for (int i = 0; i < template->segment_count; i++) {
+        if (template->segments[i].slot >= 0 && index-- == 0) {
+            return template->segments[i].slot;
+        }
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * RENDERING
+ * ============================================================================ */
+
+static int buffer_reserve(template_buffer_t *buffer, size_t size) {
+    if (size <= buffer->capacity) return 0;
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < size) capacity *= 2;
+
+    char *data = realloc(buffer->data, capacity);
+    if (!data) return -1;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+int template_render(const template_t *template, const template_vars_t *vars, template_buffer_t *out) {
+    if (!template || !vars || !out) return -1;
+
+    // Size first, so the copy loop never reallocates
+    size_t size = 0;
+    for (int i = 0; i < template->segment_count; i++) {
+        const template_segment_t *segment = &template->segments[i];
+        if (segment->slot >= 0 && vars->items[segment->slot].value) {
+            size += vars->items[segment->slot].value_length;
+        } else {
+            size += segment->length;
+        }
+    }
+    if (buffer_reserve(out, size + 1) != 0) return -1;
+
+    int unset = 0;
+    char *dst = out->data;
+    for (int i = 0; i < template->segment_count; i++) {
+        const template_segment_t *segment = &template->segments[i];
+        if (segment->slot >= 0) {
+            const template_var_t *var = &vars->items[segment->slot];
+            if (var->value) {
+                memcpy(dst, var->value, var->value_length);
+                dst += var->value_length;
+                continue;
+            }
+            unset++;
+        }
+        memcpy(dst, template->source + segment->offset, segment->length);
+        dst += segment->length;
+    }
+    *dst = '\0';
+    out->length = size;
+    return unset;
+}
+
+void template_buffer_free(template_buffer_t *buffer) {
+    if (!buffer) return;
+
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
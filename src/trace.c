@@ -0,0 +1,305 @@
+/* ============================================================================
+ * API Kit - Tracing Implementation
+ *
+ * Each recording thread owns a ring buffer; only that thread writes it, so
+ * recording needs no locks. Every slot carries a sequence number that is
+ * odd while the slot is being written, which lets a dump running on another
+ * thread copy events and discard any that were overwritten mid-copy.
+ *
+ * Buffers are registered on a lock-free list and never freed. When a
+ * thread exits its buffer is released for reuse by the next new thread, so
+ * short-lived workers (one per response) do not grow memory; events carry
+ * their thread id, so the history of a finished thread stays attributed
+ * to it.
+ * ============================================================================ */
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_EVENTS - 1)
+#define MAX_THREAD_NAMES 4096
+
+typedef struct {
+    uint64_t seq;             // 2 * position + 1 while writing, + 2 once complete
+    const char *name;
+    const char *category;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint32_t tid;
+    char phase;               // 'X' complete span, 'i' instant
+} trace_event_t;
+
+typedef struct trace_buffer {
+    trace_event_t events[TRACE_BUFFER_EVENTS];
+    uint64_t head;            // Atomic: events ever written to this buffer
+    int in_use;               // Atomic: owned by a live thread
+    struct trace_buffer *next;
+} trace_buffer_t;
+
+int trace_enabled_flag = 0;
+
+static uint64_t trace_epoch_ns = 0;
+static char trace_path[512];
+static trace_buffer_t *trace_buffers = NULL;   // Atomic list head
+static uint32_t trace_next_tid = 0;
+static const char *thread_names[MAX_THREAD_NAMES];
+
+static __thread trace_buffer_t *tls_buffer = NULL;
+static __thread uint32_t tls_tid = 0;
+
+static pthread_key_t buffer_key;
+static pthread_once_t buffer_key_once = PTHREAD_ONCE_INIT;
+
+static int dump_pipe[2] = {-1, -1};
+static pthread_t dump_thread;
+static struct sigaction previous_sigusr1;
+
+/* ============================================================================
+ * BUFFER OWNERSHIP
+ * ============================================================================ */
+
+static void release_buffer(void *buffer) {
+    __atomic_store_n(&((trace_buffer_t *)buffer)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_buffer_key(void) {
+    pthread_key_create(&buffer_key, release_buffer);
+}
+
+static uint32_t current_tid(void) {
+    if (tls_tid == 0) {
+        tls_tid = __atomic_add_fetch(&trace_next_tid, 1, __ATOMIC_RELAXED);
+    }
+    return tls_tid;
+}
+
+static trace_buffer_t *acquire_buffer(void) {
+    pthread_once(&buffer_key_once, create_buffer_key);
+
+    // Reuse a buffer released by a finished thread
+    trace_buffer_t *buffer = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE);
+    for (; buffer; buffer = buffer->next) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&buffer->in_use, &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (!buffer) {
+        buffer = calloc(1, sizeof(trace_buffer_t));
+        if (!buffer) return NULL;
+        buffer->in_use = 1;
+        buffer->next = __atomic_load_n(&trace_buffers, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&trace_buffers, &buffer->next, buffer, 1,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    pthread_setspecific(buffer_key, buffer);
+    return buffer;
+}
+
+/* ============================================================================
+ * RECORDING
+ * ============================================================================ */
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void record(const char *name, const char *category, uint64_t start_ns, uint64_t duration_ns, char phase) {
+    if (!tls_buffer) {
+        tls_buffer = acquire_buffer();
+        if (!tls_buffer) return;
+    }
+
+    trace_buffer_t *buffer = tls_buffer;
+    uint64_t position = buffer->head;
+    trace_event_t *event = &buffer->events[position & TRACE_BUFFER_MASK];
+
+    __atomic_store_n(&event->seq, 2 * position + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event->name = name;
+    event->category = category;
+    event->start_ns = start_ns;
+    event->duration_ns = duration_ns;
+    event->tid = current_tid();
+    event->phase = phase;
+    __atomic_store_n(&event->seq, 2 * position + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&buffer->head, position + 1, __ATOMIC_RELEASE);
+}
+
+void trace_end(const char *name, const char *category, uint64_t start_ns) {
+    if (start_ns == 0) return;
+    uint64_t now = trace_now_ns();
+    record(name, category, start_ns, now - start_ns, 'X');
+}
+
+void trace_complete(const char *name, const char *category, uint64_t start_ns, uint64_t duration_ns) {
+    if (!trace_is_enabled()) return;
+    record(name, category, start_ns, duration_ns, 'X');
+}
+
+void trace_instant(const char *name, const char *category) {
+    if (!trace_is_enabled()) return;
+    record(name, category, trace_now_ns(), 0, 'i');
+}
+
+void trace_set_thread_name(const char *name) {
+    uint32_t tid = current_tid();
+    if (tid < MAX_THREAD_NAMES) {
+        __atomic_store_n(&thread_names[tid], name, __ATOMIC_RELEASE);
+    }
+}
+
+int trace_is_enabled(void) {
+    return __atomic_load_n(&trace_enabled_flag, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ * EXPORT
+ * ============================================================================ */
+
+// Copy a slot; returns 0 if it does not hold a complete event for position
+static int read_event(trace_event_t *slot, uint64_t position, trace_event_t *out) {
+    uint64_t before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (before != 2 * position + 2) return 0;
+
+    out->name = slot->name;
+    out->category = slot->category;
+    out->start_ns = slot->start_ns;
+    out->duration_ns = slot->duration_ns;
+    out->tid = slot->tid;
+    out->phase = slot->phase;
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == before;
+}
+
+int trace_dump(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) return -1;
+
+    int pid = (int)getpid();
+    uint64_t epoch = trace_epoch_ns;
+    int written = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"apikit\"}}", pid);
+
+    uint32_t tid_count = __atomic_load_n(&trace_next_tid, __ATOMIC_RELAXED);
+    for (uint32_t tid = 1; tid <= tid_count && tid < MAX_THREAD_NAMES; tid++) {
+        const char *name = __atomic_load_n(&thread_names[tid], __ATOMIC_ACQUIRE);
+        if (name) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    pid, tid, name);
+        }
+    }
+
+    trace_buffer_t *buffer = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE);
+    for (; buffer; buffer = buffer->next) {
+        uint64_t head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+        uint64_t first = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+
+        for (uint64_t position = first; position < head; position++) {
+            trace_event_t event;
+            if (!read_event(&buffer->events[position & TRACE_BUFFER_MASK], position, &event)) continue;
+            if (event.start_ns < epoch) continue;
+
+            double ts = (double)(event.start_ns - epoch) / 1000.0;
+            if (event.phase == 'i') {
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u}",
+                        event.name, event.category, ts, pid, event.tid);
+            } else {
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+                        event.name, event.category, ts, (double)event.duration_ns / 1000.0, pid, event.tid);
+            }
+            written++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return written;
+}
+
+/* ============================================================================
+ * SESSION AND SIGUSR1 DUMPS
+ * ============================================================================ */
+
+static void sigusr1_handler(int signal_number) {
+    (void)signal_number;
+    int saved_errno = errno;
+    if (write(dump_pipe[1], "d", 1) < 0) {
+        // Nothing useful to do inside a signal handler
+    }
+    errno = saved_errno;
+}
+
+// Performs SIGUSR1 dumps outside the handler, even while the UI thread is stuck
+static void *dump_worker(void *arg) {
+    (void)arg;
+    char command;
+
+    for (;;) {
+        ssize_t n = read(dump_pipe[0], &command, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0 || command == 'q') break;
+
+        int count = trace_dump(trace_path);
+        fprintf(stderr, "trace: wrote %d events to %s\n", count, trace_path);
+    }
+    return NULL;
+}
+
+int trace_start(const char *path) {
+    if (trace_is_enabled()) return 0;
+    if (!path || path[0] == '\0') return -1;
+
+    snprintf(trace_path, sizeof(trace_path), "%s", path);
+    trace_epoch_ns = trace_now_ns();
+
+    if (pipe(dump_pipe) != 0) return -1;
+    if (pthread_create(&dump_thread, NULL, dump_worker, NULL) != 0) {
+        close(dump_pipe[0]);
+        close(dump_pipe[1]);
+        dump_pipe[0] = dump_pipe[1] = -1;
+        return -1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = sigusr1_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, &previous_sigusr1);
+
+    __atomic_store_n(&trace_enabled_flag, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void trace_stop(void) {
+    if (!trace_is_enabled()) return;
+
+    __atomic_store_n(&trace_enabled_flag, 0, __ATOMIC_RELEASE);
+    sigaction(SIGUSR1, &previous_sigusr1, NULL);
+
+    if (write(dump_pipe[1], "q", 1) == 1) {
+        pthread_join(dump_thread, NULL);
+    }
+    close(dump_pipe[0]);
+    close(dump_pipe[1]);
+    dump_pipe[0] = dump_pipe[1] = -1;
+
+    trace_dump(trace_path);
+}
@@ -0,0 +1,506 @@
+/* ============================================================================
+ * API Kit - Work-Stealing Scheduler Implementation
+ *
+ * The deques follow Chase and Lev ("Dynamic Circular Work-Stealing Deque")
+ * with the memory orders of Le et al. ("Correct and Efficient Work-Stealing
+ * for Weak Memory Models"). A full deque grows into a new array; the old
+ * one is kept until the scheduler is destroyed, since a thief may still be
+ * reading from it.
+ *
+ * Idle workers sleep on a condition variable. A worker about to sleep
+ * counts itself in sleepers and then checks queued; a producer increments
+ * queued and then checks sleepers, both sequentially consistent, so at
+ * least one of them sees the other and no wake-up is lost. Producers only
+ * take the lock when someone is asleep.
+ * ============================================================================ */
+
+#include "work_scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define DEQUE_INITIAL_SIZE 64
+#define STEAL_ATTEMPTS 4                // Rounds over the victims before sleeping
+#define CACHE_LINE 64
+
+/* ============================================================================
+ * TYPE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct work_task {
+    work_fn fn;
+    void *arg;
+    struct work_task *next;     // Shared queue link
+} work_task_t;
+
+typedef struct deque_array {
+    int64_t size;               // Power of two
+    struct deque_array *retired_next;
+    work_task_t *items[];
+} deque_array_t;
+
+typedef struct {
+    int64_t top;                // Atomic: thieves take here
+    int64_t bottom;             // Atomic: the owner pushes and takes here
+    deque_array_t *array;       // Atomic
+    deque_array_t *retired;     // Arrays replaced by a bigger one
+} work_deque_t;
+
+typedef struct {
+    work_scheduler_t *scheduler;
+    int index;
+    pthread_t thread;
+    int started;
+    uint64_t rng;
+    work_deque_t deque;
+    work_worker_stats_t stats;  // Written by this worker only
+    char padding[CACHE_LINE];   // Keep neighbours' deques off this cache line
+} work_worker_t;
+
+struct work_scheduler {
+    work_worker_t *workers;
+    int worker_count;
+    int started;                // Threads running
+    uint64_t start_ns;
+
+    pthread_mutex_t lock;       // Guards the shared queue, sleeping and stop
+    pthread_cond_t wake;        // Signalled when a task is queued
+    pthread_cond_t idle;        // Broadcast when pending work reaches zero
+    work_task_t *head, *tail;   // Shared queue, FIFO
+    int stop;
+
+    int64_t queued;             // Atomic: tasks in deques and the shared queue
+    int64_t pending;            // Atomic: tasks queued or running
+    int sleepers;               // Atomic: workers waiting on wake
+};
+
+// Range of a work_scheduler_for loop
+typedef struct {
+    work_scheduler_t *scheduler;
+    work_index_fn fn;
+    void *arg;
+    uint64_t grain;
+    int64_t remaining;          // Atomic: indexes not yet run
+} work_loop_t;
+
+typedef struct {
+    work_loop_t *loop;
+    uint64_t begin, end;
+} work_range_t;
+
+static __thread work_worker_t *current_worker = NULL;
+
+/* ============================================================================
+ * UTILITIES
+ * ============================================================================ */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Single writer, concurrent readers: see work_scheduler_worker_stats
+static void add(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+// xorshift64
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/* ============================================================================
+ * DEQUE
+ * ============================================================================ */
+
+static deque_array_t *deque_array_create(int64_t size) {
+    deque_array_t *array = malloc(sizeof(deque_array_t) + (size_t)size * sizeof(work_task_t *));
+    if (!array) return NULL;
+    array->size = size;
+    array->retired_next = NULL;
+    return array;
+}
+
+static work_task_t *array_get(const deque_array_t *array, int64_t i) {
+    return __atomic_load_n(&array->items[i & (array->size - 1)], __ATOMIC_RELAXED);
+}
+
+static void array_put(deque_array_t *array, int64_t i, work_task_t *task) {
+    __atomic_store_n(&array->items[i & (array->size - 1)], task, __ATOMIC_RELAXED);
+}
+
+static int deque_init(work_deque_t *deque) {
+    memset(deque, 0, sizeof(*deque));
+    deque->array = deque_array_create(DEQUE_INITIAL_SIZE);
+    return deque->array ? 0 : -1;
+}
+
+// Owner only. Returns -1 if the deque was full and could not grow
+static int deque_push(work_deque_t *deque, work_task_t *task) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    deque_array_t *array = __atomic_load_n(&deque->array, __ATOMIC_RELAXED);
+
+    if (bottom - top > array->size - 1) {
+        deque_array_t *grown = deque_array_create(array->size * 2);
+        if (!grown) return -1;
+        for (int64_t i = top; i < bottom; i++) array_put(grown, i, array_get(array, i));
+        array->retired_next = deque->retired;
+        deque->retired = array;
+        __atomic_store_n(&deque->array, grown, __ATOMIC_RELEASE);
+        array = grown;
+    }
+    array_put(array, bottom, task);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// Owner only: the most recently pushed task, or NULL
+static work_task_t *deque_take(work_deque_t *deque) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    deque_array_t *array = __atomic_load_n(&deque->array, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    work_task_t *task = NULL;
+    if (top <= bottom) {
+        task = array_get(array, bottom);
+        if (top == bottom) {
+            // Last task: race the thieves for it
+            if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                task = NULL;
+            }
+            __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+// Any thread: the oldest task. Returns 1 with *task set, 0 if empty, -1 if it lost a race
+static int deque_steal(work_deque_t *deque, work_task_t **task) {
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom) return 0;
+
+    deque_array_t *array = __atomic_load_n(&deque->array, __ATOMIC_ACQUIRE);
+    *task = array_get(array, top);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return -1;
+    }
+    return 1;
+}
+
+static void deque_free(work_deque_t *deque) {
+    deque_array_t *array = deque->array;
+    if (array) {
+        for (int64_t i = deque->top; i < deque->bottom; i++) free(array_get(array, i));
+        free(array);
+    }
+    while (deque->retired) {
+        deque_array_t *next = deque->retired->retired_next;
+        free(deque->retired);
+        deque->retired = next;
+    }
+}
+
+/* ============================================================================
+ * WORKERS
+ * ============================================================================ */
+
+static void wake_sleepers(work_scheduler_t *scheduler) {
+    if (__atomic_load_n(&scheduler->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&scheduler->lock);
+        pthread_cond_signal(&scheduler->wake);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+}
+
+static work_task_t *queue_pop(work_scheduler_t *scheduler) {
+    pthread_mutex_lock(&scheduler->lock);
+    work_task_t *task = scheduler->head;
+    if (task) {
+        scheduler->head = task->next;
+        if (!scheduler->head) scheduler->tail = NULL;
+        __atomic_sub_fetch(&scheduler->queued, 1, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+    return task;
+}
+
+static void run_task(work_scheduler_t *scheduler, work_worker_t *worker, work_task_t *task) {
+    work_fn fn = task->fn;
+    void *arg = task->arg;
+    free(task);
+
+    uint64_t start_ns = now_ns();
+    fn(arg, worker->index);
+    add(&worker->stats.busy_ns, now_ns() - start_ns);
+    add(&worker->stats.tasks, 1);
+
+    if (__atomic_sub_fetch(&scheduler->pending, 1, __ATOMIC_SEQ_CST) == 0) {
+        pthread_mutex_lock(&scheduler->lock);
+        pthread_cond_broadcast(&scheduler->idle);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+}
+
+// Own deque first, then the other workers' (from a random one), then the
+// shared queue. *contended is set if a steal lost a race, so work may be left
+static work_task_t *find_task(work_worker_t *worker, int *contended) {
+    work_scheduler_t *scheduler = worker->scheduler;
+    work_task_t *task = deque_take(&worker->deque);
+    if (task) {
+        __atomic_sub_fetch(&scheduler->queued, 1, __ATOMIC_SEQ_CST);
+        return task;
+    }
+
+    int count = scheduler->worker_count;
+    int first = count > 1 ? (int)(next_random(&worker->rng) % (uint64_t)count) : 0;
+    for (int i = 0; i < count; i++) {
+        int victim = (first + i) % count;
+        if (victim == worker->index) continue;
+        int stolen = deque_steal(&scheduler->workers[victim].deque, &task);
+        if (stolen > 0) {
+            __atomic_sub_fetch(&scheduler->queued, 1, __ATOMIC_SEQ_CST);
+            add(&worker->stats.steals, 1);
+            return task;
+        }
+        if (stolen < 0) *contended = 1;
+    }
+    return queue_pop(scheduler);
+}
+
+static void *worker_main(void *arg) {
+    work_worker_t *worker = arg;
+    work_scheduler_t *scheduler = worker->scheduler;
+    current_worker = worker;
+
+    int idle_rounds = 0;
+    for (;;) {
+        int contended = 0;
+        work_task_t *task = find_task(worker, &contended);
+        if (task) {
+            run_task(scheduler, worker, task);
+            idle_rounds = 0;
+            continue;
+        }
+        if (contended || ++idle_rounds < STEAL_ATTEMPTS) continue;
+
+        pthread_mutex_lock(&scheduler->lock);
+        __atomic_add_fetch(&scheduler->sleepers, 1, __ATOMIC_SEQ_CST);
+        while (!scheduler->stop && __atomic_load_n(&scheduler->queued, __ATOMIC_SEQ_CST) == 0) {
+            pthread_cond_wait(&scheduler->wake, &scheduler->lock);
+        }
+        __atomic_sub_fetch(&scheduler->sleepers, 1, __ATOMIC_SEQ_CST);
+        int stop = scheduler->stop;
+        pthread_mutex_unlock(&scheduler->lock);
+        if (stop) break;
+        idle_rounds = 0;
+    }
+    current_worker = NULL;
+    return NULL;
+}
+
+// Block until *counter is zero; without threads, run the tasks here
+static void wait_for(work_scheduler_t *scheduler, int64_t *counter) {
+    if (scheduler->started == 0) {
+        work_task_t *task;
+        while ((task = queue_pop(scheduler)) != NULL) {
+            run_task(scheduler, &scheduler->workers[0], task);
+        }
+        return;
+    }
+    pthread_mutex_lock(&scheduler->lock);
+    while (__atomic_load_n(counter, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&scheduler->idle, &scheduler->lock);
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+work_scheduler_t *work_scheduler_create(int workers) {
+    if (workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (int)cpus : 1;
+    }
+
+    work_scheduler_t *scheduler = calloc(1, sizeof(work_scheduler_t));
+    if (!scheduler) return NULL;
+    scheduler->workers = calloc((size_t)workers, sizeof(work_worker_t));
+    if (!scheduler->workers) {
+        free(scheduler);
+        return NULL;
+    }
+    scheduler->worker_count = workers;
+    scheduler->start_ns = now_ns();
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->wake, NULL);
+    pthread_cond_init(&scheduler->idle, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        work_worker_t *worker = &scheduler->workers[i];
+        worker->scheduler = scheduler;
+        worker->index = i;
+        worker->rng = 0x9E3779B97F4A7C15ull * (uint64_t)(i + 1);
+        if (deque_init(&worker->deque) != 0) {
+            work_scheduler_destroy(scheduler);
+            return NULL;
+        }
+    }
+    for (int i = 0; i < workers; i++) {
+        work_worker_t *worker = &scheduler->workers[i];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) == 0) {
+            worker->started = 1;
+            scheduler->started++;
+        }
+    }
+    return scheduler;
+}
+
+void work_scheduler_destroy(work_scheduler_t *scheduler) {
+    if (!scheduler) return;
+
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->stop = 1;
+    pthread_cond_broadcast(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+
+    for (int i = 0; i < scheduler->worker_count; i++) {
+        if (scheduler->workers[i].started) pthread_join(scheduler->workers[i].thread, NULL);
+    }
+    for (int i = 0; i < scheduler->worker_count; i++) {
+        deque_free(&scheduler->workers[i].deque);
+    }
+    while (scheduler->head) {
+        work_task_t *next = scheduler->head->next;
+        free(scheduler->head);
+        scheduler->head = next;
+    }
+    pthread_mutex_destroy(&scheduler->lock);
+    pthread_cond_destroy(&scheduler->wake);
+    pthread_cond_destroy(&scheduler->idle);
+    free(scheduler->workers);
+    free(scheduler);
+}
+
+int work_scheduler_submit(work_scheduler_t *scheduler, work_fn fn, void *arg) {
+    if (!scheduler || !fn) return -1;
+    work_task_t *task = malloc(sizeof(work_task_t));
+    if (!task) return -1;
+    task->fn = fn;
+    task->arg = arg;
+    task->next = NULL;
+    __atomic_add_fetch(&scheduler->pending, 1, __ATOMIC_SEQ_CST);
+
+    work_worker_t *worker = current_worker;
+    if (worker && worker->scheduler == scheduler && deque_push(&worker->deque, task) == 0) {
+        __atomic_add_fetch(&scheduler->queued, 1, __ATOMIC_SEQ_CST);
+        wake_sleepers(scheduler);
+        return 0;
+    }
+
+    pthread_mutex_lock(&scheduler->lock);
+    if (scheduler->tail) scheduler->tail->next = task;
+    else scheduler->head = task;
+    scheduler->tail = task;
+    __atomic_add_fetch(&scheduler->queued, 1, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+    return 0;
+}
+
+void work_scheduler_wait(work_scheduler_t *scheduler) {
+    if (scheduler) wait_for(scheduler, &scheduler->pending);
+}
+
+// Split off the upper half for thieves until the range is one grain, then run it
+static void run_range(void *arg, int worker) {
+    work_range_t *range = arg;
+    work_loop_t *loop = range->loop;
+
+    while (range->end - range->begin > loop->grain) {
+        uint64_t middle = range->begin + (range->end - range->begin) / 2;
+        work_range_t *upper = malloc(sizeof(work_range_t));
+        if (!upper) break;      // Run the rest here
+        upper->loop = loop;
+        upper->begin = middle;
+        upper->end = range->end;
+        if (work_scheduler_submit(loop->scheduler, run_range, upper) != 0) {
+            free(upper);
+            break;
+        }
+        range->end = middle;
+    }
+
+    for (uint64_t i = range->begin; i < range->end; i++) {
+        loop->fn(loop->arg, i, worker);
+    }
+    int64_t ran = (int64_t)(range->end - range->begin);
+    free(range);
+
+    // The loop lives on the waiter's stack, which may return as soon as
+    // remaining reaches zero: touch nothing in it after the decrement
+    work_scheduler_t *scheduler = loop->scheduler;
+    if (__atomic_sub_fetch(&loop->remaining, ran, __ATOMIC_SEQ_CST) == 0) {
+        pthread_mutex_lock(&scheduler->lock);
+        pthread_cond_broadcast(&scheduler->idle);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+}
+
+int work_scheduler_for(work_scheduler_t *scheduler, uint64_t count, uint64_t grain,
+                       work_index_fn fn, void *arg) {
+    if (!scheduler || !fn) return -1;
+    if (count == 0) return 0;
+
+    work_loop_t loop = {
+        .scheduler = scheduler, .fn = fn, .arg = arg,
+        .grain = grain > 0 ? grain : 1, .remaining = (int64_t)count
+    };
+    work_range_t *range = malloc(sizeof(work_range_t));
+    if (!range) return -1;
+    range->loop = &loop;
+    range->begin = 0;
+    range->end = count;
+    if (work_scheduler_submit(scheduler, run_range, range) != 0) {
+        free(range);
+        return -1;
+    }
+    wait_for(scheduler, &loop.remaining);
+    return 0;
+}
+
+int work_scheduler_workers(const work_scheduler_t *scheduler) {
+    return scheduler ? scheduler->worker_count : 0;
+}
+
+work_worker_stats_t work_scheduler_worker_stats(const work_scheduler_t *scheduler, int worker) {
+    work_worker_stats_t stats = {0};
+    if (!scheduler || worker < 0 || worker >= scheduler->worker_count) return stats;
+
+    const work_worker_stats_t *live = &scheduler->workers[worker].stats;
+    stats.tasks = __atomic_load_n(&live->tasks, __ATOMIC_RELAXED);
+    stats.steals = __atomic_load_n(&live->steals, __ATOMIC_RELAXED);
+    stats.busy_ns = __atomic_load_n(&live->busy_ns, __ATOMIC_RELAXED);
+    stats.elapsed_ns = now_ns() - scheduler->start_ns;
+    return stats;
+}
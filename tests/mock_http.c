@@ -0,0 +1,232 @@
+/* ============================================================================
+ * API Kit - Test Mock HTTP Server Implementation
+ * ============================================================================ */
+
+#include "mock_http.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define REQUEST_BUFFER_SIZE 16384
+
+struct mock_http {
+    int socket;
+    int port;
+    char url[64];
+    char path[108];             // Unix socket file, "" for TCP
+    mock_http_handler_fn handler;
+    void *user_data;
+    pthread_t thread;
+};
+
+// What a connection thread needs; it may outlive the server
+typedef struct {
+    int client;
+    mock_http_handler_fn handler;
+    void *user_data;
+} connection_t;
+
+/* ============================================================================
+ * CONNECTIONS
+ * ============================================================================ */
+
+static size_t content_length(const char *head, const char *end) {
+    for (const char *line = strstr(head, "\r\n"); line && line < end; line = strstr(line + 2, "\r\n")) {
+        if (strncasecmp(line + 2, "Content-Length:", 15) == 0) {
+            return (size_t)strtoul(line + 17, NULL, 10);
+        }
+    }
+    return 0;
+}
+
+static void *connection_worker(void *arg) {
+    connection_t connection = *(connection_t *)arg;
+    free(arg);
+
+    char *buffer = malloc(REQUEST_BUFFER_SIZE);
+    size_t length = 0;
+    int index = 0;
+    while (buffer) {
+        // Read a whole request: headers, then the body they announce
+        buffer[length] = '\0';
+        char *end = strstr(buffer, "\r\n\r\n");
+        size_t size = end ? (size_t)(end + 4 - buffer) + content_length(buffer, end) : 0;
+        if (!end || length < size) {
+            if (length >= REQUEST_BUFFER_SIZE - 1 || size >= REQUEST_BUFFER_SIZE) break;
+            ssize_t n = recv(connection.client, buffer + length, REQUEST_BUFFER_SIZE - 1 - length, 0);
+            if (n <= 0) break;
+            length += (size_t)n;
+            continue;
+        }
+
+        // NUL-terminated copies, so the buffer keeps what follows
+        size_t head_length = (size_t)(end + 4 - buffer);
+        char head[REQUEST_BUFFER_SIZE], body[REQUEST_BUFFER_SIZE];
+        memcpy(head, buffer, head_length);
+        head[head_length] = '\0';
+        memcpy(body, buffer + head_length, size - head_length);
+        body[size - head_length] = '\0';
+        char method[16] = "", path[256] = "";
+        sscanf(head, "%15s %255s", method, path);
+
+        mock_http_request_t request = {
+            .method = method, .path = path, .head = head,
+            .body = body, .body_length = size - head_length, .index = index++
+        };
+        length -= size;
+        memmove(buffer, buffer + size, length);
+        if (!connection.handler(connection.client, &request, connection.user_data)) break;
+    }
+    free(buffer);
+
+    // Closing with pipelined requests still unread would reset the connection
+    // and could drop the last response, so read until the client closes too
+    char drain[4096];
+    struct timeval timeout = { 1, 0 };
+    shutdown(connection.client, SHUT_WR);
+    setsockopt(connection.client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    while (recv(connection.client, drain, sizeof(drain), 0) > 0) {
+    }
+    close(connection.client);
+    return NULL;
+}
+
+static void *server_worker(void *arg) {
+    mock_http_t *server = arg;
+    for (;;) {
+        int client = accept(server->socket, NULL, NULL);
+        if (client < 0) break;
+
+        connection_t *connection = malloc(sizeof(connection_t));
+        pthread_t thread;
+        if (connection) {
+            connection->client = client;
+            connection->handler = server->handler;
+            connection->user_data = server->user_data;
+        }
+        if (connection && pthread_create(&thread, NULL, connection_worker, connection) == 0) {
+            pthread_detach(thread);
+        } else {
+            free(connection);
+            close(client);
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+static mock_http_t *start(mock_http_t *server, struct sockaddr *addr, socklen_t addr_length) {
+    if (bind(server->socket, addr, addr_length) != 0 || listen(server->socket, 64) != 0 ||
+        getsockname(server->socket, addr, &addr_length) != 0) {
+        close(server->socket);
+        free(server);
+        return NULL;
+    }
+    if (addr->sa_family == AF_INET) {
+        server->port = ntohs(((struct sockaddr_in *)addr)->sin_port);
+        snprintf(server->url, sizeof(server->url), "http://127.0.0.1:%d", server->port);
+    }
+    if (pthread_create(&server->thread, NULL, server_worker, server) != 0) {
+        close(server->socket);
+        free(server);
+        return NULL;
+    }
+    return server;
+}
+
+mock_http_t *mock_http_start(mock_http_handler_fn handler, void *user_data) {
+    mock_http_t *server = calloc(1, sizeof(mock_http_t));
+    if (!server) return NULL;
+    server->handler = handler;
+    server->user_data = user_data;
+    server->socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->socket < 0) {
+        free(server);
+        return NULL;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return start(server, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+mock_http_t *mock_http_start_unix(const char *path, mock_http_handler_fn handler, void *user_data) {
+    mock_http_t *server = calloc(1, sizeof(mock_http_t));
+    if (!server) return NULL;
+    server->handler = handler;
+    server->user_data = user_data;
+    snprintf(server->path, sizeof(server->path), "%s", path);
+    unlink(server->path);
+    server->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->socket < 0) {
+        free(server);
+        return NULL;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", server->path);
+    return start(server, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+int mock_http_port(const mock_http_t *server) {
+    return server->port;
+}
+
+const char *mock_http_url(const mock_http_t *server) {
+    return server->url;
+}
+
+void mock_http_stop(mock_http_t *server) {
+    if (!server) return;
+    shutdown(server->socket, SHUT_RDWR);
+    close(server->socket);
+    pthread_join(server->thread, NULL);
+    if (server->path[0]) unlink(server->path);
+    free(server);
+}
+
+static const char *reason_phrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Status";
+    }
+}
+
+int mock_http_reply(int client, int status, const char *headers, const char *body) {
+    size_t body_length = body ? strlen(body) : 0;
+    size_t size = 128 + (headers ? strlen(headers) : 0) + body_length;
+    char *response = malloc(size);
+    if (!response) return -1;
+
+    int length = body ? snprintf(response, size, "HTTP/1.1 %d %s\r\n%sContent-Length: %zu\r\n\r\n%s", status,
+                                 reason_phrase(status), headers ? headers : "", body_length, body)
+                      : snprintf(response, size, "HTTP/1.1 %d %s\r\n%s\r\n", status, reason_phrase(status),
+                                 headers ? headers : "");
+    size_t sent = 0;
+    while (length > 0 && sent < (size_t)length) {
+        ssize_t n = send(client, response + sent, (size_t)length - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+    free(response);
+    return length > 0 && sent == (size_t)length ? 0 : -1;
+}
@@ -0,0 +1,77 @@
+/* ============================================================================
+ * API Kit - Test Mock HTTP Server
+ *
+ * A loopback (or Unix socket) HTTP/1.1 server for the test suites. Each
+ * connection gets its own thread, which reads requests one after another
+ * (with their Content-Length bodies) and hands each to the suite's handler.
+ * The handler writes the response itself, usually with mock_http_reply,
+ * and says whether to keep the connection open for the next request.
+ * ============================================================================ */
+
+#ifndef MOCK_HTTP_H
+#define MOCK_HTTP_H
+
+#include <stddef.h>
+
+typedef struct mock_http mock_http_t;
+
+typedef struct {
+    const char *method;         // "GET", ...
+    const char *path;           // Request target
+    const char *head;           // Request line and headers, through the blank line
+    const char *body;           // Content-Length bytes, NUL-terminated
+    size_t body_length;
+    int index;                  // Requests answered before on this connection
+} mock_http_request_t;
+
+/**
+ * @brief Answer a request
+ * @param client Connection socket to write the response to
+ * @param request Request (valid during the call only)
+ * @param user_data From mock_http_start
+ * @return 1 to read the next request on the connection, 0 to close it
+ */
+typedef int (*mock_http_handler_fn)(int client, const mock_http_request_t *request, void *user_data);
+
+/**
+ * @brief Start a server on an ephemeral loopback TCP port
+ * @return Server, or NULL if it cannot listen
+ */
+mock_http_t *mock_http_start(mock_http_handler_fn handler, void *user_data);
+
+/**
+ * @brief Start a server on a Unix domain socket (replacing any file at path)
+ * @return Server, or NULL if it cannot listen
+ */
+mock_http_t *mock_http_start_unix(const char *path, mock_http_handler_fn handler, void *user_data);
+
+/**
+ * @brief TCP port of a server (0 for a Unix socket)
+ */
+int mock_http_port(const mock_http_t *server);
+
+/**
+ * @brief "http://127.0.0.1:PORT" for a TCP server
+ */
+const char *mock_http_url(const mock_http_t *server);
+
+/**
+ * @brief Stop accepting and free the server
+ *
+ * Connections still open finish on their own threads.
+ *
+ * @param server Server (may be NULL)
+ */
+void mock_http_stop(mock_http_t *server);
+
+/**
+ * @brief Send a response
+ * @param client Connection socket
+ * @param status Status code
+ * @param headers Extra header lines, each ending in CRLF (may be NULL)
+ * @param body Body, sent with its Content-Length; NULL for no body and no length
+ * @return 0 on success, -1 if the client is gone
+ */
+int mock_http_reply(int client, int status, const char *headers, const char *body);
+
+#endif // MOCK_HTTP_H
@@ -0,0 +1,195 @@
+#include "unity/unity.h"
+#include "../include/capture.h"
+#include "../include/json_path.h"
+#include "../include/http_parser.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define TEST_FIXTURES_DIR "tests/fixtures/"
+
+static const char *login_body =
+    "{\n"
+    "  \"user\": {\"id\": 7, \"name\": \"Test \\\"User\\\"\", \"roles\": [\"admin\", \"dev\"]},\n"
+    "  \"noise\": [{\"access_token\": \"wrong\"}, \"}]\\\\\", [1, [2, {\"x\": \"]\"}]]],\n"
+    "  \"access_token\": \"abc.def\",\n"
+    "  \"expires_in\": 3600,\n"
+    "  \"caf\\u00e9\": true,\n"
+    "  \"meta\": {\"a b\": null, \"empty\": {}}\n"
+    "}";
+
+static char *find_text(const char *json, const char *expression) {
+    json_path_t path;
+    if (json_path_compile(expression, &path) != 0) return NULL;
+
+    const char *value;
+    size_t length;
+    if (json_path_find(json, strlen(json), &path, &value, &length) != 0) return NULL;
+    return json_path_value_text(value, length);
+}
+
+static void assert_path(const char *expected, const char *expression) {
+    char *text = find_text(login_body, expression);
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+    free(text);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Test path lookups through objects and arrays
+void test_json_path_find(void) {
+    assert_path("abc.def", "$.access_token");
+    assert_path("3600", "$.expires_in");
+    assert_path("7", "$.user.id");
+    assert_path("Test \"User\"", "$.user.name");
+    assert_path("dev", "$.user.roles[1]");
+    assert_path("]", "$.noise[2][1][1].x");
+    assert_path("null", "$.meta['a b']");
+    assert_path("{}", "$.meta[\"empty\"]");
+    assert_path("true", "$['caf\xc3\xa9']");
+    assert_path("[\"admin\", \"dev\"]", "$.user.roles");
+}
+
+// Test missing values and malformed input
+void test_json_path_missing(void) {
+    TEST_ASSERT_NULL(find_text(login_body, "$.missing"));
+    TEST_ASSERT_NULL(find_text(login_body, "$.user.roles[2]"));
+    TEST_ASSERT_NULL(find_text(login_body, "$.user.id.deeper"));
+    TEST_ASSERT_NULL(find_text(login_body, "$.meta.empty.x"));
+    TEST_ASSERT_NULL(find_text("{\"a\": [1, 2", "$.a[3]"));
+    TEST_ASSERT_NULL(find_text("{\"a\": \"unterminated", "$.a"));
+    TEST_ASSERT_NULL(find_text("not json", "$.a"));
+
+    json_path_t path;
+    TEST_ASSERT_EQUAL_INT(-1, json_path_compile("access_token", &path));
+    TEST_ASSERT_EQUAL_INT(-1, json_path_compile("$.", &path));
+    TEST_ASSERT_EQUAL_INT(-1, json_path_compile("$[x]", &path));
+    TEST_ASSERT_EQUAL_INT(-1, json_path_compile("$['open", &path));
+    TEST_ASSERT_EQUAL_INT(0, json_path_compile("$", &path));
+    TEST_ASSERT_EQUAL_INT(0, path.step_count);
+}
+
+// Test unescaping of string values
+void test_json_path_unescape(void) {
+    char *text = find_text("{\"s\": \"a\\nb\\t\\/\\u0041\\ud83d\\ude00\"}", "$.s");
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_EQUAL_STRING("a\nb\t/A\xf0\x9f\x98\x80", text);
+    free(text);
+}
+
+// Test parsing capture directives out of a header block
+void test_capture_parse(void) {
+    capture_list_t list;
+    int count = capture_parse(
+        "Content-Type: application/json\n"
+        "# @capture token = body $.access_token\n"
+        "  # @capture session = header Set-Cookie\r\n"
+        "# @capture code=status\n"
+        "# @capture raw = body\n"
+        "# @capture broken = cookie x\n"
+        "# @capture = status\n"
+        "# @captured nope = status\n", &list);
+
+    TEST_ASSERT_EQUAL_INT(4, count);
+    TEST_ASSERT_EQUAL_STRING("token", list.items[0].variable);
+    TEST_ASSERT_EQUAL_INT(CAPTURE_BODY, list.items[0].source);
+    TEST_ASSERT_EQUAL_INT(1, list.items[0].path.step_count);
+    TEST_ASSERT_EQUAL_STRING("session", list.items[1].variable);
+    TEST_ASSERT_EQUAL_INT(CAPTURE_HEADER, list.items[1].source);
+    TEST_ASSERT_EQUAL_STRING("Set-Cookie", list.items[1].header);
+    TEST_ASSERT_EQUAL_STRING("code", list.items[2].variable);
+    TEST_ASSERT_EQUAL_INT(CAPTURE_STATUS, list.items[2].source);
+    TEST_ASSERT_EQUAL_STRING("raw", list.items[3].variable);
+    TEST_ASSERT_EQUAL_INT(0, list.items[3].path.step_count);
+
+    TEST_ASSERT_EQUAL_INT(0, capture_parse(NULL, &list));
+}
+
+// Test chaining: a login response feeds the next request's Authorization header
+void test_capture_chain_from_collection(void) {
+    http_collection_t *collection = malloc(sizeof(http_collection_t));
+    TEST_ASSERT_NOT_NULL(collection);
+    TEST_ASSERT_EQUAL_INT(0, http_parse_file(TEST_FIXTURES_DIR "complex_request.http", collection));
+
+    capture_list_t captures;
+    TEST_ASSERT_EQUAL_INT(1, capture_parse(collection->requests[0].headers, &captures));
+
+    char headers[] =
+        "HTTP/1.1 302 Found\r\n"
+        "Set-Cookie: stale=1\r\n"
+        "\r\n"
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "set-cookie: sid=42; HttpOnly\r\n"
+        "\r\n";
+    http_response_t response = {
+        .body = (char *)login_body,
+        .body_size = strlen(login_body),
+        .status_code = 200,
+        .headers = headers,
+        .headers_size = strlen(headers)
+    };
+    http_headers_init(&response.header_fields);
+    TEST_ASSERT_EQUAL_INT(0, http_headers_parse(&response.header_fields, headers, strlen(headers)));
+
+    template_vars_t *vars = template_vars_create();
+    TEST_ASSERT_EQUAL_INT(1, capture_apply(&captures, &response, vars));
+    TEST_ASSERT_EQUAL_STRING("abc.def", template_vars_get(vars, "token"));
+
+    template_t *template = template_compile(collection->requests[1].headers, vars);
+    template_buffer_t out = {0};
+    TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    TEST_ASSERT_NOT_NULL(strstr(out.data, "Authorization: Bearer abc.def"));
+
+    // Headers come from the final response only
+    capture_parse("# @capture session = header Set-Cookie\n"
+                  "# @capture code = status\n"
+                  "# @capture missing = header X-Missing\n", &captures);
+    TEST_ASSERT_EQUAL_INT(2, capture_apply(&captures, &response, vars));
+    TEST_ASSERT_EQUAL_STRING("sid=42; HttpOnly", template_vars_get(vars, "session"));
+    TEST_ASSERT_EQUAL_STRING("200", template_vars_get(vars, "code"));
+    TEST_ASSERT_NULL(template_vars_get(vars, "missing"));
+
+    http_headers_free(&response.header_fields);
+    template_buffer_free(&out);
+    template_destroy(template);
+    template_vars_destroy(vars);
+    free(collection);
+}
+
+// Test that directives survive a save/load round trip
+void test_capture_directives_round_trip(void) {
+    http_collection_t *collection = malloc(sizeof(http_collection_t));
+    TEST_ASSERT_NOT_NULL(collection);
+    TEST_ASSERT_EQUAL_INT(0, http_parse_file(TEST_FIXTURES_DIR "complex_request.http", collection));
+    TEST_ASSERT_NOT_NULL(strstr(collection->requests[0].headers, "# @capture token = body $.access_token"));
+
+    const char *path = "/tmp/apikit_test_capture.http";
+    TEST_ASSERT_EQUAL_INT(0, http_save_file(path, collection));
+    TEST_ASSERT_EQUAL_INT(0, http_parse_file(path, collection));
+    TEST_ASSERT_EQUAL_STRING("POST", collection->requests[0].method);
+    TEST_ASSERT_NOT_NULL(strstr(collection->requests[0].headers, "# @capture token = body $.access_token"));
+    TEST_ASSERT_NOT_NULL(strstr(collection->requests[0].headers, "Content-Type: application/json"));
+
+    remove(path);
+    free(collection);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_capture.c");
+
+    RUN_TEST(test_json_path_find);
+    RUN_TEST(test_json_path_missing);
+    RUN_TEST(test_json_path_unescape);
+    RUN_TEST(test_capture_parse);
+    RUN_TEST(test_capture_chain_from_collection);
+    RUN_TEST(test_capture_directives_round_trip);
+
+    return UnityEnd();
+}
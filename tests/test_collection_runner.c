@@ -0,0 +1,236 @@
+#include "unity/unity.h"
+#include "../include/collection_runner.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+
+// Mock server handler: answers and closes
+static mock_http_t *server;
+
+static template_vars_t *vars;
+
+static int respond(int client, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    const char *path = request->path;
+    int status = 200;
+    const char *body = "{\"ok\": true}";
+    if (strcmp(path, "/login") == 0) {
+        body = "{\"user\": {\"id\": 7}, \"access_token\": \"tok-123\"}";
+    } else if (strcmp(path, "/me") == 0) {
+        if (!strstr(request->head, "Authorization: Bearer tok-123\r\n")) {
+            status = 401;
+            body = "{\"error\": \"unauthorized\"}";
+        }
+    } else if (strncmp(path, "/delay/", 7) == 0) {
+        usleep((useconds_t)atoi(path + 7) * 1000);
+    } else if (strcmp(path, "/fail") == 0) {
+        status = 500;
+        body = "{\"error\": \"server error\"}";
+    }
+
+    mock_http_reply(client, status, "Content-Type: application/json\r\nConnection: close\r\n", body);
+    return 0;
+}
+
+static void make_request(http_request_t *request, const char *name, const char *method,
+                         const char *url, const char *headers) {
+    memset(request, 0, sizeof(*request));
+    snprintf(request->name, sizeof(request->name), "%s", name);
+    snprintf(request->method, sizeof(request->method), "%s", method);
+    snprintf(request->url, sizeof(request->url), "%s", url);
+    snprintf(request->headers, sizeof(request->headers), "%s", headers);
+}
+
+void setUp(void) {
+    vars = template_vars_create();
+    template_vars_set(vars, "host", mock_http_url(server));
+}
+
+void tearDown(void) {
+    template_vars_destroy(vars);
+}
+
+// Test dependencies inferred from captures and variable use
+void test_runner_infers_dependencies(void) {
+    http_request_t requests[5];
+    make_request(&requests[0], "Login", "POST", "{{host}}/login",
+                 "# @capture token = body $.access_token");
+    make_request(&requests[1], "Profile", "GET", "{{host}}/me", "Authorization: Bearer {{token}}");
+    make_request(&requests[2], "Health", "GET", "{{host}}/delay/1", "");
+    make_request(&requests[3], "Relogin", "POST", "{{host}}/login",
+                 "# @capture token = body $.access_token");
+    make_request(&requests[4], "After health", "GET", "{{host}}/delay/1", "# @depends-on Health");
+
+    collection_run_t *run = collection_run_create(requests, 5, vars);
+    TEST_ASSERT_NOT_NULL(run);
+
+    TEST_ASSERT_EQUAL_INT(0, collection_run_result(run, 0)->dependency_count);
+    TEST_ASSERT_EQUAL_INT(1, collection_run_result(run, 1)->dependency_count);
+    TEST_ASSERT_EQUAL_INT(0, collection_run_result(run, 1)->dependencies[0]);
+    TEST_ASSERT_EQUAL_INT(0, collection_run_result(run, 2)->dependency_count);
+
+    // A later capture of token waits for the earlier capture and its reader
+    const run_result_t *relogin = collection_run_result(run, 3);
+    TEST_ASSERT_EQUAL_INT(2, relogin->dependency_count);
+    TEST_ASSERT_EQUAL_INT(0, relogin->dependencies[0]);
+    TEST_ASSERT_EQUAL_INT(1, relogin->dependencies[1]);
+
+    TEST_ASSERT_EQUAL_INT(1, collection_run_result(run, 4)->dependency_count);
+    TEST_ASSERT_EQUAL_INT(2, collection_run_result(run, 4)->dependencies[0]);
+
+    TEST_ASSERT_EQUAL_INT(0, collection_run_execute(run, NULL));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(RUN_PASSED, collection_run_result(run, i)->state);
+    }
+    TEST_ASSERT_EQUAL_STRING("tok-123", template_vars_get(vars, "token"));
+    collection_run_destroy(run);
+}
+
+// Test that independent requests run in parallel
+void test_runner_parallel_critical_path(void) {
+    http_request_t requests[8];
+    for (int i = 0; i < 8; i++) {
+        make_request(&requests[i], "Slow", "GET", "{{host}}/delay/150", "");
+    }
+
+    collection_run_t *run = collection_run_create(requests, 8, vars);
+    TEST_ASSERT_NOT_NULL(run);
+    TEST_ASSERT_EQUAL_INT(0, collection_run_execute(run, NULL));
+
+    // 8 x 150 ms sequentially; in parallel about one request's time
+    TEST_ASSERT_TRUE(collection_run_elapsed_ns(run) < 600000000ull);
+    TEST_ASSERT_TRUE(collection_run_critical_path_ns(run) >= 150000000ull);
+    TEST_ASSERT_TRUE(collection_run_critical_path_ns(run) <= collection_run_elapsed_ns(run));
+
+    // A concurrency limit of 2 needs at least 4 rounds
+    run_options_t options = { .concurrency = 2 };
+    TEST_ASSERT_EQUAL_INT(0, collection_run_execute(run, &options));
+    TEST_ASSERT_TRUE(collection_run_elapsed_ns(run) >= 600000000ull);
+    collection_run_destroy(run);
+}
+
+// Test that a dependent starts as soon as its dependency finishes, even
+// while an unrelated slow request keeps the engine busy
+void test_runner_dependent_start_latency(void) {
+    http_request_t requests[5];
+    make_request(&requests[0], "Slow", "GET", "{{host}}/delay/1000", "");
+    make_request(&requests[1], "A", "GET", "{{host}}/delay/5", "");
+    make_request(&requests[2], "B", "GET", "{{host}}/delay/5", "# @depends-on A");
+    make_request(&requests[3], "C", "GET", "{{host}}/delay/5", "# @depends-on B");
+    make_request(&requests[4], "D", "GET", "{{host}}/delay/5", "# @depends-on C");
+
+    collection_run_t *run = collection_run_create(requests, 5, vars);
+    TEST_ASSERT_NOT_NULL(run);
+    TEST_ASSERT_EQUAL_INT(0, collection_run_execute(run, NULL));
+
+    for (int i = 2; i < 5; i++) {
+        const run_result_t *result = collection_run_result(run, i);
+        TEST_ASSERT_TRUE(result->start_ns - collection_run_result(run, i - 1)->end_ns < 30000000ull);
+    }
+    TEST_ASSERT_TRUE(collection_run_result(run, 4)->end_ns < 300000000ull);
+    collection_run_destroy(run);
+}
+
+// Test that failures skip dependents but not independent requests
+void test_runner_failure_skips_dependents(void) {
+    http_request_t requests[5];
+    make_request(&requests[0], "Broken", "POST", "{{host}}/fail",
+                 "# @capture token = body $.access_token");
+    make_request(&requests[1], "Uses token", "GET", "{{host}}/me", "Authorization: Bearer {{token}}");
+    make_request(&requests[2], "Independent", "GET", "{{host}}/delay/1", "");
+    make_request(&requests[3], "Cycle A", "GET", "{{host}}/delay/1", "# @depends-on Cycle B");
+    make_request(&requests[4], "Cycle B", "GET", "{{host}}/delay/1", "# @depends-on Cycle A");
+
+    collection_run_t *run = collection_run_create(requests, 5, vars);
+    TEST_ASSERT_NOT_NULL(run);
+    TEST_ASSERT_EQUAL_INT(4, collection_run_execute(run, NULL));
+
+    TEST_ASSERT_EQUAL_INT(RUN_FAILED, collection_run_result(run, 0)->state);
+    TEST_ASSERT_EQUAL_INT(500, collection_run_result(run, 0)->status_code);
+    TEST_ASSERT_EQUAL_INT(RUN_SKIPPED, collection_run_result(run, 1)->state);
+    TEST_ASSERT_NOT_NULL(strstr(collection_run_result(run, 1)->error, "Broken"));
+    TEST_ASSERT_EQUAL_INT(RUN_PASSED, collection_run_result(run, 2)->state);
+    TEST_ASSERT_EQUAL_INT(RUN_SKIPPED, collection_run_result(run, 3)->state);
+    TEST_ASSERT_EQUAL_STRING("dependency cycle", collection_run_result(run, 3)->error);
+    TEST_ASSERT_EQUAL_INT(RUN_SKIPPED, collection_run_result(run, 4)->state);
+    TEST_ASSERT_NULL(template_vars_get(vars, "token"));
+    collection_run_destroy(run);
+}
+
+void test_runner_shared_engine(void) {
+    http_request_t requests[3];
+    make_request(&requests[0], "Login", "POST", "{{host}}/login",
+                 "# @capture token = body $.access_token");
+    make_request(&requests[1], "Profile", "GET", "{{host}}/me", "Authorization: Bearer {{token}}");
+    make_request(&requests[2], "Slow", "GET", "{{host}}/delay/{{ms}}", "");
+
+    // One run per row of data, each with its own variables, on one engine
+    template_vars_t *row_vars[4];
+    collection_run_t *runs[4];
+    for (int r = 0; r < 4; r++) {
+        row_vars[r] = template_vars_create();
+        template_vars_set(row_vars[r], "host", template_vars_get(vars, "host"));
+        template_vars_set(row_vars[r], "ms", "150");
+        runs[r] = collection_run_create(requests, 3, row_vars[r]);
+        TEST_ASSERT_NOT_NULL(runs[r]);
+    }
+    http_engine_t *engine = collection_run_engine_create(NULL);
+    TEST_ASSERT_NOT_NULL(engine);
+
+    for (int round = 0; round < 2; round++) {
+        for (int r = 0; r < 4; r++) {
+            TEST_ASSERT_EQUAL_INT(0, collection_run_start(runs[r], engine, NULL));
+        }
+        TEST_ASSERT_EQUAL_INT(-1, collection_run_start(runs[0], engine, NULL));
+
+        int active = 4;
+        while (active > 0) {
+            http_engine_run(engine, 100);
+            active = 0;
+            for (int r = 0; r < 4; r++) {
+                if (collection_run_pump(runs[r]) > 0) active++;
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            for (int i = 0; i < 3; i++) {
+                TEST_ASSERT_EQUAL_INT(RUN_PASSED, collection_run_result(runs[r], i)->state);
+            }
+            // The four slow requests overlapped
+            TEST_ASSERT_TRUE(collection_run_elapsed_ns(runs[r]) < 450000000ull);
+            TEST_ASSERT_EQUAL_STRING("tok-123", template_vars_get(row_vars[r], "token"));
+        }
+        TEST_ASSERT_EQUAL_INT(0, http_engine_pending(engine));
+    }
+
+    http_engine_destroy(engine);
+    for (int r = 0; r < 4; r++) {
+        collection_run_destroy(runs[r]);
+        template_vars_destroy(row_vars[r]);
+    }
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+
+    UnityBegin("test_collection_runner.c");
+
+    RUN_TEST(test_runner_infers_dependencies);
+    RUN_TEST(test_runner_parallel_critical_path);
+    RUN_TEST(test_runner_dependent_start_latency);
+    RUN_TEST(test_runner_failure_skips_dependents);
+    RUN_TEST(test_runner_shared_engine);
+
+    int result = UnityEnd();
+    mock_http_stop(server);
+    return result;
+}
@@ -0,0 +1,170 @@
+#include "unity/unity.h"
+#include "../include/compiled_request.h"
+#include <curl/curl.h>
+#include <stdio.h>
+#include <string.h>
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static int has_header(const compiled_request_t *request, const char *header) {
+    for (const struct curl_slist *item = request->headers; item; item = item->next) {
+        if (strcmp(item->data, header) == 0) return 1;
+    }
+    return 0;
+}
+
+// Test that header text is split, trimmed and filtered
+void test_compile_headers_are_trimmed(void) {
+    const char *headers =
+        "  Accept: application/json  \r\n"
+        "\n"
+        "# X-Disabled: 1\n"
+        "not a header\n"
+        "\tAuthorization: Bearer abc\t\r\n";
+
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://localhost/",
+                                                          headers, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(2, request->header_count);
+    TEST_ASSERT_TRUE(has_header(request, "Accept: application/json"));
+    TEST_ASSERT_TRUE(has_header(request, "Authorization: Bearer abc"));
+    TEST_ASSERT_FALSE(has_header(request, "# X-Disabled: 1"));
+    TEST_ASSERT_EQUAL_STRING("GET", request->method_name);
+    TEST_ASSERT_NULL(request->body);
+    TEST_ASSERT_TRUE(request->timeout_ms == 5000);
+    compiled_request_destroy(request);
+}
+
+// Test that there is no cap on the number of headers
+void test_compile_many_headers(void) {
+    char headers[2048] = "";
+    for (int i = 0; i < 40; i++) {
+        char line[32];
+        snprintf(line, sizeof(line), "X-Header-%d: %d\n", i, i);
+        strcat(headers, line);
+    }
+
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://localhost/",
+                                                          headers, NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(40, request->header_count);
+    TEST_ASSERT_TRUE(has_header(request, "X-Header-0: 0"));
+    TEST_ASSERT_TRUE(has_header(request, "X-Header-39: 39"));
+    compiled_request_destroy(request);
+}
+
+// Test the default Content-Type for requests with a body
+void test_compile_default_content_type(void) {
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_POST, "http://localhost/",
+                                                          "Accept: */*", "{\"a\":1}", 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(2, request->header_count);
+    TEST_ASSERT_TRUE(has_header(request, "Content-Type: application/json"));
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1}", request->body);
+    TEST_ASSERT_EQUAL_INT(7, (int)request->body_size);
+    compiled_request_destroy(request);
+
+    request = compiled_request_create(HTTP_METHOD_PUT, "http://localhost/",
+                                      "content-type: text/plain", "hello", 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(1, request->header_count);
+    TEST_ASSERT_FALSE(has_header(request, "Content-Type: application/json"));
+    compiled_request_destroy(request);
+
+    // An empty body is no body
+    request = compiled_request_create(HTTP_METHOD_POST, "http://localhost/", NULL, "", 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_NULL(request->body);
+    TEST_ASSERT_EQUAL_INT(0, request->header_count);
+    compiled_request_destroy(request);
+}
+
+// Test that the source hash tracks every field
+void test_compiled_request_hash(void) {
+    uint64_t base = compiled_request_hash(HTTP_METHOD_GET, "http://a/", "A: 1", NULL);
+    TEST_ASSERT_TRUE(base == compiled_request_hash(HTTP_METHOD_GET, "http://a/", "A: 1", ""));
+    TEST_ASSERT_TRUE(base != compiled_request_hash(HTTP_METHOD_POST, "http://a/", "A: 1", NULL));
+    TEST_ASSERT_TRUE(base != compiled_request_hash(HTTP_METHOD_GET, "http://b/", "A: 1", NULL));
+    TEST_ASSERT_TRUE(base != compiled_request_hash(HTTP_METHOD_GET, "http://a/", "A: 2", NULL));
+    TEST_ASSERT_TRUE(base != compiled_request_hash(HTTP_METHOD_GET, "http://a/", "A: 1", "x"));
+    TEST_ASSERT_TRUE(compiled_request_hash(HTTP_METHOD_GET, "ab", "c", NULL) !=
+                     compiled_request_hash(HTTP_METHOD_GET, "a", "bc", NULL));
+
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://a/", "A: 1", NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_TRUE(request->source_hash == base);
+    compiled_request_destroy(request);
+}
+
+// Test that routing directives are read from comment lines
+void test_compile_route_directives(void) {
+    const char *headers =
+        "Accept: */*\n"
+        "# @unix-socket /run/api.sock  \n"
+        "# @unix-socket /run/other.sock\n"
+        "# @resolve api.example.com:443:10.0.0.5\n"
+        "# @resolve api.example.com:80:::1\n"
+        "# @resolve missing-port:10.0.0.5\n"
+        "# @resolved not-a-directive:1:2\n"
+        "# @http-version 2-prior-knowledge\n"
+        "# @http-version 1.1\n";
+
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "https://api.example.com/",
+                                                          headers, NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(1, request->header_count);
+    TEST_ASSERT_EQUAL_STRING("/run/api.sock", request->unix_socket);
+    TEST_ASSERT_NOT_NULL(request->connect_to);
+    TEST_ASSERT_EQUAL_STRING("api.example.com:443:10.0.0.5:443", request->connect_to->data);
+    TEST_ASSERT_NOT_NULL(request->connect_to->next);
+    TEST_ASSERT_EQUAL_STRING("api.example.com:80:[::1]:80", request->connect_to->next->data);
+    TEST_ASSERT_NULL(request->connect_to->next->next);
+    TEST_ASSERT_EQUAL_INT(CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE, (int)request->http_version);
+    compiled_request_destroy(request);
+
+    request = compiled_request_create(HTTP_METHOD_GET, "http://localhost/", "A: 1", NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_NULL(request->unix_socket);
+    TEST_ASSERT_NULL(request->connect_to);
+    TEST_ASSERT_EQUAL_INT(CURL_HTTP_VERSION_NONE, (int)request->http_version);
+    TEST_ASSERT_EQUAL_INT(0, compiled_request_add_routes(request, "# @http-version 2"));
+    TEST_ASSERT_EQUAL_INT(CURL_HTTP_VERSION_2TLS, (int)request->http_version);
+    compiled_request_destroy(request);
+}
+
+// Test that default routes come after the request's own
+void test_compiled_request_add_routes(void) {
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://a/",
+                                                          "# @resolve a:80:10.0.0.1", NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(0, compiled_request_add_routes(request, NULL));
+    TEST_ASSERT_EQUAL_INT(0, compiled_request_add_routes(request,
+        "X-Ignored: 1\n# @unix-socket /run/default.sock\n# @resolve a:80:10.0.0.2\n"));
+    TEST_ASSERT_EQUAL_INT(0, request->header_count);
+    TEST_ASSERT_EQUAL_STRING("/run/default.sock", request->unix_socket);
+    TEST_ASSERT_EQUAL_STRING("a:80:10.0.0.1:80", request->connect_to->data);
+    TEST_ASSERT_EQUAL_STRING("a:80:10.0.0.2:80", request->connect_to->next->data);
+
+    // The request's own socket wins
+    TEST_ASSERT_EQUAL_INT(0, compiled_request_add_routes(request, "# @unix-socket /run/later.sock"));
+    TEST_ASSERT_EQUAL_STRING("/run/default.sock", request->unix_socket);
+    compiled_request_destroy(request);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_compiled_request.c");
+
+    RUN_TEST(test_compile_headers_are_trimmed);
+    RUN_TEST(test_compile_many_headers);
+    RUN_TEST(test_compile_default_content_type);
+    RUN_TEST(test_compiled_request_hash);
+    RUN_TEST(test_compile_route_directives);
+    RUN_TEST(test_compiled_request_add_routes);
+
+    return UnityEnd();
+}
@@ -0,0 +1,216 @@
+#include "unity/unity.h"
+#include "../include/data_file.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static char data_path[256];
+
+void setUp(void) {
+    data_path[0] = '\0';
+}
+
+void tearDown(void) {
+    if (data_path[0]) remove(data_path);
+}
+
+static void write_data(const char *extension, const char *content) {
+    snprintf(data_path, sizeof(data_path), "/tmp/apikit_data_%d%s", (int)getpid(), extension);
+    FILE *file = fopen(data_path, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(content, file);
+    fclose(file);
+}
+
+static void assert_field(const data_row_t *row, int index, const char *name, const char *value) {
+    TEST_ASSERT_TRUE(index < row->field_count);
+    const data_field_t *field = &row->fields[index];
+    TEST_ASSERT_EQUAL_INT((int)strlen(name), (int)field->name_length);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(name, field->name, field->name_length));
+    if (!value) {
+        TEST_ASSERT_NULL(field->value);
+        return;
+    }
+    TEST_ASSERT_NOT_NULL(field->value);
+    TEST_ASSERT_EQUAL_INT((int)strlen(value), (int)field->value_length);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(value, field->value, field->value_length));
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_csv_rows(void) {
+    const char *content = "\xEF\xBB\xBFid,\"full name\",note\r\n"
+                          "1,Ada,\"says \"\"hi\"\", twice\"\r\n"
+                          "\r\n"
+                          "2,,\"\"\n"
+                          "3,Bob\n"
+                          "4,\"Eve,x\",last";
+    write_data(".csv", content);
+    data_file_t *file = data_file_open(data_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(DATA_FORMAT_CSV, data_file_format(file));
+    TEST_ASSERT_EQUAL_INT(1, (int)data_file_chunk_count(file, DATA_CHUNK_SIZE));
+
+    data_cursor_t cursor;
+    data_row_t row = {0};
+    data_file_chunk(file, DATA_CHUNK_SIZE, 0, &cursor);
+
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT(3, row.field_count);
+    assert_field(&row, 0, "id", "1");
+    assert_field(&row, 1, "full name", "Ada");
+    assert_field(&row, 2, "note", "says \"hi\", twice");
+
+    // Blank lines are skipped; empty fields are empty values
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    assert_field(&row, 0, "id", "2");
+    assert_field(&row, 1, "full name", "");
+    assert_field(&row, 2, "note", "");
+
+    // Too few fields
+    TEST_ASSERT_EQUAL_INT(-1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT((int)(strstr(content, "3,Bob") - content), (int)row.offset);
+
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    assert_field(&row, 1, "full name", "Eve,x");
+    assert_field(&row, 2, "note", "last");
+    TEST_ASSERT_EQUAL_INT(0, data_file_next(file, &cursor, &row));
+
+    data_file_release(file, &cursor);
+    data_row_free(&row);
+    data_file_close(file);
+}
+
+void test_jsonl_rows(void) {
+    write_data(".jsonl", "{\"id\": 1, \"name\": \"A\\u00e9\\n\", \"tags\": [\"x\", \"]\"], \"ok\": true}\n"
+                         "{\"id\":2,\"meta\":{\"a\":{\"b\":\"}\"}},\"gone\":null,\"k\\\"ey\":\"v\"}\n"
+                         "{}\n"
+                         "[1, 2]\n"
+                         "{\"id\": 3,}\n"
+                         "{\"id\": \"4\"} trailing\n"
+                         "{\"id\": \"5\"}");
+    data_file_t *file = data_file_open(data_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(DATA_FORMAT_JSONL, data_file_format(file));
+
+    data_cursor_t cursor;
+    data_row_t row = {0};
+    data_file_chunk(file, DATA_CHUNK_SIZE, 0, &cursor);
+
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT(4, row.field_count);
+    assert_field(&row, 0, "id", "1");
+    assert_field(&row, 1, "name", "A\xc3\xa9\n");
+    assert_field(&row, 2, "tags", "[\"x\", \"]\"]");
+    assert_field(&row, 3, "ok", "true");
+
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT(4, row.field_count);
+    assert_field(&row, 1, "meta", "{\"a\":{\"b\":\"}\"}}");
+    assert_field(&row, 2, "gone", NULL);
+    assert_field(&row, 3, "k\"ey", "v");
+
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT(0, row.field_count);
+
+    // Not an object, trailing comma, text after the object
+    TEST_ASSERT_EQUAL_INT(-1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT(-1, data_file_next(file, &cursor, &row));
+    TEST_ASSERT_EQUAL_INT(-1, data_file_next(file, &cursor, &row));
+
+    TEST_ASSERT_EQUAL_INT(1, data_file_next(file, &cursor, &row));
+    assert_field(&row, 0, "id", "5");
+    TEST_ASSERT_EQUAL_INT(0, data_file_next(file, &cursor, &row));
+
+    data_row_free(&row);
+    data_file_close(file);
+}
+
+void test_format_detection(void) {
+    write_data(".txt", "  {\"a\": 1}\n");
+    data_file_t *file = data_file_open(data_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(DATA_FORMAT_JSONL, data_file_format(file));
+    data_file_close(file);
+    remove(data_path);
+
+    write_data(".dat", "a,b\n1,2\n");
+    file = data_file_open(data_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(DATA_FORMAT_CSV, data_file_format(file));
+    data_file_close(file);
+    remove(data_path);
+
+    // An empty JSONL file has no rows; a CSV file needs its header
+    write_data(".ndjson", "");
+    file = data_file_open(data_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(0, (int)data_file_chunk_count(file, DATA_CHUNK_SIZE));
+    data_file_close(file);
+    remove(data_path);
+
+    write_data(".csv", "");
+    TEST_ASSERT_NULL(data_file_open(data_path));
+    TEST_ASSERT_NULL(data_file_open("/nonexistent/rows.csv"));
+}
+
+void test_chunks_cover_every_row_once(void) {
+    // Rows of varying length, some longer than the smallest chunks
+    size_t capacity = 64 * 1024;
+    char *content = malloc(capacity);
+    TEST_ASSERT_NOT_NULL(content);
+    size_t used = (size_t)snprintf(content, capacity, "id,pad\n");
+    int rows = 0;
+    long expected = 0;
+    for (int i = 1; used + 200 < capacity; i++) {
+        used += (size_t)snprintf(content + used, capacity - used, "%d,%.*s\n", i, (i * 7) % 90,
+                                 "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+        rows++;
+        expected += i;
+    }
+    write_data(".csv", content);
+    free(content);
+
+    data_file_t *file = data_file_open(data_path);
+    TEST_ASSERT_NOT_NULL(file);
+    uint64_t chunk_sizes[] = { 1, 13, 64, 4096, DATA_CHUNK_SIZE };
+    data_row_t row = {0};
+    for (int c = 0; c < 5; c++) {
+        uint64_t chunks = data_file_chunk_count(file, chunk_sizes[c]);
+        int seen = 0;
+        long sum = 0;
+        // Out of order, as workers take them
+        for (uint64_t k = 0; k < chunks; k++) {
+            uint64_t index = (k * 7919) % chunks;
+            if (chunks % 7919 == 0) index = k;
+            data_cursor_t cursor;
+            data_file_chunk(file, chunk_sizes[c], index, &cursor);
+            int status;
+            while ((status = data_file_next(file, &cursor, &row)) != 0) {
+                TEST_ASSERT_EQUAL_INT(1, status);
+                seen++;
+                sum += strtol(row.fields[0].value, NULL, 10);
+            }
+            data_file_release(file, &cursor);
+        }
+        TEST_ASSERT_EQUAL_INT(rows, seen);
+        TEST_ASSERT_TRUE(sum == expected);
+    }
+    data_row_free(&row);
+    data_file_close(file);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_data_file.c");
+
+    RUN_TEST(test_csv_rows);
+    RUN_TEST(test_jsonl_rows);
+    RUN_TEST(test_format_detection);
+    RUN_TEST(test_chunks_cover_every_row_once);
+
+    return UnityEnd();
+}
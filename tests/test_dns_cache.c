@@ -0,0 +1,150 @@
+#include "unity/unity.h"
+#include "../include/dns_cache.h"
+#include "../include/http_client.h"
+#include "../include/compiled_request.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <signal.h>
+
+// Mock server handler: answers 200 {} and closes
+static mock_http_t *server;
+
+static char state_dir[64];
+static char dns_path[128];
+
+static int respond(int client, const mock_http_request_t *request, void *user_data) {
+    (void)request;
+    (void)user_data;
+    mock_http_reply(client, 200, "Connection: close\r\n", "{}");
+    return 0;
+}
+
+static http_response_t *send_get(http_client_t *client, const char *host) {
+    char url[128];
+    snprintf(url, sizeof(url), "http://%s:%d/", host, mock_http_port(server));
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    http_response_t *response = http_request_compiled(client, request);
+    compiled_request_destroy(request);
+    return response;
+}
+
+void setUp(void) {
+    snprintf(state_dir, sizeof(state_dir), "/tmp/apikit_dns_test_%d", (int)getpid());
+    mkdir(state_dir, 0755);
+    snprintf(dns_path, sizeof(dns_path), "%s/dns.txt", state_dir);
+    remove(dns_path);
+}
+
+void tearDown(void) {
+    char path[128];
+    remove(dns_path);
+    snprintf(path, sizeof(path), "%s/alt-svc.txt", state_dir);
+    remove(path);
+    snprintf(path, sizeof(path), "%s/hsts.txt", state_dir);
+    remove(path);
+    rmdir(state_dir);
+}
+
+// Test recording, the resolve list, and a save/load round trip
+void test_dns_cache_round_trip(void) {
+    time_t now = time(NULL);
+    dns_cache_t *cache = dns_cache_load(dns_path);
+    TEST_ASSERT_NOT_NULL(cache);
+    TEST_ASSERT_EQUAL_INT(0, dns_cache_count(cache));
+
+    dns_cache_record(cache, "api.example.com", 443, "93.184.216.34", now);
+    dns_cache_record(cache, "v6.example.com", 80, "2001:db8::1", now);
+    dns_cache_record(cache, "127.0.0.1", 80, "127.0.0.1", now);
+    dns_cache_record(cache, "api.example.com", 443, "93.184.216.35", now);
+    TEST_ASSERT_EQUAL_INT(2, dns_cache_count(cache));
+
+    // Newest record last; IPv6 in brackets
+    struct curl_slist *list = dns_cache_resolve_list(cache, now);
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_EQUAL_STRING("+v6.example.com:80:[2001:db8::1]", list->data);
+    TEST_ASSERT_EQUAL_STRING("+api.example.com:443:93.184.216.35", list->next->data);
+    TEST_ASSERT_NULL(list->next->next);
+    curl_slist_free_all(list);
+
+    TEST_ASSERT_EQUAL_INT(0, dns_cache_save(cache, dns_path));
+    dns_cache_destroy(cache);
+
+    cache = dns_cache_load(dns_path);
+    TEST_ASSERT_EQUAL_INT(2, dns_cache_count(cache));
+    list = dns_cache_resolve_list(cache, now);
+    TEST_ASSERT_EQUAL_STRING("+api.example.com:443:93.184.216.35", list->next->data);
+    curl_slist_free_all(list);
+    dns_cache_destroy(cache);
+}
+
+// Test that expired entries are neither offered nor saved
+void test_dns_cache_expiry(void) {
+    time_t now = time(NULL);
+    dns_cache_t *cache = dns_cache_load(dns_path);
+    dns_cache_record(cache, "old.example.com", 80, "10.0.0.1", now - DNS_CACHE_TTL_SECONDS - 1);
+    dns_cache_record(cache, "new.example.com", 80, "10.0.0.2", now);
+
+    struct curl_slist *list = dns_cache_resolve_list(cache, now);
+    TEST_ASSERT_EQUAL_STRING("+new.example.com:80:10.0.0.2", list->data);
+    TEST_ASSERT_NULL(list->next);
+    curl_slist_free_all(list);
+
+    TEST_ASSERT_EQUAL_INT(0, dns_cache_save(cache, dns_path));
+    dns_cache_destroy(cache);
+    cache = dns_cache_load(dns_path);
+    TEST_ASSERT_EQUAL_INT(1, dns_cache_count(cache));
+    dns_cache_destroy(cache);
+}
+
+// Test that a client saves the addresses it reached and starts with them next time
+void test_client_persists_dns(void) {
+    http_client_options_t options = { .state_dir = state_dir };
+    http_client_t *client = http_client_create_ex(&options);
+    TEST_ASSERT_NOT_NULL(client);
+    http_response_t *response = send_get(client, "localhost");
+    TEST_ASSERT_EQUAL_INT(200, response->status_code);
+    http_response_free(response);
+    http_client_destroy(client);
+
+    dns_cache_t *cache = dns_cache_load(dns_path);
+    TEST_ASSERT_EQUAL_INT(1, dns_cache_count(cache));
+
+    // A name that cannot resolve works only through the saved entry
+    dns_cache_record(cache, "apikit-test.invalid", mock_http_port(server), "127.0.0.1", time(NULL));
+    TEST_ASSERT_EQUAL_INT(0, dns_cache_save(cache, dns_path));
+    dns_cache_destroy(cache);
+
+    client = http_client_create_ex(&options);
+    TEST_ASSERT_NOT_NULL(client);
+    response = send_get(client, "apikit-test.invalid");
+    TEST_ASSERT_NULL(response->error_message);
+    TEST_ASSERT_EQUAL_INT(200, response->status_code);
+    http_response_free(response);
+    http_client_destroy(client);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+
+    UnityBegin("test_dns_cache.c");
+
+    RUN_TEST(test_dns_cache_round_trip);
+    RUN_TEST(test_dns_cache_expiry);
+    RUN_TEST(test_client_persists_dns);
+
+    int result = UnityEnd();
+    mock_http_stop(server);
+    return result;
+}
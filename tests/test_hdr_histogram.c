@@ -0,0 +1,218 @@
+#include "unity/unity.h"
+#include "../include/hdr_histogram.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define THREAD_COUNT 4
+#define VALUES_PER_THREAD 100000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+typedef struct {
+    hdr_histogram_t histogram;
+    uint64_t seed;
+} recorder_t;
+
+static void *record_values(void *arg) {
+    recorder_t *recorder = arg;
+    for (int i = 0; i < VALUES_PER_THREAD; i++) {
+        hdr_histogram_record(&recorder->histogram, next_random(&recorder->seed) % 1000000);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_init_rejects_bad_layouts(void) {
+    hdr_histogram_t histogram;
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_init(&histogram, 0, 32, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_init(&histogram, HDR_PRECISION_MAX + 1, 40, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_init(&histogram, 5, 5, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_init(&histogram, 5, 65, NULL));
+
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&histogram, 5, 32, NULL));
+    TEST_ASSERT_EQUAL_INT(HDR_BUCKET_COUNT(5, 32), histogram.bucket_count);
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_count(&histogram));
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_percentile(&histogram, 50));
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_max(&histogram));
+    hdr_histogram_free(&histogram);
+    hdr_histogram_free(NULL);
+}
+
+void test_small_values_are_exact(void) {
+    hdr_histogram_t histogram;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&histogram, 5, 32, NULL));
+    for (uint64_t v = 0; v < 64; v++) hdr_histogram_record(&histogram, v);
+
+    TEST_ASSERT_EQUAL_INT(64, (int)hdr_histogram_count(&histogram));
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_min(&histogram));
+    TEST_ASSERT_EQUAL_INT(63, (int)hdr_histogram_max(&histogram));
+    TEST_ASSERT_EQUAL_INT(31, (int)hdr_histogram_percentile(&histogram, 50));
+    TEST_ASSERT_EQUAL_INT(63, (int)hdr_histogram_percentile(&histogram, 100));
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_percentile(&histogram, 0));
+    TEST_ASSERT_TRUE(hdr_histogram_mean(&histogram) > 31.4 && hdr_histogram_mean(&histogram) < 31.6);
+
+    hdr_histogram_reset(&histogram);
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_count(&histogram));
+    hdr_histogram_free(&histogram);
+}
+
+void test_large_values_within_precision(void) {
+    hdr_histogram_t histogram;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&histogram, 7, 48, NULL));
+
+    uint64_t seed = 12345;
+    for (int i = 0; i < 10000; i++) {
+        uint64_t value = next_random(&seed) >> (next_random(&seed) % 24 + 16);
+        hdr_histogram_reset(&histogram);
+        hdr_histogram_record(&histogram, value);
+        uint64_t low = hdr_histogram_min(&histogram);
+        uint64_t high = hdr_histogram_max(&histogram);
+        uint64_t middle = hdr_histogram_percentile(&histogram, 50);
+        TEST_ASSERT_TRUE(low <= value && value <= high);
+        TEST_ASSERT_TRUE(low <= middle && middle <= high);
+        // A bucket is at most 1/128 of its lowest value wide
+        TEST_ASSERT_TRUE((high - low + 1) * 128 <= (low > 128 ? low : 128));
+    }
+
+    // Values past the range count as the largest one
+    hdr_histogram_reset(&histogram);
+    hdr_histogram_record(&histogram, UINT64_MAX);
+    TEST_ASSERT_TRUE(hdr_histogram_max(&histogram) == (1ull << 48) - 1);
+    hdr_histogram_free(&histogram);
+}
+
+void test_caller_counts_and_merge(void) {
+    // Counts in caller memory, as in a shared region
+    uint64_t counts[HDR_BUCKET_COUNT(4, 20)];
+    memset(counts, 0, sizeof(counts));
+    hdr_histogram_t shared, own;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&shared, 4, 20, counts));
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&own, 4, 20, NULL));
+    hdr_histogram_record_n(&shared, 1000, 3);
+    hdr_histogram_record(&own, 10);
+
+    hdr_histogram_merge(&own, &shared);
+    TEST_ASSERT_EQUAL_INT(4, (int)hdr_histogram_count(&own));
+    TEST_ASSERT_EQUAL_INT(10, (int)hdr_histogram_min(&own));
+    TEST_ASSERT_TRUE(hdr_histogram_percentile(&own, 50) >= 992 && hdr_histogram_percentile(&own, 50) < 1024);
+    hdr_histogram_free(&shared);
+    uint64_t kept = 0;
+    for (int i = 0; i < HDR_BUCKET_COUNT(4, 20); i++) kept += counts[i];
+    TEST_ASSERT_EQUAL_INT(3, (int)kept);
+
+    // A different layout keeps the counts at the coarser precision
+    hdr_histogram_t fine;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&fine, 10, 30, NULL));
+    hdr_histogram_merge(&fine, &own);
+    TEST_ASSERT_EQUAL_INT(4, (int)hdr_histogram_count(&fine));
+    TEST_ASSERT_EQUAL_INT(10, (int)hdr_histogram_min(&fine));
+    hdr_histogram_free(&fine);
+    hdr_histogram_free(&own);
+}
+
+void test_per_thread_recording(void) {
+    recorder_t recorders[THREAD_COUNT];
+    pthread_t threads[THREAD_COUNT];
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&recorders[t].histogram, 5, 32, NULL));
+        recorders[t].seed = 0x9E3779B97F4A7C15ull * (uint64_t)(t + 1);
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[t], NULL, record_values, &recorders[t]));
+    }
+
+    // Merging while the threads record sees a consistent prefix of each
+    hdr_histogram_t live;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&live, 5, 32, NULL));
+    for (int t = 0; t < THREAD_COUNT; t++) hdr_histogram_merge(&live, &recorders[t].histogram);
+    TEST_ASSERT_TRUE(hdr_histogram_count(&live) <= THREAD_COUNT * VALUES_PER_THREAD);
+    hdr_histogram_free(&live);
+
+    hdr_histogram_t total;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&total, 5, 32, NULL));
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        pthread_join(threads[t], NULL);
+        hdr_histogram_merge(&total, &recorders[t].histogram);
+        hdr_histogram_free(&recorders[t].histogram);
+    }
+    TEST_ASSERT_EQUAL_INT(THREAD_COUNT * VALUES_PER_THREAD, (int)hdr_histogram_count(&total));
+
+    // Uniform over [0, 1000000): the median is near 500000, within 3%
+    uint64_t median = hdr_histogram_percentile(&total, 50);
+    TEST_ASSERT_TRUE(median > 480000 && median < 520000);
+    hdr_histogram_free(&total);
+}
+
+void test_encode_round_trip(void) {
+    hdr_histogram_t histogram;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_init(&histogram, 5, 32, NULL));
+    hdr_histogram_record_n(&histogram, 3, 7);
+    hdr_histogram_record_n(&histogram, 1500, 300);
+    hdr_histogram_record(&histogram, 250000);
+    hdr_histogram_record(&histogram, 1ull << 40);
+
+    size_t size = hdr_histogram_encode(&histogram, NULL, 0);
+    // Header, then four buckets of gap and count: small next to 7 KB of counts
+    TEST_ASSERT_TRUE(size > 4 && size < 32);
+    TEST_ASSERT_TRUE(size <= HDR_ENCODED_MAX(histogram.bucket_count));
+    uint8_t buffer[64];
+    memset(buffer, 0xee, sizeof(buffer));
+    TEST_ASSERT_EQUAL_INT((int)size, (int)hdr_histogram_encode(&histogram, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_INT(0xee, buffer[size]);
+
+    hdr_histogram_t decoded;
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_decode(&decoded, buffer, size));
+    TEST_ASSERT_EQUAL_INT(5, decoded.precision_bits);
+    TEST_ASSERT_EQUAL_INT(32, decoded.range_bits);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(histogram.counts, decoded.counts,
+                                    (size_t)histogram.bucket_count * sizeof(uint64_t)));
+    hdr_histogram_free(&decoded);
+
+    // Truncated, corrupt and foreign input
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_decode(&decoded, buffer, size - 1));
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_decode(&decoded, buffer, 3));
+    uint8_t corrupt[64];
+    memcpy(corrupt, buffer, size);
+    corrupt[0] = 'X';
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_decode(&decoded, corrupt, size));
+    memcpy(corrupt, buffer, size);
+    corrupt[4] = 0xff;          // First gap past the last bucket
+    corrupt[5] = 0x7f;
+    TEST_ASSERT_EQUAL_INT(-1, hdr_histogram_decode(&decoded, corrupt, size));
+
+    // Empty histogram: just the header
+    hdr_histogram_reset(&histogram);
+    TEST_ASSERT_EQUAL_INT(4, (int)hdr_histogram_encode(&histogram, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_INT(0, hdr_histogram_decode(&decoded, buffer, 4));
+    TEST_ASSERT_EQUAL_INT(0, (int)hdr_histogram_count(&decoded));
+    hdr_histogram_free(&decoded);
+    hdr_histogram_free(&histogram);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_hdr_histogram.c");
+
+    RUN_TEST(test_init_rejects_bad_layouts);
+    RUN_TEST(test_small_values_are_exact);
+    RUN_TEST(test_large_values_within_precision);
+    RUN_TEST(test_caller_counts_and_merge);
+    RUN_TEST(test_per_thread_recording);
+    RUN_TEST(test_encode_round_trip);
+
+    return UnityEnd();
+}
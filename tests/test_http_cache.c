@@ -0,0 +1,306 @@
+#include "unity/unity.h"
+#include "../include/http_cache.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
+
+// Mock server handler: answers and closes
+static mock_http_t *server;
+static pthread_mutex_t server_lock = PTHREAD_MUTEX_INITIALIZER;
+static int server_requests = 0;       // Requests that reached the server
+static int server_conditional = 0;    // Of those, with If-None-Match/If-Modified-Since
+
+static http_client_t *client;
+static http_cache_t *cache;
+static char base_url[64];
+
+static const char last_modified[] = "Mon, 01 Jan 2024 00:00:00 GMT";
+
+static int respond(int client_socket, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    const char *path = request->path;
+    int conditional = strstr(request->head, "If-None-Match: ") ||
+                      strstr(request->head, "If-Modified-Since: ") != NULL;
+
+    pthread_mutex_lock(&server_lock);
+    int count = ++server_requests;
+    server_conditional += conditional;
+    pthread_mutex_unlock(&server_lock);
+
+    int status = 200;
+    char headers[4096] = "";
+    char body[128];
+    snprintf(body, sizeof(body), "{\"path\": \"%s\", \"request\": %d}", path, count);
+
+    if (strcmp(path, "/fresh") == 0) {
+        snprintf(headers, sizeof(headers), "Cache-Control: max-age=3600\r\n");
+    } else if (strcmp(path, "/etag") == 0) {
+        snprintf(headers, sizeof(headers), "Cache-Control: no-cache\r\nETag: \"v1\"\r\n");
+        if (conditional) status = 304;
+    } else if (strcmp(path, "/modified") == 0) {
+        snprintf(headers, sizeof(headers), "Cache-Control: max-age=0\r\nLast-Modified: %s\r\n", last_modified);
+        if (conditional) status = 304;
+    } else if (strcmp(path, "/vary") == 0) {
+        const char *accept = strstr(request->head, "Accept: ");
+        char value[32] = "";
+        if (accept) sscanf(accept + 8, "%31[^\r]", value);
+        snprintf(headers, sizeof(headers), "Cache-Control: max-age=3600\r\nVary: Accept\r\n");
+        snprintf(body, sizeof(body), "{\"accept\": \"%s\"}", value);
+    } else if (strcmp(path, "/nostore") == 0) {
+        snprintf(headers, sizeof(headers), "Cache-Control: no-store\r\n");
+    } else if (strcmp(path, "/compact") == 0) {
+        // No space after the colons and bare LF line ends: stored shorter than rewritten
+        size_t length = (size_t)snprintf(headers, sizeof(headers), "Cache-Control:no-cache\r\nETag:\"a\"\r\n");
+        if (conditional) {
+            status = 304;
+        } else {
+            for (int i = 0; i < 40; i++) length += (size_t)snprintf(headers + length, sizeof(headers) - length, "Xa:1\n");
+        }
+    } else if (strcmp(path, "/grow") == 0) {
+        // The 304 adds more headers than the cache has room for
+        size_t length = (size_t)snprintf(headers, sizeof(headers), "Cache-Control: no-cache\r\nETag: \"v1\"\r\n");
+        if (conditional) {
+            status = 304;
+            for (int i = 0; i < 40; i++) {
+                length += (size_t)snprintf(headers + length, sizeof(headers) - length,
+                                           "X-Padding-%02d: %040d\r\n", i, i);
+            }
+        }
+    }
+
+    size_t length = strlen(headers);
+    if (status == 304) {
+        snprintf(headers + length, sizeof(headers) - length, "X-Revalidated: yes\r\nConnection: close\r\n");
+        mock_http_reply(client_socket, 304, headers, NULL);
+    } else {
+        snprintf(headers + length, sizeof(headers) - length,
+                 "Content-Type: application/json\r\nConnection: close\r\n");
+        mock_http_reply(client_socket, 200, headers, body);
+    }
+    return 0;
+}
+
+static int requests_seen(void) {
+    pthread_mutex_lock(&server_lock);
+    int count = server_requests;
+    pthread_mutex_unlock(&server_lock);
+    return count;
+}
+
+// Send a request through the cached client; returns the response
+static http_response_t *send_request(http_method_t method, const char *path, const char *headers) {
+    char url[128];
+    snprintf(url, sizeof(url), "%s%s", base_url, path);
+    compiled_request_t *request = compiled_request_create(method, url, headers, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    http_response_t *response = http_request_compiled(client, request);
+    compiled_request_destroy(request);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_NULL(response->error_message);
+    return response;
+}
+
+void setUp(void) {
+    cache = http_cache_create(1 << 20, NULL);
+    http_client_set_cache(client, cache);
+    pthread_mutex_lock(&server_lock);
+    server_requests = 0;
+    server_conditional = 0;
+    pthread_mutex_unlock(&server_lock);
+}
+
+void tearDown(void) {
+    http_client_set_cache(client, NULL);
+    http_cache_destroy(cache);
+}
+
+// Test that fresh responses are served without a request
+void test_cache_fresh_hit(void) {
+    http_response_t *first = send_request(HTTP_METHOD_GET, "/fresh", NULL);
+    http_response_t *second = send_request(HTTP_METHOD_GET, "/fresh", NULL);
+
+    TEST_ASSERT_EQUAL_INT(1, requests_seen());
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_NONE, first->cache_result);
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_HIT, second->cache_result);
+    TEST_ASSERT_EQUAL_INT(200, second->status_code);
+    TEST_ASSERT_EQUAL_STRING(first->body, second->body);
+    TEST_ASSERT_NOT_NULL(http_headers_get(&second->header_fields, "cache-control", NULL));
+
+    http_cache_stats_t stats = http_cache_stats(cache);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.hits);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.misses);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.stores);
+
+    // Cache-Control: no-cache on the request skips the stored copy
+    http_response_t *forced = send_request(HTTP_METHOD_GET, "/fresh", "Cache-Control: no-cache");
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_NONE, forced->cache_result);
+    TEST_ASSERT_EQUAL_INT(2, requests_seen());
+
+    http_response_free(first);
+    http_response_free(second);
+    http_response_free(forced);
+}
+
+// Test ETag and Last-Modified revalidation
+void test_cache_revalidation(void) {
+    const char *paths[] = {"/etag", "/modified"};
+    for (int i = 0; i < 2; i++) {
+        http_response_t *first = send_request(HTTP_METHOD_GET, paths[i], NULL);
+        http_response_t *second = send_request(HTTP_METHOD_GET, paths[i], NULL);
+
+        TEST_ASSERT_EQUAL_INT(HTTP_CACHE_REVALIDATED, second->cache_result);
+        TEST_ASSERT_EQUAL_INT(200, second->status_code);
+        TEST_ASSERT_EQUAL_STRING(first->body, second->body);
+
+        // Headers from the 304 replace the stored ones
+        TEST_ASSERT_NOT_NULL(http_headers_get(&second->header_fields, "X-Revalidated", NULL));
+        TEST_ASSERT_NOT_NULL(http_headers_get(&second->header_fields, "Content-Type", NULL));
+
+        http_response_free(first);
+        http_response_free(second);
+    }
+
+    TEST_ASSERT_EQUAL_INT(4, requests_seen());
+    TEST_ASSERT_EQUAL_INT(2, server_conditional);
+    TEST_ASSERT_EQUAL_INT(2, (int)http_cache_stats(cache).revalidated);
+}
+
+// Test that a 304 merged into compactly written stored headers stays in bounds
+void test_cache_revalidation_compact_headers(void) {
+    http_response_t *first = send_request(HTTP_METHOD_GET, "/compact", NULL);
+    http_response_t *second = send_request(HTTP_METHOD_GET, "/compact", NULL);
+
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_REVALIDATED, second->cache_result);
+    TEST_ASSERT_EQUAL_STRING(first->body, second->body);
+    TEST_ASSERT_NOT_NULL(http_headers_get(&second->header_fields, "Xa", NULL));
+    TEST_ASSERT_NOT_NULL(http_headers_get(&second->header_fields, "X-Revalidated", NULL));
+
+    http_response_free(first);
+    http_response_free(second);
+}
+
+// Test that an entry grown by a 304 past the budget is evicted
+void test_cache_revalidation_evicts(void) {
+    http_client_set_cache(client, NULL);
+    http_cache_destroy(cache);
+    cache = http_cache_create(2048, NULL);
+    http_client_set_cache(client, cache);
+
+    http_response_t *first = send_request(HTTP_METHOD_GET, "/grow", NULL);
+    http_response_t *second = send_request(HTTP_METHOD_GET, "/grow", NULL);
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_REVALIDATED, second->cache_result);
+    TEST_ASSERT_NOT_NULL(http_headers_get(&second->header_fields, "X-Padding-39", NULL));
+    TEST_ASSERT_EQUAL_INT(1, (int)http_cache_stats(cache).evictions);
+
+    // Nothing is left to revalidate against
+    http_response_t *third = send_request(HTTP_METHOD_GET, "/grow", NULL);
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_NONE, third->cache_result);
+
+    http_response_free(first);
+    http_response_free(second);
+    http_response_free(third);
+}
+
+// Test that Vary keeps a variant per request header value
+void test_cache_vary(void) {
+    http_response_t *json = send_request(HTTP_METHOD_GET, "/vary", "Accept: application/json");
+    http_response_t *xml = send_request(HTTP_METHOD_GET, "/vary", "Accept: text/xml");
+    http_response_t *again = send_request(HTTP_METHOD_GET, "/vary", "accept: application/json");
+
+    TEST_ASSERT_EQUAL_INT(2, requests_seen());
+    TEST_ASSERT_EQUAL_STRING("{\"accept\": \"text/xml\"}", xml->body);
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_HIT, again->cache_result);
+    TEST_ASSERT_EQUAL_STRING("{\"accept\": \"application/json\"}", again->body);
+
+    http_response_free(json);
+    http_response_free(xml);
+    http_response_free(again);
+}
+
+// Test no-store and invalidation by unsafe methods
+void test_cache_no_store_and_invalidation(void) {
+    http_response_free(send_request(HTTP_METHOD_GET, "/nostore", NULL));
+    http_response_free(send_request(HTTP_METHOD_GET, "/nostore", NULL));
+    TEST_ASSERT_EQUAL_INT(2, requests_seen());
+
+    http_response_free(send_request(HTTP_METHOD_GET, "/fresh", NULL));
+    http_response_free(send_request(HTTP_METHOD_POST, "/fresh", NULL));
+    http_response_t *after = send_request(HTTP_METHOD_GET, "/fresh", NULL);
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_NONE, after->cache_result);
+    TEST_ASSERT_EQUAL_INT(5, requests_seen());
+    http_response_free(after);
+}
+
+// Test that entries survive on disk, even when too large for memory
+void test_cache_disk_store(void) {
+    char directory[128];
+    snprintf(directory, sizeof(directory), "/tmp/apikit_test_cache_%d", (int)getpid());
+
+    http_cache_t *disk = http_cache_create(1 << 20, directory);
+    TEST_ASSERT_NOT_NULL(disk);
+    http_client_set_cache(client, disk);
+    http_response_t *first = send_request(HTTP_METHOD_GET, "/fresh", NULL);
+    http_cache_destroy(disk);
+
+    // A new cache with no memory budget reads the entry back from disk
+    disk = http_cache_create(0, directory);
+    http_client_set_cache(client, disk);
+    http_response_t *second = send_request(HTTP_METHOD_GET, "/fresh", NULL);
+    TEST_ASSERT_EQUAL_INT(1, requests_seen());
+    TEST_ASSERT_EQUAL_INT(HTTP_CACHE_HIT, second->cache_result);
+    TEST_ASSERT_EQUAL_STRING(first->body, second->body);
+    http_client_set_cache(client, cache);
+    http_cache_destroy(disk);
+
+    http_response_free(first);
+    http_response_free(second);
+
+    DIR *dir = opendir(directory);
+    TEST_ASSERT_NOT_NULL(dir);
+    struct dirent *item;
+    while ((item = readdir(dir))) {
+        if (item->d_name[0] == '.') continue;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", directory, item->d_name);
+        remove(path);
+    }
+    closedir(dir);
+    rmdir(directory);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+    snprintf(base_url, sizeof(base_url), "%s", mock_http_url(server));
+    client = http_client_create();
+    if (!client) {
+        printf("Failed to create HTTP client\n");
+        return 1;
+    }
+
+    UnityBegin("test_http_cache.c");
+
+    RUN_TEST(test_cache_fresh_hit);
+    RUN_TEST(test_cache_revalidation);
+    RUN_TEST(test_cache_revalidation_compact_headers);
+    RUN_TEST(test_cache_revalidation_evicts);
+    RUN_TEST(test_cache_vary);
+    RUN_TEST(test_cache_no_store_and_invalidation);
+    RUN_TEST(test_cache_disk_store);
+
+    int result = UnityEnd();
+    http_client_destroy(client);
+    mock_http_stop(server);
+    return result;
+}
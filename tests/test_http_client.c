@@ -1,5 +1,6 @@
 #include "unity/unity.h"
 #include "../include/http_client.h"
+#include "../include/compiled_request.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -42,6 +43,29 @@ static const char* mock_response_500 =
     "\r\n"
     "{\"error\": \"server error\"}";
 
+// gzip of gzip_test_body() (mtime 0), served by /gzip when the client accepts it
+static const unsigned char mock_gzip_body[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0xd0,
+    0x3b, 0x0a, 0x80, 0x30, 0x10, 0x45, 0xd1, 0xad, 0x84, 0xa9, 0x53, 0xf8,
+    0xfc, 0xeb, 0x56, 0xc4, 0x42, 0xd0, 0xc2, 0x22, 0x36, 0xda, 0x85, 0xec,
+    0xdd, 0x20, 0x76, 0x72, 0xad, 0x66, 0xe0, 0x56, 0xef, 0x44, 0xdb, 0xaf,
+    0x2d, 0x9c, 0x36, 0xba, 0x29, 0xda, 0xbe, 0xe6, 0x5b, 0x78, 0x67, 0xc7,
+    0x12, 0xb6, 0xfc, 0x3e, 0xcd, 0x92, 0x7f, 0x8b, 0xb0, 0x94, 0x58, 0x2a,
+    0x2c, 0x35, 0x96, 0x06, 0x4b, 0x8b, 0xa5, 0xc3, 0xd2, 0x63, 0x19, 0x78,
+    0xe9, 0x0f, 0x02, 0x2b, 0x88, 0x19, 0xc4, 0x0e, 0x62, 0x08, 0xb1, 0x84,
+    0x98, 0x42, 0x6c, 0x21, 0xc6, 0xd0, 0x57, 0x63, 0x4e, 0x37, 0xb9, 0x25,
+    0x03, 0x27, 0x1e, 0x02, 0x00, 0x00
+};
+
+static void gzip_test_body(char *out, size_t size) {
+    int length = snprintf(out, size, "{\"items\": [");
+    for (int i = 0; i < 20; i++) {
+        length += snprintf(out + length, size - (size_t)length, "%s{\"id\": %d, \"name\": \"item\"}",
+                           i ? "," : "", i);
+    }
+    snprintf(out + length, size - (size_t)length, "]}");
+}
+
 // Simple HTTP request parser for mock server
 typedef struct {
     char method[16];
@@ -151,6 +175,18 @@ void* mock_server_worker(void* arg) {
                     response = mock_response_404;
                 } else if (strcmp(parsed.path, "/error") == 0) {
                     response = mock_response_500;
+                } else if (strcmp(parsed.path, "/gzip") == 0 && strstr(parsed.headers, "gzip")) {
+                    char header[256];
+                    int header_length = snprintf(header, sizeof(header),
+                                                 "HTTP/1.1 200 OK\r\n"
+                                                 "Content-Type: application/json\r\n"
+                                                 "Content-Encoding: gzip\r\n"
+                                                 "Content-Length: %zu\r\n"
+                                                 "\r\n", sizeof(mock_gzip_body));
+                    send(client_socket, header, (size_t)header_length, 0);
+                    send(client_socket, mock_gzip_body, sizeof(mock_gzip_body), 0);
+                    close(client_socket);
+                    continue;
                 } else if (strstr(parsed.path, "/timeout") != NULL) {
                     // Simulate timeout by not responding
                     sleep(2);
@@ -238,10 +274,41 @@ void test_http_get_request(void) {
     TEST_ASSERT_EQUAL_INT(200, response->status_code);
     TEST_ASSERT_NOT_NULL(response->body);
     TEST_ASSERT_TRUE(strstr(response->body, "success") != NULL);
+
+    // Headers are indexed as they arrive
+    size_t length = 0;
+    const char *content_type = http_headers_get(&response->header_fields, "content-type", &length);
+    TEST_ASSERT_NOT_NULL(content_type);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(content_type, "application/json", length));
+    TEST_ASSERT_EQUAL_INT(200, http_headers_final(&response->header_fields)->status_code);
     
     http_response_free(response);
 }
 
+// Test that compressed bodies are negotiated and decoded, with both sizes reported
+void test_http_response_decompression(void) {
+    TEST_ASSERT_NOT_NULL(test_client);
+
+    http_response_t *response = http_request(test_client, HTTP_METHOD_GET, TEST_URL_BASE "/gzip", NULL);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_NULL(response->error_message);
+    TEST_ASSERT_EQUAL_INT(200, response->status_code);
+
+    char expected[1024];
+    gzip_test_body(expected, sizeof(expected));
+    TEST_ASSERT_EQUAL_STRING(expected, response->body);
+    TEST_ASSERT_EQUAL_INT(strlen(expected), response->body_size);
+    TEST_ASSERT_EQUAL_INT(sizeof(mock_gzip_body), (int)response->wire_size);
+    TEST_ASSERT_NOT_NULL(http_headers_get(&response->header_fields, "Content-Encoding", NULL));
+    http_response_free(response);
+
+    // Uncompressed bodies are the same size on the wire
+    response = http_request(test_client, HTTP_METHOD_GET, TEST_URL_BASE "/users", NULL);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(response->body_size, (int)response->wire_size);
+    http_response_free(response);
+}
+
 // Test POST request with JSON body
 void test_http_post_request_with_json(void) {
     TEST_ASSERT_NOT_NULL(test_client);
@@ -300,6 +367,43 @@ void test_http_request_with_headers(void) {
     http_response_free(response);
 }
 
+// Test that a compiled request can be sent repeatedly and mixed with http_request
+void test_http_request_compiled(void) {
+    TEST_ASSERT_NOT_NULL(test_client);
+
+    compiled_request_t *post = compiled_request_create(HTTP_METHOD_POST, TEST_URL_BASE "/users",
+                                                       "Authorization: Bearer token123",
+                                                       "{\"name\": \"test\"}", 5000);
+    TEST_ASSERT_NOT_NULL(post);
+
+    for (int i = 0; i < 3; i++) {
+        http_response_t *response = http_request_compiled(test_client, post);
+        TEST_ASSERT_NOT_NULL(response);
+        TEST_ASSERT_EQUAL_INT(200, response->status_code);
+        http_response_free(response);
+    }
+
+    // The handle must not keep the POST state for the next request
+    compiled_request_t *get = compiled_request_create(HTTP_METHOD_GET, TEST_URL_BASE "/notfound",
+                                                      NULL, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(get);
+    http_response_t *response = http_request_compiled(test_client, get);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(404, response->status_code);
+    http_response_free(response);
+
+    response = http_request(test_client, HTTP_METHOD_GET, TEST_URL_BASE "/users", NULL);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(200, response->status_code);
+    http_response_free(response);
+
+    TEST_ASSERT_NULL(http_request_compiled(NULL, get));
+    TEST_ASSERT_NULL(http_request_compiled(test_client, NULL));
+
+    compiled_request_destroy(post);
+    compiled_request_destroy(get);
+}
+
 // Test 404 response
 void test_http_404_response(void) {
     TEST_ASSERT_NOT_NULL(test_client);
@@ -525,6 +629,8 @@ int main(void) {
     RUN_TEST(test_http_get_request);
     RUN_TEST(test_http_post_request_with_json);
     RUN_TEST(test_http_request_with_headers);
+    RUN_TEST(test_http_request_compiled);
+    RUN_TEST(test_http_response_decompression);
     
     // Response code tests
     RUN_TEST(test_http_404_response);
@@ -0,0 +1,377 @@
+#include "unity/unity.h"
+#include "../include/http_engine.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+#define MAX_KEYS 64
+
+// Mock server handler: answers and closes.
+//   /flaky/KEY/N      503 (Retry-After: 0) for the first N requests of KEY, then 200
+//   /slow-first/KEY   the first request of KEY takes 2 s, later ones answer at once
+//   /hold/KEY         answers after 50 ms, recording the peak concurrency of KEY
+//   /slow             answers after 300 ms
+static mock_http_t *server;
+static pthread_mutex_t server_lock = PTHREAD_MUTEX_INITIALIZER;
+static int key_requests[MAX_KEYS];
+static int key_active[MAX_KEYS];
+static int key_peak[MAX_KEYS];
+
+static http_engine_t *engine;
+static char base_url[64];
+
+static int respond(int client, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    const char *path = request->path;
+    int key = 0, failures = 0, status = 200;
+    if (sscanf(path, "/flaky/%d/%d", &key, &failures) == 2 ||
+        sscanf(path, "/slow-first/%d", &key) == 1) {
+        pthread_mutex_lock(&server_lock);
+        int count = ++key_requests[key % MAX_KEYS];
+        pthread_mutex_unlock(&server_lock);
+
+        if (strncmp(path, "/flaky/", 7) == 0 && count <= failures) status = 503;
+        if (strncmp(path, "/slow-first/", 12) == 0 && count == 1) usleep(2000000);
+    } else if (sscanf(path, "/hold/%d", &key) == 1) {
+        pthread_mutex_lock(&server_lock);
+        int active = ++key_active[key % MAX_KEYS];
+        if (active > key_peak[key % MAX_KEYS]) key_peak[key % MAX_KEYS] = active;
+        pthread_mutex_unlock(&server_lock);
+
+        usleep(50000);
+        pthread_mutex_lock(&server_lock);
+        key_active[key % MAX_KEYS]--;
+        pthread_mutex_unlock(&server_lock);
+    } else if (strcmp(path, "/slow") == 0) {
+        usleep(300000);
+    }
+
+    mock_http_reply(client, status, "Retry-After: 0\r\nConnection: close\r\n", "{}");
+    return 0;
+}
+
+static void store_response(void *user_data, http_response_t *response) {
+    *(http_response_t **)user_data = response;
+}
+
+// Submit requests and run the engine until all are answered
+static void run_requests(compiled_request_t **requests, http_response_t **responses, int count) {
+    for (int i = 0; i < count; i++) {
+        responses[i] = NULL;
+        TEST_ASSERT_EQUAL_INT(0, http_engine_submit(engine, requests[i], store_response, &responses[i]));
+    }
+    while (http_engine_run(engine, 100) > 0) {
+    }
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_NOT_NULL(responses[i]);
+    }
+}
+
+// Run one request to completion; returns the number of run loop turns it took
+static int run_counting_turns(compiled_request_t *request, http_response_t **response) {
+    *response = NULL;
+    TEST_ASSERT_EQUAL_INT(0, http_engine_submit(engine, request, store_response, response));
+    int turns = 0;
+    while (http_engine_run(engine, 100) > 0) {
+        turns++;
+    }
+    TEST_ASSERT_NOT_NULL(*response);
+    return turns;
+}
+
+static compiled_request_t *make_request(http_method_t method, const char *path) {
+    char url[128];
+    snprintf(url, sizeof(url), "%s%s", base_url, path);
+    compiled_request_t *request = compiled_request_create(method, url, NULL, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    return request;
+}
+
+static double elapsed_seconds(const struct timespec *start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static http_retry_policy_t fast_policy(void) {
+    http_retry_policy_t policy = http_retry_policy_default();
+    policy.backoff_base_ms = 10;
+    policy.backoff_max_ms = 50;
+    return policy;
+}
+
+void setUp(void) {
+    engine = http_engine_create(0);
+    memset(key_requests, 0, sizeof(key_requests));
+    memset(key_peak, 0, sizeof(key_peak));
+}
+
+void tearDown(void) {
+    http_engine_destroy(engine);
+}
+
+// Test retrying until success, and giving up after max_attempts
+void test_engine_retries(void) {
+    http_retry_policy_t policy = fast_policy();
+    http_engine_set_policy(engine, &policy);
+
+    compiled_request_t *requests[2] = {
+        make_request(HTTP_METHOD_GET, "/flaky/1/2"),
+        make_request(HTTP_METHOD_GET, "/flaky/2/5")
+    };
+    http_response_t *responses[2];
+    run_requests(requests, responses, 2);
+
+    TEST_ASSERT_EQUAL_INT(200, responses[0]->status_code);
+    TEST_ASSERT_EQUAL_INT(3, responses[0]->attempt_count);
+    TEST_ASSERT_EQUAL_INT(HTTP_ATTEMPT_FAILED, responses[0]->attempts[0].outcome);
+    TEST_ASSERT_EQUAL_INT(503, responses[0]->attempts[1].status_code);
+    TEST_ASSERT_EQUAL_INT(HTTP_ATTEMPT_WON, responses[0]->attempts[2].outcome);
+    TEST_ASSERT_TRUE(responses[0]->attempts[1].start_ns >= responses[0]->attempts[0].end_ns);
+
+    TEST_ASSERT_EQUAL_INT(503, responses[1]->status_code);
+    TEST_ASSERT_EQUAL_INT(3, responses[1]->attempt_count);
+    TEST_ASSERT_EQUAL_INT(3, key_requests[2]);
+
+    http_engine_stats_t stats = http_engine_stats(engine);
+    TEST_ASSERT_EQUAL_INT(2, (int)stats.requests);
+    TEST_ASSERT_EQUAL_INT(6, (int)stats.attempts);
+    TEST_ASSERT_EQUAL_INT(4, (int)stats.retries);
+
+    for (int i = 0; i < 2; i++) {
+        http_response_free(responses[i]);
+        compiled_request_destroy(requests[i]);
+    }
+}
+
+// Test that non-idempotent requests are retried only when nothing was sent
+void test_engine_retry_post_safety(void) {
+    http_retry_policy_t policy = fast_policy();
+    http_engine_set_policy(engine, &policy);
+
+    compiled_request_t *requests[2] = {
+        make_request(HTTP_METHOD_POST, "/flaky/3/1"),
+        compiled_request_create(HTTP_METHOD_POST, "http://127.0.0.1:1/closed", NULL, "{}", 5000)
+    };
+    http_response_t *responses[2];
+    run_requests(requests, responses, 2);
+
+    TEST_ASSERT_EQUAL_INT(503, responses[0]->status_code);
+    TEST_ASSERT_EQUAL_INT(1, responses[0]->attempt_count);
+    TEST_ASSERT_NOT_NULL(responses[1]->error_message);
+    TEST_ASSERT_EQUAL_INT(3, responses[1]->attempt_count);
+    TEST_ASSERT_EQUAL_INT(CURLE_COULDNT_CONNECT, responses[1]->attempts[0].curl_result);
+
+    for (int i = 0; i < 2; i++) {
+        http_response_free(responses[i]);
+        compiled_request_destroy(requests[i]);
+    }
+}
+
+// Test that the retry budget caps extra attempts
+void test_engine_retry_budget(void) {
+    http_retry_policy_t policy = fast_policy();
+    policy.budget_ratio = 0;
+    policy.budget_min = 1;
+    http_engine_set_policy(engine, &policy);
+
+    compiled_request_t *requests[2] = {
+        make_request(HTTP_METHOD_GET, "/flaky/4/1"),
+        make_request(HTTP_METHOD_GET, "/flaky/5/1")
+    };
+    http_response_t *responses[2];
+    run_requests(requests, responses, 2);
+
+    // One of them got the only retry
+    TEST_ASSERT_EQUAL_INT(3, responses[0]->attempt_count + responses[1]->attempt_count);
+    TEST_ASSERT_EQUAL_INT(1, (int)http_engine_stats(engine).budget_denied);
+
+    for (int i = 0; i < 2; i++) {
+        http_response_free(responses[i]);
+        compiled_request_destroy(requests[i]);
+    }
+}
+
+// Test that a hedge answers a slow request and the original is cancelled
+void test_engine_hedging(void) {
+    http_retry_policy_t policy = fast_policy();
+    policy.hedge_after_ms = 100;
+    http_engine_set_policy(engine, &policy);
+
+    compiled_request_t *request = make_request(HTTP_METHOD_GET, "/slow-first/6");
+    http_response_t *response;
+    run_requests(&request, &response, 1);
+
+    TEST_ASSERT_EQUAL_INT(200, response->status_code);
+    TEST_ASSERT_EQUAL_INT(2, response->attempt_count);
+    TEST_ASSERT_EQUAL_INT(HTTP_ATTEMPT_CANCELLED, response->attempts[0].outcome);
+    TEST_ASSERT_TRUE(response->attempts[1].hedge);
+    TEST_ASSERT_EQUAL_INT(HTTP_ATTEMPT_WON, response->attempts[1].outcome);
+    TEST_ASSERT_TRUE(response->attempts[1].start_ns >= 100000000ull);
+
+    // Well before the slow original would have finished
+    TEST_ASSERT_TRUE(response->attempts[1].end_ns < 1500000000ull);
+
+    http_engine_stats_t stats = http_engine_stats(engine);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.hedges);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.hedge_wins);
+
+    http_response_free(response);
+    compiled_request_destroy(request);
+}
+
+// Test that a hedge the engine cannot start does not wake the run loop
+// again and again: a POST, a spent budget, and a full engine
+void test_engine_hedge_refused(void) {
+    http_retry_policy_t policy = fast_policy();
+    policy.hedge_after_ms = 50;
+    http_engine_set_policy(engine, &policy);
+
+    compiled_request_t *post = make_request(HTTP_METHOD_POST, "/slow");
+    http_response_t *response;
+    TEST_ASSERT_TRUE(run_counting_turns(post, &response) < 30);
+    TEST_ASSERT_EQUAL_INT(1, response->attempt_count);
+    http_response_free(response);
+    compiled_request_destroy(post);
+
+    // Each hedge decision is one denial, however long the attempt then runs
+    policy.budget_ratio = 0;
+    policy.budget_min = 0;
+    http_engine_set_policy(engine, &policy);
+    compiled_request_t *request = make_request(HTTP_METHOD_GET, "/slow");
+    TEST_ASSERT_TRUE(run_counting_turns(request, &response) < 30);
+    TEST_ASSERT_EQUAL_INT(1, response->attempt_count);
+    TEST_ASSERT_EQUAL_INT(1, (int)http_engine_stats(engine).budget_denied);
+    http_response_free(response);
+
+    http_engine_destroy(engine);
+    engine = http_engine_create(1);
+    policy.budget_min = 10;
+    http_engine_set_policy(engine, &policy);
+    TEST_ASSERT_TRUE(run_counting_turns(request, &response) < 30);
+    TEST_ASSERT_EQUAL_INT(1, response->attempt_count);
+    TEST_ASSERT_EQUAL_INT(0, (int)http_engine_stats(engine).budget_denied);
+    http_response_free(response);
+    compiled_request_destroy(request);
+}
+
+// Test that the engine-wide rate spaces out starts without bursting
+void test_engine_rate_limit(void) {
+    enum { COUNT = 41 };
+    http_engine_set_rate(engine, 100, 1);
+
+    compiled_request_t *request = make_request(HTTP_METHOD_GET, "/ok");
+    compiled_request_t *requests[COUNT];
+    http_response_t *responses[COUNT];
+    for (int i = 0; i < COUNT; i++) requests[i] = request;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_requests(requests, responses, COUNT);
+    double elapsed = elapsed_seconds(&start);
+
+    // The first request takes the initial token, the other 40 come at 100/s
+    TEST_ASSERT_TRUE(elapsed >= 0.39);
+    TEST_ASSERT_TRUE(elapsed < 0.55);
+    for (int i = 0; i < COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(200, responses[i]->status_code);
+    }
+    TEST_ASSERT_EQUAL_INT(COUNT - 1, (int)http_engine_stats(engine).throttled);
+
+    for (int i = 0; i < COUNT; i++) http_response_free(responses[i]);
+    compiled_request_destroy(request);
+}
+
+// Test the per-host connection cap, and that other hosts are not held back
+void test_engine_host_limits(void) {
+    TEST_ASSERT_EQUAL_INT(0, http_engine_set_host_limits(engine, "127.0.0.1", 0, 0, 2));
+
+    char url[128];
+    snprintf(url, sizeof(url), "http://localhost:%d/hold/8", mock_http_port(server));
+    compiled_request_t *capped = make_request(HTTP_METHOD_GET, "/hold/7");
+    compiled_request_t *other = compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 5000);
+    compiled_request_t *requests[12];
+    http_response_t *responses[12];
+    for (int i = 0; i < 12; i++) requests[i] = i < 6 ? capped : other;
+
+    run_requests(requests, responses, 12);
+
+    TEST_ASSERT_EQUAL_INT(2, key_peak[7]);
+    TEST_ASSERT_TRUE(key_peak[8] > 2);
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_INT(200, responses[i]->status_code);
+        http_response_free(responses[i]);
+    }
+    compiled_request_destroy(capped);
+    compiled_request_destroy(other);
+}
+
+// Test a per-request limit, which does not hold back other requests to the host
+void test_engine_request_limit(void) {
+    http_token_bucket_t limit;
+    http_token_bucket_init(&limit, 50, 1);
+
+    compiled_request_t *limited = make_request(HTTP_METHOD_GET, "/limited");
+    compiled_request_t *free_request = make_request(HTTP_METHOD_GET, "/free");
+    http_response_t *responses[10] = {0};
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Limited submissions first, so the free ones queue behind them
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(0, http_engine_submit_limited(engine, i < 5 ? limited : free_request,
+                                                            i < 5 ? &limit : NULL,
+                                                            store_response, &responses[i]));
+    }
+    double free_done = 0;
+    while (http_engine_run(engine, 100) > 0) {
+        int answered = 0;
+        for (int i = 5; i < 10; i++) answered += responses[i] != NULL;
+        if (answered == 5 && free_done == 0) free_done = elapsed_seconds(&start);
+    }
+    double elapsed = elapsed_seconds(&start);
+
+    // Four limited requests wait 20 ms each; the free ones do not wait for them
+    TEST_ASSERT_TRUE(elapsed >= 0.079);
+    TEST_ASSERT_TRUE(free_done > 0 && free_done < 0.06);
+    TEST_ASSERT_EQUAL_INT(4, (int)http_engine_stats(engine).throttled);
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_NOT_NULL(responses[i]);
+        http_response_free(responses[i]);
+    }
+    compiled_request_destroy(limited);
+    compiled_request_destroy(free_request);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+    snprintf(base_url, sizeof(base_url), "%s", mock_http_url(server));
+
+    UnityBegin("test_http_engine.c");
+
+    RUN_TEST(test_engine_retries);
+    RUN_TEST(test_engine_retry_post_safety);
+    RUN_TEST(test_engine_retry_budget);
+    RUN_TEST(test_engine_hedging);
+    RUN_TEST(test_engine_hedge_refused);
+    RUN_TEST(test_engine_rate_limit);
+    RUN_TEST(test_engine_host_limits);
+    RUN_TEST(test_engine_request_limit);
+
+    int result = UnityEnd();
+    mock_http_stop(server);
+    return result;
+}
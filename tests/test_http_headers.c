@@ -0,0 +1,142 @@
+#include "unity/unity.h"
+#include "../include/http_headers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char redirected[] =
+    "HTTP/1.1 301 Moved Permanently\r\n"
+    "Location: /v2/users\r\n"
+    "Set-Cookie: hop=1\r\n"
+    "\r\n"
+    "HTTP/1.1 100 Continue\r\n"
+    "\r\n"
+    "HTTP/2 200\r\n"
+    "content-type: application/json\r\n"
+    "Set-Cookie: a=1\r\n"
+    "ETag:   \"abc\"  \r\n"
+    "set-cookie: b=2\r\n"
+    "X-Empty:\r\n"
+    "\r\n";
+
+static http_headers_t headers;
+
+void setUp(void) {
+    http_headers_init(&headers);
+}
+
+void tearDown(void) {
+    http_headers_free(&headers);
+}
+
+static int value_equals(const http_header_t *header, const char *expected) {
+    return header && header->value_length == strlen(expected) &&
+           strncmp(headers.text + header->value_offset, expected, header->value_length) == 0;
+}
+
+// Test that every response gets its own block with its status
+void test_headers_blocks(void) {
+    TEST_ASSERT_EQUAL_INT(0, http_headers_parse(&headers, redirected, strlen(redirected)));
+
+    TEST_ASSERT_EQUAL_INT(3, headers.block_count);
+    TEST_ASSERT_EQUAL_INT(301, headers.blocks[0].status_code);
+    TEST_ASSERT_EQUAL_INT(2, headers.blocks[0].count);
+    TEST_ASSERT_EQUAL_INT(100, headers.blocks[1].status_code);
+    TEST_ASSERT_EQUAL_INT(0, headers.blocks[1].count);
+
+    const http_header_block_t *final = http_headers_final(&headers);
+    TEST_ASSERT_EQUAL_INT(200, final->status_code);
+    TEST_ASSERT_EQUAL_INT(5, final->count);
+    TEST_ASSERT_EQUAL_INT(strlen("HTTP/2 200"), final->line_length);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(headers.text + final->line_offset, "HTTP/2 200", final->line_length));
+}
+
+// Test case-insensitive lookup, trimming and repeated headers
+void test_headers_lookup(void) {
+    TEST_ASSERT_EQUAL_INT(0, http_headers_parse(&headers, redirected, strlen(redirected)));
+
+    size_t length = 0;
+    const char *value = http_headers_get(&headers, "Content-Type", &length);
+    TEST_ASSERT_NOT_NULL(value);
+    TEST_ASSERT_EQUAL_INT(strlen("application/json"), length);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(value, "application/json", length));
+
+    TEST_ASSERT_TRUE(value_equals(http_headers_find(&headers, -1, "etag"), "\"abc\""));
+    TEST_ASSERT_TRUE(value_equals(http_headers_find(&headers, -1, "X-EMPTY"), ""));
+    TEST_ASSERT_NULL(http_headers_find(&headers, -1, "Location"));
+
+    // Repeated headers come back in arrival order, from the final block only
+    const http_header_t *cookie = http_headers_find(&headers, -1, "set-cookie");
+    TEST_ASSERT_TRUE(value_equals(cookie, "a=1"));
+    cookie = http_headers_find_next(&headers, cookie);
+    TEST_ASSERT_TRUE(value_equals(cookie, "b=2"));
+    TEST_ASSERT_NULL(http_headers_find_next(&headers, cookie));
+
+    // Earlier hops can be searched by block index
+    TEST_ASSERT_TRUE(value_equals(http_headers_find(&headers, 0, "location"), "/v2/users"));
+    cookie = http_headers_find(&headers, 0, "Set-Cookie");
+    TEST_ASSERT_TRUE(value_equals(cookie, "hop=1"));
+    TEST_ASSERT_NULL(http_headers_find_next(&headers, cookie));
+    TEST_ASSERT_NULL(http_headers_find(&headers, 5, "Location"));
+}
+
+// Test incremental indexing while the raw text is reallocated, as curl delivers it
+void test_headers_incremental(void) {
+    char *text = NULL;
+    size_t size = 0;
+    const char *p = redirected;
+    while (*p) {
+        const char *end = strchr(p, '\n') + 1;
+        size_t line = (size_t)(end - p);
+        char *grown = realloc(text, size + line + 1);
+        TEST_ASSERT_NOT_NULL(grown);
+        text = grown;
+        memcpy(text + size, p, line);
+        text[size + line] = '\0';
+        TEST_ASSERT_EQUAL_INT(0, http_headers_add_line(&headers, text, size, line));
+        size += line;
+        p = end;
+    }
+
+    TEST_ASSERT_EQUAL_INT(3, headers.block_count);
+    TEST_ASSERT_TRUE(value_equals(http_headers_find(&headers, -1, "ETag"), "\"abc\""));
+    free(text);
+}
+
+// Test many headers in one block (bucket chains) and malformed lines
+void test_headers_many_and_malformed(void) {
+    char text[8192];
+    int length = snprintf(text, sizeof(text), "HTTP/1.1 200 OK\r\nno colon here\r\n folded continuation\r\n");
+    for (int i = 0; i < 200; i++) {
+        length += snprintf(text + length, sizeof(text) - (size_t)length, "X-Header-%d: value-%d\r\n", i, i);
+    }
+    TEST_ASSERT_EQUAL_INT(0, http_headers_parse(&headers, text, (size_t)length));
+
+    TEST_ASSERT_EQUAL_INT(200, http_headers_final(&headers)->count);
+    for (int i = 0; i < 200; i++) {
+        char name[32], value[32];
+        snprintf(name, sizeof(name), "x-header-%d", i);
+        snprintf(value, sizeof(value), "value-%d", i);
+        TEST_ASSERT_TRUE(value_equals(http_headers_find(&headers, -1, name), value));
+    }
+    TEST_ASSERT_NULL(http_headers_find(&headers, -1, "no colon here"));
+
+    // Headers without a status line still get a block
+    http_headers_free(&headers);
+    TEST_ASSERT_EQUAL_INT(0, http_headers_parse(&headers, "Content-Length: 3\n", 18));
+    TEST_ASSERT_EQUAL_INT(1, headers.block_count);
+    TEST_ASSERT_EQUAL_INT(0, http_headers_final(&headers)->status_code);
+    TEST_ASSERT_TRUE(value_equals(http_headers_find(&headers, -1, "content-length"), "3"));
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_http_headers.c");
+
+    RUN_TEST(test_headers_blocks);
+    RUN_TEST(test_headers_lookup);
+    RUN_TEST(test_headers_incremental);
+    RUN_TEST(test_headers_many_and_malformed);
+
+    return UnityEnd();
+}
@@ -0,0 +1,197 @@
+#include "unity/unity.h"
+#include "../include/http_client.h"
+#include "../include/http_engine.h"
+#include "../include/compiled_request.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+
+// Mock servers, one on a Unix socket and one on loopback TCP, answering
+// every request with 200 and the request's Host header as the body.
+static mock_http_t *unix_server;
+static mock_http_t *tcp_server;
+static char socket_path[108];
+static int tcp_port;
+
+static int respond(int client, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    char host[256] = "";
+    const char *field = strstr(request->head, "\r\nHost: ");
+    if (field) {
+        field += 8;
+        size_t host_length = strcspn(field, "\r");
+        if (host_length >= sizeof(host)) host_length = sizeof(host) - 1;
+        memcpy(host, field, host_length);
+        host[host_length] = '\0';
+    }
+    return mock_http_reply(client, 200, NULL, host) == 0;
+}
+
+static void count_response(void *user_data, http_response_t *response) {
+    if (response && response->status_code == 200 && response->body &&
+        strcmp(response->body, "apikit-test.invalid") == 0) {
+        (*(int *)user_data)++;
+    }
+    http_response_free(response);
+}
+
+static void count_any_response(void *user_data, http_response_t *response) {
+    if (response && response->status_code == 200 && response->http_version == 11) {
+        (*(int *)user_data)++;
+    }
+    http_response_free(response);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Test a request sent through a Unix socket keeps the URL's host
+void test_unix_socket_request(void) {
+    char headers[256];
+    snprintf(headers, sizeof(headers), "Accept: */*\n# @unix-socket %s\n", socket_path);
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://apikit-test.invalid/x",
+                                                          headers, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+
+    http_client_t *client = http_client_create();
+    TEST_ASSERT_NOT_NULL(client);
+    for (int i = 0; i < 3; i++) {
+        http_response_t *response = http_request_compiled(client, request);
+        TEST_ASSERT_NOT_NULL(response);
+        TEST_ASSERT_EQUAL_INT(200, (int)response->status_code);
+        TEST_ASSERT_EQUAL_STRING("apikit-test.invalid", response->body);
+        http_response_free(response);
+    }
+
+    http_client_destroy(client);
+    compiled_request_destroy(request);
+}
+
+// Test a resolve override pins the host, and only for requests that have it
+void test_resolve_override(void) {
+    char url[128], headers[128], host[64];
+    snprintf(url, sizeof(url), "http://apikit-test.invalid:%d/", tcp_port);
+    snprintf(headers, sizeof(headers), "# @resolve apikit-test.invalid:%d:127.0.0.1", tcp_port);
+    snprintf(host, sizeof(host), "apikit-test.invalid:%d", tcp_port);
+
+    compiled_request_t *pinned = compiled_request_create(HTTP_METHOD_GET, url, headers, NULL, 5000);
+    compiled_request_t *plain = compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(pinned);
+    TEST_ASSERT_NOT_NULL(plain);
+
+    http_client_t *client = http_client_create();
+    TEST_ASSERT_NOT_NULL(client);
+
+    http_response_t *response = http_request_compiled(client, pinned);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(200, (int)response->status_code);
+    TEST_ASSERT_EQUAL_STRING(host, response->body);
+    http_response_free(response);
+
+    // The same handle without the override must not reuse the pinned route
+    response = http_request_compiled(client, plain);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(0, (int)response->status_code);
+    TEST_ASSERT_NOT_NULL(response->error_message);
+    http_response_free(response);
+
+    http_client_destroy(client);
+    compiled_request_destroy(pinned);
+    compiled_request_destroy(plain);
+}
+
+// Test the engine sends routed requests on its pooled handles
+void test_engine_unix_socket(void) {
+    char routes[256];
+    snprintf(routes, sizeof(routes), "# @unix-socket %s", socket_path);
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://apikit-test.invalid/",
+                                                          NULL, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(0, compiled_request_add_routes(request, routes));
+
+    http_engine_t *engine = http_engine_create(4);
+    TEST_ASSERT_NOT_NULL(engine);
+    int passed = 0;
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL_INT(0, http_engine_submit(engine, request, count_response, &passed));
+    }
+    while (http_engine_run(engine, 100) > 0) {
+    }
+    TEST_ASSERT_EQUAL_INT(20, passed);
+
+    http_connection_stats_t connection;
+    TEST_ASSERT_EQUAL_INT(1, http_engine_connections(engine, &connection, 1));
+    TEST_ASSERT_EQUAL_STRING("unix", connection.local);
+    TEST_ASSERT_TRUE(connection.streams == 20);
+
+    http_engine_destroy(engine);
+    compiled_request_destroy(request);
+}
+
+// Test per-connection stream counts over HTTP/1.1 keep-alive connections
+void test_engine_connection_stats(void) {
+    char url[128];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/", tcp_port);
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, url, "# @http-version 1.1",
+                                                          NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_EQUAL_INT(CURL_HTTP_VERSION_1_1, (int)request->http_version);
+
+    http_engine_t *engine = http_engine_create(4);
+    TEST_ASSERT_NOT_NULL(engine);
+    http_engine_set_multiplexing(engine, 8);
+    int done = 0;
+    for (int i = 0; i < 40; i++) {
+        TEST_ASSERT_EQUAL_INT(0, http_engine_submit(engine, request, count_any_response, &done));
+    }
+    while (http_engine_run(engine, 100) > 0) {
+    }
+    TEST_ASSERT_EQUAL_INT(40, done);
+
+    // HTTP/1.1 carries one request at a time, so about one connection per slot
+    http_connection_stats_t connections[8];
+    int count = http_engine_connections(engine, connections, 8);
+    TEST_ASSERT_TRUE(count >= 1 && count <= 4);
+    uint64_t streams = 0;
+    for (int i = 0; i < count; i++) {
+        streams += connections[i].streams;
+        TEST_ASSERT_EQUAL_INT(11, connections[i].http_version);
+        TEST_ASSERT_TRUE(strncmp(connections[i].local, "127.0.0.1:", 10) == 0);
+        TEST_ASSERT_TRUE(strstr(connections[i].remote, "127.0.0.1:") != NULL);
+    }
+    TEST_ASSERT_TRUE(streams == 40);
+
+    http_engine_destroy(engine);
+    compiled_request_destroy(request);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+    snprintf(socket_path, sizeof(socket_path), "/tmp/apikit-test-%d.sock", (int)getpid());
+    unix_server = mock_http_start_unix(socket_path, respond, NULL);
+    tcp_server = mock_http_start(respond, NULL);
+    if (!unix_server || !tcp_server) {
+        printf("Failed to start mock servers\n");
+        return 1;
+    }
+    tcp_port = mock_http_port(tcp_server);
+
+    UnityBegin("test_http_routes.c");
+
+    RUN_TEST(test_unix_socket_request);
+    RUN_TEST(test_resolve_override);
+    RUN_TEST(test_engine_unix_socket);
+    RUN_TEST(test_engine_connection_stats);
+
+    int result = UnityEnd();
+    mock_http_stop(unix_server);
+    mock_http_stop(tcp_server);
+    return result;
+}
@@ -0,0 +1,148 @@
+#include "unity/unity.h"
+#include "../include/http_task.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+#define STREAM_SIZE (16 * 1024 * 1024)
+#define STREAM_CHUNK (64 * 1024)
+
+// Mock server handler: answers and closes.
+//   /stream   16 MB body sent in 64 KB chunks every 10 ms (about 25 s in all)
+//   anything else   200 with body {}
+static mock_http_t *server;
+static char base_url[64];
+
+static http_client_t *client;
+
+static int respond(int client_socket, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    if (strcmp(request->path, "/stream") != 0) {
+        mock_http_reply(client_socket, 200, "Connection: close\r\n", "{}");
+        return 0;
+    }
+
+    char head[128];
+    int size = snprintf(head, sizeof(head),
+                        "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", STREAM_SIZE);
+    send(client_socket, head, (size_t)size, 0);
+
+    static char chunk[STREAM_CHUNK];
+    memset(chunk, 'x', sizeof(chunk));
+    for (int sent = 0; sent < STREAM_SIZE; sent += STREAM_CHUNK) {
+        if (send(client_socket, chunk, sizeof(chunk), 0) < 0) break;
+        usleep(10000);
+    }
+    return 0;
+}
+
+static compiled_request_t *make_request(const char *path) {
+    char url[128];
+    snprintf(url, sizeof(url), "%s%s", base_url, path);
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 60000);
+    TEST_ASSERT_NOT_NULL(request);
+    return request;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+void setUp(void) {
+    client = http_client_create();
+}
+
+void tearDown(void) {
+    http_client_destroy(client);
+}
+
+// Test that a task delivers its response in the background
+void test_task_completes(void) {
+    compiled_request_t *request = make_request("/ok");
+    http_task_t *task = http_task_start(client, request);
+    TEST_ASSERT_NOT_NULL(task);
+
+    for (int i = 0; i < 500 && !http_task_is_done(task); i++) {
+        sleep_ms(10);
+    }
+    TEST_ASSERT_TRUE(http_task_is_done(task));
+    TEST_ASSERT_EQUAL_INT(2, (int)http_task_progress(task).downloaded);
+
+    http_response_t *response = http_task_finish(task);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(200, response->status_code);
+    TEST_ASSERT_EQUAL_STRING("{}", response->body);
+    TEST_ASSERT_NULL(response->error_message);
+
+    http_response_free(response);
+    compiled_request_destroy(request);
+}
+
+// Test progress and throughput of a slow download, and cancelling it
+void test_task_progress_and_cancel(void) {
+    compiled_request_t *request = make_request("/stream");
+    http_task_t *task = http_task_start(client, request);
+    TEST_ASSERT_NOT_NULL(task);
+
+    http_task_progress_t progress = http_task_progress(task);
+    for (int i = 0; i < 20; i++) {
+        sleep_ms(50);
+        progress = http_task_progress(task);
+    }
+    TEST_ASSERT_FALSE(http_task_is_done(task));
+    TEST_ASSERT_EQUAL_INT(STREAM_SIZE, (int)progress.download_total);
+    TEST_ASSERT_TRUE(progress.downloaded > 0);
+    TEST_ASSERT_TRUE(progress.downloaded < STREAM_SIZE);
+    TEST_ASSERT_TRUE(progress.bytes_per_second > 0);
+    TEST_ASSERT_TRUE(progress.elapsed_ns >= 1000000000ull);
+
+    // The transfer stops at the next progress callback, long before the end
+    http_task_cancel(task);
+    for (int i = 0; i < 200 && !http_task_is_done(task); i++) {
+        sleep_ms(10);
+    }
+    TEST_ASSERT_TRUE(http_task_is_done(task));
+
+    http_response_t *response = http_task_finish(task);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_STRING("Cancelled", response->error_message);
+    TEST_ASSERT_TRUE(response->body_size < STREAM_SIZE);
+
+    // The client is usable again afterwards
+    compiled_request_t *next = make_request("/ok");
+    http_response_t *second = http_request_compiled(client, next);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_EQUAL_INT(200, second->status_code);
+
+    http_response_free(second);
+    http_response_free(response);
+    compiled_request_destroy(next);
+    compiled_request_destroy(request);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+    snprintf(base_url, sizeof(base_url), "%s", mock_http_url(server));
+
+    UnityBegin("test_http_task.c");
+
+    RUN_TEST(test_task_completes);
+    RUN_TEST(test_task_progress_and_cancel);
+
+    int result = UnityEnd();
+    mock_http_stop(server);
+    return result;
+}
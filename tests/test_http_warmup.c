@@ -0,0 +1,196 @@
+#include "unity/unity.h"
+#include "../include/http_warmup.h"
+#include "../include/http_engine.h"
+#include "../include/compiled_request.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+
+// Keep-alive mock server handler, answering every request with 200 {}.
+// Counts connections (by their first request) and "OPTIONS *" requests;
+// GET /slow answers after 100 ms.
+static mock_http_t *server;
+static pthread_mutex_t server_lock = PTHREAD_MUTEX_INITIALIZER;
+static int connection_count;
+static int options_count;
+static char base_url[64];
+
+static int respond(int client, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    pthread_mutex_lock(&server_lock);
+    connection_count += request->index == 0;
+    options_count += strcmp(request->method, "OPTIONS") == 0 && strcmp(request->path, "*") == 0;
+    pthread_mutex_unlock(&server_lock);
+    if (strcmp(request->path, "/slow") == 0) usleep(100000);
+
+    return mock_http_reply(client, 200, NULL, "{}") == 0;
+}
+
+static compiled_request_t *make_request(const char *path) {
+    char url[128];
+    snprintf(url, sizeof(url), "%s%s", base_url, path);
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    return request;
+}
+
+static void count_response(void *user_data, http_response_t *response) {
+    if (response && response->status_code == 200) (*(int *)user_data)++;
+    http_response_free(response);
+}
+
+void setUp(void) {
+    pthread_mutex_lock(&server_lock);
+    connection_count = 0;
+    options_count = 0;
+    pthread_mutex_unlock(&server_lock);
+}
+
+void tearDown(void) {
+}
+
+// Test origin extraction and de-duplication by origin and routing
+void test_warmup_targets(void) {
+    char origin[HTTP_ORIGIN_LENGTH];
+    TEST_ASSERT_EQUAL_INT(0, http_url_origin("https://api.example.com/v1/users?page=2", origin, sizeof(origin)));
+    TEST_ASSERT_EQUAL_STRING("https://api.example.com:443", origin);
+    TEST_ASSERT_EQUAL_INT(-1, http_url_origin("http://", origin, sizeof(origin)));
+
+    const char *urls[] = {
+        "http://127.0.0.1:8080/a", "https://api.example.com/x", "http://127.0.0.1:8080/b?q=1",
+        "{{base_url}}/unrendered", "https://api.example.com:443/y", "http://127.0.0.1:8080/c"
+    };
+    const char *headers[] = {
+        NULL, NULL, "Accept: */*", NULL, NULL, "# @unix-socket /tmp/api.sock"
+    };
+    compiled_request_t *requests[6];
+    for (int i = 0; i < 6; i++) {
+        requests[i] = compiled_request_create(HTTP_METHOD_GET, urls[i], headers[i], NULL, 0);
+        TEST_ASSERT_NOT_NULL(requests[i]);
+    }
+
+    compiled_request_t *targets[4];
+    TEST_ASSERT_EQUAL_INT(3, http_warmup_targets((const compiled_request_t *const *)requests, 6, targets, 4));
+    TEST_ASSERT_EQUAL_STRING("http://127.0.0.1:8080/", targets[0]->url);
+    TEST_ASSERT_NULL(targets[0]->unix_socket);
+    TEST_ASSERT_EQUAL_STRING("https://api.example.com:443/", targets[1]->url);
+    TEST_ASSERT_EQUAL_STRING("http://127.0.0.1:8080/", targets[2]->url);
+    TEST_ASSERT_EQUAL_STRING("/tmp/api.sock", targets[2]->unix_socket);
+
+    for (int i = 0; i < 3; i++) {
+        compiled_request_destroy(targets[i]);
+    }
+    for (int i = 0; i < 6; i++) {
+        compiled_request_destroy(requests[i]);
+    }
+}
+
+typedef struct {
+    http_client_t *client;
+    http_response_t *response;
+} client_send_t;
+
+static void *send_worker(void *arg) {
+    client_send_t *send = arg;
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, base_url, NULL, NULL, 5000);
+    if (request) send->response = http_request_compiled(send->client, request);
+    compiled_request_destroy(request);
+    return NULL;
+}
+
+// Test that a client sends from one thread while warming up from another
+void test_client_warm_up(void) {
+    http_client_t *client = http_client_create();
+    compiled_request_t *request = make_request("/first");
+    const compiled_request_t *requests[] = { request };
+
+    client_send_t send = { client, NULL };
+    pthread_t sender;
+    http_warmup_t *warmup = http_warmup_start(client, requests, 1, 2);
+    TEST_ASSERT_NOT_NULL(warmup);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&sender, NULL, send_worker, &send));
+    pthread_join(sender, NULL);
+    TEST_ASSERT_EQUAL_INT(2, http_warmup_finish(warmup));
+    TEST_ASSERT_EQUAL_INT(2, options_count);
+
+    TEST_ASSERT_NOT_NULL(send.response);
+    TEST_ASSERT_EQUAL_INT(200, send.response->status_code);
+    http_response_free(send.response);
+
+    compiled_request_destroy(request);
+    http_client_destroy(client);
+}
+
+// Test that concurrent engine requests all find warmed connections
+void test_engine_warm_up(void) {
+    http_engine_t *engine = http_engine_create(4);
+    compiled_request_t *request = make_request("/slow");
+    const compiled_request_t *requests[] = { request, request };
+
+    TEST_ASSERT_EQUAL_INT(3, http_engine_warm_up(engine, requests, 2, 3));
+    TEST_ASSERT_EQUAL_INT(3, connection_count);
+
+    int answered = 0;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, http_engine_submit(engine, request, count_response, &answered));
+    }
+    while (http_engine_run(engine, 100) > 0) {
+    }
+    TEST_ASSERT_EQUAL_INT(3, answered);
+    TEST_ASSERT_EQUAL_INT(3, connection_count);
+
+    compiled_request_destroy(request);
+    http_engine_destroy(engine);
+}
+
+// Test that warm-up connections follow the requests' "# @resolve" routes
+void test_engine_warm_up_routes(void) {
+    http_engine_t *engine = http_engine_create(4);
+    const char *port = strrchr(base_url, ':') + 1;
+    char url[128], routes[128];
+    snprintf(url, sizeof(url), "http://warmup.invalid:%s/first", port);
+    snprintf(routes, sizeof(routes), "%s warmup.invalid:%s:127.0.0.1", ROUTE_RESOLVE_DIRECTIVE, port);
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, url, routes, NULL, 5000);
+    TEST_ASSERT_NOT_NULL(request);
+    const compiled_request_t *requests[] = { request };
+
+    TEST_ASSERT_EQUAL_INT(1, http_engine_warm_up(engine, requests, 1, 1));
+    TEST_ASSERT_EQUAL_INT(1, connection_count);
+
+    int answered = 0;
+    TEST_ASSERT_EQUAL_INT(0, http_engine_submit(engine, request, count_response, &answered));
+    while (http_engine_run(engine, 100) > 0) {
+    }
+    TEST_ASSERT_EQUAL_INT(1, answered);
+    TEST_ASSERT_EQUAL_INT(1, connection_count);
+
+    compiled_request_destroy(request);
+    http_engine_destroy(engine);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+    snprintf(base_url, sizeof(base_url), "%s", mock_http_url(server));
+
+    UnityBegin("test_http_warmup.c");
+
+    RUN_TEST(test_warmup_targets);
+    RUN_TEST(test_client_warm_up);
+    RUN_TEST(test_engine_warm_up);
+    RUN_TEST(test_engine_warm_up_routes);
+
+    int result = UnityEnd();
+    mock_http_stop(server);
+    return result;
+}
@@ -0,0 +1,245 @@
+#include "unity/unity.h"
+#include "../include/json_format.h"
+#include "../include/response_view.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Collected lines for the formatter under test
+#define MAX_TEST_LINES 64
+static json_line_t test_lines[MAX_TEST_LINES];
+static int test_line_count = 0;
+
+static void collect_line(void *user_data, const json_line_t *line) {
+    (void)user_data;
+    if (test_line_count < MAX_TEST_LINES) {
+        test_lines[test_line_count++] = *line;
+    }
+}
+
+// Format a whole document and return the rendered lines joined by '\n'
+static void format_document(const char *json, char *out, size_t out_size) {
+    json_formatter_t formatter;
+    json_formatter_init(&formatter, json, strlen(json), collect_line, NULL);
+    while (json_formatter_step(&formatter, 3)) {
+        // Tiny steps exercise resuming in the middle of tokens
+    }
+
+    out[0] = '\0';
+    for (int i = 0; i < test_line_count; i++) {
+        char line[256];
+        if (test_lines[i].depth == JSON_LINE_PLAIN) {
+            json_format_render_plain(json, &test_lines[i], line, sizeof(line));
+        } else {
+            json_format_render_line(json, &test_lines[i], line, sizeof(line), NULL, 0, NULL);
+        }
+        strncat(out, line, out_size - strlen(out) - 1);
+        if (i < test_line_count - 1) {
+            strncat(out, "\n", out_size - strlen(out) - 1);
+        }
+    }
+}
+
+void setUp(void) {
+    test_line_count = 0;
+}
+
+void tearDown(void) {
+}
+
+// Test detection of JSON bodies
+void test_json_format_detect(void) {
+    TEST_ASSERT_TRUE(json_format_detect("{\"a\":1}", 7));
+    TEST_ASSERT_TRUE(json_format_detect("  \n[1]", 6));
+    TEST_ASSERT_FALSE(json_format_detect("<html>", 6));
+    TEST_ASSERT_FALSE(json_format_detect("", 0));
+    TEST_ASSERT_FALSE(json_format_detect(NULL, 0));
+}
+
+// Test pretty printing of minified JSON
+void test_json_format_minified_object(void) {
+    char out[1024];
+    format_document("{\"name\":\"a,b\",\"tags\":[1,2],\"empty\":{},\"ok\":true}", out, sizeof(out));
+
+    TEST_ASSERT_EQUAL_STRING(
+        "{\n"
+        "  \"name\": \"a,b\",\n"
+        "  \"tags\": [\n"
+        "    1,\n"
+        "    2\n"
+        "  ],\n"
+        "  \"empty\": {},\n"
+        "  \"ok\": true\n"
+        "}", out);
+}
+
+// Test that existing whitespace and escaped quotes are handled
+void test_json_format_whitespace_and_escapes(void) {
+    char out[1024];
+    format_document("[ {\"q\" : \"say \\\"hi\\\"\" } ,\n null ]", out, sizeof(out));
+
+    TEST_ASSERT_EQUAL_STRING(
+        "[\n"
+        "  {\n"
+        "    \"q\": \"say \\\"hi\\\"\"\n"
+        "  },\n"
+        "  null\n"
+        "]", out);
+}
+
+// Test fallback to plain text after a structural error
+void test_json_format_unbalanced_falls_back(void) {
+    char out[1024];
+    format_document("[1]]\ntrailing text", out, sizeof(out));
+
+    TEST_ASSERT_EQUAL_STRING("[\n  1\n]\n]\ntrailing text", out);
+}
+
+// Test highlight spans cover the rendered line contiguously
+void test_json_format_spans(void) {
+    const char *json = "\"key\":12,";
+    json_line_t line = { 0, (uint32_t)strlen(json), 1 };
+    char out[64];
+    json_span_t spans[8];
+    int count = 0;
+
+    int len = json_format_render_line(json, &line, out, sizeof(out), spans, 8, &count);
+
+    TEST_ASSERT_EQUAL_STRING("  \"key\": 12,", out);
+    TEST_ASSERT_EQUAL_INT(5, count);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_PLAIN, spans[0].kind);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_KEY, spans[1].kind);
+    TEST_ASSERT_EQUAL_INT(5, spans[1].length);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_PUNCT, spans[2].kind);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_NUMBER, spans[3].kind);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_PUNCT, spans[4].kind);
+    TEST_ASSERT_EQUAL_INT(len, spans[4].start + spans[4].length);
+}
+
+// Test that only a line's first string is a key, escaped quotes included,
+// and that a string is read only as far as the output holds: cut short,
+// a key is not known to be one
+void test_json_format_key_spans(void) {
+    const char *json = "\"a\\\"b\": \"c:d\",";
+    json_line_t line = { 0, (uint32_t)strlen(json), 0 };
+    char out[64];
+    json_span_t spans[8];
+    int count = 0;
+
+    json_format_render_line(json, &line, out, sizeof(out), spans, 8, &count);
+    TEST_ASSERT_EQUAL_STRING("\"a\\\"b\": \"c:d\",", out);
+    TEST_ASSERT_EQUAL_INT(4, count);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_KEY, spans[0].kind);
+    TEST_ASSERT_EQUAL_INT(6, spans[0].length);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_STRING, spans[2].kind);
+
+    const char *long_key = "\"0123456789012345678901234567890123456789\": 1";
+    line.length = (uint32_t)strlen(long_key);
+    int len = json_format_render_line(long_key, &line, out, 16, spans, 8, &count);
+    TEST_ASSERT_EQUAL_INT(15, len);
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_INT(JSON_SPAN_STRING, spans[0].kind);
+}
+
+// Test that a full span array still covers the whole line
+void test_json_format_span_overflow(void) {
+    const char *json = "[1,2,3]";
+    json_line_t line = { 0, (uint32_t)strlen(json), 0 };
+    char out[64];
+    json_span_t spans[2];
+    int count = 0;
+
+    int len = json_format_render_line(json, &line, out, sizeof(out), spans, 2, &count);
+
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(len, spans[1].start + spans[1].length);
+}
+
+// Test plain indexing of non-JSON bodies
+void test_json_index_plain(void) {
+    const char *text = "line one\r\nline two\n\nlast";
+    size_t pos = 0;
+    size_t size = strlen(text);
+    while (pos < size) {
+        pos = json_index_plain(text, pos, size, 4, collect_line, NULL);
+    }
+
+    TEST_ASSERT_EQUAL_INT(4, test_line_count);
+    TEST_ASSERT_EQUAL_INT(8, test_lines[0].length);
+    TEST_ASSERT_EQUAL_INT(0, test_lines[2].length);
+    TEST_ASSERT_EQUAL_INT(4, test_lines[3].length);
+}
+
+// Test the background view on a large generated body
+void test_response_view_large_body(void) {
+    const int items = 20000;
+    size_t capacity = (size_t)items * 32 + 16;
+    char *body = malloc(capacity);
+    TEST_ASSERT_NOT_NULL(body);
+
+    size_t len = 0;
+    body[len++] = '[';
+    for (int i = 0; i < items; i++) {
+        len += (size_t)snprintf(body + len, capacity - len, "%s{\"id\":%d}", i ? "," : "", i);
+    }
+    body[len++] = ']';
+    body[len] = '\0';
+
+    response_view_t *view = response_view_create(body, len);
+    TEST_ASSERT_NOT_NULL(view);
+    TEST_ASSERT_TRUE(response_view_is_json(view));
+
+    for (int i = 0; i < 500 && !response_view_is_complete(view); i++) {
+        usleep(10000);
+    }
+    TEST_ASSERT_TRUE(response_view_is_complete(view));
+
+    // "[", then three lines per item, then "]"
+    TEST_ASSERT_EQUAL_INT(items * 3 + 2, (int)response_view_line_count(view));
+
+    char line[128];
+    TEST_ASSERT_TRUE(response_view_render_line(view, 2, line, sizeof(line), NULL, 0, NULL) > 0);
+    TEST_ASSERT_EQUAL_STRING("    \"id\": 0", line);
+    TEST_ASSERT_EQUAL_INT(-1, response_view_render_line(view, (size_t)items * 3 + 2, line, sizeof(line), NULL, 0, NULL));
+
+    response_view_destroy(view);
+}
+
+// Test that destroying a view mid-format stops the worker
+void test_response_view_destroy_early(void) {
+    size_t len = 4 * 1024 * 1024;
+    char *body = malloc(len + 1);
+    TEST_ASSERT_NOT_NULL(body);
+    memset(body, 'x', len);
+    for (size_t i = 79; i < len; i += 80) body[i] = '\n';
+    body[len] = '\0';
+
+    response_view_t *view = response_view_create(body, len);
+    TEST_ASSERT_NOT_NULL(view);
+    TEST_ASSERT_FALSE(response_view_is_json(view));
+    response_view_destroy(view); // Should not crash or leak
+
+    response_view_destroy(NULL);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_json_format.c");
+
+    // Formatter tests
+    RUN_TEST(test_json_format_detect);
+    RUN_TEST(test_json_format_minified_object);
+    RUN_TEST(test_json_format_whitespace_and_escapes);
+    RUN_TEST(test_json_format_unbalanced_falls_back);
+    RUN_TEST(test_json_format_spans);
+    RUN_TEST(test_json_format_span_overflow);
+    RUN_TEST(test_json_format_key_spans);
+    RUN_TEST(test_json_index_plain);
+
+    // Response view tests
+    RUN_TEST(test_response_view_large_body);
+    RUN_TEST(test_response_view_destroy_early);
+
+    return UnityEnd();
+}
@@ -0,0 +1,177 @@
+#include "unity/unity.h"
+#include "../include/latency_trend.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static char trends_path[256];
+
+void setUp(void) {
+    snprintf(trends_path, sizeof(trends_path), "/tmp/apikit_trends_%d.txt", (int)getpid());
+    remove(trends_path);
+}
+
+void tearDown(void) {
+    remove(trends_path);
+}
+
+static void assert_endpoint(const char *expected, const char *method, const char *url) {
+    char key[TREND_KEY_LENGTH];
+    TEST_ASSERT_EQUAL_INT(0, latency_trend_endpoint(method, url, key, sizeof(key)));
+    TEST_ASSERT_EQUAL_STRING(expected, key);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_endpoint_normalization(void) {
+    assert_endpoint("GET https://api.example.com/users/{id}", "GET", "HTTPS://API.Example.com/users/17");
+    assert_endpoint("GET https://api.example.com/users/{id}", "GET", "https://api.example.com/users/42/?page=2#top");
+    assert_endpoint("GET https://api.example.com/Users/{id}/orders", "GET",
+                    "https://api.example.com/Users/550e8400-e29b-41d4-a716-446655440000/orders");
+    assert_endpoint("DELETE http://h/blobs/{id}", "DELETE", "http://h/blobs/0123456789abcdef0123");
+    assert_endpoint("GET http://h/v2/items", "GET", "http://h/v2/items");
+    assert_endpoint("GET http://h/", "GET", "http://h");
+    assert_endpoint("GET http://h/", "GET", "http://h/?q=1");
+    assert_endpoint("GET {{base}}/users/{id}", "GET", "{{base}}/users/7");
+
+    char small[16];
+    TEST_ASSERT_EQUAL_INT(-1, latency_trend_endpoint("GET", "https://api.example.com/users", small, sizeof(small)));
+}
+
+void test_lttb_downsampling(void) {
+    trend_point_t points[100], out[100];
+    for (int i = 0; i < 100; i++) {
+        points[i].x = i;
+        points[i].y = i == 57 ? 500.0 : 10.0;
+    }
+
+    // Endpoints kept, the spike survives
+    TEST_ASSERT_EQUAL_INT(10, latency_trend_lttb(points, 100, 10, out));
+    TEST_ASSERT_TRUE(out[0].x == 0 && out[9].x == 99);
+    int spike = 0;
+    for (int i = 0; i < 10; i++) {
+        if (out[i].y == 500.0) spike++;
+        if (i > 0) TEST_ASSERT_TRUE(out[i].x > out[i - 1].x);
+    }
+    TEST_ASSERT_EQUAL_INT(1, spike);
+
+    // Short series are copied
+    TEST_ASSERT_EQUAL_INT(5, latency_trend_lttb(points, 5, 10, out));
+    TEST_ASSERT_TRUE(out[4].x == 4);
+    TEST_ASSERT_EQUAL_INT(2, latency_trend_lttb(points, 100, 2, out));
+    TEST_ASSERT_TRUE(out[0].x == 0 && out[1].x == 99);
+    TEST_ASSERT_EQUAL_INT(0, latency_trend_lttb(points, 0, 10, out));
+}
+
+void test_record_summary(void) {
+    latency_trends_t *trends = latency_trends_load(NULL);
+    TEST_ASSERT_NOT_NULL(trends);
+    TEST_ASSERT_NULL(latency_trends_find(trends, "GET", "http://h/items/1"));
+
+    for (int i = 0; i < 100; i++) {
+        latency_trends_record(trends, "GET", "http://h/items/1", 1000 + (uint64_t)i * 10, 200, 1000 + i);
+    }
+    latency_trends_record(trends, "GET", "http://h/items/2", 0, 0, 2000);
+
+    // Another id of the same endpoint
+    const latency_trend_t *trend = latency_trends_find(trends, "GET", "http://h/items/99");
+    TEST_ASSERT_NOT_NULL(trend);
+    TEST_ASSERT_EQUAL_INT(101, trend->samples);
+    TEST_ASSERT_EQUAL_INT(1, trend->errors);
+    TEST_ASSERT_EQUAL_INT(0, (int)trend->last_status);
+    TEST_ASSERT_EQUAL_INT(TREND_SPARKLINE_POINTS, trend->point_count);
+    TEST_ASSERT_TRUE(trend->points[0].x == 0.0 && trend->points[trend->point_count - 1].x == 1.0);
+    TEST_ASSERT_TRUE(trend->max_ms > 1.98 && trend->max_ms < 2.0);
+
+    // The failure has no response and is left out of the badges; 3% precision
+    TEST_ASSERT_TRUE(trend->p50_us > 1450 && trend->p50_us < 1550);
+    TEST_ASSERT_TRUE(trend->p99_us > 1900 && trend->p99_us < 2050);
+    TEST_ASSERT_FALSE(trend->regressed);
+
+    TEST_ASSERT_NULL(latency_trends_find(trends, "POST", "http://h/items/1"));
+    latency_trends_destroy(trends);
+}
+
+void test_regression_flag(void) {
+    latency_trends_t *trends = latency_trends_load(NULL);
+    for (int i = 0; i < 40; i++) latency_trends_record(trends, "GET", "http://h/slow", 2000, 200, i);
+    for (int i = 0; i < TREND_RECENT_SAMPLES / 2; i++) {
+        latency_trends_record(trends, "GET", "http://h/slow", 9000, 200, 100 + i);
+    }
+    // Half of the recent samples are slow: their median is still fast
+    TEST_ASSERT_FALSE(latency_trends_find(trends, "GET", "http://h/slow")->regressed);
+
+    latency_trends_record(trends, "GET", "http://h/slow", 9000, 200, 200);
+    TEST_ASSERT_TRUE(latency_trends_find(trends, "GET", "http://h/slow")->regressed);
+    latency_trends_destroy(trends);
+}
+
+void test_sample_and_endpoint_limits(void) {
+    latency_trends_t *trends = latency_trends_load(NULL);
+    for (int i = 0; i < TREND_MAX_SAMPLES + 50; i++) {
+        latency_trends_record(trends, "GET", "http://h/ring", (uint64_t)i, 200, i);
+    }
+    TEST_ASSERT_EQUAL_INT(TREND_MAX_SAMPLES, latency_trends_find(trends, "GET", "http://h/ring")->samples);
+
+    // A new endpoint past the limit replaces the one recorded longest ago
+    char url[64];
+    for (int i = 0; i < TREND_MAX_ENDPOINTS - 1; i++) {
+        snprintf(url, sizeof(url), "http://h/e%d", i);
+        latency_trends_record(trends, "GET", url, 100, 200, 1000 + i);
+    }
+    latency_trends_record(trends, "GET", "http://h/ring", 100, 200, 5000);
+    latency_trends_record(trends, "GET", "http://h/new", 100, 200, 6000);
+    TEST_ASSERT_NULL(latency_trends_find(trends, "GET", "http://h/e0"));
+    TEST_ASSERT_NOT_NULL(latency_trends_find(trends, "GET", "http://h/e1"));
+    TEST_ASSERT_NOT_NULL(latency_trends_find(trends, "GET", "http://h/ring"));
+    TEST_ASSERT_NOT_NULL(latency_trends_find(trends, "GET", "http://h/new"));
+    latency_trends_destroy(trends);
+}
+
+void test_save_and_load(void) {
+    latency_trends_t *trends = latency_trends_load(trends_path);
+    TEST_ASSERT_NOT_NULL(trends);
+    for (int i = 0; i < 30; i++) {
+        latency_trends_record(trends, "GET", "https://api.example.com/a", 500 + (uint64_t)i, 200, 1700000000000ll + i);
+    }
+    latency_trends_record(trends, "POST", "https://api.example.com/b", 70000, 503, 1700000001000ll);
+    TEST_ASSERT_EQUAL_INT(0, latency_trends_save(trends, trends_path));
+    latency_trend_t saved = *latency_trends_find(trends, "GET", "https://api.example.com/a");
+    latency_trends_destroy(trends);
+
+    trends = latency_trends_load(trends_path);
+    const latency_trend_t *loaded = latency_trends_find(trends, "GET", "https://api.example.com/a");
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(&saved, loaded, sizeof(saved)));
+    loaded = latency_trends_find(trends, "POST", "https://api.example.com/b");
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL_INT(503, (int)loaded->last_status);
+    TEST_ASSERT_EQUAL_INT(1, loaded->errors);
+    latency_trends_destroy(trends);
+
+    // Foreign files are ignored
+    FILE *file = fopen(trends_path, "w");
+    fputs("something else\nendpoint GET http://h/x\n1 2 200\n", file);
+    fclose(file);
+    trends = latency_trends_load(trends_path);
+    TEST_ASSERT_NOT_NULL(trends);
+    TEST_ASSERT_NULL(latency_trends_find(trends, "GET", "http://h/x"));
+    latency_trends_destroy(trends);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_latency_trend.c");
+
+    RUN_TEST(test_endpoint_normalization);
+    RUN_TEST(test_lttb_downsampling);
+    RUN_TEST(test_record_summary);
+    RUN_TEST(test_regression_flag);
+    RUN_TEST(test_sample_and_endpoint_limits);
+    RUN_TEST(test_save_and_load);
+
+    return UnityEnd();
+}
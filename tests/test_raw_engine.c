@@ -0,0 +1,340 @@
+#include "unity/unity.h"
+#include "../include/raw_engine.h"
+#include "mock_http.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <signal.h>
+
+// Pipelining keep-alive mock server handler: answers each GET in order with
+// 200 "ok" (or the status in "/status/NNN") and closes with
+// "Connection: close" after CLOSE_AFTER responses.
+#define CLOSE_AFTER 50
+
+static mock_http_t *server;
+
+static int respond(int client, const mock_http_request_t *request, void *user_data) {
+    (void)user_data;
+    int status = 200;
+    if (strncmp(request->path, "/status/", 8) == 0) status = atoi(request->path + 8);
+    int closing = request->index + 1 == CLOSE_AFTER;
+    mock_http_reply(client, status, closing ? "Connection: close\r\n" : NULL, "ok");
+    return !closing;
+}
+
+static compiled_request_t *local_request(const char *path) {
+    char url[128];
+    snprintf(url, sizeof(url), "%s%s", mock_http_url(server), path);
+    return compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 5000);
+}
+
+// Feed text in pieces of step bytes; returns completed responses, -1 on error
+static int feed_in_steps(raw_parser_t *parser, const char *text, size_t step, int *statuses) {
+    size_t length = strlen(text), offset = 0;
+    int responses = 0;
+    while (offset < length) {
+        size_t size = length - offset < step ? length - offset : step;
+        long used = raw_parser_feed(parser, text + offset, size);
+        if (used < 0) return -1;
+        offset += (size_t)used;
+        if (parser->complete) statuses[responses++] = parser->status;
+    }
+    return responses;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Test the request line, Host and headers of a serialized GET
+void test_serialize_get(void) {
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "http://example.com:8080/a/b?x=1&y=2",
+                                                          "Accept: */*\nUser-Agent:", NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+
+    size_t size = 0;
+    char *bytes = raw_request_serialize(request, &size);
+    TEST_ASSERT_NOT_NULL(bytes);
+    TEST_ASSERT_EQUAL_STRING("GET /a/b?x=1&y=2 HTTP/1.1\r\n"
+                             "Host: example.com:8080\r\n"
+                             "Accept: */*\r\n"
+                             "\r\n", bytes);
+    TEST_ASSERT_EQUAL_INT((int)strlen(bytes), (int)size);
+
+    free(bytes);
+    compiled_request_destroy(request);
+}
+
+// Test a body gets its Content-Length, and a Host header is not doubled
+void test_serialize_post(void) {
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_POST, "http://example.com",
+                                                          "Host: api.internal", "{\"a\":1}", 0);
+    TEST_ASSERT_NOT_NULL(request);
+
+    size_t size = 0;
+    char *bytes = raw_request_serialize(request, &size);
+    TEST_ASSERT_NOT_NULL(bytes);
+    TEST_ASSERT_EQUAL_STRING("POST / HTTP/1.1\r\n"
+                             "Host: api.internal\r\n"
+                             "Content-Type: application/json\r\n"
+                             "Content-Length: 7\r\n"
+                             "\r\n"
+                             "{\"a\":1}", bytes);
+
+    free(bytes);
+    compiled_request_destroy(request);
+}
+
+// Test only plain HTTP can be serialized
+void test_serialize_rejects_https(void) {
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, "https://example.com/", NULL, NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+    TEST_ASSERT_NULL(raw_request_serialize(request, NULL));
+    compiled_request_destroy(request);
+}
+
+// Test pipelined responses are returned one at a time, however the bytes arrive
+void test_parser_pipelined_split(void) {
+    const char *text = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello"
+                       "HTTP/1.1 404 Not Found\r\ncontent-length: 0\r\n\r\n"
+                       "HTTP/1.1 204 No Content\r\n\r\n";
+    size_t steps[] = {1, 2, 7, 1000};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        raw_parser_t parser;
+        raw_parser_init(&parser);
+        int statuses[8];
+        TEST_ASSERT_EQUAL_INT(3, feed_in_steps(&parser, text, steps[i], statuses));
+        TEST_ASSERT_EQUAL_INT(200, statuses[0]);
+        TEST_ASSERT_EQUAL_INT(404, statuses[1]);
+        TEST_ASSERT_EQUAL_INT(204, statuses[2]);
+        TEST_ASSERT_TRUE(parser.keep_alive);
+        TEST_ASSERT_EQUAL_INT(0, raw_parser_finish(&parser));
+    }
+}
+
+// Test chunked bodies with extensions and trailers, after an interim response
+void test_parser_chunked(void) {
+    const char *text = "HTTP/1.1 100 Continue\r\n\r\n"
+                       "HTTP/1.1 201 Created\r\nTransfer-Encoding: chunked\r\n\r\n"
+                       "5;ext=1\r\nhello\r\n1A\r\nabcdefghijklmnopqrstuvwxyz\r\n0\r\nX-Trailer: 1\r\n\r\n"
+                       "HTTP/1.1 500 Oops\r\nConnection: close\r\nContent-Length: 1\r\n\r\nx";
+    size_t steps[] = {1, 3, 1000};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        raw_parser_t parser;
+        raw_parser_init(&parser);
+        int statuses[8];
+        TEST_ASSERT_EQUAL_INT(2, feed_in_steps(&parser, text, steps[i], statuses));
+        TEST_ASSERT_EQUAL_INT(201, statuses[0]);
+        TEST_ASSERT_EQUAL_INT(500, statuses[1]);
+        TEST_ASSERT_FALSE(parser.keep_alive);
+    }
+}
+
+// Test a body without framing runs until the connection closes
+void test_parser_until_close(void) {
+    raw_parser_t parser;
+    raw_parser_init(&parser);
+    const char *text = "HTTP/1.0 200 OK\r\n\r\nsome body";
+    TEST_ASSERT_EQUAL_INT((long)strlen(text), raw_parser_feed(&parser, text, strlen(text)));
+    TEST_ASSERT_FALSE(parser.complete);
+    TEST_ASSERT_EQUAL_INT(1, raw_parser_finish(&parser));
+    TEST_ASSERT_TRUE(parser.complete);
+    TEST_ASSERT_FALSE(parser.keep_alive);
+
+    // A response cut short is an error
+    raw_parser_init(&parser);
+    text = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc";
+    raw_parser_feed(&parser, text, strlen(text));
+    TEST_ASSERT_EQUAL_INT(-1, raw_parser_finish(&parser));
+}
+
+// Test malformed responses are rejected
+void test_parser_malformed(void) {
+    const char *texts[] = {
+        "SMTP 220 hello\r\n",
+        "HTTP/1.1 2x0 OK\r\n",
+        "HTTP/1.1 200 OK\r\nno colon here\r\n",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+        "HTTP/1.1 101 Switching Protocols\r\n\r\n",
+    };
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        raw_parser_t parser;
+        raw_parser_init(&parser);
+        TEST_ASSERT_EQUAL_INT(-1, raw_parser_feed(&parser, texts[i], strlen(texts[i])));
+    }
+}
+
+// Test a request-limited run answers every request exactly once
+void test_load_requests(void) {
+    compiled_request_t *ok = local_request("/");
+    compiled_request_t *missing = local_request("/status/404");
+    TEST_ASSERT_NOT_NULL(ok);
+    TEST_ASSERT_NOT_NULL(missing);
+
+    const compiled_request_t *requests[] = {ok, missing};
+    raw_load_options_t options = { .threads = 2, .connections = 4, .pipeline = 8, .requests = 1000 };
+    raw_load_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, raw_load_run(requests, 2, &options, &stats));
+
+    TEST_ASSERT_TRUE(stats.responses == 1000);
+    TEST_ASSERT_TRUE(stats.status[2] + stats.status[4] == 1000);
+    TEST_ASSERT_TRUE(stats.status[2] > 0 && stats.status[4] > 0);
+    TEST_ASSERT_TRUE(stats.errors == 0);
+    TEST_ASSERT_TRUE(stats.unanswered == 0);
+    TEST_ASSERT_TRUE(stats.sent >= 1000);
+    // The server closes every CLOSE_AFTER responses; those connections are reopened
+    TEST_ASSERT_TRUE(stats.reconnects >= 1000 / CLOSE_AFTER - 4);
+    TEST_ASSERT_TRUE(stats.elapsed_ns > 0);
+
+    compiled_request_destroy(ok);
+    compiled_request_destroy(missing);
+}
+
+// Test a timed run keeps sending until the deadline
+void test_load_duration(void) {
+    compiled_request_t *request = local_request("/");
+    TEST_ASSERT_NOT_NULL(request);
+
+    const compiled_request_t *requests[] = {request};
+    raw_load_options_t options = { .threads = 1, .connections = 2, .pipeline = 4, .duration_ms = 200 };
+    raw_load_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, raw_load_run(requests, 1, &options, &stats));
+
+    TEST_ASSERT_TRUE(stats.responses > 100);
+    TEST_ASSERT_TRUE(stats.status[2] == stats.responses);
+    TEST_ASSERT_TRUE(stats.errors == 0);
+    TEST_ASSERT_TRUE(stats.elapsed_ns >= 190000000ull && stats.elapsed_ns < 2000000000ull);
+
+    compiled_request_destroy(request);
+}
+
+// Test connections that cannot connect are given up, not retried forever
+void test_load_refused(void) {
+    int probe = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_length = sizeof(addr);
+    TEST_ASSERT_EQUAL_INT(0, bind(probe, (struct sockaddr *)&addr, sizeof(addr)));
+    TEST_ASSERT_EQUAL_INT(0, getsockname(probe, (struct sockaddr *)&addr, &addr_length));
+    close(probe);   // Nothing listens on the port now
+
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/", ntohs(addr.sin_port));
+    compiled_request_t *request = compiled_request_create(HTTP_METHOD_GET, url, NULL, NULL, 0);
+    TEST_ASSERT_NOT_NULL(request);
+
+    const compiled_request_t *requests[] = {request};
+    raw_load_options_t options = { .threads = 1, .connections = 3, .duration_ms = 5000 };
+    raw_load_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, raw_load_run(requests, 1, &options, &stats));
+    TEST_ASSERT_TRUE(stats.errors == 3);
+    TEST_ASSERT_TRUE(stats.responses == 0);
+    TEST_ASSERT_TRUE(stats.elapsed_ns < 1000000000ull);
+
+    compiled_request_destroy(request);
+}
+
+// Test a run split over processes adds up to the same totals
+void test_load_processes(void) {
+    compiled_request_t *request = local_request("/");
+    TEST_ASSERT_NOT_NULL(request);
+
+    const compiled_request_t *requests[] = {request};
+    raw_load_options_t options = { .threads = 3, .connections = 5, .pipeline = 4, .requests = 1001 };
+    raw_load_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, raw_load_run_processes(requests, 1, &options, 3, NULL, NULL, &stats));
+
+    TEST_ASSERT_TRUE(stats.responses == 1001);
+    TEST_ASSERT_TRUE(stats.status[2] == 1001);
+    TEST_ASSERT_TRUE(stats.errors == 0);
+    TEST_ASSERT_TRUE(stats.unanswered == 0);
+
+    // Every response has a latency, and percentiles are ordered
+    uint64_t recorded = 0;
+    for (int b = 0; b < RAW_LATENCY_BUCKETS; b++) recorded += stats.latency[b];
+    TEST_ASSERT_TRUE(recorded == 1001);
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 50) <= raw_latency_percentile(&stats, 99));
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 99) <= raw_latency_percentile(&stats, 100));
+
+    compiled_request_destroy(request);
+}
+
+// Test percentiles over hand-filled latency buckets
+void test_latency_percentile(void) {
+    static raw_load_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 50) == 0);
+
+    // Below 32 us every microsecond has its own bucket
+    stats.latency[5] = 90;
+    stats.latency[20] = 10;
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 50) == 5);
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 90) == 5);
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 91) == 20);
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 100) == 20);
+
+    // Buckets are 16 us wide between 512 and 1024 us: 992-1007 us share one
+    stats.latency[(9 - 4) * RAW_LATENCY_SUB_BUCKETS + 30] = 100;
+    TEST_ASSERT_TRUE(raw_latency_percentile(&stats, 100) == 1000);
+}
+
+// Test requests this engine cannot send are refused up front
+void test_load_rejects(void) {
+    compiled_request_t *local = local_request("/");
+    compiled_request_t *other = compiled_request_create(HTTP_METHOD_GET, "http://127.0.0.2:1/", NULL, NULL, 0);
+    compiled_request_t *secure = compiled_request_create(HTTP_METHOD_GET, "https://127.0.0.1/", NULL, NULL, 0);
+    compiled_request_t *http2 = local_request("/");
+    TEST_ASSERT_NOT_NULL(http2);
+    TEST_ASSERT_EQUAL_INT(0, compiled_request_add_routes(http2, "# @http-version 2-prior-knowledge"));
+
+    raw_load_options_t options = { .connections = 1 };
+    raw_load_stats_t stats;
+    const compiled_request_t *mixed[] = {local, other};
+    TEST_ASSERT_EQUAL_INT(-1, raw_load_run(mixed, 2, &options, &stats));
+    const compiled_request_t *tls[] = {secure};
+    TEST_ASSERT_EQUAL_INT(-1, raw_load_run(tls, 1, &options, &stats));
+    const compiled_request_t *h2[] = {http2};
+    TEST_ASSERT_EQUAL_INT(-1, raw_load_run(h2, 1, &options, &stats));
+
+    compiled_request_destroy(local);
+    compiled_request_destroy(other);
+    compiled_request_destroy(secure);
+    compiled_request_destroy(http2);
+}
+
+// Main test runner
+int main(void) {
+    signal(SIGPIPE, SIG_IGN);
+    server = mock_http_start(respond, NULL);
+    if (!server) {
+        printf("Failed to start mock server\n");
+        return 1;
+    }
+
+    UnityBegin("test_raw_engine.c");
+
+    RUN_TEST(test_serialize_get);
+    RUN_TEST(test_serialize_post);
+    RUN_TEST(test_serialize_rejects_https);
+    RUN_TEST(test_parser_pipelined_split);
+    RUN_TEST(test_parser_chunked);
+    RUN_TEST(test_parser_until_close);
+    RUN_TEST(test_parser_malformed);
+    RUN_TEST(test_load_requests);
+    RUN_TEST(test_load_duration);
+    RUN_TEST(test_load_refused);
+    RUN_TEST(test_load_processes);
+    RUN_TEST(test_latency_percentile);
+    RUN_TEST(test_load_rejects);
+
+    int result = UnityEnd();
+    mock_http_stop(server);
+    return result;
+}
@@ -0,0 +1,134 @@
+#include "unity/unity.h"
+#include "../include/response_search.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Wait for a background search to finish
+static void wait_for_search(response_search_t *search) {
+    for (int i = 0; i < 500 && !response_search_is_complete(search); i++) {
+        usleep(10000);
+    }
+    TEST_ASSERT_TRUE(response_search_is_complete(search));
+}
+
+// Test the plain-text matcher against a naive scan at every alignment
+void test_search_find_matches_naive(void) {
+    char haystack[200];
+    for (int i = 0; i < (int)sizeof(haystack); i++) {
+        haystack[i] = (char)('a' + (i * 7) % 5);
+    }
+    const char *needle = "cead";
+
+    for (size_t start = 0; start < 40; start++) {
+        long expected = -1;
+        for (size_t i = start; i + 4 <= sizeof(haystack); i++) {
+            if (memcmp(haystack + i, needle, 4) == 0) {
+                expected = (long)(i - start);
+                break;
+            }
+        }
+        long found = search_find(haystack + start, sizeof(haystack) - start, needle, 4, 0);
+        TEST_ASSERT_EQUAL_INT(expected, found);
+    }
+}
+
+// Test case-insensitive matching and edge cases
+void test_search_find_ignore_case(void) {
+    const char *text = "{\"Status\":\"OK\",\"status\":\"ok\"}";
+
+    TEST_ASSERT_EQUAL_INT(2, search_find(text, strlen(text), "status", 6, 1));
+    TEST_ASSERT_EQUAL_INT(16, search_find(text, strlen(text), "status", 6, 0));
+    TEST_ASSERT_EQUAL_INT(-1, search_find(text, strlen(text), "missing", 7, 1));
+    TEST_ASSERT_EQUAL_INT(-1, search_find(text, 3, "status", 6, 1));
+    TEST_ASSERT_EQUAL_INT(0, search_find("x", 1, "X", 1, 1));
+}
+
+// Test streaming all matches of a large body
+void test_response_search_all_matches(void) {
+    size_t size = 3 * 1024 * 1024;
+    char *body = malloc(size);
+    TEST_ASSERT_NOT_NULL(body);
+    memset(body, '.', size);
+
+    // Needles straddle the worker's internal chunk boundary
+    size_t positions[] = { 0, 1024 * 1024 - 2, 2 * 1024 * 1024 + 5, size - 6 };
+    for (int i = 0; i < 4; i++) {
+        memcpy(body + positions[i], "NeEdLe", 6);
+    }
+
+    response_search_t *search = response_search_start(body, size, "needle", SEARCH_MODE_IGNORE_CASE);
+    TEST_ASSERT_NOT_NULL(search);
+    wait_for_search(search);
+
+    TEST_ASSERT_EQUAL_INT(4, (int)response_search_match_count(search));
+    for (int i = 0; i < 4; i++) {
+        search_match_t match;
+        TEST_ASSERT_EQUAL_INT(0, response_search_get(search, (size_t)i, &match));
+        TEST_ASSERT_EQUAL_INT((int)positions[i], (int)match.offset);
+        TEST_ASSERT_EQUAL_INT(6, (int)match.length);
+    }
+
+    // Jumping uses the collected positions
+    TEST_ASSERT_EQUAL_INT(1, response_search_find_from(search, 1));
+    TEST_ASSERT_EQUAL_INT(3, response_search_find_from(search, positions[3]));
+    TEST_ASSERT_EQUAL_INT(-1, response_search_find_from(search, size - 1));
+
+    response_search_destroy(search);
+    free(body);
+}
+
+// Test regular expression search per line
+void test_response_search_regex(void) {
+    const char *body = "id=12\nname=abc id=7\n\nid=x";
+
+    response_search_t *search = response_search_start(body, strlen(body), "id=[0-9]+", SEARCH_MODE_REGEX);
+    TEST_ASSERT_NOT_NULL(search);
+    wait_for_search(search);
+
+    TEST_ASSERT_NULL(response_search_error(search));
+    TEST_ASSERT_EQUAL_INT(2, (int)response_search_match_count(search));
+
+    search_match_t match;
+    response_search_get(search, 1, &match);
+    TEST_ASSERT_EQUAL_INT(15, (int)match.offset);
+    TEST_ASSERT_EQUAL_INT(4, (int)match.length);
+
+    response_search_destroy(search);
+}
+
+// Test invalid patterns and empty input
+void test_response_search_errors(void) {
+    response_search_t *search = response_search_start("abc", 3, "(", SEARCH_MODE_REGEX);
+    TEST_ASSERT_NOT_NULL(search);
+    wait_for_search(search);
+    TEST_ASSERT_NOT_NULL(response_search_error(search));
+    TEST_ASSERT_EQUAL_INT(0, (int)response_search_match_count(search));
+    response_search_destroy(search);
+
+    TEST_ASSERT_NULL(response_search_start("abc", 3, "", SEARCH_MODE_TEXT));
+    response_search_destroy(NULL); // Should not crash
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_response_search.c");
+
+    // Matcher tests
+    RUN_TEST(test_search_find_matches_naive);
+    RUN_TEST(test_search_find_ignore_case);
+
+    // Background search tests
+    RUN_TEST(test_response_search_all_matches);
+    RUN_TEST(test_response_search_regex);
+    RUN_TEST(test_response_search_errors);
+
+    return UnityEnd();
+}
@@ -0,0 +1,141 @@
+#include "unity/unity.h"
+#include "../include/template.h"
+#include "../include/environment.h"
+#include "../include/http_parser.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define TEST_FIXTURES_DIR "tests/fixtures/"
+
+static template_vars_t *vars;
+static template_buffer_t out;
+
+void setUp(void) {
+    vars = template_vars_create();
+    memset(&out, 0, sizeof(out));
+}
+
+void tearDown(void) {
+    template_buffer_free(&out);
+    template_vars_destroy(vars);
+}
+
+// Test rendering literal text and variables
+void test_template_render_variables(void) {
+    template_t *template = template_compile("{{host}}/users/{{ id }}?v={{host}}", vars);
+    TEST_ASSERT_NOT_NULL(template);
+    TEST_ASSERT_EQUAL_INT(3, template_placeholder_count(template));
+
+    TEST_ASSERT_EQUAL_INT(0, template_vars_set(vars, "host", "http://localhost"));
+    TEST_ASSERT_EQUAL_INT(0, template_vars_set(vars, "id", "42"));
+    TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("http://localhost/users/42?v=http://localhost", out.data);
+    TEST_ASSERT_EQUAL_INT((int)strlen(out.data), (int)out.length);
+
+    template_destroy(template);
+}
+
+// Test that unset variables and non-placeholders are left as written
+void test_template_unset_and_literal_braces(void) {
+    template_t *template = template_compile("{\"a\": {{missing}}, \"b\": {{ not valid }}, \"c\": {{x", vars);
+    TEST_ASSERT_NOT_NULL(template);
+    TEST_ASSERT_EQUAL_INT(1, template_placeholder_count(template));
+
+    TEST_ASSERT_EQUAL_INT(1, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("{\"a\": {{missing}}, \"b\": {{ not valid }}, \"c\": {{x", out.data);
+
+    template_vars_set(vars, "missing", "1");
+    TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("{\"a\": 1, \"b\": {{ not valid }}, \"c\": {{x", out.data);
+
+    template_destroy(template);
+
+    template = template_compile(NULL, vars);
+    TEST_ASSERT_NOT_NULL(template);
+    TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("", out.data);
+    template_destroy(template);
+}
+
+// Test per-iteration values bound without copying
+void test_template_bind_slot(void) {
+    template_t *template = template_compile("/items/{{id}}", vars);
+    int slot = template_vars_slot(vars, "id", 2);
+    TEST_ASSERT_TRUE(slot >= 0);
+
+    char id[16];
+    for (int i = 0; i < 100; i++) {
+        int length = snprintf(id, sizeof(id), "%d", i);
+        template_vars_bind(vars, slot, id, (size_t)length);
+        TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    }
+    TEST_ASSERT_EQUAL_STRING("/items/99", out.data);
+
+    template_vars_bind(vars, slot, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(1, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("/items/{{id}}", out.data);
+
+    template_destroy(template);
+}
+
+// Test loading environments and switching between them without recompiling
+void test_environment_switch(void) {
+    environment_list_t environments;
+    TEST_ASSERT_EQUAL_INT(0, environment_load(TEST_FIXTURES_DIR "environments.toml", &environments));
+    TEST_ASSERT_EQUAL_INT(2, environments.count);
+    TEST_ASSERT_EQUAL_INT(2, environments.shared.variable_count);
+    TEST_ASSERT_EQUAL_INT(0, environment_find(&environments, "dev"));
+    TEST_ASSERT_EQUAL_INT(1, environment_find(&environments, "prod"));
+    TEST_ASSERT_EQUAL_INT(-1, environment_find(&environments, "staging"));
+
+    template_t *template = template_compile("{{host}}/{{api_version}} {{token}} {{retries}}", vars);
+    TEST_ASSERT_NOT_NULL(template);
+
+    TEST_ASSERT_EQUAL_INT(0, environment_apply(&environments, 0, vars));
+    TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("http://localhost:8080/v1 dev-token 3", out.data);
+
+    // prod has no token or retries: the shared token applies, retries stays unset
+    TEST_ASSERT_EQUAL_INT(0, environment_apply(&environments, 1, vars));
+    TEST_ASSERT_EQUAL_INT(1, template_render(template, vars, &out));
+    TEST_ASSERT_EQUAL_STRING("https://api.example.com/v1 shared-token {{retries}}", out.data);
+
+    template_destroy(template);
+
+    // A missing file is an empty list
+    TEST_ASSERT_EQUAL_INT(0, environment_load("tests/fixtures/nonexistent.toml", &environments));
+    TEST_ASSERT_EQUAL_INT(0, environments.count);
+}
+
+// Test rendering the {{token}} placeholders of a parsed collection
+void test_template_collection_headers(void) {
+    http_collection_t *collection = malloc(sizeof(http_collection_t));
+    TEST_ASSERT_NOT_NULL(collection);
+    TEST_ASSERT_EQUAL_INT(0, http_parse_file(TEST_FIXTURES_DIR "complex_request.http", collection));
+
+    environment_list_t environments;
+    environment_load(TEST_FIXTURES_DIR "environments.toml", &environments);
+    environment_apply(&environments, environment_find(&environments, "dev"), vars);
+
+    template_t *template = template_compile(collection->requests[1].headers, vars);
+    TEST_ASSERT_EQUAL_INT(0, template_render(template, vars, &out));
+    TEST_ASSERT_NOT_NULL(strstr(out.data, "Authorization: Bearer dev-token"));
+    TEST_ASSERT_NULL(strstr(out.data, "{{"));
+
+    template_destroy(template);
+    free(collection);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_template.c");
+
+    RUN_TEST(test_template_render_variables);
+    RUN_TEST(test_template_unset_and_literal_braces);
+    RUN_TEST(test_template_bind_slot);
+    RUN_TEST(test_environment_switch);
+    RUN_TEST(test_template_collection_headers);
+
+    return UnityEnd();
+}
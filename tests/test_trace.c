@@ -0,0 +1,162 @@
+#include "unity/unity.h"
+#include "../include/trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TRACE_TEST_FILE "/tmp/apikit_test_trace.json"
+
+void setUp(void) {
+    unlink(TRACE_TEST_FILE);
+}
+
+void tearDown(void) {
+    trace_stop();
+    unlink(TRACE_TEST_FILE);
+}
+
+static char *read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = malloc((size_t)size + 1);
+    size_t read = fread(data, 1, (size_t)size, file);
+    data[read] = '\0';
+    fclose(file);
+    return data;
+}
+
+static int count_occurrences(const char *text, const char *needle) {
+    int count = 0;
+    for (const char *p = strstr(text, needle); p; p = strstr(p + 1, needle)) {
+        count++;
+    }
+    return count;
+}
+
+static void *worker_spans(void *arg) {
+    (void)arg;
+    trace_set_thread_name("test_worker");
+    uint64_t start = trace_begin();
+    usleep(1000);
+    trace_end("worker_span", "test", start);
+    return NULL;
+}
+
+static void *worker_flood(void *arg) {
+    (void)arg;
+    uint64_t start = trace_begin();
+    trace_end("oldest_span", "test", start);
+    for (int i = 0; i < TRACE_BUFFER_EVENTS; i++) {
+        trace_instant("filler", "test");
+    }
+    return NULL;
+}
+
+// Test that nothing is recorded while tracing is off
+void test_trace_disabled_records_nothing(void) {
+    TEST_ASSERT_FALSE(trace_is_enabled());
+    TEST_ASSERT_TRUE(trace_begin() == 0);
+
+    trace_end("never", "test", trace_begin());
+    trace_instant("never", "test");
+    TEST_ASSERT_EQUAL_INT(0, trace_dump(TRACE_TEST_FILE));
+}
+
+// Test that spans from several threads end up in the Chrome JSON output
+void test_trace_spans_from_threads(void) {
+    TEST_ASSERT_EQUAL_INT(0, trace_start(TRACE_TEST_FILE));
+    TEST_ASSERT_TRUE(trace_is_enabled());
+
+    trace_set_thread_name("test_main");
+    uint64_t start = trace_begin();
+    TEST_ASSERT_TRUE(start != 0);
+    pthread_t thread;
+    pthread_create(&thread, NULL, worker_spans, NULL);
+    pthread_join(thread, NULL);
+    trace_end("main_span", "test", start);
+    trace_complete("explicit_span", "test", start, 500);
+
+    trace_stop();
+    TEST_ASSERT_FALSE(trace_is_enabled());
+
+    char *json = read_file(TRACE_TEST_FILE);
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"traceEvents\":["));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"main_span\",\"cat\":\"test\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"worker_span\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"name\":\"explicit_span\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"args\":{\"name\":\"test_worker\"}"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"args\":{\"name\":\"test_main\"}"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "]}\n"));
+    free(json);
+}
+
+// Test that a full ring keeps the newest events
+void test_trace_ring_keeps_newest(void) {
+    TEST_ASSERT_EQUAL_INT(0, trace_start(TRACE_TEST_FILE));
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, worker_flood, NULL);
+    pthread_join(thread, NULL);
+
+    TEST_ASSERT_EQUAL_INT(TRACE_BUFFER_EVENTS, trace_dump(TRACE_TEST_FILE));
+    char *json = read_file(TRACE_TEST_FILE);
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_NULL(strstr(json, "oldest_span"));
+    TEST_ASSERT_EQUAL_INT(TRACE_BUFFER_EVENTS, count_occurrences(json, "\"name\":\"filler\""));
+    free(json);
+}
+
+// Test that events from an earlier session are not exported again
+void test_trace_new_session_starts_empty(void) {
+    TEST_ASSERT_EQUAL_INT(0, trace_start(TRACE_TEST_FILE));
+    trace_instant("first_session", "test");
+    trace_stop();
+
+    TEST_ASSERT_EQUAL_INT(0, trace_start(TRACE_TEST_FILE));
+    trace_instant("second_session", "test");
+    TEST_ASSERT_EQUAL_INT(1, trace_dump(TRACE_TEST_FILE));
+
+    char *json = read_file(TRACE_TEST_FILE);
+    TEST_ASSERT_NOT_NULL(strstr(json, "second_session"));
+    TEST_ASSERT_NULL(strstr(json, "first_session"));
+    free(json);
+}
+
+// Test that SIGUSR1 writes the trace without stopping it
+void test_trace_sigusr1_dumps(void) {
+    TEST_ASSERT_EQUAL_INT(0, trace_start(TRACE_TEST_FILE));
+    trace_instant("before_signal", "test");
+
+    raise(SIGUSR1);
+
+    char *json = NULL;
+    for (int i = 0; i < 200 && !(json && strstr(json, "]}\n")); i++) {
+        free(json);
+        usleep(10000);
+        json = read_file(TRACE_TEST_FILE);
+    }
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_NOT_NULL(strstr(json, "before_signal"));
+    TEST_ASSERT_TRUE(trace_is_enabled());
+    free(json);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_trace.c");
+
+    RUN_TEST(test_trace_disabled_records_nothing);
+    RUN_TEST(test_trace_spans_from_threads);
+    RUN_TEST(test_trace_ring_keeps_newest);
+    RUN_TEST(test_trace_new_session_starts_empty);
+    RUN_TEST(test_trace_sigusr1_dumps);
+
+    return UnityEnd();
+}
@@ -0,0 +1,178 @@
+#include "unity/unity.h"
+#include "../include/work_scheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define LOOP_COUNT 100000
+#define TREE_DEPTH 12
+#define SHORT_LOOPS 20000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void count_index(void *arg, uint64_t index, int worker) {
+    (void)worker;
+    unsigned char *hits = arg;
+    __atomic_add_fetch(&hits[index], 1, __ATOMIC_RELAXED);
+}
+
+static void sleep_index(void *arg, uint64_t index, int worker) {
+    (void)arg;
+    (void)worker;
+    // The first few indexes are much slower, so a static split would be uneven
+    struct timespec pause = { 0, index < 4 ? 20 * 1000000L : 1000000L };
+    nanosleep(&pause, NULL);
+}
+
+typedef struct {
+    work_scheduler_t *scheduler;
+    int depth;
+    int *leaves;
+} tree_node_t;
+
+// Every node below the leaves queues two children from inside its task
+static void run_node(void *arg, int worker) {
+    (void)worker;
+    tree_node_t *node = arg;
+    if (node->depth == 0) {
+        __atomic_add_fetch(node->leaves, 1, __ATOMIC_RELAXED);
+    } else {
+        for (int i = 0; i < 2; i++) {
+            // No assertions here (not the test thread): a lost child shows in the leaf count
+            tree_node_t *child = malloc(sizeof(tree_node_t));
+            if (!child) continue;
+            *child = *node;
+            child->depth--;
+            if (work_scheduler_submit(node->scheduler, run_node, child) != 0) free(child);
+        }
+    }
+    free(node);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_for_runs_every_index_once(void) {
+    work_scheduler_t *scheduler = work_scheduler_create(4);
+    TEST_ASSERT_NOT_NULL(scheduler);
+    TEST_ASSERT_EQUAL_INT(4, work_scheduler_workers(scheduler));
+
+    unsigned char *hits = calloc(LOOP_COUNT, 1);
+    TEST_ASSERT_NOT_NULL(hits);
+    TEST_ASSERT_EQUAL_INT(0, work_scheduler_for(scheduler, LOOP_COUNT, 16, count_index, hits));
+    int wrong = 0;
+    for (int i = 0; i < LOOP_COUNT; i++) wrong += hits[i] != 1;
+    TEST_ASSERT_EQUAL_INT(0, wrong);
+
+    // Again on the same pool, with the smallest grain
+    memset(hits, 0, LOOP_COUNT);
+    TEST_ASSERT_EQUAL_INT(0, work_scheduler_for(scheduler, 1000, 0, count_index, hits));
+    for (int i = 0; i < 1000; i++) TEST_ASSERT_EQUAL_INT(1, hits[i]);
+    TEST_ASSERT_EQUAL_INT(0, hits[1000]);
+
+    free(hits);
+    work_scheduler_destroy(scheduler);
+}
+
+// Loops of one index end as soon as they start, so the worker finishing
+// one races the caller returning from it
+void test_for_many_short_loops(void) {
+    work_scheduler_t *scheduler = work_scheduler_create(4);
+    TEST_ASSERT_NOT_NULL(scheduler);
+
+    unsigned char hits[2];
+    int wrong = 0;
+    for (int i = 0; i < SHORT_LOOPS; i++) {
+        memset(hits, 0, sizeof(hits));
+        uint64_t count = (uint64_t)(i % 2) + 1;
+        wrong += work_scheduler_for(scheduler, count, 1, count_index, hits) != 0;
+        for (uint64_t j = 0; j < count; j++) wrong += hits[j] != 1;
+    }
+    TEST_ASSERT_EQUAL_INT(0, wrong);
+
+    work_scheduler_destroy(scheduler);
+}
+
+void test_for_balances_slow_indexes(void) {
+    work_scheduler_t *scheduler = work_scheduler_create(4);
+    TEST_ASSERT_NOT_NULL(scheduler);
+    TEST_ASSERT_EQUAL_INT(0, work_scheduler_for(scheduler, 64, 1, sleep_index, NULL));
+
+    // The range starts on one worker; the others only get work by stealing
+    uint64_t tasks = 0, steals = 0;
+    int busy_workers = 0;
+    for (int w = 0; w < 4; w++) {
+        work_worker_stats_t stats = work_scheduler_worker_stats(scheduler, w);
+        tasks += stats.tasks;
+        steals += stats.steals;
+        if (stats.tasks > 0) {
+            busy_workers++;
+            TEST_ASSERT_TRUE(stats.busy_ns > 0);
+            TEST_ASSERT_TRUE(stats.busy_ns <= stats.elapsed_ns);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(64, (int)tasks);
+    TEST_ASSERT_TRUE(steals > 0);
+    TEST_ASSERT_TRUE(busy_workers >= 2);
+
+    work_scheduler_destroy(scheduler);
+}
+
+void test_nested_submit_and_wait(void) {
+    work_scheduler_t *scheduler = work_scheduler_create(3);
+    TEST_ASSERT_NOT_NULL(scheduler);
+
+    int leaves = 0;
+    tree_node_t *root = malloc(sizeof(tree_node_t));
+    TEST_ASSERT_NOT_NULL(root);
+    root->scheduler = scheduler;
+    root->depth = TREE_DEPTH;
+    root->leaves = &leaves;
+    TEST_ASSERT_EQUAL_INT(0, work_scheduler_submit(scheduler, run_node, root));
+    work_scheduler_wait(scheduler);
+    TEST_ASSERT_EQUAL_INT(1 << TREE_DEPTH, leaves);
+
+    uint64_t tasks = 0;
+    for (int w = 0; w < 3; w++) tasks += work_scheduler_worker_stats(scheduler, w).tasks;
+    TEST_ASSERT_EQUAL_INT((2 << TREE_DEPTH) - 1, (int)tasks);
+
+    // Waiting with nothing queued returns at once
+    work_scheduler_wait(scheduler);
+    work_scheduler_destroy(scheduler);
+}
+
+void test_worker_stats_bounds(void) {
+    work_scheduler_t *scheduler = work_scheduler_create(2);
+    TEST_ASSERT_NOT_NULL(scheduler);
+
+    work_worker_stats_t stats = work_scheduler_worker_stats(scheduler, 2);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.tasks);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.elapsed_ns);
+    stats = work_scheduler_worker_stats(scheduler, -1);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.elapsed_ns);
+    TEST_ASSERT_EQUAL_INT(0, work_scheduler_workers(NULL));
+    TEST_ASSERT_EQUAL_INT(-1, work_scheduler_for(NULL, 1, 1, count_index, NULL));
+    TEST_ASSERT_EQUAL_INT(0, work_scheduler_for(scheduler, 0, 1, count_index, NULL));
+
+    work_scheduler_destroy(scheduler);
+    work_scheduler_destroy(NULL);
+}
+
+// Main test runner
+int main(void) {
+    UnityBegin("test_work_scheduler.c");
+
+    RUN_TEST(test_for_runs_every_index_once);
+    RUN_TEST(test_for_many_short_loops);
+    RUN_TEST(test_for_balances_slow_indexes);
+    RUN_TEST(test_nested_submit_and_wait);
+    RUN_TEST(test_worker_stats_bounds);
+
+    return UnityEnd();
+}